@@ -283,9 +283,15 @@ int socketClientInit(const char *devPath, socketClientCb_t cb)
     printf("Trying to connect...\n");
 
 #ifdef NPI_UNIX
+    memset(&remote, 0, sizeof(remote));
     remote.sun_family = AF_UNIX;
-    strcpy(remote.sun_path, ipAddress);
+    strncpy(remote.sun_path, ipAddress, sizeof(remote.sun_path) - 1);
     len = strlen(remote.sun_path) + sizeof(remote.sun_family);
+    if (remote.sun_path[0] == '@')
+    {
+        // abstract namespace, the name starts with a NUL and is not NUL terminated
+        remote.sun_path[0] = 0;
+    }
     if (connect(sClientFd, (struct sockaddr *)&remote, len) == -1) {
         perror("connect");
         res = 0;
@@ -352,8 +358,12 @@ static void *handleThreadFunc (void *ptr)
 		}
 		
 		// Conditional wait for the response handled in the Rx handling thread,
+		// the Rx thread may have handed over messages before this thread first waited
 		debug_printf("[MUTEX] Wait for Rx Cond (Handle) signal...\n");
-		pthread_cond_wait(&clientRxCond, &clientRxMutex);
+		while (rxProcBuf == NULL)
+		{
+			pthread_cond_wait(&clientRxCond, &clientRxMutex);
+		}
 
 		debug_printf("[MUTEX] (Handle) has lock\n");
 
@@ -435,7 +445,7 @@ static void *rxThreadFunc (void *ptr)
 				n = recv(sClientFd,
 						socketBuf[0],
 						SRPC_FRAME_HDR_SZ,
-						0); // normal data
+						MSG_WAITALL); // normal data
 			}
 			if (ufds[0].revents & POLLPRI) {
 				n = recv(sClientFd,
@@ -451,11 +461,12 @@ static void *rxThreadFunc (void *ptr)
 			}
 			else if (n == SRPC_FRAME_HDR_SZ)
 			{
-				// We have received the header, now read out length byte and process it
+				// We have received the header, now read out length byte and process it.
+				// The payload may arrive in a later segment than the header, wait for all of it
 				n = recv(sClientFd,
 						(uint8_t*)&(socketBuf[0][SRPC_FRAME_HDR_SZ]),
 						((msgData_t *)&(socketBuf[0][0]))->len,
-						0);
+						MSG_WAITALL);
 				if (n == ((msgData_t *)&(socketBuf[0][0]))->len)
 				{
 					int i;
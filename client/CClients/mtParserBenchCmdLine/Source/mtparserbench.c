@@ -0,0 +1,341 @@
+ /**************************************************************************************************
+  Filename:       mtparserbench.c
+
+  Description:    Throughput benchmark of the MT frame parser, fed from a
+                  captured byte stream or a generated one.
+
+  Copyright (C) {2012} Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ 
+**************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+
+#include "zbSocMtParser.h"
+
+#define BENCH_DEFAULT_FRAMES 100000
+#define BENCH_DEFAULT_CHUNK 64
+#define BENCH_DEFAULT_PASSES 20
+
+// MT_AF_INCOMING_MSG, the frame the SoC sends most
+#define BENCH_AF_CMD0 0x44
+#define BENCH_AF_CMD1 0x81
+
+static uint8_t *benchGenerate( uint32_t numFrames, uint32_t corruptEvery, uint32_t *len, uint32_t *good );
+static uint8_t *benchLoad( const char *path, uint32_t *len );
+static uint64_t benchNow( void );
+
+static zbSocMtParser_t benchParser;
+
+/*********************************************************************
+ * @fn          main
+ *
+ * @brief       Feeds a byte stream through the MT frame parser in chunks
+ *              the size of a transport read and reports the throughput
+ *              and the parser counters. The stream is a raw capture of
+ *              the bytes read from the SoC, or is generated with every
+ *              Nth frame corrupted and noise between the frames.
+ *
+ * @param       [-f capture] [-w save generated stream] [-n frames] 
+ *              [-e corrupt every Nth frame] [-c chunk bytes] [-p passes]
+ *
+ * @return      
+ */
+int main(int argc, char *argv[])
+{
+  const char *capture = NULL, *save = NULL;
+  uint32_t numFrames = BENCH_DEFAULT_FRAMES, corruptEvery = 0;
+  uint32_t chunk = BENCH_DEFAULT_CHUNK, passes = BENCH_DEFAULT_PASSES;
+  uint32_t streamLen, good = 0, pass;
+  uint64_t start, elapsed, check = 0;
+  zbSocMtParserStats_t *stats = &benchParser.stats;
+  uint8_t *stream;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "f:w:n:e:c:p:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'f':
+        capture = optarg;
+        break;
+      case 'w':
+        save = optarg;
+        break;
+      case 'n':
+        numFrames = atoi(optarg);
+        break;
+      case 'e':
+        corruptEvery = atoi(optarg);
+        break;
+      case 'c':
+        chunk = atoi(optarg);
+        break;
+      case 'p':
+        passes = atoi(optarg);
+        break;
+      default:
+        printf("Usage: %s [-f capture] [-w save generated stream] [-n frames] [-e corrupt every Nth frame] [-c chunk bytes] [-p passes]\n", argv[0]);
+        printf("  default %d generated frames, %d byte chunks, %d passes\n", BENCH_DEFAULT_FRAMES,
+          BENCH_DEFAULT_CHUNK, BENCH_DEFAULT_PASSES);
+        exit(-1);
+    }
+  }
+
+  if ((chunk == 0) || (passes == 0) || ((capture == NULL) && (numFrames == 0)))
+  {
+    printf("Invalid arguments\n");
+    exit(-1);
+  }
+
+  if (capture)
+  {
+    stream = benchLoad(capture, &streamLen);
+  }
+  else
+  {
+    stream = benchGenerate(numFrames, corruptEvery, &streamLen, &good);
+  }
+
+  if (stream == NULL)
+  {
+    exit(-1);
+  }
+
+  if (save)
+  {
+    FILE *fp = fopen(save, "wb");
+
+    if ((fp == NULL) || (fwrite(stream, 1, streamLen, fp) != streamLen))
+    {
+      printf("Could not write %s\n", save);
+      exit(-1);
+    }
+    fclose(fp);
+  }
+
+  zbSocMtParserInit(&benchParser);
+
+  start = benchNow();
+  for (pass = 0; pass < passes; pass++)
+  {
+    uint32_t idx = 0;
+
+    zbSocMtParserReset(&benchParser);
+
+    while (idx < streamLen)
+    {
+      uint32_t space, n;
+      uint8_t *buf = zbSocMtParserGetSpace(&benchParser, &space);
+      uint8_t *frame;
+      uint16_t len;
+
+      //stands in for the read() from the transport
+      n = streamLen - idx;
+      n = (n < chunk) ? n : chunk;
+      n = (n < space) ? n : space;
+      memcpy(buf, &stream[idx], n);
+      zbSocMtParserCommit(&benchParser, n);
+      idx += n;
+
+      while (zbSocMtParserNext(&benchParser, &frame, &len))
+      {
+        //touch the frame like the dispatcher would
+        check += frame[2] + frame[len - 1];
+      }
+    }
+  }
+  elapsed = benchNow() - start;
+
+  printf("stream: %u bytes%s%s, %u byte chunks, %u passes\n", streamLen, 
+    capture ? " from " : " generated", capture ? capture : "", chunk, passes);
+  printf("time: %.3f ms, %.1f MB/s, %.0f frames/s, %.1f ns/frame\n", elapsed / 1e6,
+    (double)stats->bytes * 1e3 / elapsed, (double)stats->frames * 1e9 / elapsed,
+    stats->frames ? (double)elapsed / stats->frames : 0.0);
+  printf("per pass: %llu frames, %llu fcs errors, %llu length errors, %llu bytes discarded, %llu fills\n",
+    (unsigned long long)(stats->frames / passes), (unsigned long long)(stats->fcsErrors / passes),
+    (unsigned long long)(stats->lenErrors / passes), (unsigned long long)(stats->discardedBytes / passes),
+    (unsigned long long)(stats->fills / passes));
+  if (!capture)
+  {
+    printf("expected %u good frames per pass: %s\n", good, 
+      (stats->frames == (uint64_t)good * passes) ? "ok" : "MISMATCH");
+  }
+  printf("(checksum %llu)\n", (unsigned long long)check);
+
+  free(stream);
+
+  return ((capture) || (stats->frames == (uint64_t)good * passes)) ? 0 : 1;
+}
+
+/*********************************************************************
+ * @fn          benchGenerate
+ *
+ * @brief       Generates MT_AF_INCOMING_MSG frames with payload lengths
+ *              spread like ZCL traffic, mostly short attribute reports
+ *              and some long ones. With corruptEvery set, every Nth frame
+ *              gets a bad FCS or length and is preceded by noise bytes.
+ *
+ * @param       numFrames - number of frames
+ * @param       corruptEvery - corrupt every Nth frame, 0 for none
+ * @param       len - set to the length of the stream
+ * @param       good - set to the number of frames the parser should return
+ *
+ * @return      stream, NULL on failure
+ */
+static uint8_t *benchGenerate( uint32_t numFrames, uint32_t corruptEvery, uint32_t *len, uint32_t *good )
+{
+  // frame and up to 4 noise bytes for every frame
+  uint8_t *stream = malloc((uint64_t)numFrames * (ZBSOC_MT_MAX_PAYLOAD + ZBSOC_MT_FRAME_OVERHEAD + 4));
+  uint8_t *p = stream;
+  uint32_t idx;
+
+  if (stream == NULL)
+  {
+    printf("Could not allocate the stream\n");
+    return NULL;
+  }
+
+  srand(1);
+  *good = 0;
+
+  for (idx = 0; idx < numFrames; idx++)
+  {
+    uint8_t payloadLen = ((rand() % 8) == 0) ? (rand() % (ZBSOC_MT_MAX_PAYLOAD + 1)) : (20 + rand() % 20);
+    uint8_t corrupt = (corruptEvery) && ((idx % corruptEvery) == (corruptEvery - 1));
+    uint8_t fcs, *frame, i;
+
+    if (corrupt)
+    {
+      //line noise, never a SOF
+      for (i = rand() % 5; i > 0; i--)
+      {
+        *p++ = rand() % ZBSOC_MT_SOF;
+      }
+    }
+
+    frame = p;
+    *p++ = ZBSOC_MT_SOF;
+    *p++ = payloadLen;
+    *p++ = BENCH_AF_CMD0;
+    *p++ = BENCH_AF_CMD1;
+    fcs = payloadLen ^ BENCH_AF_CMD0 ^ BENCH_AF_CMD1;
+    for (i = 0; i < payloadLen; i++)
+    {
+      //keep the SOF out of the payload, so a corrupt frame can not
+      //resync onto a frame inside it
+      *p = rand() % ZBSOC_MT_SOF;
+      fcs ^= *p++;
+    }
+    *p++ = fcs;
+
+    if (corrupt)
+    {
+      if ((idx / corruptEvery) & 1)
+      {
+        frame[1] = ZBSOC_MT_MAX_PAYLOAD + 1;
+      }
+      else
+      {
+        p[-1] ^= 0x5A;
+      }
+    }
+    else
+    {
+      (*good)++;
+    }
+  }
+
+  *len = p - stream;
+
+  return stream;
+}
+
+/*********************************************************************
+ * @fn          benchLoad
+ *
+ * @brief       Reads a capture of the raw bytes received from the SoC.
+ *
+ * @param       path - capture file
+ * @param       len - set to the length of the capture
+ *
+ * @return      stream, NULL on failure
+ */
+static uint8_t *benchLoad( const char *path, uint32_t *len )
+{
+  FILE *fp = fopen(path, "rb");
+  uint8_t *stream = NULL;
+  long size;
+
+  if (fp == NULL)
+  {
+    printf("Could not open %s\n", path);
+    return NULL;
+  }
+
+  if ((fseek(fp, 0, SEEK_END) == 0) && ((size = ftell(fp)) > 0) && (fseek(fp, 0, SEEK_SET) == 0))
+  {
+    stream = malloc(size);
+    if ((stream) && (fread(stream, 1, size, fp) != (size_t)size))
+    {
+      free(stream);
+      stream = NULL;
+    }
+    *len = size;
+  }
+
+  if (stream == NULL)
+  {
+    printf("Could not read %s\n", path);
+  }
+
+  fclose(fp);
+
+  return stream;
+}
+
+/*********************************************************************
+ * @fn          benchNow
+ *
+ * @brief       Monotonic time in ns.
+ */
+static uint64_t benchNow( void )
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
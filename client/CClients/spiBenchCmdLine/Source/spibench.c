@@ -0,0 +1,184 @@
+ /**************************************************************************************************
+  Filename:       spibench.c
+
+  Description:    Syscalls per frame of the SPI transport, measured
+                  against the mock spidev.
+
+  Copyright (C) {2012} Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ 
+**************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+
+#include "zbSocTransport.h"
+#include "zbSocSpiDev.h"
+
+#define BENCH_DEFAULT_FRAMES 100000
+#define BENCH_DEFAULT_LEN 32
+#define BENCH_MAX_LEN 253
+
+static void benchPrint( const char *phase, uint32_t frames, uint64_t elapsed, 
+  const zbSocSpiDevStats_t *before, const zbSocSpiDevStats_t *after );
+static uint64_t benchNow( void );
+
+// the transport prints every frame when set
+uint8_t uartDebugPrintsEnabled = 0;
+
+/*********************************************************************
+ * @fn          main
+ *
+ * @brief       Clocks frames through the SPI transport with the mock
+ *              spidev and SRDY, and reports the SPI_IOC_MESSAGE calls,
+ *              each one syscall on a real spidev, per frame received 
+ *              and sent. The received frames are compared with what
+ *              the mock SoC was given, the sent ones only counted.
+ *
+ * @param       [-n frames] [-l frame data length]
+ *
+ * @return      0 if every frame was received intact
+ */
+int main(int argc, char *argv[])
+{
+  zbSocSpiDevStats_t before, after;
+  uint8_t frame[BENCH_MAX_LEN], rxBuf[BENCH_MAX_LEN];
+  uint32_t numFrames = BENCH_DEFAULT_FRAMES, len = BENCH_DEFAULT_LEN;
+  uint32_t i, idx, received = 0;
+  uint64_t start;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:l:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n':
+        numFrames = atoi(optarg);
+        break;
+      case 'l':
+        len = atoi(optarg);
+        break;
+      default:
+        printf("Usage: %s [-n frames] [-l frame data length]\n", argv[0]);
+        printf("  default %d frames of %d bytes\n", BENCH_DEFAULT_FRAMES, BENCH_DEFAULT_LEN);
+        exit(-1);
+    }
+  }
+
+  if ((numFrames == 0) || (len < 3) || (len > BENCH_MAX_LEN))
+  {
+    printf("Invalid arguments\n");
+    exit(-1);
+  }
+
+  if ((zbSocTransportSelect("spi", NULL) != 0) || (zbSocTransportSetProfile("mock") != 0) || (zbSocTransportOpen("mock") < 0))
+  {
+    printf("Could not open the mock transport\n");
+    exit(-1);
+  }
+
+  //an MT AREQ, CMD0 CMD1 and a payload
+  frame[0] = 0x44;
+  frame[1] = 0x81;
+  for (idx = 2; idx < len; idx++)
+  {
+    frame[idx] = idx;
+  }
+
+  zbSocSpiDevGetStats(&before);
+  start = benchNow();
+  for (i = 0; i < numFrames; i++)
+  {
+    frame[2] = i;
+    zbSocSpiDevMockQueue(frame, len);
+
+    if ((zbSocTransportRead(rxBuf, sizeof(rxBuf)) == len) &&
+        (memcmp(rxBuf, frame, len) == 0))
+    {
+      received++;
+    }
+  }
+  zbSocSpiDevGetStats(&after);
+  benchPrint("rx", received, benchNow() - start, &before, &after);
+
+  before = after;
+  start = benchNow();
+  for (i = 0; i < numFrames; i++)
+  {
+    zbSocTransportWrite(frame, len);
+  }
+  zbSocSpiDevGetStats(&after);
+  benchPrint("tx", numFrames, benchNow() - start, &before, &after);
+
+  zbSocTransportClose();
+
+  if (received != numFrames)
+  {
+    printf("rx: %d of %d frames were lost or corrupted\n", numFrames - received, numFrames);
+    return 1;
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn          benchPrint
+ *
+ * @brief       Prints the frames/s and the counters per frame of a phase.
+ */
+static void benchPrint( const char *phase, uint32_t frames, uint64_t elapsed, 
+  const zbSocSpiDevStats_t *before, const zbSocSpiDevStats_t *after )
+{
+  double perFrame = frames ? (1.0 / frames) : 0.0;
+
+  printf("%s: %d frames, %.0f frames/s, %.2f SPI messages, %.2f transfers, %.1f bytes per frame\n",
+    phase, frames, elapsed ? (frames * 1e9 / elapsed) : 0.0,
+    (after->messages - before->messages) * perFrame,
+    (after->segments - before->segments) * perFrame,
+    (after->bytes - before->bytes) * perFrame);
+}
+
+/*********************************************************************
+ * @fn          benchNow
+ *
+ * @brief       Monotonic time in ns.
+ */
+static uint64_t benchNow( void )
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
@@ -0,0 +1,234 @@
+ /**************************************************************************************************
+  Filename:       srdybench.c
+
+  Description:    Latency benchmark of the SRDY GPIO backends, the edge 
+                  to wake up time of the SPI transport I/O thread.
+
+  Copyright (C) {2012} Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ 
+**************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "zbSocGpio.h"
+
+#define BENCH_DEFAULT_EDGES 100000
+// no edge for this long ends the run
+#define BENCH_STALL_MS 5000
+#define BENCH_VALUE_READS 100000
+
+typedef struct
+{
+  uint32_t numEdges;
+  uint32_t intervalUs;
+} benchSoc_t;
+
+static void *benchSocFunc( void *arg );
+static uint64_t benchNow( void );
+
+static volatile uint8_t benchDone = 0;
+
+/*********************************************************************
+ * @fn          main
+ *
+ * @brief       Waits for SRDY falling edges like the I/O thread of the
+ *              SPI transport does, and reports the edges/s and the time
+ *              from an edge to the wake up. With the mock backend a 
+ *              thread plays the SoC: it asserts SRDY once the previous
+ *              frame was read, the bench deasserts it after the drain
+ *              like clocking out the frame would. With a real backend 
+ *              the edges come from the SoC.
+ *
+ * @param       [-g backend] [-n edges] [-i mock edge interval us]
+ *
+ * @return      
+ */
+int main(int argc, char *argv[])
+{
+  zbSocGpioConfig_t config;
+  zbSocGpioStats_t stats;
+  benchSoc_t soc = { BENCH_DEFAULT_EDGES, 0 };
+  const char *backend = "mock";
+  uint64_t start, elapsed, lastEdge;
+  pthread_t thread;
+  uint32_t i;
+  int fd, opt;
+
+  while ((opt = getopt(argc, argv, "g:n:i:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'g':
+        backend = optarg;
+        break;
+      case 'n':
+        soc.numEdges = atoi(optarg);
+        break;
+      case 'i':
+        soc.intervalUs = atoi(optarg);
+        break;
+      default:
+        printf("Usage: %s [-g sysfs|mock|chardev=<chip>,<srdy line>[,<enable line>]] [-n edges] [-i mock edge interval us]\n", argv[0]);
+        printf("  default the mock backend, %d edges as fast as they are consumed\n", BENCH_DEFAULT_EDGES);
+        exit(-1);
+    }
+  }
+
+  if ((soc.numEdges == 0) || (zbSocGpioParse(backend, &config) != 0))
+  {
+    printf("Invalid arguments\n");
+    exit(-1);
+  }
+
+  fd = zbSocGpioOpen(&config);
+  if (fd < 0)
+  {
+    exit(-1);
+  }
+
+  //the cost of the level read the SPI transport does before a frame
+  start = benchNow();
+  for (i = 0; i < BENCH_VALUE_READS; i++)
+  {
+    zbSocGpioGetSrdy();
+  }
+  elapsed = benchNow() - start;
+  printf("%s: %.0f ns per SRDY read\n", backend, (double)elapsed / BENCH_VALUE_READS);
+
+  if ((config.backend == ZBSOC_GPIO_MOCK) && 
+      (pthread_create(&thread, NULL, benchSocFunc, &soc) != 0))
+  {
+    printf("Could not start the SoC thread\n");
+    exit(-1);
+  }
+
+  start = lastEdge = benchNow();
+  zbSocGpioGetStats(&stats);
+  while (stats.edges < soc.numEdges)
+  {
+    struct pollfd pollFd = { fd, zbSocGpioPollEvents(), 0 };
+
+    if (poll(&pollFd, 1, BENCH_STALL_MS) <= 0)
+    {
+      break;
+    }
+
+    if (zbSocGpioDrain() > 0)
+    {
+      lastEdge = benchNow();
+    }
+
+    if ((config.backend == ZBSOC_GPIO_MOCK) && (zbSocGpioGetSrdy() == 0))
+    {
+      zbSocGpioMockSet(1);
+    }
+
+    zbSocGpioGetStats(&stats);
+  }
+  elapsed = lastEdge - start;
+
+  benchDone = 1;
+  if (config.backend == ZBSOC_GPIO_MOCK)
+  {
+    pthread_join(thread, NULL);
+  }
+
+  printf("%s: %llu edges in %d wake ups, %.0f edges/s\n", backend, (unsigned long long)stats.edges,
+    (int)stats.wakeups, elapsed ? (stats.edges * 1e9 / elapsed) : 0.0);
+  if (stats.timestamped)
+  {
+    printf("%s: edge to wake up avg %.1f us, max %.1f us\n", backend, 
+      (double)stats.latencySumNs / stats.timestamped / 1e3, stats.latencyMaxNs / 1e3);
+  }
+  else
+  {
+    printf("%s: edges are not timestamped\n", backend);
+  }
+
+  zbSocGpioClose();
+
+  return (stats.edges == soc.numEdges) ? 0 : 1;
+}
+
+/*********************************************************************
+ * @fn          benchSocFunc
+ *
+ * @brief       Plays the SoC on the mock line, asserts SRDY again once
+ *              the bench deasserted it.
+ *
+ * @param       arg - benchSoc_t
+ *
+ * @return      NULL
+ */
+static void *benchSocFunc( void *arg )
+{
+  benchSoc_t *soc = arg;
+  uint32_t idx;
+
+  for (idx = 0; (idx < soc->numEdges) && (!benchDone); idx++)
+  {
+    while ((zbSocGpioGetSrdy() == 0) && (!benchDone))
+    {
+      sched_yield();
+    }
+
+    if (soc->intervalUs)
+    {
+      usleep(soc->intervalUs);
+    }
+
+    zbSocGpioMockSet(0);
+  }
+
+  return NULL;
+}
+
+/*********************************************************************
+ * @fn          benchNow
+ *
+ * @brief       Monotonic time in ns.
+ */
+static uint64_t benchNow( void )
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
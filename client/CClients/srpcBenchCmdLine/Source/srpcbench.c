@@ -0,0 +1,260 @@
+ /**************************************************************************************************
+  Filename:       srpcbench.c
+
+  Description:    SRPC round trip latency and throughput benchmark, built once
+                  against the TCP and once against the unix socket_client.
+
+  Copyright (C) {2012} Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ 
+**************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "socket_client.h"
+#include "interface_srpcserver.h"
+
+#ifdef NPI_UNIX
+#define BENCH_TRANSPORT "unix"
+#define BENCH_DEFAULT_ADDR "@zbGateway"
+#else
+#define BENCH_TRANSPORT "tcp"
+#define BENCH_DEFAULT_ADDR "127.0.0.1:11235"
+#endif
+
+#define BENCH_DEFAULT_ITERATIONS 10000
+#define BENCH_DEFAULT_WINDOW 16
+// The server queues at most this many responses per client by default
+#define BENCH_MAX_WINDOW 64
+
+void socketClientCb( msgData_t *msg );
+static void benchSend( void );
+static uint64_t benchNow( void );
+static int benchCompare( const void *a, const void *b );
+
+// Send time of each outstanding request, responses come back in order
+static uint64_t benchSendTime[BENCH_MAX_WINDOW];
+static uint32_t benchSent = 0;
+static uint32_t benchReceived = 0;
+static uint32_t benchWindow = 1;
+static uint32_t benchPayloadLen = 1;
+static uint64_t *benchRtt;
+
+static pthread_mutex_t benchMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t benchCond = PTHREAD_COND_INITIALIZER;
+
+/*********************************************************************
+ * @fn          main
+ *
+ * @brief       Measures the round trip time of single requests, then
+ *              the throughput with a window of outstanding requests.
+ *              The request is SRPC_SUBSCRIBE clearing the filters of the
+ *              bench client, which the server answers without involving
+ *              the ZigBee SoC.
+ *
+ * @param       [-a addr] [-n iterations] [-w window] [-s payload bytes]
+ *
+ * @return      
+ */
+int main(int argc, char *argv[])
+{
+  const char *addr = BENCH_DEFAULT_ADDR;
+  uint32_t iterations = BENCH_DEFAULT_ITERATIONS, window = BENCH_DEFAULT_WINDOW, idx;
+  uint64_t start, elapsed, total = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "a:n:w:s:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'a':
+        addr = optarg;
+        break;
+      case 'n':
+        iterations = atoi(optarg);
+        break;
+      case 'w':
+        window = atoi(optarg);
+        break;
+      case 's':
+        benchPayloadLen = atoi(optarg);
+        break;
+      default:
+        printf("Usage: %s [-a addr] [-n iterations] [-w window] [-s payload bytes]\n", argv[0]);
+        printf("  default addr %s, %d iterations, window %d\n", BENCH_DEFAULT_ADDR, 
+          BENCH_DEFAULT_ITERATIONS, BENCH_DEFAULT_WINDOW);
+        exit(-1);
+    }
+  }
+
+  if ((iterations == 0) || (window == 0) || (window > BENCH_MAX_WINDOW) || 
+      (benchPayloadLen == 0) || (benchPayloadLen > AP_MAX_BUF_LEN))
+  {
+    printf("Invalid arguments\n");
+    exit(-1);
+  }
+
+  benchRtt = malloc(iterations * sizeof(uint64_t));
+  if (benchRtt == NULL)
+  {
+    exit(-1);
+  }
+
+  if (socketClientInit(addr, socketClientCb) != 1)
+  {
+    printf("Could not connect to %s\n", addr);
+    exit(-1);
+  }
+
+  //round trip, one request at a time
+  benchWindow = 1;
+  pthread_mutex_lock(&benchMutex);
+  for (idx = 0; idx < iterations; idx++)
+  {
+    benchSend();
+    while (benchReceived < benchSent)
+    {
+      pthread_cond_wait(&benchCond, &benchMutex);
+    }
+  }
+  pthread_mutex_unlock(&benchMutex);
+
+  for (idx = 0; idx < iterations; idx++)
+  {
+    total += benchRtt[idx];
+  }
+  qsort(benchRtt, iterations, sizeof(uint64_t), benchCompare);
+  printf("%s round trip (us): min %.1f avg %.1f p50 %.1f p99 %.1f max %.1f\n", BENCH_TRANSPORT,
+    benchRtt[0] / 1000.0, (total / iterations) / 1000.0, benchRtt[iterations / 2] / 1000.0,
+    benchRtt[(iterations * 99) / 100] / 1000.0, benchRtt[iterations - 1] / 1000.0);
+
+  //throughput, keep a window of requests outstanding
+  benchWindow = window;
+  benchSent = benchReceived = 0;
+  start = benchNow();
+  pthread_mutex_lock(&benchMutex);
+  while (benchReceived < iterations)
+  {
+    while ((benchSent < iterations) && ((benchSent - benchReceived) < benchWindow))
+    {
+      benchSend();
+    }
+    pthread_cond_wait(&benchCond, &benchMutex);
+  }
+  pthread_mutex_unlock(&benchMutex);
+  elapsed = benchNow() - start;
+
+  printf("%s throughput (window %d, %d byte requests): %.0f req/s, %.2f MB/s in\n", BENCH_TRANSPORT,
+    window, benchPayloadLen, iterations / (elapsed / 1e9),
+    ((double) iterations * (benchPayloadLen + SRPC_FRAME_HDR_SZ)) / (elapsed / 1e3));
+
+  //exit without socketClientClose, it destroys the Rx condition while the
+  //socket client's handle thread is still waiting on it
+  free(benchRtt);
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn          benchNow
+ *
+ * @brief       monotonic time in ns
+ */
+static uint64_t benchNow( void )
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+/*********************************************************************
+ * @fn          benchCompare
+ *
+ * @brief       qsort comparison of two round trip times
+ */
+static int benchCompare( const void *a, const void *b )
+{
+  uint64_t rttA = *(const uint64_t *) a, rttB = *(const uint64_t *) b;
+
+  return (rttA > rttB) - (rttA < rttB);
+}
+
+/*********************************************************************
+ * @fn          benchSend
+ *
+ * @brief       send one request, called with benchMutex held.
+ */
+static void benchSend( void )
+{ 
+  msgData_t srpcCmd;
+  
+  memset(&srpcCmd, 0, sizeof(srpcCmd));
+  srpcCmd.cmdId = SRPC_SUBSCRIBE;
+  srpcCmd.len = benchPayloadLen;
+  //SUBS_OP_CLEAR, the server ignores the padding
+  srpcCmd.pData[0] = 0;
+
+  benchSendTime[benchSent % BENCH_MAX_WINDOW] = benchNow();
+  benchSent++;
+  
+  socketClientSendData (&srpcCmd);
+}
+
+/*********************************************************************
+ * @fn          socketClientCb
+ *
+ * @brief       count the responses and wake up main
+ */
+void socketClientCb( msgData_t *msg )
+{
+  uint64_t now = benchNow();
+
+  if (msg->cmdId != SRPC_SUBSCRIBE_RSP)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&benchMutex);
+  if (benchWindow == 1)
+  {
+    benchRtt[benchReceived] = now - benchSendTime[benchReceived % BENCH_MAX_WINDOW];
+  }
+  benchReceived++;
+  pthread_cond_signal(&benchCond);
+  pthread_mutex_unlock(&benchMutex);
+}
@@ -0,0 +1,373 @@
+ /**************************************************************************************************
+  Filename:       tcpbench.c
+
+  Description:    Round trip latency of the TCP transport, against a 
+                  local stand-in server that answers MT SREQs with 
+                  canned SRSPs, and its recovery from dropped connections.
+
+  Copyright (C) {2012} Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ 
+**************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "zbSocTransport.h"
+#include "zbSocMtParser.h"
+
+#define BENCH_DEFAULT_REQUESTS 10000
+// a request not answered this long is lost
+#define BENCH_RSP_TIMEOUT_MS 2000
+#define BENCH_DEFAULT_PROFILE "backoff=10:maxbackoff=1000"
+
+// SYS_PING SREQ and its SRSP
+#define BENCH_PING_CMD0 0x21
+#define BENCH_PING_CMD1 0x01
+#define BENCH_SRSP_CMD0 0x61
+
+typedef struct
+{
+  int listenFd;
+  uint32_t dropEvery;  // close the connection after this many responses, 0 never
+} benchServer_t;
+
+static void *benchServerFunc( void *arg );
+static uint8_t benchWaitRsp( uint64_t deadline, uint8_t *lost );
+static int benchCompare( const void *a, const void *b );
+static uint64_t benchNow( void );
+
+// the transport prints every frame when set
+uint8_t uartDebugPrintsEnabled = 0;
+
+static zbSocMtParser_t benchParser;
+
+/*********************************************************************
+ * @fn          main
+ *
+ * @brief       Pings the stand-in server, or a real SoC behind e.g. 
+ *              ser2net, through the TCP transport one request at a time
+ *              and reports the round trip percentiles. With -d the 
+ *              stand-in drops the connection every n responses, the 
+ *              requests that were cut off are sent again once the 
+ *              transport reconnected and their time is the recovery 
+ *              time.
+ *
+ * @param       [-n requests] [-d drop every n] [-s profile] [-c host:port]
+ *
+ * @return      0 if every request was answered
+ */
+int main(int argc, char *argv[])
+{
+  static const uint8_t ping[] = { ZBSOC_MT_SOF, 0x00, BENCH_PING_CMD0, BENCH_PING_CMD1, 0x20 };
+  benchServer_t server = { -1, 0 };
+  const char *profile = BENCH_DEFAULT_PROFILE;
+  char peer[64], *remote = NULL;
+  uint32_t numRequests = BENCH_DEFAULT_REQUESTS, answered = 0, recovered = 0, lostRequests = 0;
+  uint64_t sum = 0, recoverySum = 0, recoveryMax = 0;
+  uint32_t *latencies;
+  pthread_t thread;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:d:s:c:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n':
+        numRequests = atoi(optarg);
+        break;
+      case 'd':
+        server.dropEvery = atoi(optarg);
+        break;
+      case 's':
+        profile = optarg;
+        break;
+      case 'c':
+        remote = optarg;
+        break;
+      default:
+        printf("Usage: %s [-n requests] [-d drop every n] [-s profile] [-c host:port]\n", argv[0]);
+        printf("  default %d requests to a local stand-in, profile %s\n", BENCH_DEFAULT_REQUESTS, BENCH_DEFAULT_PROFILE);
+        exit(-1);
+    }
+  }
+
+  latencies = malloc(numRequests * sizeof(uint32_t));
+  if ((numRequests == 0) || (latencies == NULL) || 
+      (zbSocTransportSelect("tcp", NULL) != 0) || (zbSocTransportSetProfile(profile) != 0))
+  {
+    printf("Invalid arguments\n");
+    exit(-1);
+  }
+
+  if (remote == NULL)
+  {
+    struct sockaddr_in addr;
+    socklen_t addrLen = sizeof(addr);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    server.listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if ((server.listenFd < 0) || (bind(server.listenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0) ||
+        (listen(server.listenFd, 1) < 0) || 
+        (getsockname(server.listenFd, (struct sockaddr *)&addr, &addrLen) < 0) ||
+        (pthread_create(&thread, NULL, benchServerFunc, &server) != 0))
+    {
+      perror("stand-in server");
+      exit(-1);
+    }
+
+    snprintf(peer, sizeof(peer), "127.0.0.1:%u", ntohs(addr.sin_port));
+    remote = peer;
+  }
+
+  zbSocMtParserInit(&benchParser);
+  if (zbSocTransportOpen(remote) < 0)
+  {
+    exit(-1);
+  }
+
+  while (answered + recovered + lostRequests < numRequests)
+  {
+    uint64_t start = benchNow(), elapsed;
+    uint8_t cutOff = 0, lost = 0, rtn;
+
+    do
+    {
+      //cut off by a drop, sent again on the new connection
+      cutOff |= lost;
+      lost = 0;
+      zbSocTransportWrite((uint8_t *)ping, sizeof(ping));
+      rtn = benchWaitRsp(benchNow() + BENCH_RSP_TIMEOUT_MS * 1000000ULL, &lost);
+    } while ((!rtn) && (lost));
+    elapsed = benchNow() - start;
+
+    if (!rtn)
+    {
+      lostRequests++;
+    }
+    else if (cutOff)
+    {
+      recovered++;
+      recoverySum += elapsed;
+      recoveryMax = (elapsed > recoveryMax) ? elapsed : recoveryMax;
+    }
+    else
+    {
+      latencies[answered++] = elapsed / 1000;
+      sum += elapsed / 1000;
+    }
+  }
+
+  zbSocTransportClose();
+
+  if (answered)
+  {
+    qsort(latencies, answered, sizeof(uint32_t), benchCompare);
+    printf("%s: %u round trips, avg %.1f us, p50 %u us, p99 %u us, max %u us\n", remote, answered,
+      (double)sum / answered, latencies[answered / 2], latencies[(answered * 99) / 100], latencies[answered - 1]);
+  }
+  if (recovered)
+  {
+    printf("%s: %u requests cut off by a drop, recovered in avg %.1f ms, max %.1f ms\n", remote, recovered,
+      recoverySum / 1e6 / recovered, recoveryMax / 1e6);
+  }
+  if (lostRequests)
+  {
+    printf("%s: %u requests not answered\n", remote, lostRequests);
+  }
+
+  return lostRequests ? 1 : 0;
+}
+
+/*********************************************************************
+ * @fn          benchWaitRsp
+ *
+ * @brief       Waits for the ping SRSP the way the I/O thread of the 
+ *              gateway waits on the transport, on its fd, events and 
+ *              timeout, which also moves a reconnect on.
+ *
+ * @param       deadline - give up at, ns
+ * @param       lost - set if the connection was lost meanwhile
+ *
+ * @return      1 if the SRSP came
+ */
+static uint8_t benchWaitRsp( uint64_t deadline, uint8_t *lost )
+{
+  while (benchNow() < deadline)
+  {
+    struct pollfd pollFd = { zbSocTransportFd(), zbSocTransportPollEvents(), 0 };
+    int32_t timeout = zbSocTransportReadTimeout();
+    int32_t remaining = (deadline - benchNow()) / 1000000 + 1;
+    uint8_t *buf, *frame;
+    uint32_t space;
+    uint16_t len;
+    int32_t n;
+
+    if (pollFd.fd < 0)
+    {
+      *lost = 1;
+    }
+
+    poll(&pollFd, 1, ((timeout < 0) || (timeout > remaining)) ? remaining : timeout);
+
+    buf = zbSocMtParserGetSpace(&benchParser, &space);
+    n = zbSocTransportRead(buf, space);
+    if (n > 0)
+    {
+      zbSocMtParserCommit(&benchParser, n);
+    }
+
+    while (zbSocMtParserNext(&benchParser, &frame, &len))
+    {
+      if ((frame[2] == BENCH_SRSP_CMD0) && (frame[3] == BENCH_PING_CMD1))
+      {
+        return 1;
+      }
+    }
+
+    //the reconnect finished, the request went to the old connection
+    if ((*lost) && (zbSocTransportFd() >= 0))
+    {
+      return 0;
+    }
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn          benchServerFunc
+ *
+ * @brief       The stand-in: answers every SREQ with an SRSP, SYS_PING
+ *              with the capabilities, anything else with status 0.
+ *
+ * @param       arg - benchServer_t
+ *
+ * @return      NULL
+ */
+static void *benchServerFunc( void *arg )
+{
+  benchServer_t *server = arg;
+  static zbSocMtParser_t parser;
+  int fd;
+
+  while ((fd = accept(server->listenFd, NULL, NULL)) >= 0)
+  {
+    uint32_t responses = 0;
+    uint8_t *buf, *frame;
+    uint32_t space;
+    uint16_t len;
+    ssize_t n;
+
+    zbSocMtParserInit(&parser);
+
+    while ((server->dropEvery == 0) || (responses < server->dropEvery))
+    {
+      buf = zbSocMtParserGetSpace(&parser, &space);
+      n = read(fd, buf, space);
+      if (n <= 0)
+      {
+        break;
+      }
+      zbSocMtParserCommit(&parser, n);
+
+      while (zbSocMtParserNext(&parser, &frame, &len))
+      {
+        uint8_t rsp[7] = { ZBSOC_MT_SOF, 1, frame[2] ^ 0x40, frame[3], 0 };
+        uint8_t idx, rspLen;
+
+        //not an SREQ
+        if ((frame[2] & 0xE0) != 0x20)
+        {
+          continue;
+        }
+
+        if ((frame[2] == BENCH_PING_CMD0) && (frame[3] == BENCH_PING_CMD1))
+        {
+          rsp[1] = 2;
+          rsp[4] = 0x79;
+          rsp[5] = 0x01;
+        }
+
+        rspLen = rsp[1] + ZBSOC_MT_FRAME_OVERHEAD;
+        rsp[rspLen - 1] = 0;
+        for (idx = 1; idx < rspLen - 1; idx++)
+        {
+          rsp[rspLen - 1] ^= rsp[idx];
+        }
+
+        write(fd, rsp, rspLen);
+        responses++;
+      }
+    }
+
+    close(fd);
+  }
+
+  return NULL;
+}
+
+/*********************************************************************
+ * @fn          benchCompare
+ *
+ * @brief       qsort order of the latencies.
+ */
+static int benchCompare( const void *a, const void *b )
+{
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+/*********************************************************************
+ * @fn          benchNow
+ *
+ * @brief       Monotonic time in ns.
+ */
+static uint64_t benchNow( void )
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
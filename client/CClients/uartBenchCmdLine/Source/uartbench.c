@@ -0,0 +1,366 @@
+ /**************************************************************************************************
+  Filename:       uartbench.c
+
+  Description:    Throughput benchmark of the UART transport, over a pty
+                  pair or a serial port with its Tx wired to its Rx.
+
+  Copyright (C) {2012} Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ 
+**************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "zbSocTransport.h"
+#include "zbSocMtParser.h"
+
+#define BENCH_DEFAULT_FRAMES 20000
+#define BENCH_DEFAULT_PAYLOAD 40
+// no byte for this long ends a run, the missing frames are lost
+#define BENCH_STALL_MS 2000
+#define BENCH_MAX_PROFILES 16
+
+// MT_AF_DATA_REQUEST, the frame the gateway sends most
+#define BENCH_AF_CMD0 0x24
+#define BENCH_AF_CMD1 0x01
+
+typedef struct
+{
+  int fd;             // -1 writes with zbSocTransportWrite
+  uint32_t numFrames;
+} benchWriter_t;
+
+typedef struct
+{
+  uint64_t frames;
+  uint64_t bytes;
+  uint64_t reads;
+  uint64_t elapsedNs;
+} benchResult_t;
+
+static void *benchWriterFunc( void *arg );
+static uint8_t benchRun( int rxFd, int txFd, uint32_t numFrames, benchResult_t *result );
+static void benchPrint( const char *profile, const char *dir, uint32_t numFrames, benchResult_t *result );
+static uint64_t benchNow( void );
+
+// the transport prints every frame when set
+uint8_t uartDebugPrintsEnabled = 0;
+
+static const char *benchDefaultProfiles[] =
+{
+  "38400", "115200", "460800", "921600", "921600:lowlat", "921600:vmin=64", "921600:vmin=64:vtime=1"
+};
+
+static uint8_t benchFrame[ZBSOC_MT_MAX_PAYLOAD + ZBSOC_MT_FRAME_OVERHEAD];
+static uint32_t benchFrameLen;
+static zbSocMtParser_t benchParser;
+
+/*********************************************************************
+ * @fn          main
+ *
+ * @brief       Sends MT frames through the UART transport with each
+ *              profile and reports the sustained frames/s and the bytes
+ *              a read returns. Over a pty pair the host sends to the SoC
+ *              end (tx) and the SoC end sends to the host (rx); a pty
+ *              has no baud rate, so this measures the host cost of a
+ *              profile. On a serial port with Tx wired to Rx the frames
+ *              loop back at the baud rate of the profile.
+ *
+ * @param       [-d loopback device] [-n frames] [-l payload bytes] 
+ *              [-s profile]...
+ *
+ * @return      
+ */
+int main(int argc, char *argv[])
+{
+  const char *device = NULL;
+  const char *profiles[BENCH_MAX_PROFILES];
+  uint32_t numProfiles = 0, numFrames = BENCH_DEFAULT_FRAMES;
+  uint32_t payloadLen = BENCH_DEFAULT_PAYLOAD, i;
+  benchResult_t result;
+  uint8_t fcs, ok = 1;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "d:n:l:s:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'd':
+        device = optarg;
+        break;
+      case 'n':
+        numFrames = atoi(optarg);
+        break;
+      case 'l':
+        payloadLen = atoi(optarg);
+        break;
+      case 's':
+        if (numProfiles < BENCH_MAX_PROFILES)
+        {
+          profiles[numProfiles++] = optarg;
+        }
+        break;
+      default:
+        printf("Usage: %s [-d loopback device] [-n frames] [-l payload bytes] [-s profile]...\n", argv[0]);
+        printf("  default a pty pair, %d frames of %d payload bytes, profiles", BENCH_DEFAULT_FRAMES,
+          BENCH_DEFAULT_PAYLOAD);
+        for (i = 0; i < (sizeof(benchDefaultProfiles) / sizeof(benchDefaultProfiles[0])); i++)
+        {
+          printf(" %s", benchDefaultProfiles[i]);
+        }
+        printf("\n");
+        exit(-1);
+    }
+  }
+
+  if ((numFrames == 0) || (payloadLen > ZBSOC_MT_MAX_PAYLOAD))
+  {
+    printf("Invalid arguments\n");
+    exit(-1);
+  }
+
+  if (numProfiles == 0)
+  {
+    for (i = 0; i < (sizeof(benchDefaultProfiles) / sizeof(benchDefaultProfiles[0])); i++)
+    {
+      profiles[numProfiles++] = benchDefaultProfiles[i];
+    }
+  }
+
+  benchFrame[0] = ZBSOC_MT_SOF;
+  benchFrame[1] = payloadLen;
+  benchFrame[2] = BENCH_AF_CMD0;
+  benchFrame[3] = BENCH_AF_CMD1;
+  fcs = payloadLen ^ BENCH_AF_CMD0 ^ BENCH_AF_CMD1;
+  for (i = 0; i < payloadLen; i++)
+  {
+    benchFrame[4 + i] = i;
+    fcs ^= i;
+  }
+  benchFrame[4 + payloadLen] = fcs;
+  benchFrameLen = payloadLen + ZBSOC_MT_FRAME_OVERHEAD;
+
+  printf("%u frames of %u bytes over %s\n", numFrames, benchFrameLen, device ? device : "a pty pair");
+
+  zbSocTransportSelect("uart", NULL);
+
+  for (i = 0; i < numProfiles; i++)
+  {
+    if (zbSocTransportSetProfile(profiles[i]) != 0)
+    {
+      printf("Invalid profile %s\n", profiles[i]);
+      exit(-1);
+    }
+
+    if (device)
+    {
+      if (zbSocTransportOpen((char *)device) < 0)
+      {
+        exit(-1);
+      }
+
+      ok &= benchRun(zbSocTransportFd(), -1, numFrames, &result);
+      benchPrint(profiles[i], "lo", numFrames, &result);
+    }
+    else
+    {
+      int master = posix_openpt(O_RDWR | O_NOCTTY);
+
+      if ((master < 0) || (grantpt(master) < 0) || (unlockpt(master) < 0) || 
+          (zbSocTransportOpen(ptsname(master)) < 0))
+      {
+        perror("pty");
+        exit(-1);
+      }
+
+      ok &= benchRun(master, -1, numFrames, &result);
+      benchPrint(profiles[i], "tx", numFrames, &result);
+      ok &= benchRun(zbSocTransportFd(), master, numFrames, &result);
+      benchPrint(profiles[i], "rx", numFrames, &result);
+
+      close(master);
+    }
+
+    zbSocTransportClose();
+  }
+
+  return ok ? 0 : 1;
+}
+
+/*********************************************************************
+ * @fn          benchWriterFunc
+ *
+ * @brief       Writes the frames, with the transport or to the SoC end
+ *              of the pty.
+ *
+ * @param       arg - benchWriter_t
+ *
+ * @return      NULL
+ */
+static void *benchWriterFunc( void *arg )
+{
+  benchWriter_t *writer = arg;
+  uint32_t idx;
+
+  for (idx = 0; idx < writer->numFrames; idx++)
+  {
+    if (writer->fd < 0)
+    {
+      zbSocTransportWrite(benchFrame, benchFrameLen);
+    }
+    else
+    {
+      uint32_t done = 0;
+
+      while (done < benchFrameLen)
+      {
+        ssize_t n = write(writer->fd, benchFrame + done, benchFrameLen - done);
+
+        if (n <= 0)
+        {
+          return NULL;
+        }
+        done += n;
+      }
+    }
+  }
+
+  return NULL;
+}
+
+/*********************************************************************
+ * @fn          benchRun
+ *
+ * @brief       Writes the frames from a thread and reads them like the
+ *              I/O thread of the gateway does, with the read timeout of
+ *              the profile when reading the transport.
+ *
+ * @param       rxFd - fd the frames are read from
+ * @param       txFd - fd the frames are written to, -1 for the transport
+ * @param       numFrames - number of frames
+ * @param       result - counters of the run
+ *
+ * @return      1 if every frame was received
+ */
+static uint8_t benchRun( int rxFd, int txFd, uint32_t numFrames, benchResult_t *result )
+{
+  benchWriter_t writer = { txFd, numFrames };
+  int32_t timeout = (rxFd == zbSocTransportFd()) ? zbSocTransportReadTimeout() : -1;
+  uint64_t start, lastRx;
+  pthread_t thread;
+
+  memset(result, 0, sizeof(*result));
+  zbSocMtParserInit(&benchParser);
+
+  start = lastRx = benchNow();
+  if (pthread_create(&thread, NULL, benchWriterFunc, &writer) != 0)
+  {
+    printf("Could not start the writer\n");
+    exit(-1);
+  }
+
+  while (result->frames < numFrames)
+  {
+    struct pollfd pollFd = { rxFd, POLLIN, 0 };
+    uint32_t space;
+    uint8_t *buf, *frame;
+    uint16_t len;
+    ssize_t n;
+
+    if (((benchNow() - lastRx) / 1000000) > BENCH_STALL_MS)
+    {
+      break;
+    }
+
+    if (poll(&pollFd, 1, ((timeout < 0) || (timeout > BENCH_STALL_MS)) ? BENCH_STALL_MS : timeout) < 0)
+    {
+      continue;
+    }
+
+    buf = zbSocMtParserGetSpace(&benchParser, &space);
+    n = read(rxFd, buf, space);
+    if (n <= 0)
+    {
+      continue;
+    }
+
+    lastRx = benchNow();
+    result->reads++;
+    result->bytes += n;
+    zbSocMtParserCommit(&benchParser, n);
+
+    while (zbSocMtParserNext(&benchParser, &frame, &len))
+    {
+      result->frames++;
+    }
+  }
+  result->elapsedNs = lastRx - start;
+
+  pthread_join(thread, NULL);
+
+  return (result->frames == numFrames);
+}
+
+/*********************************************************************
+ * @fn          benchPrint
+ *
+ * @brief       Prints the result of a run.
+ */
+static void benchPrint( const char *profile, const char *dir, uint32_t numFrames, benchResult_t *result )
+{
+  double secs = result->elapsedNs ? (result->elapsedNs / 1e9) : 1e-9;
+
+  printf("%-24s %s: %9.0f frames/s %8.1f kB/s %7.1f bytes/read, %llu lost\n", profile, dir,
+    result->frames / secs, result->bytes / secs / 1e3,
+    result->reads ? ((double)result->bytes / result->reads) : 0.0,
+    (unsigned long long)(numFrames - result->frames));
+}
+
+/*********************************************************************
+ * @fn          benchNow
+ *
+ * @brief       Monotonic time in ns.
+ */
+static uint64_t benchNow( void )
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
@@ -0,0 +1,2594 @@
+ /**************************************************************************************************
+  Filename:       znpemulator.c
+
+  Description:    ZNP SoC emulator, speaks the MT protocol of the gateway
+                  over a pseudo terminal for a simulated population of
+                  ZigBee devices, so the gateway can be run under load
+                  without hardware.
+
+  Copyright (C) {2012} Texas Instruments Incorporated - http://www.ti.com/
+
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+     Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+     Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the
+     distribution.
+
+     Neither the name of Texas Instruments Incorporated nor the names of
+     its contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ 
+**************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <signal.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "zbSocTransport.h"
+#include "zbSocMtParser.h"
+#include "zbSocCmd.h"
+#include "hal_defs.h"
+
+#ifndef FALSE
+#define FALSE 0
+#define TRUE (!FALSE)
+#endif
+
+#define EMU_DEFAULT_LINK "/tmp/znpemu"
+#define EMU_DEFAULT_ENDPOINTS 5000
+#define EMU_DEFAULT_KINDS "odctzm"
+#define EMU_DEFAULT_LATENCY "20-200"
+#define EMU_DEFAULT_LOSS "0"
+#define EMU_DEFAULT_REPORT "60-300"
+#define EMU_DEFAULT_JOIN_RATE 250
+
+// the nodes get the nwk addrs from EMU_FIRST_NWK_ADDR up, below the
+// broadcast addrs
+#define EMU_FIRST_NWK_ADDR 0x0001
+#define EMU_MAX_NODES 0xFFF0
+#define EMU_MAX_EPS_PER_NODE 8
+#define EMU_MAX_GROUPS 4
+// a tty that hung up is opened again this often
+#define EMU_REOPEN_MS 100
+// events run between two reads of the tty, so a join storm does not hold
+// back the frames of the gateway
+#define EMU_MAX_EVENTS_PER_PASS 64
+
+// MT command types and subsystems, see zbSocCmd.c
+#define EMU_MT_SREQ 0x20
+#define EMU_MT_AREQ 0x40
+#define EMU_MT_SRSP 0x60
+#define EMU_MT_TYPE_MASK 0xE0
+#define EMU_MT_SUBSYSTEM_MASK 0x1F
+#define EMU_MT_SYS_RES0 0x00
+#define EMU_MT_SYS_SYS 0x01
+#define EMU_MT_SYS_NWK 0x03
+#define EMU_MT_SYS_ZDO 0x05
+#define EMU_MT_SYS_UTIL 0x07
+#define EMU_MT_SYS_APP 0x09
+#define EMU_MT_SYS_SBL 0x0D
+
+// MT_RPC_ERR_* of the RES0 SRSP to an SREQ the SoC does not support
+#define EMU_MT_ERR_SUBSYSTEM 0x01
+#define EMU_MT_ERR_COMMAND_ID 0x02
+
+#define EMU_SYS_RESET_REQ 0x00
+#define EMU_SYS_PING 0x01
+#define EMU_SYS_OSAL_NV_WRITE 0x09
+#define EMU_SYS_RESET_IND 0x80
+#define EMU_NLME_LEAVE_REQ 0x05
+#define EMU_ZDO_BIND_REQ 0x21
+#define EMU_UTIL_GET_DEVICE_INFO 0x00
+#define EMU_APP_MSG 0x00
+#define EMU_APP_RSP 0x80
+#define EMU_APP_NEW_DEV_IND 0x82
+
+// MT_APP_MSGs to this cluster are commands to the SoC application
+#define EMU_APP_RPC_CLUSTER 0xFFFF
+#define EMU_APP_RPC_CMD_PERMIT_JOIN 0x05
+
+// appEp, nwk addr, endpoint, cluster and ZCL length of an MT_APP_RSP
+#define EMU_APP_RSP_HDR_LEN 7
+// appEp, nwk addr, endpoint, cluster, data len and addr mode of an MT_APP_MSG
+#define EMU_APP_MSG_HDR_LEN 8
+#define EMU_ZCL_MAX_PAYLOAD (ZBSOC_MT_MAX_PAYLOAD - EMU_APP_RSP_HDR_LEN - 3)
+
+// MT_APP_NEW_DEV_IND flags, see interface_srpcserver.h
+#define EMU_NEW_DEV_FLAGS_FIRST 0x01
+#define EMU_NEW_DEV_FLAGS_LAST 0x02
+#define EMU_PROFILE_HA 0x0104
+
+#define EMU_ADDR_GROUP 1
+#define EMU_ADDR_16BIT 2
+#define EMU_ADDR_BROADCAST 15
+#define EMU_BROADCAST_EP 0xFF
+
+// serial bootloader, see zbSocCmd.c
+#define EMU_SBL_CMD0 (EMU_MT_AREQ | EMU_MT_SYS_SBL)
+#define EMU_SB_WRITE_CMD 0x01
+#define EMU_SB_READ_CMD 0x02
+#define EMU_SB_ENABLE_CMD 0x03
+#define EMU_SB_HANDSHAKE_CMD 0x04
+#define EMU_SB_RESPONSE 0x80
+#define EMU_SB_SUCCESS 0
+#define EMU_SB_FAILURE 1
+#define EMU_SB_FORCE_RUN (0xF8 ^ 0xFF)
+#define EMU_SBL_BLOCK_SIZE 64
+// flash of a CC2530F256
+#define EMU_FLASH_SIZE (256 * 1024)
+
+// ZCL statuses
+#define EMU_ZCL_STATUS_MALFORMED_COMMAND 0x80
+#define EMU_ZCL_STATUS_UNSUP_CLUSTER_COMMAND 0x81
+#define EMU_ZCL_STATUS_UNSUP_GENERAL_COMMAND 0x82
+#define EMU_ZCL_STATUS_UNSUP_MANU_CLUSTER_COMMAND 0x83
+#define EMU_ZCL_STATUS_UNSUP_MANU_GENERAL_COMMAND 0x84
+#define EMU_ZCL_STATUS_INVALID_FIELD 0x85
+#define EMU_ZCL_STATUS_UNSUPPORTED_ATTRIBUTE 0x86
+#define EMU_ZCL_STATUS_READ_ONLY 0x88
+#define EMU_ZCL_STATUS_INSUFFICIENT_SPACE 0x89
+#define EMU_ZCL_STATUS_DUPLICATE_EXISTS 0x8a
+#define EMU_ZCL_STATUS_NOT_FOUND 0x8b
+#define EMU_ZCL_STATUS_UNREPORTABLE_ATTRIBUTE 0x8c
+#define EMU_ZCL_STATUS_INVALID_DATA_TYPE 0x8d
+#define EMU_ZCL_STATUS_UNSUPPORTED_CLUSTER 0xc3
+
+// frame control of the frames the devices send
+#define EMU_ZCL_FC_SERVER (ZCL_FRAME_CONTROL_DIRECTION | ZCL_FRAME_CONTROL_DISABLE_DEFAULT_RSP)
+
+#define EMU_CLUSTER_ID_GEN_BASIC 0x0000
+#define EMU_ATTRID_BASIC_ZCL_VERSION 0x0000
+#define EMU_ATTRID_IDENTIFY_TIME 0x0000
+#define EMU_ATTRID_ZONE_STATE 0x0000
+#define EMU_ATTRID_ZONE_TYPE 0x0001
+#define EMU_ATTRID_ZONE_STATUS 0x0002
+
+#define EMU_COMMAND_IDENTIFY 0x00
+#define EMU_COMMAND_TOGGLE 0x02
+#define EMU_COMMAND_LEVEL_MOVE_TO_LEVEL_WITH_ON_OFF 0x04
+#define EMU_COMMAND_GROUP_ADD 0x00
+#define EMU_COMMAND_GROUP_REMOVE 0x03
+#define EMU_COMMAND_GROUP_REMOVE_ALL 0x04
+#define EMU_COMMAND_SCENE_STORE 0x04
+#define EMU_COMMAND_SCENE_RECALL 0x05
+#define EMU_COMMAND_ZONE_STATUS_CHANGE 0x00
+
+#define EMU_ZONE_STATE_ENROLLED 0x01
+#define EMU_ZONE_TYPE_CONTACT_SWITCH 0x0015
+#define EMU_ZONE_STATUS_ALARM1 0x0001
+
+#define EMU_ATTR_WRITABLE 0x01
+#define EMU_ATTR_REPORTABLE 0x02
+
+#define EMU_NODE_LEFT 0    // not joined yet, or left
+#define EMU_NODE_JOINING 1 // its join event is pending
+#define EMU_NODE_JOINED 2
+
+// the values an endpoint holds, an attribute refers to one or is constant
+typedef enum
+{
+  emuValOn,
+  emuValLevel,
+  emuValHue,
+  emuValSat,
+  emuValTemp,
+  emuValHumid,
+  emuValDemand,
+  emuValZoneStatus,
+  emuValIdentify,
+  emuNumVals,
+  emuValConst = emuNumVals
+} emuVal_t;
+
+typedef struct
+{
+  uint16_t clusterId;
+  uint16_t attrId;
+  uint8_t dataType;
+  uint8_t val;         // emuVal_t
+  uint8_t access;      // EMU_ATTR_*
+  int32_t constValue;  // of an emuValConst attribute
+} emuAttr_t;
+
+typedef struct
+{
+  char letter;         // of the -k option
+  uint16_t deviceId;
+  const emuAttr_t *attrs;
+  uint8_t numAttrs;
+  uint8_t zone;        // sends zone status change notifications instead of reports
+} emuKind_t;
+
+typedef struct
+{
+  uint8_t kind;
+  uint8_t tsn;                   // of the frames it sends on its own
+  uint8_t lossPct;               // of the frames to and from it
+  uint8_t reportGen;             // report events of an older generation are dropped
+  uint16_t latencyMs;            // of its responses
+  uint16_t reportS;              // report interval, 0 never
+  uint8_t numGroups;
+  uint16_t groups[EMU_MAX_GROUPS];
+  uint8_t sceneValid;
+  uint8_t sceneId;
+  uint16_t sceneGroup;
+  int32_t scene[emuValSat + 1];  // on, level, hue and sat
+  int32_t values[emuNumVals];
+} emuEp_t;
+
+typedef enum
+{
+  emuEvtJoin,    // a node joins
+  emuEvtReport,  // an endpoint reports
+  emuEvtFrame    // a delayed response is sent
+} emuEvtType_t;
+
+typedef struct
+{
+  uint64_t due;    // ms
+  uint32_t seq;    // keeps the events that are due at the same time in order
+  uint8_t type;
+  uint8_t gen;     // report generation of the endpoint
+  uint32_t idx;    // node or endpoint
+  uint8_t *frame;  // of emuEvtFrame, freed once sent
+} emuEvent_t;
+
+typedef enum
+{
+  emuRspDefault,  // default response, unless disabled
+  emuRspFrame,    // the response in the buffer
+  emuRspNone
+} emuRspType_t;
+
+typedef struct
+{
+  uint8_t send;   // emuRspType_t
+  uint8_t type;   // ZCL frame type
+  uint8_t cmd;
+  uint8_t len;
+  uint8_t buf[EMU_ZCL_MAX_PAYLOAD];
+} emuZclRsp_t;
+
+typedef struct
+{
+  uint32_t framesIn;
+  uint32_t framesOut;
+  uint32_t sreqs;
+  uint32_t appMsgs;
+  uint32_t zclRequests;  // per endpoint the MT_APP_MSG was delivered to
+  uint32_t zclRsps;
+  uint32_t reports;
+  uint32_t zoneNotifs;
+  uint32_t joins;
+  uint32_t leaves;
+  uint32_t lostDown;     // to the devices
+  uint32_t lostUp;       // from the devices
+  uint32_t sblWrites;
+  uint32_t sblReads;
+} emuStats_t;
+
+static void emuSignal( int sig );
+static uint64_t emuNow( void );
+static int32_t emuParseRange( const char *str, uint32_t maxValue, uint32_t *min, uint32_t *max );
+static uint32_t emuRandom( uint32_t min, uint32_t max );
+static int32_t emuCreate( uint32_t numEps, const char *kinds, const char *latency, const char *loss, const char *report );
+static void emuEventPush( uint64_t due, uint8_t type, uint8_t gen, uint32_t idx, uint8_t *frame );
+static void emuEventPop( emuEvent_t *evt );
+static void emuRunEvents( void );
+static void emuRead( void );
+static void emuWrite( uint8_t *frame, uint16_t len );
+static void emuHangUp( void );
+static uint16_t emuFinishFrame( uint8_t *frame, uint8_t cmd0, uint8_t cmd1, uint8_t len );
+static void emuSend( uint8_t cmd0, uint8_t cmd1, uint8_t *payload, uint8_t len );
+static void emuProcessFrame( uint8_t *frame, uint16_t len );
+static uint8_t emuProcessSys( uint8_t cmd1, uint8_t *payload, uint8_t len );
+static uint8_t emuProcessUtil( uint8_t cmd1, uint8_t *payload, uint8_t len );
+static uint8_t emuProcessNwk( uint8_t cmd1, uint8_t *payload, uint8_t len );
+static uint8_t emuProcessZdo( uint8_t cmd1, uint8_t *payload, uint8_t len );
+static uint8_t emuProcessApp( uint8_t cmd1, uint8_t *payload, uint8_t len );
+static void emuProcessSbl( uint8_t cmd1, uint8_t *payload, uint8_t len );
+static void emuSblRun( void );
+static void emuZclRequest( uint32_t epIdx, uint8_t appEp, uint16_t clusterId, uint8_t *zcl, uint8_t zclLen, uint8_t unicast );
+static uint8_t emuZclFoundation( uint32_t epIdx, uint16_t clusterId, uint8_t commandId, uint8_t *buf, uint8_t len, emuZclRsp_t *rsp );
+static void emuZclRead( emuEp_t *ep, uint16_t clusterId, uint8_t *buf, uint8_t len, emuZclRsp_t *rsp );
+static void emuZclWrite( emuEp_t *ep, uint16_t clusterId, uint8_t commandId, uint8_t *buf, uint8_t len, emuZclRsp_t *rsp );
+static void emuZclConfigReport( uint32_t epIdx, uint16_t clusterId, uint8_t *buf, uint8_t len, emuZclRsp_t *rsp );
+static uint8_t emuZclCluster( emuEp_t *ep, uint16_t clusterId, uint8_t commandId, uint8_t *buf, uint8_t len, emuZclRsp_t *rsp );
+static uint8_t emuZclGroups( emuEp_t *ep, uint8_t commandId, uint8_t *buf, uint8_t len, emuZclRsp_t *rsp );
+static uint8_t emuZclScenes( emuEp_t *ep, uint8_t commandId, uint8_t *buf, uint8_t len, emuZclRsp_t *rsp );
+static void emuSendZcl( uint32_t epIdx, uint8_t appEp, uint16_t clusterId, uint8_t frameControl, uint8_t tsn,
+                        uint8_t commandId, uint8_t *payload, uint8_t len, uint32_t delayMs );
+static void emuJoinNodes( void );
+static void emuJoin( uint32_t node );
+static void emuLeave( uint32_t node );
+static void emuReport( uint32_t epIdx );
+static void emuSetReporting( uint32_t epIdx, uint16_t maxInterval );
+static const emuAttr_t *emuFindAttr( emuEp_t *ep, uint16_t clusterId, uint16_t attrId );
+static uint8_t emuHasCluster( emuEp_t *ep, uint16_t clusterId );
+static int32_t emuGetAttr( emuEp_t *ep, const emuAttr_t *attr );
+static void emuPutValue( uint8_t *buf, int32_t value, uint8_t len );
+static int32_t emuGetValue( uint8_t *buf, uint8_t len, uint8_t dataType );
+static int32_t emuDrift( int32_t value, int32_t step, int32_t min, int32_t max );
+static uint8_t emuLost( emuEp_t *ep );
+static int32_t emuFindGroup( emuEp_t *ep, uint16_t groupId );
+static void emuPrintStats( void );
+
+// the transport prints every frame it writes when set
+uint8_t uartDebugPrintsEnabled = 0;
+
+// every endpoint has these
+static const emuAttr_t emuCommonAttrs[] =
+{
+  { EMU_CLUSTER_ID_GEN_BASIC, EMU_ATTRID_BASIC_ZCL_VERSION, ZCL_DATATYPE_UINT8, emuValConst, 0, 1 },
+  { ZCL_CLUSTER_ID_GEN_IDENTIFY, EMU_ATTRID_IDENTIFY_TIME, ZCL_DATATYPE_UINT16, emuValIdentify, EMU_ATTR_WRITABLE, 0 },
+};
+
+static const emuAttr_t emuOnOffAttrs[] =
+{
+  { ZCL_CLUSTER_ID_GEN_ON_OFF, ATTRID_ON_OFF, ZCL_DATATYPE_BOOLEAN, emuValOn, EMU_ATTR_REPORTABLE, 0 },
+};
+
+static const emuAttr_t emuDimmerAttrs[] =
+{
+  { ZCL_CLUSTER_ID_GEN_ON_OFF, ATTRID_ON_OFF, ZCL_DATATYPE_BOOLEAN, emuValOn, EMU_ATTR_REPORTABLE, 0 },
+  { ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL, ATTRID_LEVEL_CURRENT_LEVEL, ZCL_DATATYPE_UINT8, emuValLevel, EMU_ATTR_REPORTABLE, 0 },
+};
+
+static const emuAttr_t emuColorAttrs[] =
+{
+  { ZCL_CLUSTER_ID_GEN_ON_OFF, ATTRID_ON_OFF, ZCL_DATATYPE_BOOLEAN, emuValOn, EMU_ATTR_REPORTABLE, 0 },
+  { ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL, ATTRID_LEVEL_CURRENT_LEVEL, ZCL_DATATYPE_UINT8, emuValLevel, EMU_ATTR_REPORTABLE, 0 },
+  { ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL, ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_HUE, ZCL_DATATYPE_UINT8, emuValHue, EMU_ATTR_REPORTABLE, 0 },
+  { ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL, ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_SATURATION, ZCL_DATATYPE_UINT8, emuValSat, EMU_ATTR_REPORTABLE, 0 },
+};
+
+static const emuAttr_t emuTempAttrs[] =
+{
+  { ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT, ATTRID_MS_TEMPERATURE_MEASURED_VALUE, ZCL_DATATYPE_INT16, emuValTemp, EMU_ATTR_REPORTABLE, 0 },
+  { ZCL_CLUSTER_ID_MS_REL_HUMIDITY_MEASUREMENT, ATTRID_MS_RELATIVE_HUMIDITY_MEASURED_VALUE, ZCL_DATATYPE_UINT16, emuValHumid, EMU_ATTR_REPORTABLE, 0 },
+};
+
+static const emuAttr_t emuZoneAttrs[] =
+{
+  { ZCL_CLUSTER_ID_SS_IAS_ZONE, EMU_ATTRID_ZONE_STATE, ZCL_DATATYPE_ENUM8, emuValConst, 0, EMU_ZONE_STATE_ENROLLED },
+  { ZCL_CLUSTER_ID_SS_IAS_ZONE, EMU_ATTRID_ZONE_TYPE, ZCL_DATATYPE_ENUM16, emuValConst, 0, EMU_ZONE_TYPE_CONTACT_SWITCH },
+  { ZCL_CLUSTER_ID_SS_IAS_ZONE, EMU_ATTRID_ZONE_STATUS, ZCL_DATATYPE_BITMAP16, emuValZoneStatus, 0, 0 },
+};
+
+static const emuAttr_t emuMeterAttrs[] =
+{
+  { ZCL_CLUSTER_ID_SE_SIMPLE_METERING, ATTRID_SE_INSTANTANEOUS_DEMAND, ZCL_DATATYPE_INT24, emuValDemand, EMU_ATTR_REPORTABLE, 0 },
+};
+
+#define EMU_ATTRS(attrs) attrs, (sizeof(attrs) / sizeof(attrs[0]))
+
+static const emuKind_t emuKinds[] =
+{
+  { 'o', 0x0100, EMU_ATTRS(emuOnOffAttrs), FALSE },   // on/off light
+  { 'd', 0x0101, EMU_ATTRS(emuDimmerAttrs), FALSE },  // dimmable light
+  { 'c', 0x0102, EMU_ATTRS(emuColorAttrs), FALSE },   // color dimmable light
+  { 't', 0x0302, EMU_ATTRS(emuTempAttrs), FALSE },    // temperature and humidity sensor
+  { 'z', 0x0402, EMU_ATTRS(emuZoneAttrs), TRUE },     // IAS zone, a contact switch
+  { 'm', 0x0053, EMU_ATTRS(emuMeterAttrs), FALSE },   // metering device
+};
+
+#define EMU_NUM_KINDS (sizeof(emuKinds) / sizeof(emuKinds[0]))
+
+// IEEE addr of the SoC, the ones of the nodes have the node in the 2 LSBs
+// and a 0x00 in the third
+static const uint8_t emuIeeeAddr[8] = { 0xFF, 0xFF, 0xFF, 0xEE, 0x00, 0x4B, 0x12, 0x00 };
+
+static emuEp_t *emuEps;
+static uint8_t *emuNodes;  // EMU_NODE_*
+static uint32_t emuNumEps;
+static uint32_t emuNumNodes;
+static uint32_t emuEpsPerNode = 1;
+static uint32_t emuJoinRate = EMU_DEFAULT_JOIN_RATE;
+static uint8_t emuJoinsStarted = FALSE;
+static unsigned int emuSeed = 1;
+
+// min-heap on the due time
+static emuEvent_t *emuEvents;
+static uint32_t emuNumEvents;
+static uint32_t emuMaxEvents;
+static uint32_t emuEventSeq;
+
+static zbSocMtParser_t emuParser;
+static emuStats_t emuStats;
+static uint8_t emuPortOpen = FALSE;
+static char emuDevicePath[256];
+static uint64_t emuNextOpen;
+static uint64_t emuNowMs;  // of the current pass of the loop
+static volatile sig_atomic_t emuStop = FALSE;
+
+static uint8_t emuSblActive = FALSE;
+static uint8_t emuFlash[EMU_FLASH_SIZE];
+static uint32_t emuFlashEnd;
+static const char *emuImagePath = NULL;
+
+/*********************************************************************
+ * @fn          main
+ *
+ * @brief       Emulates a ZNP SoC and the devices of its network. The
+ *              emulator opens a pseudo terminal pair and links the slave
+ *              from -p, the gateway is started with the link as its
+ *              device. With -a it opens a tty instead, e.g. the link of
+ *              a gateway started with -t pty, and opens it again when
+ *              the gateway restarts.
+ *
+ *              The nodes join once the gateway sent the first frame,
+ *              and again on a permit join after they were removed. Each
+ *              endpoint gets its latency, loss and report interval from
+ *              the ranges of -l, -x and -r, they are seeded with -S so a
+ *              run can be repeated.
+ *
+ * @param       see the usage
+ *
+ * @return      0
+ */
+int main(int argc, char *argv[])
+{
+  const char *link = EMU_DEFAULT_LINK, *tty = NULL, *profile = NULL, *kinds = EMU_DEFAULT_KINDS;
+  const char *latency = EMU_DEFAULT_LATENCY, *loss = EMU_DEFAULT_LOSS, *report = EMU_DEFAULT_REPORT;
+  uint32_t numEps = EMU_DEFAULT_ENDPOINTS, runS = 0, statsS = 0;
+  uint64_t start, stopAt = 0, nextStats = 0;
+  struct pollfd pfd;
+  struct stat st;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:e:k:l:x:r:j:p:a:s:f:t:i:S:v")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n':
+        numEps = atoi(optarg);
+        break;
+      case 'e':
+        emuEpsPerNode = atoi(optarg);
+        break;
+      case 'k':
+        kinds = optarg;
+        break;
+      case 'l':
+        latency = optarg;
+        break;
+      case 'x':
+        loss = optarg;
+        break;
+      case 'r':
+        report = optarg;
+        break;
+      case 'j':
+        emuJoinRate = atoi(optarg);
+        break;
+      case 'p':
+        link = optarg;
+        break;
+      case 'a':
+        tty = optarg;
+        break;
+      case 's':
+        profile = optarg;
+        break;
+      case 'f':
+        emuImagePath = optarg;
+        break;
+      case 't':
+        runS = atoi(optarg);
+        break;
+      case 'i':
+        statsS = atoi(optarg);
+        break;
+      case 'S':
+        emuSeed = atoi(optarg);
+        break;
+      case 'v':
+        uartDebugPrintsEnabled = 1;
+        break;
+      default:
+        printf("Usage: %s [options]\n", argv[0]);
+        printf("  -n <endpoints>       endpoints of the population (default %d)\n", EMU_DEFAULT_ENDPOINTS);
+        printf("  -e <endpoints>       endpoints per node, 1 to %d (default 1)\n", EMU_MAX_EPS_PER_NODE);
+        printf("  -k <kinds>           kinds the endpoints take in turn, o on/off light, d dimmable light,\n");
+        printf("                       c color light, t temperature sensor, z IAS zone, m meter (default %s)\n", EMU_DEFAULT_KINDS);
+        printf("  -l <ms>[-<ms>]       response latency of an endpoint (default %s)\n", EMU_DEFAULT_LATENCY);
+        printf("  -x <%%>[-<%%>]         loss of the frames to and from an endpoint (default %s)\n", EMU_DEFAULT_LOSS);
+        printf("  -r <s>[-<s>]         report interval of an endpoint, 0 never (default %s)\n", EMU_DEFAULT_REPORT);
+        printf("  -j <nodes/s>         join rate, 0 all at once (default %d)\n", EMU_DEFAULT_JOIN_RATE);
+        printf("  -p <path>            link to the pseudo terminal (default %s)\n", EMU_DEFAULT_LINK);
+        printf("  -a <tty>             open a tty instead, e.g. the link of zbGateway -t pty\n");
+        printf("  -s <profile>         uart profile of the tty\n");
+        printf("  -f <file>            write the image loaded through the bootloader to a file\n");
+        printf("  -t <s>               stop after, default on SIGINT or SIGTERM\n");
+        printf("  -i <s>               print the counters every s\n");
+        printf("  -S <seed>            seed of the population, the loss and the sensor values\n");
+        printf("  -v                   print the frames sent\n");
+        exit(-1);
+    }
+  }
+
+  if (emuCreate(numEps, kinds, latency, loss, report) != 0)
+  {
+    printf("Invalid population\n");
+    exit(-1);
+  }
+
+  if (tty != NULL)
+  {
+    if ((zbSocTransportSelect("uart", NULL) != 0) ||
+        ((profile != NULL) && (zbSocTransportSetProfile(profile) != 0)))
+    {
+      printf("Invalid uart profile: %s\n", profile);
+      exit(-1);
+    }
+    snprintf(emuDevicePath, sizeof(emuDevicePath), "%s", tty);
+  }
+  else
+  {
+    zbSocTransportSelect("pty", NULL);
+    snprintf(emuDevicePath, sizeof(emuDevicePath), "%s", link);
+  }
+
+  if (zbSocTransportOpen(emuDevicePath) < 0)
+  {
+    exit(-1);
+  }
+  emuPortOpen = TRUE;
+
+  signal(SIGINT, emuSignal);
+  signal(SIGTERM, emuSignal);
+
+  zbSocMtParserInit(&emuParser);
+  memset(emuFlash, 0xFF, sizeof(emuFlash));
+
+  printf("%u endpoints on %u nodes, waiting for the gateway\n", emuNumEps, emuNumNodes);
+
+  start = emuNow();
+  if (runS > 0)
+  {
+    stopAt = start + (runS * 1000ULL);
+  }
+  if (statsS > 0)
+  {
+    nextStats = start + (statsS * 1000ULL);
+  }
+
+  while (!emuStop)
+  {
+    int timeout = -1;
+
+    emuNowMs = emuNow();
+
+    //the gateway replaces the link of its pseudo terminal when it opens it again
+    if ((!emuPortOpen) && (emuNowMs >= emuNextOpen))
+    {
+      if ((stat(emuDevicePath, &st) == 0) && (zbSocTransportOpen(emuDevicePath) >= 0))
+      {
+        zbSocMtParserReset(&emuParser);
+        emuPortOpen = TRUE;
+      }
+      else
+      {
+        emuNextOpen = emuNowMs + EMU_REOPEN_MS;
+      }
+    }
+
+    if (emuNumEvents > 0)
+    {
+      timeout = (emuEvents[0].due > emuNowMs) ? (emuEvents[0].due - emuNowMs) : 0;
+    }
+    if ((nextStats > 0) && ((timeout < 0) || ((nextStats - emuNowMs) < timeout)))
+    {
+      timeout = (nextStats > emuNowMs) ? (nextStats - emuNowMs) : 0;
+    }
+    if ((stopAt > 0) && ((timeout < 0) || ((stopAt - emuNowMs) < timeout)))
+    {
+      timeout = (stopAt > emuNowMs) ? (stopAt - emuNowMs) : 0;
+    }
+    if ((!emuPortOpen) && ((timeout < 0) || (timeout > EMU_REOPEN_MS)))
+    {
+      timeout = EMU_REOPEN_MS;
+    }
+
+    pfd.fd = emuPortOpen ? zbSocTransportFd() : -1;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, timeout) > 0)
+    {
+      if (pfd.revents & POLLIN)
+      {
+        emuRead();
+      }
+      if (pfd.revents & (POLLHUP | POLLERR))
+      {
+        emuHangUp();
+      }
+    }
+
+    emuNowMs = emuNow();
+    emuRunEvents();
+
+    if ((nextStats > 0) && (emuNowMs >= nextStats))
+    {
+      printf("%llu s: ", (unsigned long long)((emuNowMs - start) / 1000));
+      emuPrintStats();
+      nextStats += statsS * 1000ULL;
+    }
+
+    if ((stopAt > 0) && (emuNowMs >= stopAt))
+    {
+      break;
+    }
+  }
+
+  emuPrintStats();
+
+  if (emuPortOpen)
+  {
+    zbSocTransportClose();
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn          emuSignal
+ *
+ * @brief       Ends the loop, the counters are printed on the way out.
+ *
+ * @param       sig - signal
+ *
+ * @return      none
+ */
+static void emuSignal( int sig )
+{
+  emuStop = TRUE;
+}
+
+/*********************************************************************
+ * @fn          emuNow
+ *
+ * @brief       Monotonic time.
+ *
+ * @param       none
+ *
+ * @return      ms
+ */
+static uint64_t emuNow( void )
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ((uint64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+/*********************************************************************
+ * @fn          emuParseRange
+ *
+ * @brief       Parses <value> or <min>-<max>.
+ *
+ * @param       str - range
+ * @param       maxValue - largest value allowed
+ * @param       min - lower end of the range
+ * @param       max - upper end of the range
+ *
+ * @return      0 on success, -1 if the range is invalid
+ */
+static int32_t emuParseRange( const char *str, uint32_t maxValue, uint32_t *min, uint32_t *max )
+{
+  const char *start = str;
+  char *end;
+
+  *min = strtoul(start, &end, 10);
+  if (end == start)
+  {
+    return -1;
+  }
+
+  *max = *min;
+  if (*end == '-')
+  {
+    start = end + 1;
+    *max = strtoul(start, &end, 10);
+    if (end == start)
+    {
+      return -1;
+    }
+  }
+
+  if ((*end != '\0') || (*min > *max) || (*max > maxValue))
+  {
+    return -1;
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn          emuRandom
+ *
+ * @brief       Pseudo random value from the seed of -S.
+ *
+ * @param       min - lowest value
+ * @param       max - highest value
+ *
+ * @return      value from min to max
+ */
+static uint32_t emuRandom( uint32_t min, uint32_t max )
+{
+  return min + (rand_r(&emuSeed) % (max - min + 1));
+}
+
+/*********************************************************************
+ * @fn          emuCreate
+ *
+ * @brief       Creates the endpoints, none of the nodes has joined yet.
+ *
+ * @param       numEps - endpoints
+ * @param       kinds - letters of the kinds the endpoints take in turn
+ * @param       latency - range of the response latency in ms
+ * @param       loss - range of the loss in %
+ * @param       report - range of the report interval in s
+ *
+ * @return      0 on success, -1 if an argument is invalid
+ */
+static int32_t emuCreate( uint32_t numEps, const char *kinds, const char *latency, const char *loss, const char *report )
+{
+  uint32_t minLatency, maxLatency, minLoss, maxLoss, minReport, maxReport;
+  uint32_t numKinds = strlen(kinds), i, k;
+  uint8_t kindOf[256];
+
+  if ((numEps == 0) || (numKinds == 0) ||
+      (emuEpsPerNode == 0) || (emuEpsPerNode > EMU_MAX_EPS_PER_NODE) ||
+      (((numEps + emuEpsPerNode - 1) / emuEpsPerNode) > EMU_MAX_NODES) ||
+      (emuParseRange(latency, 0xFFFF, &minLatency, &maxLatency) != 0) ||
+      (emuParseRange(loss, 100, &minLoss, &maxLoss) != 0) ||
+      (emuParseRange(report, 0xFFFE, &minReport, &maxReport) != 0))
+  {
+    return -1;
+  }
+
+  for (i = 0; i < numKinds; i++)
+  {
+    for (k = 0; (k < EMU_NUM_KINDS) && (emuKinds[k].letter != kinds[i]); k++);
+    if (k == EMU_NUM_KINDS)
+    {
+      return -1;
+    }
+    kindOf[i % sizeof(kindOf)] = k;
+  }
+
+  emuNumEps = numEps;
+  emuNumNodes = (numEps + emuEpsPerNode - 1) / emuEpsPerNode;
+  emuEps = calloc(emuNumEps, sizeof(emuEp_t));
+  emuNodes = calloc(emuNumNodes, sizeof(uint8_t));
+  if ((emuEps == NULL) || (emuNodes == NULL))
+  {
+    return -1;
+  }
+
+  for (i = 0; i < emuNumEps; i++)
+  {
+    emuEp_t *ep = &emuEps[i];
+
+    ep->kind = kindOf[(i % numKinds) % sizeof(kindOf)];
+    ep->latencyMs = emuRandom(minLatency, maxLatency);
+    ep->lossPct = emuRandom(minLoss, maxLoss);
+    ep->reportS = emuRandom(minReport, maxReport);
+
+    ep->values[emuValOn] = 1;
+    ep->values[emuValLevel] = 200;
+    //0.01 C, 0.01 % and W
+    ep->values[emuValTemp] = emuRandom(1800, 2400);
+    ep->values[emuValHumid] = emuRandom(3000, 6000);
+    ep->values[emuValDemand] = emuRandom(50, 2000);
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn          emuEventBefore
+ *
+ * @brief       Order of the events in the heap.
+ *
+ * @param       a - event
+ * @param       b - event
+ *
+ * @return      TRUE if a is due before b
+ */
+static uint8_t emuEventBefore( emuEvent_t *a, emuEvent_t *b )
+{
+  return (a->due < b->due) || ((a->due == b->due) && ((int32_t)(a->seq - b->seq) < 0));
+}
+
+/*********************************************************************
+ * @fn          emuEventPush
+ *
+ * @brief       Adds an event to the heap.
+ *
+ * @param       due - time the event is due, ms
+ * @param       type - emuEvtType_t
+ * @param       gen - report generation of the endpoint
+ * @param       idx - node or endpoint
+ * @param       frame - frame of emuEvtFrame
+ *
+ * @return      none
+ */
+static void emuEventPush( uint64_t due, uint8_t type, uint8_t gen, uint32_t idx, uint8_t *frame )
+{
+  emuEvent_t evt = { due, emuEventSeq++, type, gen, idx, frame };
+  uint32_t pos, parent;
+
+  if (emuNumEvents == emuMaxEvents)
+  {
+    uint32_t maxEvents = (emuMaxEvents > 0) ? (emuMaxEvents * 2) : 1024;
+    emuEvent_t *events = realloc(emuEvents, maxEvents * sizeof(emuEvent_t));
+
+    if (events == NULL)
+    {
+      printf("emuEventPush: out of memory\n");
+      exit(-1);
+    }
+    emuEvents = events;
+    emuMaxEvents = maxEvents;
+  }
+
+  for (pos = emuNumEvents++; pos > 0; pos = parent)
+  {
+    parent = (pos - 1) / 2;
+    if (!emuEventBefore(&evt, &emuEvents[parent]))
+    {
+      break;
+    }
+    emuEvents[pos] = emuEvents[parent];
+  }
+  emuEvents[pos] = evt;
+}
+
+/*********************************************************************
+ * @fn          emuEventPop
+ *
+ * @brief       Takes the event that is due first off the heap.
+ *
+ * @param       evt - the event
+ *
+ * @return      none
+ */
+static void emuEventPop( emuEvent_t *evt )
+{
+  emuEvent_t last;
+  uint32_t pos = 0, child;
+
+  *evt = emuEvents[0];
+  last = emuEvents[--emuNumEvents];
+
+  while ((child = (pos * 2) + 1) < emuNumEvents)
+  {
+    if (((child + 1) < emuNumEvents) && emuEventBefore(&emuEvents[child + 1], &emuEvents[child]))
+    {
+      child++;
+    }
+    if (!emuEventBefore(&emuEvents[child], &last))
+    {
+      break;
+    }
+    emuEvents[pos] = emuEvents[child];
+    pos = child;
+  }
+  emuEvents[pos] = last;
+}
+
+/*********************************************************************
+ * @fn          emuRunEvents
+ *
+ * @brief       Runs the events that are due, up to
+ *              EMU_MAX_EVENTS_PER_PASS. The loop runs the rest without
+ *              waiting.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+static void emuRunEvents( void )
+{
+  emuEvent_t evt;
+  uint32_t numRun;
+
+  for (numRun = 0; (numRun < EMU_MAX_EVENTS_PER_PASS) && (emuNumEvents > 0) && (emuEvents[0].due <= emuNowMs); numRun++)
+  {
+    emuEventPop(&evt);
+
+    switch (evt.type)
+    {
+      case emuEvtJoin:
+        emuJoin(evt.idx);
+        break;
+
+      case emuEvtReport:
+      {
+        emuEp_t *ep = &emuEps[evt.idx];
+
+        //the interval changed or the node left since
+        if ((evt.gen == ep->reportGen) && (ep->reportS > 0) &&
+            (emuNodes[evt.idx / emuEpsPerNode] == EMU_NODE_JOINED))
+        {
+          emuReport(evt.idx);
+          emuEventPush(emuNowMs + (ep->reportS * 1000ULL), emuEvtReport, ep->reportGen, evt.idx, NULL);
+        }
+        break;
+      }
+
+      case emuEvtFrame:
+        emuWrite(evt.frame, evt.frame[1] + ZBSOC_MT_FRAME_OVERHEAD);
+        free(evt.frame);
+        break;
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn          emuRead
+ *
+ * @brief       Reads the tty and processes the frames it completed.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+static void emuRead( void )
+{
+  uint8_t *space, *frame;
+  uint32_t spaceLen;
+  uint16_t frameLen;
+  int32_t bytesRead;
+
+  space = zbSocMtParserGetSpace(&emuParser, &spaceLen);
+  bytesRead = zbSocTransportRead(space, spaceLen);
+
+  //the bootloader runs the image on a lone SB_FORCE_RUN, the parser drops it
+  if (emuSblActive && (bytesRead == 1) && (space[0] == EMU_SB_FORCE_RUN))
+  {
+    emuSblRun();
+  }
+
+  zbSocMtParserCommit(&emuParser, bytesRead);
+
+  while (zbSocMtParserNext(&emuParser, &frame, &frameLen))
+  {
+    emuProcessFrame(frame, frameLen);
+  }
+}
+
+/*********************************************************************
+ * @fn          emuWrite
+ *
+ * @brief       Writes a frame to the gateway, it is lost while the tty
+ *              is being opened again.
+ *
+ * @param       frame - MT frame
+ * @param       len - length of the frame
+ *
+ * @return      none
+ */
+static void emuWrite( uint8_t *frame, uint16_t len )
+{
+  struct pollfd pfd;
+
+  if (!emuPortOpen)
+  {
+    return;
+  }
+
+  //the loop only sees the hang up once the events that are due have run
+  pfd.fd = zbSocTransportFd();
+  pfd.events = POLLOUT;
+  pfd.revents = 0;
+  if ((poll(&pfd, 1, 0) > 0) && (pfd.revents & (POLLHUP | POLLERR)))
+  {
+    emuHangUp();
+    return;
+  }
+
+  zbSocTransportWrite(frame, len);
+  emuStats.framesOut++;
+}
+
+/*********************************************************************
+ * @fn          emuHangUp
+ *
+ * @brief       Closes the tty the gateway hung up, the loop opens it
+ *              again once the gateway is back.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+static void emuHangUp( void )
+{
+  printf("%s hung up, opening it again\n", emuDevicePath);
+  zbSocTransportClose();
+  emuPortOpen = FALSE;
+  emuNextOpen = emuNow() + EMU_REOPEN_MS;
+}
+
+/*********************************************************************
+ * @fn          emuFinishFrame
+ *
+ * @brief       Fills in the header and the FCS of a frame, the payload
+ *              is in place from frame[4].
+ *
+ * @param       frame - MT frame
+ * @param       cmd0 - CMD0
+ * @param       cmd1 - CMD1
+ * @param       len - length of the payload
+ *
+ * @return      length of the frame
+ */
+static uint16_t emuFinishFrame( uint8_t *frame, uint8_t cmd0, uint8_t cmd1, uint8_t len )
+{
+  uint8_t fcs = 0;
+  uint16_t i;
+
+  frame[0] = ZBSOC_MT_SOF;
+  frame[1] = len;
+  frame[2] = cmd0;
+  frame[3] = cmd1;
+
+  for (i = 1; i < (len + 4); i++)
+  {
+    fcs ^= frame[i];
+  }
+  frame[len + 4] = fcs;
+
+  return len + ZBSOC_MT_FRAME_OVERHEAD;
+}
+
+/*********************************************************************
+ * @fn          emuSend
+ *
+ * @brief       Sends a frame to the gateway.
+ *
+ * @param       cmd0 - CMD0
+ * @param       cmd1 - CMD1
+ * @param       payload - payload
+ * @param       len - length of the payload
+ *
+ * @return      none
+ */
+static void emuSend( uint8_t cmd0, uint8_t cmd1, uint8_t *payload, uint8_t len )
+{
+  uint8_t frame[ZBSOC_MT_MAX_PAYLOAD + ZBSOC_MT_FRAME_OVERHEAD];
+
+  memcpy(&frame[4], payload, len);
+  emuWrite(frame, emuFinishFrame(frame, cmd0, cmd1, len));
+}
+
+/*********************************************************************
+ * @fn          emuProcessFrame
+ *
+ * @brief       Processes a frame from the gateway. An SREQ the SoC does
+ *              not support is answered with the RES0 SRSP, as ZNP does.
+ *
+ * @param       frame - MT frame, from the SOF to the FCS
+ * @param       len - length of the frame
+ *
+ * @return      none
+ */
+static void emuProcessFrame( uint8_t *frame, uint16_t len )
+{
+  uint8_t cmd0 = frame[2], cmd1 = frame[3], payloadLen = frame[1];
+  uint8_t *payload = &frame[4];
+  uint8_t handled = FALSE, err = EMU_MT_ERR_COMMAND_ID;
+
+  emuStats.framesIn++;
+
+  //the gateway is up, the network comes up with it
+  if (!emuJoinsStarted)
+  {
+    emuJoinsStarted = TRUE;
+    emuJoinNodes();
+  }
+
+  //the bootloader knows no other frames
+  if (emuSblActive)
+  {
+    if (cmd0 == EMU_SBL_CMD0)
+    {
+      emuProcessSbl(cmd1, payload, payloadLen);
+    }
+    return;
+  }
+
+  switch (cmd0 & EMU_MT_SUBSYSTEM_MASK)
+  {
+    case EMU_MT_SYS_SYS:
+      handled = emuProcessSys(cmd1, payload, payloadLen);
+      break;
+    case EMU_MT_SYS_UTIL:
+      handled = emuProcessUtil(cmd1, payload, payloadLen);
+      break;
+    case EMU_MT_SYS_NWK:
+      handled = emuProcessNwk(cmd1, payload, payloadLen);
+      break;
+    case EMU_MT_SYS_ZDO:
+      handled = emuProcessZdo(cmd1, payload, payloadLen);
+      break;
+    case EMU_MT_SYS_APP:
+      handled = emuProcessApp(cmd1, payload, payloadLen);
+      break;
+    default:
+      err = EMU_MT_ERR_SUBSYSTEM;
+      break;
+  }
+
+  if ((cmd0 & EMU_MT_TYPE_MASK) == EMU_MT_SREQ)
+  {
+    emuStats.sreqs++;
+
+    if (!handled)
+    {
+      uint8_t rsp[] = { err, cmd0, cmd1 };
+
+      emuSend(EMU_MT_SRSP | EMU_MT_SYS_RES0, 0x00, rsp, sizeof(rsp));
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn          emuProcessSys
+ *
+ * @brief       SYS requests. A reset with the bootloader flag waits
+ *              for the SBL handshake, any other reset is indicated.
+ *
+ * @param       cmd1 - CMD1
+ * @param       payload - payload
+ * @param       len - length of the payload
+ *
+ * @return      TRUE if handled
+ */
+static uint8_t emuProcessSys( uint8_t cmd1, uint8_t *payload, uint8_t len )
+{
+  switch (cmd1)
+  {
+    case EMU_SYS_PING:
+    {
+      //MT capabilities: SYS, MAC, NWK, AF, ZDO, SAPI, UTIL and APP
+      uint8_t rsp[] = { 0x79, 0x01 };
+
+      emuSend(EMU_MT_SRSP | EMU_MT_SYS_SYS, cmd1, rsp, sizeof(rsp));
+      return TRUE;
+    }
+
+    case EMU_SYS_OSAL_NV_WRITE:
+    {
+      uint8_t status = (len >= 4) ? 0 : 1;
+
+      emuSend(EMU_MT_SRSP | EMU_MT_SYS_SYS, cmd1, &status, 1);
+      return TRUE;
+    }
+
+    case EMU_SYS_RESET_REQ:
+      if ((len >= 1) && (payload[0] == 0x01))
+      {
+        printf("SBL: waiting for the handshake\n");
+        emuSblActive = TRUE;
+        memset(emuFlash, 0xFF, sizeof(emuFlash));
+        emuFlashEnd = 0;
+      }
+      else
+      {
+        //reason, transport rev, product, major, minor and hw rev
+        uint8_t ind[] = { 0x00, 0x02, 0x00, 0x02, 0x05, 0x01 };
+
+        emuSend(EMU_MT_AREQ | EMU_MT_SYS_SYS, EMU_SYS_RESET_IND, ind, sizeof(ind));
+      }
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/*********************************************************************
+ * @fn          emuProcessUtil
+ *
+ * @brief       UTIL requests.
+ *
+ * @param       cmd1 - CMD1
+ * @param       payload - payload
+ * @param       len - length of the payload
+ *
+ * @return      TRUE if handled
+ */
+static uint8_t emuProcessUtil( uint8_t cmd1, uint8_t *payload, uint8_t len )
+{
+  if (cmd1 == EMU_UTIL_GET_DEVICE_INFO)
+  {
+    //status, IEEE addr, nwk addr, device type, device state and no associated devices
+    uint8_t rsp[14] = { 0 };
+
+    memcpy(&rsp[1], emuIeeeAddr, sizeof(emuIeeeAddr));
+    rsp[11] = 0x07; //coordinator, router and end device capable
+    rsp[12] = 0x09; //started as the coordinator
+    emuSend(EMU_MT_SRSP | EMU_MT_SYS_UTIL, cmd1, rsp, sizeof(rsp));
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+/*********************************************************************
+ * @fn          emuProcessNwk
+ *
+ * @brief       NWK requests, a leave request removes the node.
+ *
+ * @param       cmd1 - CMD1
+ * @param       payload - payload
+ * @param       len - length of the payload
+ *
+ * @return      TRUE if handled
+ */
+static uint8_t emuProcessNwk( uint8_t cmd1, uint8_t *payload, uint8_t len )
+{
+  if ((cmd1 == EMU_NLME_LEAVE_REQ) && (len >= sizeof(emuIeeeAddr)))
+  {
+    uint32_t node = BUILD_UINT16(payload[0], payload[1]);
+
+    if ((payload[2] == 0x00) && (memcmp(&payload[3], &emuIeeeAddr[3], sizeof(emuIeeeAddr) - 3) == 0) &&
+        (node < emuNumNodes))
+    {
+      emuLeave(node);
+    }
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+/*********************************************************************
+ * @fn          emuProcessZdo
+ *
+ * @brief       ZDO requests, the bindings are accepted but the reports
+ *              go to the gateway anyway.
+ *
+ * @param       cmd1 - CMD1
+ * @param       payload - payload
+ * @param       len - length of the payload
+ *
+ * @return      TRUE if handled
+ */
+static uint8_t emuProcessZdo( uint8_t cmd1, uint8_t *payload, uint8_t len )
+{
+  if (cmd1 == EMU_ZDO_BIND_REQ)
+  {
+    uint8_t status = 0;
+
+    emuSend(EMU_MT_SRSP | EMU_MT_SYS_ZDO, cmd1, &status, 1);
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+/*********************************************************************
+ * @fn          emuProcessApp
+ *
+ * @brief       MT_APP_MSG, the SoC takes it with a status at once and
+ *              delivers the ZCL frame to the endpoints it is addressed
+ *              to, or runs the command of the SoC application.
+ *
+ * @param       cmd1 - CMD1
+ * @param       payload - payload
+ * @param       len - length of the payload
+ *
+ * @return      TRUE if handled
+ */
+static uint8_t emuProcessApp( uint8_t cmd1, uint8_t *payload, uint8_t len )
+{
+  uint16_t dstAddr, clusterId;
+  uint8_t appEp, dstEp, addrMode, zclLen, status = 0;
+  uint8_t *zcl;
+  uint32_t node, idx, last;
+
+  if (cmd1 != EMU_APP_MSG)
+  {
+    return FALSE;
+  }
+
+  //the data len counts the addr mode
+  if ((len < EMU_APP_MSG_HDR_LEN) || (payload[6] == 0) || ((payload[6] - 1) > (len - EMU_APP_MSG_HDR_LEN)))
+  {
+    status = 1;
+  }
+  emuSend(EMU_MT_SRSP | EMU_MT_SYS_APP, cmd1, &status, 1);
+  if (status != 0)
+  {
+    return TRUE;
+  }
+
+  emuStats.appMsgs++;
+
+  appEp = payload[0];
+  dstAddr = BUILD_UINT16(payload[1], payload[2]);
+  dstEp = payload[3];
+  clusterId = BUILD_UINT16(payload[4], payload[5]);
+  zclLen = payload[6] - 1;
+  addrMode = payload[7];
+  zcl = &payload[EMU_APP_MSG_HDR_LEN];
+
+  if (clusterId == EMU_APP_RPC_CLUSTER)
+  {
+    //2 dummy bytes, then the command
+    if ((zclLen >= 3) && (zcl[2] == EMU_APP_RPC_CMD_PERMIT_JOIN))
+    {
+      emuJoinNodes();
+    }
+    return TRUE;
+  }
+
+  if (addrMode == EMU_ADDR_16BIT)
+  {
+    node = dstAddr - EMU_FIRST_NWK_ADDR;
+    if ((dstAddr < EMU_FIRST_NWK_ADDR) || (node >= emuNumNodes) || (emuNodes[node] != EMU_NODE_JOINED))
+    {
+      return TRUE;
+    }
+
+    last = (node + 1) * emuEpsPerNode;
+    for (idx = node * emuEpsPerNode; (idx < last) && (idx < emuNumEps); idx++)
+    {
+      if ((dstEp == EMU_BROADCAST_EP) || (dstEp == ((idx % emuEpsPerNode) + 1)))
+      {
+        emuZclRequest(idx, appEp, clusterId, zcl, zclLen, dstEp != EMU_BROADCAST_EP);
+      }
+    }
+  }
+  else if ((addrMode == EMU_ADDR_GROUP) || (addrMode == EMU_ADDR_BROADCAST))
+  {
+    for (idx = 0; idx < emuNumEps; idx++)
+    {
+      if ((emuNodes[idx / emuEpsPerNode] == EMU_NODE_JOINED) &&
+          (((addrMode == EMU_ADDR_GROUP) && (emuFindGroup(&emuEps[idx], dstAddr) >= 0)) ||
+           ((addrMode == EMU_ADDR_BROADCAST) &&
+            ((dstEp == EMU_BROADCAST_EP) || (dstEp == ((idx % emuEpsPerNode) + 1))))))
+      {
+        emuZclRequest(idx, appEp, clusterId, zcl, zclLen, FALSE);
+      }
+    }
+  }
+
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn          emuProcessSbl
+ *
+ * @brief       SBL requests, the image is written to and read back from
+ *              the emulated flash.
+ *
+ * @param       cmd1 - CMD1
+ * @param       payload - payload
+ * @param       len - length of the payload
+ *
+ * @return      none
+ */
+static void emuProcessSbl( uint8_t cmd1, uint8_t *payload, uint8_t len )
+{
+  //status, word addr and block of a read
+  uint8_t rsp[3 + EMU_SBL_BLOCK_SIZE];
+  uint8_t rspLen = 1;
+  uint32_t addr = (len >= 2) ? (BUILD_UINT16(payload[0], payload[1]) * 4) : EMU_FLASH_SIZE;
+
+  rsp[0] = EMU_SB_SUCCESS;
+
+  switch (cmd1)
+  {
+    case EMU_SB_HANDSHAKE_CMD:
+      break;
+
+    case EMU_SB_WRITE_CMD:
+      if ((len < (2 + EMU_SBL_BLOCK_SIZE)) || ((addr + EMU_SBL_BLOCK_SIZE) > EMU_FLASH_SIZE))
+      {
+        rsp[0] = EMU_SB_FAILURE;
+        break;
+      }
+      memcpy(&emuFlash[addr], &payload[2], EMU_SBL_BLOCK_SIZE);
+      if ((addr + EMU_SBL_BLOCK_SIZE) > emuFlashEnd)
+      {
+        emuFlashEnd = addr + EMU_SBL_BLOCK_SIZE;
+      }
+      emuStats.sblWrites++;
+      break;
+
+    case EMU_SB_READ_CMD:
+      if ((addr + EMU_SBL_BLOCK_SIZE) > EMU_FLASH_SIZE)
+      {
+        rsp[0] = EMU_SB_FAILURE;
+        break;
+      }
+      rsp[1] = payload[0];
+      rsp[2] = payload[1];
+      memcpy(&rsp[3], &emuFlash[addr], EMU_SBL_BLOCK_SIZE);
+      rspLen = sizeof(rsp);
+      emuStats.sblReads++;
+      break;
+
+    case EMU_SB_ENABLE_CMD:
+      emuSend(EMU_SBL_CMD0, cmd1 | EMU_SB_RESPONSE, rsp, rspLen);
+      emuSblRun();
+      return;
+
+    default:
+      return;
+  }
+
+  emuSend(EMU_SBL_CMD0, cmd1 | EMU_SB_RESPONSE, rsp, rspLen);
+}
+
+/*********************************************************************
+ * @fn          emuSblRun
+ *
+ * @brief       Leaves the bootloader for the image, which resets the
+ *              SoC. The network is kept, as it is in NV.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+static void emuSblRun( void )
+{
+  //reason, transport rev, product, major, minor and hw rev
+  uint8_t ind[] = { 0x00, 0x02, 0x00, 0x02, 0x05, 0x01 };
+  uint32_t sum = 0, i;
+  FILE *file;
+
+  emuSblActive = FALSE;
+
+  for (i = 0; i < emuFlashEnd; i++)
+  {
+    sum += emuFlash[i];
+  }
+  printf("SBL: running the image, %u bytes, sum %08X\n", emuFlashEnd, sum);
+
+  if ((emuImagePath != NULL) && (emuFlashEnd > 0))
+  {
+    file = fopen(emuImagePath, "wb");
+    if ((file == NULL) || (fwrite(emuFlash, 1, emuFlashEnd, file) != emuFlashEnd))
+    {
+      perror(emuImagePath);
+    }
+    if (file != NULL)
+    {
+      fclose(file);
+    }
+  }
+
+  emuSend(EMU_MT_AREQ | EMU_MT_SYS_SYS, EMU_SYS_RESET_IND, ind, sizeof(ind));
+}
+
+/*********************************************************************
+ * @fn          emuZclRequest
+ *
+ * @brief       Delivers a ZCL frame to an endpoint and sends its
+ *              response after the latency of the endpoint. A default
+ *              response is only sent to a unicast.
+ *
+ * @param       epIdx - endpoint
+ * @param       appEp - endpoint of the SoC the frame was sent from
+ * @param       clusterId - cluster of the frame
+ * @param       zcl - ZCL frame
+ * @param       zclLen - length of the ZCL frame
+ * @param       unicast - TRUE if the frame was sent to the endpoint only
+ *
+ * @return      none
+ */
+static void emuZclRequest( uint32_t epIdx, uint8_t appEp, uint16_t clusterId, uint8_t *zcl, uint8_t zclLen, uint8_t unicast )
+{
+  emuEp_t *ep = &emuEps[epIdx];
+  uint8_t frameControl, hdrLen = 3, tsn, commandId, status;
+  emuZclRsp_t rsp;
+
+  if (zclLen < 3)
+  {
+    return;
+  }
+
+  frameControl = zcl[0];
+  if (frameControl & ZCL_FRAME_CONTROL_MANU_SPECIFIC)
+  {
+    hdrLen += 2;
+    if (zclLen < hdrLen)
+    {
+      return;
+    }
+  }
+  tsn = zcl[hdrLen - 2];
+  commandId = zcl[hdrLen - 1];
+
+  emuStats.zclRequests++;
+  if (emuLost(ep))
+  {
+    emuStats.lostDown++;
+    return;
+  }
+
+  rsp.send = emuRspDefault;
+  rsp.len = 0;
+
+  if (frameControl & ZCL_FRAME_CONTROL_MANU_SPECIFIC)
+  {
+    status = ((frameControl & ZCL_FRAME_CONTROL_TYPE) == ZCL_FRAME_TYPE_PROFILE_CMD) ?
+      EMU_ZCL_STATUS_UNSUP_MANU_GENERAL_COMMAND : EMU_ZCL_STATUS_UNSUP_MANU_CLUSTER_COMMAND;
+  }
+  else if ((frameControl & ZCL_FRAME_CONTROL_TYPE) == ZCL_FRAME_TYPE_PROFILE_CMD)
+  {
+    status = emuZclFoundation(epIdx, clusterId, commandId, &zcl[hdrLen], zclLen - hdrLen, &rsp);
+  }
+  else if ((frameControl & ZCL_FRAME_CONTROL_DIRECTION) == 0)
+  {
+    status = emuZclCluster(ep, clusterId, commandId, &zcl[hdrLen], zclLen - hdrLen, &rsp);
+
+    //responses to cluster commands are not sent to a group or broadcast
+    if (!unicast)
+    {
+      rsp.send = emuRspNone;
+    }
+  }
+  else
+  {
+    status = EMU_ZCL_STATUS_UNSUP_CLUSTER_COMMAND;
+  }
+
+  if (rsp.send == emuRspFrame)
+  {
+    emuSendZcl(epIdx, appEp, clusterId, EMU_ZCL_FC_SERVER | rsp.type, tsn, rsp.cmd, rsp.buf, rsp.len, ep->latencyMs);
+    emuStats.zclRsps++;
+  }
+  else if ((rsp.send == emuRspDefault) && unicast &&
+           ((status != ZCL_STATUS_SUCCESS) || !(frameControl & ZCL_FRAME_CONTROL_DISABLE_DEFAULT_RSP)))
+  {
+    uint8_t payload[] = { commandId, status };
+
+    emuSendZcl(epIdx, appEp, clusterId, EMU_ZCL_FC_SERVER | ZCL_FRAME_TYPE_PROFILE_CMD, tsn,
+      ZCL_CMD_DEFAULT_RSP, payload, sizeof(payload), ep->latencyMs);
+    emuStats.zclRsps++;
+  }
+}
+
+/*********************************************************************
+ * @fn          emuZclFoundation
+ *
+ * @brief       Foundation commands: read, write and configure reporting.
+ *
+ * @param       epIdx - endpoint
+ * @param       clusterId - cluster of the command
+ * @param       commandId - command
+ * @param       buf - ZCL payload
+ * @param       len - length of the payload
+ * @param       rsp - the response
+ *
+ * @return      status of a default response
+ */
+static uint8_t emuZclFoundation( uint32_t epIdx, uint16_t clusterId, uint8_t commandId, uint8_t *buf, uint8_t len, emuZclRsp_t *rsp )
+{
+  emuEp_t *ep = &emuEps[epIdx];
+
+  if (!emuHasCluster(ep, clusterId))
+  {
+    return EMU_ZCL_STATUS_UNSUPPORTED_CLUSTER;
+  }
+
+  switch (commandId)
+  {
+    case ZCL_CMD_READ:
+      emuZclRead(ep, clusterId, buf, len, rsp);
+      break;
+
+    case ZCL_CMD_WRITE:
+    case ZCL_CMD_WRITE_UNDIVIDED:
+    case ZCL_CMD_WRITE_NO_RSP:
+      emuZclWrite(ep, clusterId, commandId, buf, len, rsp);
+      break;
+
+    case ZCL_CMD_CONFIG_REPORT:
+      emuZclConfigReport(epIdx, clusterId, buf, len, rsp);
+      break;
+
+    default:
+      return EMU_ZCL_STATUS_UNSUP_GENERAL_COMMAND;
+  }
+
+  return ZCL_STATUS_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn          emuZclRead
+ *
+ * @brief       Read attributes, the records that do not fit the response
+ *              are left out.
+ *
+ * @param       ep - endpoint
+ * @param       clusterId - cluster of the attributes
+ * @param       buf - attribute ids
+ * @param       len - length of the ids
+ * @param       rsp - read attributes response
+ *
+ * @return      none
+ */
+static void emuZclRead( emuEp_t *ep, uint16_t clusterId, uint8_t *buf, uint8_t len, emuZclRsp_t *rsp )
+{
+  const emuAttr_t *attr;
+  uint16_t attrId;
+  int32_t valueLen;
+  uint8_t i;
+
+  for (i = 0; (i + 1) < len; i += 2)
+  {
+    attrId = BUILD_UINT16(buf[i], buf[i + 1]);
+    attr = emuFindAttr(ep, clusterId, attrId);
+    valueLen = (attr != NULL) ? zbSocZclDataTypeLen(attr->dataType) : 0;
+
+    if ((rsp->len + 3 + ((attr != NULL) ? (1 + valueLen) : 0)) > sizeof(rsp->buf))
+    {
+      break;
+    }
+
+    rsp->buf[rsp->len++] = attrId & 0x00ff;
+    rsp->buf[rsp->len++] = (attrId & 0xff00) >> 8;
+    if (attr == NULL)
+    {
+      rsp->buf[rsp->len++] = EMU_ZCL_STATUS_UNSUPPORTED_ATTRIBUTE;
+      continue;
+    }
+    rsp->buf[rsp->len++] = ZCL_STATUS_SUCCESS;
+    rsp->buf[rsp->len++] = attr->dataType;
+    emuPutValue(&rsp->buf[rsp->len], emuGetAttr(ep, attr), valueLen);
+    rsp->len += valueLen;
+  }
+
+  rsp->send = emuRspFrame;
+  rsp->type = ZCL_FRAME_TYPE_PROFILE_CMD;
+  rsp->cmd = ZCL_CMD_READ_RSP;
+}
+
+/*********************************************************************
+ * @fn          emuZclWrite
+ *
+ * @brief       Write attributes. The records are checked on the first
+ *              pass and written on the second, an undivided write only
+ *              if all of them can be.
+ *
+ * @param       ep - endpoint
+ * @param       clusterId - cluster of the attributes
+ * @param       commandId - write, undivided write or write no response
+ * @param       buf - write attribute records
+ * @param       len - length of the records
+ * @param       rsp - write attributes response
+ *
+ * @return      none
+ */
+static void emuZclWrite( emuEp_t *ep, uint16_t clusterId, uint8_t commandId, uint8_t *buf, uint8_t len, emuZclRsp_t *rsp )
+{
+  const emuAttr_t *attr;
+  uint16_t attrId;
+  int32_t valueLen;
+  uint8_t pass, i, status, dataType, failed = FALSE;
+
+  for (pass = 0; pass < 2; pass++)
+  {
+    rsp->len = 0;
+
+    for (i = 0; (i + 3) <= len; i += 3 + valueLen)
+    {
+      attrId = BUILD_UINT16(buf[i], buf[i + 1]);
+      dataType = buf[i + 2];
+      valueLen = zbSocZclDataTypeLen(dataType);
+
+      //the emulated attributes all have a fixed length
+      if ((valueLen < 0) || ((i + 3 + valueLen) > len))
+      {
+        break;
+      }
+
+      attr = emuFindAttr(ep, clusterId, attrId);
+      if (attr == NULL)
+      {
+        status = EMU_ZCL_STATUS_UNSUPPORTED_ATTRIBUTE;
+      }
+      else if (attr->dataType != dataType)
+      {
+        status = EMU_ZCL_STATUS_INVALID_DATA_TYPE;
+      }
+      else if (!(attr->access & EMU_ATTR_WRITABLE))
+      {
+        status = EMU_ZCL_STATUS_READ_ONLY;
+      }
+      else
+      {
+        status = ZCL_STATUS_SUCCESS;
+      }
+
+      if (status != ZCL_STATUS_SUCCESS)
+      {
+        failed = TRUE;
+        if ((rsp->len + 3) <= sizeof(rsp->buf))
+        {
+          rsp->buf[rsp->len++] = status;
+          rsp->buf[rsp->len++] = attrId & 0x00ff;
+          rsp->buf[rsp->len++] = (attrId & 0xff00) >> 8;
+        }
+      }
+      else if ((pass == 1) && (!failed || (commandId != ZCL_CMD_WRITE_UNDIVIDED)))
+      {
+        ep->values[attr->val] = emuGetValue(&buf[i + 3], valueLen, dataType);
+      }
+    }
+  }
+
+  //one success status if all were written
+  if (rsp->len == 0)
+  {
+    rsp->buf[rsp->len++] = ZCL_STATUS_SUCCESS;
+  }
+
+  rsp->send = (commandId == ZCL_CMD_WRITE_NO_RSP) ? emuRspNone : emuRspFrame;
+  rsp->type = ZCL_FRAME_TYPE_PROFILE_CMD;
+  rsp->cmd = ZCL_CMD_WRITE_RSP;
+}
+
+/*********************************************************************
+ * @fn          emuZclConfigReport
+ *
+ * @brief       Configure reporting. An endpoint has one report interval
+ *              for its reportable attributes, the max interval of the
+ *              last record sets it.
+ *
+ * @param       epIdx - endpoint
+ * @param       clusterId - cluster of the attributes
+ * @param       buf - attribute reporting configuration records
+ * @param       len - length of the records
+ * @param       rsp - configure reporting response
+ *
+ * @return      none
+ */
+static void emuZclConfigReport( uint32_t epIdx, uint16_t clusterId, uint8_t *buf, uint8_t len, emuZclRsp_t *rsp )
+{
+  emuEp_t *ep = &emuEps[epIdx];
+  const emuAttr_t *attr;
+  uint16_t attrId;
+  int32_t changeLen;
+  uint8_t i = 0, direction, dataType, status;
+
+  while ((i + 3) <= len)
+  {
+    direction = buf[i];
+    attrId = BUILD_UINT16(buf[i + 1], buf[i + 2]);
+
+    //the timeout of the reports the device would receive
+    if (direction != 0)
+    {
+      i += 5;
+      continue;
+    }
+
+    if ((i + 8) > len)
+    {
+      break;
+    }
+    dataType = buf[i + 3];
+    changeLen = zbSocZclIsAnalog(dataType) ? zbSocZclDataTypeLen(dataType) : 0;
+    if (changeLen < 0)
+    {
+      break;
+    }
+
+    attr = emuFindAttr(ep, clusterId, attrId);
+    if (attr == NULL)
+    {
+      status = EMU_ZCL_STATUS_UNSUPPORTED_ATTRIBUTE;
+    }
+    else if (!(attr->access & EMU_ATTR_REPORTABLE))
+    {
+      status = EMU_ZCL_STATUS_UNREPORTABLE_ATTRIBUTE;
+    }
+    else if (attr->dataType != dataType)
+    {
+      status = EMU_ZCL_STATUS_INVALID_DATA_TYPE;
+    }
+    else
+    {
+      status = ZCL_STATUS_SUCCESS;
+      emuSetReporting(epIdx, BUILD_UINT16(buf[i + 6], buf[i + 7]));
+    }
+
+    if ((status != ZCL_STATUS_SUCCESS) && ((rsp->len + 4) <= sizeof(rsp->buf)))
+    {
+      rsp->buf[rsp->len++] = status;
+      rsp->buf[rsp->len++] = direction;
+      rsp->buf[rsp->len++] = attrId & 0x00ff;
+      rsp->buf[rsp->len++] = (attrId & 0xff00) >> 8;
+    }
+
+    i += 8 + changeLen;
+  }
+
+  if (rsp->len == 0)
+  {
+    rsp->buf[rsp->len++] = ZCL_STATUS_SUCCESS;
+  }
+
+  rsp->send = emuRspFrame;
+  rsp->type = ZCL_FRAME_TYPE_PROFILE_CMD;
+  rsp->cmd = ZCL_CMD_CONFIG_REPORT_RSP;
+}
+
+/*********************************************************************
+ * @fn          emuZclCluster
+ *
+ * @brief       Cluster commands of on/off, level, color, groups, scenes
+ *              and identify. A change takes effect at once, the
+ *              transition time is not emulated.
+ *
+ * @param       ep - endpoint
+ * @param       clusterId - cluster of the command
+ * @param       commandId - command
+ * @param       buf - ZCL payload
+ * @param       len - length of the payload
+ * @param       rsp - response of a command that has one
+ *
+ * @return      status of a default response
+ */
+static uint8_t emuZclCluster( emuEp_t *ep, uint16_t clusterId, uint8_t commandId, uint8_t *buf, uint8_t len, emuZclRsp_t *rsp )
+{
+  int32_t *values = ep->values;
+
+  if (!emuHasCluster(ep, clusterId))
+  {
+    return EMU_ZCL_STATUS_UNSUPPORTED_CLUSTER;
+  }
+
+  switch (clusterId)
+  {
+    case ZCL_CLUSTER_ID_GEN_ON_OFF:
+      if (commandId == COMMAND_OFF)
+      {
+        values[emuValOn] = 0;
+      }
+      else if (commandId == COMMAND_ON)
+      {
+        values[emuValOn] = 1;
+      }
+      else if (commandId == EMU_COMMAND_TOGGLE)
+      {
+        values[emuValOn] = !values[emuValOn];
+      }
+      else
+      {
+        break;
+      }
+      return ZCL_STATUS_SUCCESS;
+
+    case ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL:
+      if ((commandId != COMMAND_LEVEL_MOVE_TO_LEVEL) && (commandId != EMU_COMMAND_LEVEL_MOVE_TO_LEVEL_WITH_ON_OFF))
+      {
+        break;
+      }
+      if (len < 1)
+      {
+        return EMU_ZCL_STATUS_MALFORMED_COMMAND;
+      }
+      values[emuValLevel] = buf[0];
+      if (commandId == EMU_COMMAND_LEVEL_MOVE_TO_LEVEL_WITH_ON_OFF)
+      {
+        values[emuValOn] = (buf[0] > 0);
+      }
+      return ZCL_STATUS_SUCCESS;
+
+    case ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL:
+      if ((commandId != COMMAND_LIGHTING_MOVE_TO_HUE) && (commandId != COMMAND_LIGHTING_MOVE_TO_SATURATION) &&
+          (commandId != COMMAND_LIGHTING_MOVE_TO_HUE_AND_SATURATION))
+      {
+        break;
+      }
+      if ((len < 1) || ((commandId == COMMAND_LIGHTING_MOVE_TO_HUE_AND_SATURATION) && (len < 2)))
+      {
+        return EMU_ZCL_STATUS_MALFORMED_COMMAND;
+      }
+      if (commandId == COMMAND_LIGHTING_MOVE_TO_SATURATION)
+      {
+        values[emuValSat] = buf[0];
+      }
+      else
+      {
+        values[emuValHue] = buf[0];
+        if (commandId == COMMAND_LIGHTING_MOVE_TO_HUE_AND_SATURATION)
+        {
+          values[emuValSat] = buf[1];
+        }
+      }
+      return ZCL_STATUS_SUCCESS;
+
+    case ZCL_CLUSTER_ID_GEN_GROUPS:
+      return emuZclGroups(ep, commandId, buf, len, rsp);
+
+    case ZCL_CLUSTER_ID_GEN_SCENES:
+      return emuZclScenes(ep, commandId, buf, len, rsp);
+
+    case ZCL_CLUSTER_ID_GEN_IDENTIFY:
+      if (commandId != EMU_COMMAND_IDENTIFY)
+      {
+        break;
+      }
+      if (len < 2)
+      {
+        return EMU_ZCL_STATUS_MALFORMED_COMMAND;
+      }
+      values[emuValIdentify] = BUILD_UINT16(buf[0], buf[1]);
+      return ZCL_STATUS_SUCCESS;
+  }
+
+  return EMU_ZCL_STATUS_UNSUP_CLUSTER_COMMAND;
+}
+
+/*********************************************************************
+ * @fn          emuZclGroups
+ *
+ * @brief       Groups cluster commands, an endpoint is in up to
+ *              EMU_MAX_GROUPS groups.
+ *
+ * @param       ep - endpoint
+ * @param       commandId - command
+ * @param       buf - ZCL payload
+ * @param       len - length of the payload
+ * @param       rsp - add or remove group response
+ *
+ * @return      status of a default response
+ */
+static uint8_t emuZclGroups( emuEp_t *ep, uint8_t commandId, uint8_t *buf, uint8_t len, emuZclRsp_t *rsp )
+{
+  uint16_t groupId;
+  int32_t idx;
+  uint8_t status;
+
+  if (commandId == EMU_COMMAND_GROUP_REMOVE_ALL)
+  {
+    ep->numGroups = 0;
+    return ZCL_STATUS_SUCCESS;
+  }
+
+  if ((commandId != EMU_COMMAND_GROUP_ADD) && (commandId != EMU_COMMAND_GROUP_REMOVE))
+  {
+    return EMU_ZCL_STATUS_UNSUP_CLUSTER_COMMAND;
+  }
+
+  if (len < 2)
+  {
+    return EMU_ZCL_STATUS_MALFORMED_COMMAND;
+  }
+
+  groupId = BUILD_UINT16(buf[0], buf[1]);
+  idx = emuFindGroup(ep, groupId);
+
+  if (commandId == EMU_COMMAND_GROUP_ADD)
+  {
+    if (idx >= 0)
+    {
+      status = EMU_ZCL_STATUS_DUPLICATE_EXISTS;
+    }
+    else if (ep->numGroups == EMU_MAX_GROUPS)
+    {
+      status = EMU_ZCL_STATUS_INSUFFICIENT_SPACE;
+    }
+    else
+    {
+      ep->groups[ep->numGroups++] = groupId;
+      status = ZCL_STATUS_SUCCESS;
+    }
+  }
+  else
+  {
+    if (idx < 0)
+    {
+      status = EMU_ZCL_STATUS_NOT_FOUND;
+    }
+    else
+    {
+      ep->groups[idx] = ep->groups[--ep->numGroups];
+      status = ZCL_STATUS_SUCCESS;
+    }
+  }
+
+  //status and group
+  rsp->buf[0] = status;
+  rsp->buf[1] = buf[0];
+  rsp->buf[2] = buf[1];
+  rsp->len = 3;
+  rsp->send = emuRspFrame;
+  rsp->type = ZCL_FRAME_TYPE_SPECIFIC_CMD;
+  rsp->cmd = commandId;
+
+  return status;
+}
+
+/*********************************************************************
+ * @fn          emuZclScenes
+ *
+ * @brief       Scenes cluster commands, an endpoint holds one scene of
+ *              its on/off, level, hue and sat.
+ *
+ * @param       ep - endpoint
+ * @param       commandId - command
+ * @param       buf - ZCL payload
+ * @param       len - length of the payload
+ * @param       rsp - store scene response
+ *
+ * @return      status of a default response
+ */
+static uint8_t emuZclScenes( emuEp_t *ep, uint8_t commandId, uint8_t *buf, uint8_t len, emuZclRsp_t *rsp )
+{
+  uint16_t groupId;
+  uint8_t sceneId, status = ZCL_STATUS_SUCCESS;
+
+  if ((commandId != EMU_COMMAND_SCENE_STORE) && (commandId != EMU_COMMAND_SCENE_RECALL))
+  {
+    return EMU_ZCL_STATUS_UNSUP_CLUSTER_COMMAND;
+  }
+
+  if (len < 3)
+  {
+    return EMU_ZCL_STATUS_MALFORMED_COMMAND;
+  }
+
+  groupId = BUILD_UINT16(buf[0], buf[1]);
+  sceneId = buf[2];
+
+  if (commandId == EMU_COMMAND_SCENE_RECALL)
+  {
+    if ((!ep->sceneValid) || (ep->sceneGroup != groupId) || (ep->sceneId != sceneId))
+    {
+      return EMU_ZCL_STATUS_NOT_FOUND;
+    }
+    memcpy(ep->values, ep->scene, sizeof(ep->scene));
+    return ZCL_STATUS_SUCCESS;
+  }
+
+  //a scene of a group the endpoint is not in
+  if ((groupId != 0) && (emuFindGroup(ep, groupId) < 0))
+  {
+    status = EMU_ZCL_STATUS_INVALID_FIELD;
+  }
+  else
+  {
+    memcpy(ep->scene, ep->values, sizeof(ep->scene));
+    ep->sceneGroup = groupId;
+    ep->sceneId = sceneId;
+    ep->sceneValid = TRUE;
+  }
+
+  //status, group and scene
+  rsp->buf[0] = status;
+  memcpy(&rsp->buf[1], buf, 3);
+  rsp->len = 4;
+  rsp->send = emuRspFrame;
+  rsp->type = ZCL_FRAME_TYPE_SPECIFIC_CMD;
+  rsp->cmd = commandId;
+
+  return status;
+}
+
+/*********************************************************************
+ * @fn          emuSendZcl
+ *
+ * @brief       Sends a ZCL frame of an endpoint to the gateway as an
+ *              MT_APP_RSP, unless it is lost.
+ *
+ * @param       epIdx - endpoint
+ * @param       appEp - endpoint of the SoC the frame is sent to
+ * @param       clusterId - cluster of the frame
+ * @param       frameControl - ZCL frame control
+ * @param       tsn - ZCL transaction sequence number
+ * @param       commandId - command
+ * @param       payload - ZCL payload
+ * @param       len - length of the payload, up to EMU_ZCL_MAX_PAYLOAD
+ * @param       delayMs - the frame is sent this much later
+ *
+ * @return      none
+ */
+static void emuSendZcl( uint32_t epIdx, uint8_t appEp, uint16_t clusterId, uint8_t frameControl, uint8_t tsn,
+                        uint8_t commandId, uint8_t *payload, uint8_t len, uint32_t delayMs )
+{
+  uint8_t frame[ZBSOC_MT_MAX_PAYLOAD + ZBSOC_MT_FRAME_OVERHEAD];
+  uint8_t *p = &frame[4];
+  uint16_t nwkAddr = EMU_FIRST_NWK_ADDR + (epIdx / emuEpsPerNode);
+  uint16_t frameLen;
+  uint8_t *delayed;
+
+  if (emuLost(&emuEps[epIdx]))
+  {
+    emuStats.lostUp++;
+    return;
+  }
+
+  *p++ = appEp;
+  *p++ = nwkAddr & 0x00ff;
+  *p++ = (nwkAddr & 0xff00) >> 8;
+  *p++ = (epIdx % emuEpsPerNode) + 1;
+  *p++ = clusterId & 0x00ff;
+  *p++ = (clusterId & 0xff00) >> 8;
+  *p++ = len + 3;
+  *p++ = frameControl;
+  *p++ = tsn;
+  *p++ = commandId;
+  memcpy(p, payload, len);
+
+  frameLen = emuFinishFrame(frame, EMU_MT_AREQ | EMU_MT_SYS_APP, EMU_APP_RSP, EMU_APP_RSP_HDR_LEN + 3 + len);
+
+  if (delayMs == 0)
+  {
+    emuWrite(frame, frameLen);
+    return;
+  }
+
+  delayed = malloc(frameLen);
+  if (delayed == NULL)
+  {
+    return;
+  }
+  memcpy(delayed, frame, frameLen);
+  emuEventPush(emuNowMs + delayMs, emuEvtFrame, 0, 0, delayed);
+}
+
+/*********************************************************************
+ * @fn          emuJoinNodes
+ *
+ * @brief       Lets the nodes that are not in the network join, one
+ *              after the other at the join rate.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+static void emuJoinNodes( void )
+{
+  uint32_t node, numJoins = 0;
+
+  for (node = 0; node < emuNumNodes; node++)
+  {
+    if (emuNodes[node] == EMU_NODE_LEFT)
+    {
+      emuNodes[node] = EMU_NODE_JOINING;
+      emuEventPush(emuNowMs + ((emuJoinRate > 0) ? ((numJoins * 1000ULL) / emuJoinRate) : 0),
+        emuEvtJoin, 0, node, NULL);
+      numJoins++;
+    }
+  }
+
+  if (numJoins > 0)
+  {
+    printf("%u nodes joining\n", numJoins);
+  }
+}
+
+/*********************************************************************
+ * @fn          emuJoin
+ *
+ * @brief       A node joins, every endpoint of it is indicated and its
+ *              reports start at a random point of its interval.
+ *
+ * @param       node - node
+ *
+ * @return      none
+ */
+static void emuJoin( uint32_t node )
+{
+  uint8_t ind[24];
+  uint16_t nwkAddr = EMU_FIRST_NWK_ADDR + node;
+  uint32_t idx, first = node * emuEpsPerNode, last = first + emuEpsPerNode;
+
+  if (emuNodes[node] != EMU_NODE_JOINING)
+  {
+    return;
+  }
+  emuNodes[node] = EMU_NODE_JOINED;
+  emuStats.joins++;
+
+  if (last > emuNumEps)
+  {
+    last = emuNumEps;
+  }
+
+  for (idx = first; idx < last; idx++)
+  {
+    emuEp_t *ep = &emuEps[idx];
+    uint16_t deviceId = emuKinds[ep->kind].deviceId;
+
+    //nwk addr, endpoint, profile, device, version, IEEE addr and flags
+    ind[0] = nwkAddr & 0x00ff;
+    ind[1] = (nwkAddr & 0xff00) >> 8;
+    ind[2] = (idx - first) + 1;
+    ind[3] = EMU_PROFILE_HA & 0x00ff;
+    ind[4] = (EMU_PROFILE_HA & 0xff00) >> 8;
+    ind[5] = deviceId & 0x00ff;
+    ind[6] = (deviceId & 0xff00) >> 8;
+    ind[7] = 0;
+    memcpy(&ind[8], emuIeeeAddr, sizeof(emuIeeeAddr));
+    ind[8] = node & 0x00ff;
+    ind[9] = (node & 0xff00) >> 8;
+    ind[10] = 0x00;
+    ind[16] = ((idx == first) ? EMU_NEW_DEV_FLAGS_FIRST : 0) | ((idx == (last - 1)) ? EMU_NEW_DEV_FLAGS_LAST : 0);
+    emuSend(EMU_MT_AREQ | EMU_MT_SYS_APP, EMU_APP_NEW_DEV_IND, ind, 17);
+
+    ep->reportGen++;
+    if (ep->reportS > 0)
+    {
+      emuEventPush(emuNowMs + emuRandom(0, (ep->reportS * 1000) - 1), emuEvtReport, ep->reportGen, idx, NULL);
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn          emuLeave
+ *
+ * @brief       A node leaves, it joins again on a permit join.
+ *
+ * @param       node - node
+ *
+ * @return      none
+ */
+static void emuLeave( uint32_t node )
+{
+  if (emuNodes[node] == EMU_NODE_JOINED)
+  {
+    emuStats.leaves++;
+  }
+
+  //a pending join is dropped as well
+  emuNodes[node] = EMU_NODE_LEFT;
+}
+
+/*********************************************************************
+ * @fn          emuReport
+ *
+ * @brief       An endpoint reports its reportable attributes, one frame
+ *              a cluster, or an IAS zone sends a zone status change
+ *              notification. The sensor values drift between reports.
+ *
+ * @param       epIdx - endpoint
+ *
+ * @return      none
+ */
+static void emuReport( uint32_t epIdx )
+{
+  emuEp_t *ep = &emuEps[epIdx];
+  const emuKind_t *kind = &emuKinds[ep->kind];
+  uint8_t buf[EMU_ZCL_MAX_PAYLOAD], len = 0, i;
+  uint16_t clusterId = 0;
+  int32_t valueLen;
+
+  if (kind->zone)
+  {
+    //alarm 1 toggles, the contact opens and closes
+    ep->values[emuValZoneStatus] ^= EMU_ZONE_STATUS_ALARM1;
+
+    //zone status, extended status, zone id and delay
+    buf[0] = ep->values[emuValZoneStatus] & 0x00ff;
+    buf[1] = (ep->values[emuValZoneStatus] & 0xff00) >> 8;
+    buf[2] = 0;
+    buf[3] = epIdx & 0xff;
+    buf[4] = 0;
+    buf[5] = 0;
+    emuSendZcl(epIdx, ZBSOC_APP_ENDPOINT, ZCL_CLUSTER_ID_SS_IAS_ZONE, EMU_ZCL_FC_SERVER | ZCL_FRAME_TYPE_SPECIFIC_CMD,
+      ep->tsn++, EMU_COMMAND_ZONE_STATUS_CHANGE, buf, 6, 0);
+    emuStats.zoneNotifs++;
+    return;
+  }
+
+  ep->values[emuValTemp] = emuDrift(ep->values[emuValTemp], 50, -1000, 4000);
+  ep->values[emuValHumid] = emuDrift(ep->values[emuValHumid], 100, 0, 10000);
+  ep->values[emuValDemand] = emuDrift(ep->values[emuValDemand], 20, 0, 10000);
+
+  for (i = 0; i <= kind->numAttrs; i++)
+  {
+    const emuAttr_t *attr = (i < kind->numAttrs) ? &kind->attrs[i] : NULL;
+
+    if ((attr != NULL) && !(attr->access & EMU_ATTR_REPORTABLE))
+    {
+      continue;
+    }
+
+    //the attributes of a cluster are next to each other in the table
+    if ((len > 0) && ((attr == NULL) || (attr->clusterId != clusterId)))
+    {
+      emuSendZcl(epIdx, ZBSOC_APP_ENDPOINT, clusterId, EMU_ZCL_FC_SERVER | ZCL_FRAME_TYPE_PROFILE_CMD,
+        ep->tsn++, ZCL_CMD_REPORT, buf, len, 0);
+      emuStats.reports++;
+      len = 0;
+    }
+
+    if (attr != NULL)
+    {
+      clusterId = attr->clusterId;
+      valueLen = zbSocZclDataTypeLen(attr->dataType);
+      buf[len++] = attr->attrId & 0x00ff;
+      buf[len++] = (attr->attrId & 0xff00) >> 8;
+      buf[len++] = attr->dataType;
+      emuPutValue(&buf[len], emuGetAttr(ep, attr), valueLen);
+      len += valueLen;
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn          emuSetReporting
+ *
+ * @brief       Sets the report interval of an endpoint, the next report
+ *              is a whole interval later.
+ *
+ * @param       epIdx - endpoint
+ * @param       maxInterval - in s, 0 and 0xFFFF stop the reports
+ *
+ * @return      none
+ */
+static void emuSetReporting( uint32_t epIdx, uint16_t maxInterval )
+{
+  emuEp_t *ep = &emuEps[epIdx];
+  uint16_t reportS = (maxInterval == 0xFFFF) ? 0 : maxInterval;
+
+  if (reportS == ep->reportS)
+  {
+    return;
+  }
+
+  ep->reportS = reportS;
+  ep->reportGen++;
+
+  if ((reportS > 0) && (emuNodes[epIdx / emuEpsPerNode] == EMU_NODE_JOINED))
+  {
+    emuEventPush(emuNowMs + (reportS * 1000ULL), emuEvtReport, ep->reportGen, epIdx, NULL);
+  }
+}
+
+/*********************************************************************
+ * @fn          emuFindAttr
+ *
+ * @brief       Attribute of an endpoint.
+ *
+ * @param       ep - endpoint
+ * @param       clusterId - cluster
+ * @param       attrId - attribute
+ *
+ * @return      the attribute, NULL if the endpoint has none
+ */
+static const emuAttr_t *emuFindAttr( emuEp_t *ep, uint16_t clusterId, uint16_t attrId )
+{
+  const emuKind_t *kind = &emuKinds[ep->kind];
+  uint8_t i;
+
+  for (i = 0; i < (sizeof(emuCommonAttrs) / sizeof(emuCommonAttrs[0])); i++)
+  {
+    if ((emuCommonAttrs[i].clusterId == clusterId) && (emuCommonAttrs[i].attrId == attrId))
+    {
+      return &emuCommonAttrs[i];
+    }
+  }
+
+  for (i = 0; i < kind->numAttrs; i++)
+  {
+    if ((kind->attrs[i].clusterId == clusterId) && (kind->attrs[i].attrId == attrId))
+    {
+      return &kind->attrs[i];
+    }
+  }
+
+  return NULL;
+}
+
+/*********************************************************************
+ * @fn          emuHasCluster
+ *
+ * @brief       Server clusters of an endpoint, the ones of its
+ *              attributes plus groups and scenes.
+ *
+ * @param       ep - endpoint
+ * @param       clusterId - cluster
+ *
+ * @return      TRUE if the endpoint has the cluster
+ */
+static uint8_t emuHasCluster( emuEp_t *ep, uint16_t clusterId )
+{
+  const emuKind_t *kind = &emuKinds[ep->kind];
+  uint8_t i;
+
+  if ((clusterId == ZCL_CLUSTER_ID_GEN_GROUPS) || (clusterId == ZCL_CLUSTER_ID_GEN_SCENES))
+  {
+    return TRUE;
+  }
+
+  for (i = 0; i < (sizeof(emuCommonAttrs) / sizeof(emuCommonAttrs[0])); i++)
+  {
+    if (emuCommonAttrs[i].clusterId == clusterId)
+    {
+      return TRUE;
+    }
+  }
+
+  for (i = 0; i < kind->numAttrs; i++)
+  {
+    if (kind->attrs[i].clusterId == clusterId)
+    {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/*********************************************************************
+ * @fn          emuGetAttr
+ *
+ * @brief       Value of an attribute of an endpoint.
+ *
+ * @param       ep - endpoint
+ * @param       attr - attribute
+ *
+ * @return      value
+ */
+static int32_t emuGetAttr( emuEp_t *ep, const emuAttr_t *attr )
+{
+  return (attr->val == emuValConst) ? attr->constValue : ep->values[attr->val];
+}
+
+/*********************************************************************
+ * @fn          emuPutValue
+ *
+ * @brief       Writes a value LSB first.
+ *
+ * @param       buf - buffer
+ * @param       value - value
+ * @param       len - bytes of the value
+ *
+ * @return      none
+ */
+static void emuPutValue( uint8_t *buf, int32_t value, uint8_t len )
+{
+  uint8_t i;
+
+  for (i = 0; i < len; i++)
+  {
+    buf[i] = (i < sizeof(value)) ? (((uint32_t)value >> (i * 8)) & 0xff) : 0;
+  }
+}
+
+/*********************************************************************
+ * @fn          emuGetValue
+ *
+ * @brief       Reads a value sent LSB first, the signed data types are
+ *              sign extended.
+ *
+ * @param       buf - buffer
+ * @param       len - bytes of the value
+ * @param       dataType - ZCL data type
+ *
+ * @return      value, the low 32 bits of a longer one
+ */
+static int32_t emuGetValue( uint8_t *buf, uint8_t len, uint8_t dataType )
+{
+  uint32_t value = 0;
+  uint8_t i;
+
+  for (i = 0; (i < len) && (i < sizeof(value)); i++)
+  {
+    value |= (uint32_t)buf[i] << (i * 8);
+  }
+
+  if ((dataType >= ZCL_DATATYPE_INT8) && (dataType <= ZCL_DATATYPE_INT64) && (len < sizeof(value)) &&
+      (value & (1UL << ((len * 8) - 1))))
+  {
+    value |= ~0UL << (len * 8);
+  }
+
+  return (int32_t)value;
+}
+
+/*********************************************************************
+ * @fn          emuDrift
+ *
+ * @brief       Random walk of a sensor value.
+ *
+ * @param       value - value
+ * @param       step - largest change
+ * @param       min - lowest value
+ * @param       max - highest value
+ *
+ * @return      new value
+ */
+static int32_t emuDrift( int32_t value, int32_t step, int32_t min, int32_t max )
+{
+  value += (int32_t)emuRandom(0, step * 2) - step;
+
+  return (value < min) ? min : ((value > max) ? max : value);
+}
+
+/*********************************************************************
+ * @fn          emuLost
+ *
+ * @brief       Draws whether a frame to or from an endpoint is lost.
+ *
+ * @param       ep - endpoint
+ *
+ * @return      TRUE if lost
+ */
+static uint8_t emuLost( emuEp_t *ep )
+{
+  return (ep->lossPct > 0) && (emuRandom(0, 99) < ep->lossPct);
+}
+
+/*********************************************************************
+ * @fn          emuFindGroup
+ *
+ * @brief       Group of an endpoint.
+ *
+ * @param       ep - endpoint
+ * @param       groupId - group
+ *
+ * @return      index in the groups of the endpoint, -1 if not a member
+ */
+static int32_t emuFindGroup( emuEp_t *ep, uint16_t groupId )
+{
+  uint8_t i;
+
+  for (i = 0; i < ep->numGroups; i++)
+  {
+    if (ep->groups[i] == groupId)
+    {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+/*********************************************************************
+ * @fn          emuPrintStats
+ *
+ * @brief       Prints the counters.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+static void emuPrintStats( void )
+{
+  printf("%u frames in, %u out, %u SREQs, %u MT_APP_MSGs, %u ZCL requests, %u responses, "
+    "%u reports, %u zone notifications, %u joins, %u leaves, %u lost to and %u from the devices, "
+    "%u SBL writes, %u SBL reads\n",
+    emuStats.framesIn, emuStats.framesOut, emuStats.sreqs, emuStats.appMsgs, emuStats.zclRequests,
+    emuStats.zclRsps, emuStats.reports, emuStats.zoneNotifs, emuStats.joins, emuStats.leaves,
+    emuStats.lostDown, emuStats.lostUp, emuStats.sblWrites, emuStats.sblReads);
+  fflush(stdout);
+}
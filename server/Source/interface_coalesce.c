@@ -0,0 +1,459 @@
+/**************************************************************************************************
+ * Filename:       interface_coalesce.c
+ * Description:    Coalescing of level and color commands, sends only the latest value per destination.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "interface_coalesce.h"
+#include "interface_grouplist.h"
+#include "interface_shadow.h"
+#include "interface_srpcserver.h"
+#include "zbSocCmd.h"
+#include "reactor.h"
+#include "hal_types.h"
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint8_t inUse;
+  uint8_t pending;    // a command is held for the end of the window
+  uint8_t addrMode;
+  uint16_t dstAddr;
+  uint8_t endpoint;
+  uint16_t clusterId;
+  uint8_t commandId;
+  uint8_t value[2];   // level, or hue and saturation
+  uint16_t time;      // transition time
+  uint64_t windowEnd; // reactorNow(), ms
+} coalesceEntry_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static coalesceEntry_t coalesceEntries[COALESCE_MAX];
+static uint32_t coalesceWindowMs = COALESCE_DEFAULT_WINDOW_MS;
+static int32_t coalesceTimer = -1;
+static coalesceStats_t coalesceStats;
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static void coalesceSend( coalesceEntry_t *entry );
+static void coalesceSubmit( uint16_t clusterId, uint8_t commandId, uint8_t value0, uint8_t value1, 
+                            uint16_t time, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode );
+static void coalesceArmTimer( void );
+static void coalesceTimerCb( void );
+static void coalesceFlushEntries( uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode );
+static void coalesceFlushMembers( uint16_t groupId );
+
+/*********************************************************************
+ * FUNCTIONS
+ *********************************************************************/
+
+/*********************************************************************
+ * @fn      coalesceSend
+ *
+ * @brief   send the command of an entry to the SoC.
+ *
+ * @param   entry - destination and values of the command
+ *
+ * @return  none
+ */
+static void coalesceSend( coalesceEntry_t *entry )
+{
+  uint8_t tsn;
+
+  //the shadow serves the values once the device confirms them
+  if (entry->clusterId == ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL)
+  {
+    tsn = zbSocSetLevel(entry->value[0], entry->time, entry->dstAddr, entry->endpoint, entry->addrMode);
+    shadowSetPending(entry->dstAddr, entry->endpoint, entry->addrMode, ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL, 
+      ATTRID_LEVEL_CURRENT_LEVEL, entry->value[0], tsn);
+  }
+  else
+  {
+    tsn = zbSocSetHueSat(entry->value[0], entry->value[1], entry->time, entry->dstAddr, 
+      entry->endpoint, entry->addrMode);
+    shadowSetPending(entry->dstAddr, entry->endpoint, entry->addrMode, ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL, 
+      ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_HUE, entry->value[0], tsn);
+    shadowSetPending(entry->dstAddr, entry->endpoint, entry->addrMode, ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL, 
+      ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_SATURATION, entry->value[1], tsn);
+  }
+
+  entry->pending = FALSE;
+  coalesceStats.sent++;
+}
+
+/*********************************************************************
+ * @fn      coalesceArmTimer
+ *
+ * @brief   arm the timer for the earliest end of a window, or disarm
+ *          it when no window is open.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void coalesceArmTimer( void )
+{
+  uint64_t windowEnd = 0;
+  uint32_t i;
+
+  for (i = 0; i < COALESCE_MAX; i++)
+  {
+    if ((coalesceEntries[i].inUse) && ((windowEnd == 0) || (coalesceEntries[i].windowEnd < windowEnd)))
+    {
+      windowEnd = coalesceEntries[i].windowEnd;
+    }
+  }
+
+  reactorArmTimer(coalesceTimer, windowEnd);
+}
+
+/*********************************************************************
+ * @fn      coalesceTimerCb
+ *
+ * @brief   reactor callback of the window timer. Sends the commands held
+ *          in the windows that ended and opens a new window for them, 
+ *          windows without a held command are closed.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void coalesceTimerCb( void )
+{
+  uint64_t now = reactorNow();
+  uint32_t i;
+
+  for (i = 0; i < COALESCE_MAX; i++)
+  {
+    coalesceEntry_t *entry = &coalesceEntries[i];
+
+    if ((entry->inUse) && (entry->windowEnd <= now))
+    {
+      if (entry->pending)
+      {
+        coalesceSend(entry);
+        entry->windowEnd = now + coalesceWindowMs;
+      }
+      else
+      {
+        entry->inUse = FALSE;
+      }
+    }
+  }
+
+  coalesceArmTimer();
+}
+
+/*********************************************************************
+ * @fn      coalesceInit
+ *
+ * @brief   create the window timer and register it with the reactor.
+ *
+ * @param   none
+ *
+ * @return  0 on success, -1 on failure
+ */
+int32_t coalesceInit( void )
+{
+  memset(coalesceEntries, 0, sizeof(coalesceEntries));
+
+  coalesceTimer = reactorAddTimer(coalesceTimerCb);
+  if (coalesceTimer < 0)
+  {
+    return -1;
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      coalesceSetWindow
+ *
+ * @brief   set how long commands to a destination are held after one
+ *          was sent, 0 sends every command as it comes.
+ *
+ * @param   windowMs - window in ms
+ *
+ * @return  0 on success, -1 if the window is too long
+ */
+int32_t coalesceSetWindow( uint32_t windowMs )
+{
+  if (windowMs > COALESCE_MAX_WINDOW_MS)
+  {
+    return -1;
+  }
+
+  coalesceWindowMs = windowMs;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      coalesceSubmit
+ *
+ * @brief   the first command to a destination is sent at once and opens
+ *          a window. Commands that come within the window are held, a
+ *          later one replacing the one held, and the last is sent when
+ *          the window ends. A slider sends at most one command per
+ *          window and its final value always goes out.
+ *
+ * @param   clusterId - cluster of the command
+ * @param   commandId - command
+ * @param   value0 - level or hue
+ * @param   value1 - saturation
+ * @param   time - transition time
+ * @param   dstAddr - Nwk Addr or Group ID
+ * @param   endpoint - endpoint
+ * @param   addrMode - Unicast or Group cast
+ *
+ * @return  none
+ */
+static void coalesceSubmit( uint16_t clusterId, uint8_t commandId, uint8_t value0, uint8_t value1, 
+                            uint16_t time, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode )
+{
+  coalesceEntry_t *entry = NULL, *freeEntry = NULL;
+  coalesceEntry_t direct;
+  uint8_t sendNow = FALSE;
+  uint32_t i;
+
+  coalesceStats.received++;
+
+  for (i = 0; i < COALESCE_MAX; i++)
+  {
+    coalesceEntry_t *e = &coalesceEntries[i];
+
+    if (!e->inUse)
+    {
+      if (freeEntry == NULL)
+      {
+        freeEntry = e;
+      }
+    }
+    else if ((e->dstAddr == dstAddr) && (e->endpoint == endpoint) && (e->addrMode == addrMode)
+      && (e->clusterId == clusterId) && (e->commandId == commandId))
+    {
+      entry = e;
+      break;
+    }
+  }
+
+  if (entry != NULL)
+  {
+    //window open, hold the command until it ends
+    if (entry->pending)
+    {
+      coalesceStats.saved++;
+    }
+  }
+  else if ((freeEntry != NULL) && (coalesceWindowMs > 0))
+  {
+    //send it and open a window
+    entry = freeEntry;
+    entry->inUse = TRUE;
+    entry->windowEnd = reactorNow() + coalesceWindowMs;
+    sendNow = TRUE;
+  }
+  else
+  {
+    //coalescing disabled or table full, send it as it is
+    entry = &direct;
+    entry->inUse = FALSE;
+    sendNow = TRUE;
+  }
+
+  entry->addrMode = addrMode;
+  entry->dstAddr = dstAddr;
+  entry->endpoint = endpoint;
+  entry->clusterId = clusterId;
+  entry->commandId = commandId;
+  entry->value[0] = value0;
+  entry->value[1] = value1;
+  entry->time = time;
+  entry->pending = TRUE;
+
+  if (sendNow)
+  {
+    if (addrMode == afAddrGroup)
+    {
+      coalesceFlushMembers(dstAddr);
+    }
+    coalesceSend(entry);
+    if (entry->inUse)
+    {
+      coalesceArmTimer();
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      coalesceSetLevel
+ *
+ * @brief   send a Move To Level command, coalesced with the other level
+ *          commands to the destination.
+ *
+ * @param   level - level to move to
+ * @param   time - transition time
+ * @param   dstAddr - Nwk Addr or Group ID
+ * @param   endpoint - endpoint
+ * @param   addrMode - Unicast or Group cast
+ *
+ * @return  none
+ */
+void coalesceSetLevel( uint8_t level, uint16_t time, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode )
+{
+  coalesceSubmit(ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL, COMMAND_LEVEL_MOVE_TO_LEVEL, level, 0, 
+    time, dstAddr, endpoint, addrMode);
+}
+
+/*********************************************************************
+ * @fn      coalesceSetHueSat
+ *
+ * @brief   send a Move To Hue and Saturation command, coalesced with the
+ *          other color commands to the destination.
+ *
+ * @param   hue - hue to move to
+ * @param   sat - saturation to move to
+ * @param   time - transition time
+ * @param   dstAddr - Nwk Addr or Group ID
+ * @param   endpoint - endpoint
+ * @param   addrMode - Unicast or Group cast
+ *
+ * @return  none
+ */
+void coalesceSetHueSat( uint8_t hue, uint8_t sat, uint16_t time, uint16_t dstAddr, uint8_t endpoint, 
+                        uint8_t addrMode )
+{
+  coalesceSubmit(ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL, COMMAND_LIGHTING_MOVE_TO_HUE_AND_SATURATION, 
+    hue, sat, time, dstAddr, endpoint, addrMode);
+}
+
+/*********************************************************************
+ * @fn      coalesceFlushEntries
+ *
+ * @brief   send the commands held for one destination.
+ *
+ * @param   dstAddr - Nwk Addr or Group ID
+ * @param   endpoint - endpoint
+ * @param   addrMode - Unicast or Group cast
+ *
+ * @return  none
+ */
+static void coalesceFlushEntries( uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode )
+{
+  uint32_t i;
+
+  for (i = 0; i < COALESCE_MAX; i++)
+  {
+    coalesceEntry_t *entry = &coalesceEntries[i];
+
+    if ((entry->inUse) && (entry->pending) && (entry->dstAddr == dstAddr)
+      && (entry->endpoint == endpoint) && (entry->addrMode == addrMode))
+    {
+      coalesceSend(entry);
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      coalesceFlushMembers
+ *
+ * @brief   send the commands held for the members of a group, a group
+ *          command must not be overridden by an older unicast one.
+ *
+ * @param   groupId - Group ID
+ *
+ * @return  none
+ */
+static void coalesceFlushMembers( uint16_t groupId )
+{
+  groupMembersRecord_t *member;
+
+  for (member = groupListGetMembers(groupId); member != NULL; member = member->next)
+  {
+    coalesceFlushEntries(member->nwkAddr, member->endpoint, afAddr16Bit);
+  }
+}
+
+/*********************************************************************
+ * @fn      coalesceFlush
+ *
+ * @brief   send the commands held for a destination. Called before a
+ *          command that must be ordered after them, like on/off or a
+ *          scene store, so the SoC sees the commands in the order the
+ *          clients sent them. The commands held for the members of a
+ *          group destination are sent too. The windows stay open.
+ *
+ * @param   dstAddr - Nwk Addr or Group ID
+ * @param   endpoint - endpoint
+ * @param   addrMode - Unicast or Group cast
+ *
+ * @return  none
+ */
+void coalesceFlush( uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode )
+{
+  if (addrMode == afAddrGroup)
+  {
+    coalesceFlushMembers(dstAddr);
+  }
+
+  coalesceFlushEntries(dstAddr, endpoint, addrMode);
+}
+
+/*********************************************************************
+ * @fn      coalesceGetStats
+ *
+ * @brief   get the coalescing counters.
+ *
+ * @param   stats - counters are copied here
+ *
+ * @return  none
+ */
+void coalesceGetStats( coalesceStats_t *stats )
+{
+  *stats = coalesceStats;
+}
@@ -0,0 +1,113 @@
+/**************************************************************************************************
+ * Filename:       interface_coalesce.h
+ * Description:    Coalescing of level and color commands, sends only the latest value per destination.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+ 
+
+#ifndef INTERFACE_COALESCE_H
+#define INTERFACE_COALESCE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// destinations coalesced at the same time, commands to further
+// destinations are sent as they come
+#define COALESCE_MAX 64
+// after a command is sent, later commands to the same destination are
+// held this long and only the latest is sent
+#define COALESCE_DEFAULT_WINDOW_MS 100
+#define COALESCE_MAX_WINDOW_MS 5000
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint32_t received; // level and color commands from the clients
+  uint32_t sent;     // commands sent to the SoC
+  uint32_t saved;    // commands replaced by a later one before being sent
+} coalesceStats_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * coalesceInit - create the window timer and register it with the reactor.
+ */
+int32_t coalesceInit( void );
+
+/*
+ * coalesceSetWindow - set the hold window, 0 sends every command as it comes.
+ */
+int32_t coalesceSetWindow( uint32_t windowMs );
+
+/*
+ * coalesceSetLevel - send or hold a move to level command.
+ */
+void coalesceSetLevel( uint8_t level, uint16_t time, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode );
+
+/*
+ * coalesceSetHueSat - send or hold a move to hue and saturation command.
+ */
+void coalesceSetHueSat( uint8_t hue, uint8_t sat, uint16_t time, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode );
+
+/*
+ * coalesceFlush - send the commands held for a destination, before any other command to it.
+ */
+void coalesceFlush( uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode );
+
+/*
+ * coalesceGetStats - get the received, sent and saved counters.
+ */
+void coalesceGetStats( coalesceStats_t *stats );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INTERFACE_COALESCE_H */
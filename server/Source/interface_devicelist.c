@@ -56,6 +56,15 @@
 
 static db_descriptor * db;
 
+// in memory copy of the device list for bulk reads, rebuilt from the
+// database on the first read after a change and sorted by IEEE address
+// and endpoint
+static epInfo_t * devListSnapshot = NULL;
+static char (* devListSnapshotNames)[MAX_SUPPORTED_DEVICE_NAME_LENGTH + 1] = NULL;
+static uint32_t devListSnapshotLen = 0;
+static uint32_t devListSnapshotSize = 0;
+static uint8_t devListSnapshotValid = FALSE;
+
 
 /*********************************************************************
  * TYPEDEFS
@@ -109,6 +118,7 @@ void devListAddDevice( epInfo_t *epInfo)
 	devListComposeRecord(epInfo, rec);
     
 	sdb_add_record(db, rec);
+	devListSnapshotValid = FALSE;
 }
 
 static epInfo_t * devListParseRecord(char * record)
@@ -216,12 +226,14 @@ epInfo_t * devListRemoveDeviceByNaEp( uint16 nwkAddr, uint8 endpoint )
         {
 	dev_key_NA_EP key = {nwkAddr, endpoint};
     
+	devListSnapshotValid = FALSE;
 	return devListParseRecord(sdb_delete_record(db, &key , (check_key_f)devListCheckKeyNaEp));
   
 }
 
 epInfo_t * devListRemoveDeviceByIeee( uint8_t ieeeAddr[8] )
   {
+	devListSnapshotValid = FALSE;
 	return devListParseRecord(sdb_delete_record(db, ieeeAddr , (check_key_f)devListCheckKeyIeee));
   }
   
@@ -283,6 +295,124 @@ epInfo_t * devListGetNextDev(uint32_t *context)
 	return epInfo;
 }
 
+
+/*********************************************************************
+ * @fn      devListCompareKey
+ *
+ * @brief   compare a device with an IEEE address and endpoint, the key
+ *          the snapshot is sorted by. Unlike the network address it
+ *          stays the same when a device rejoins.
+ *
+ * @param   epInfo - device
+ * @param   ieeeAddr - IEEE address
+ * @param   endpoint - endpoint
+ *
+ * @return  <0, 0 or >0 if the device sorts before, at or after the key
+ */
+int devListCompareKey( const epInfo_t *epInfo, const uint8_t ieeeAddr[8], uint8_t endpoint )
+{
+	int cmp = memcmp(epInfo->IEEEAddr, ieeeAddr, 8);
+
+	if (cmp == 0)
+	{
+		cmp = (int)epInfo->endpoint - (int)endpoint;
+	}
+
+	return cmp;
+}
+
+/*********************************************************************
+ * @fn      devListSnapshotCompare
+ *
+ * @brief   qsort comparator of the snapshot.
+ *
+ * @param   a, b - devices
+ *
+ * @return  <0, 0 or >0 if a sorts before, at or after b
+ */
+static int devListSnapshotCompare( const void *a, const void *b )
+{
+	const epInfo_t *epInfo = b;
+
+	return devListCompareKey(a, epInfo->IEEEAddr, epInfo->endpoint);
+}
+
+/*********************************************************************
+ * @fn      devListGetSnapshot
+ *
+ * @brief   get all the devices as an array sorted by IEEE address and
+ *          endpoint. The array is kept in memory and only rebuilt from
+ *          the database after the list changed, so serving it does not
+ *          parse the database file each time.
+ *
+ * @param   devices - set to the devices, valid until the list changes
+ * @param   numDevices - number of devices in the array
+ *
+ * @return  0 on success, -1 if out of memory
+ */
+int32_t devListGetSnapshot( epInfo_t **devices, uint32_t *numDevices )
+{
+	epInfo_t *epInfo;
+	uint32_t context = 0;
+	uint32_t idx;
+
+	*devices = NULL;
+	*numDevices = 0;
+
+	if (!devListSnapshotValid)
+	{
+		devListSnapshotLen = 0;
+
+		while ((epInfo = devListGetNextDev(&context)) != NULL)
+		{
+			if (devListSnapshotLen == devListSnapshotSize)
+			{
+				uint32_t newSize = devListSnapshotSize ? (devListSnapshotSize * 2) : 64;
+				epInfo_t *newSnapshot = realloc(devListSnapshot, newSize * sizeof(epInfo_t));
+				void *newNames;
+
+				if (newSnapshot == NULL)
+				{
+					return -1;
+				}
+				devListSnapshot = newSnapshot;
+
+				newNames = realloc(devListSnapshotNames, newSize * sizeof(*devListSnapshotNames));
+				if (newNames == NULL)
+				{
+					return -1;
+				}
+				devListSnapshotNames = newNames;
+				devListSnapshotSize = newSize;
+			}
+
+			devListSnapshot[devListSnapshotLen] = *epInfo;
+			if (epInfo->deviceName)
+			{
+				strcpy(devListSnapshotNames[devListSnapshotLen], epInfo->deviceName);
+			}
+			devListSnapshotLen++;
+		}
+
+		//the names array may have moved while growing
+		for (idx = 0; idx < devListSnapshotLen; idx++)
+		{
+			if (devListSnapshot[idx].deviceName)
+			{
+				devListSnapshot[idx].deviceName = devListSnapshotNames[idx];
+			}
+		}
+
+		qsort(devListSnapshot, devListSnapshotLen, sizeof(epInfo_t), devListSnapshotCompare);
+
+		devListSnapshotValid = TRUE;
+	}
+
+	*devices = devListSnapshot;
+	*numDevices = devListSnapshotLen;
+
+	return 0;
+}
   
 void devListInitDatabase( char * dbFilename )
     {
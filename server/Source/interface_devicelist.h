@@ -92,6 +92,17 @@ epInfo_t * devListGetDeviceByNaEp( uint16_t nwkAddr, uint8_t endpoint );
 
 epInfo_t * devListRemoveDeviceByIeee( uint8_t ieeeAddr[8] );
 
+/*
+ * devListCompareKey - compare a device with an IEEE address and endpoint.
+ */
+int devListCompareKey( const epInfo_t *epInfo, const uint8_t ieeeAddr[8], uint8_t endpoint );
+
+/*
+ * devListGetSnapshot - get all the devices as an array sorted by IEEE address and endpoint,
+ * kept in memory between changes.
+ */
+int32_t devListGetSnapshot( epInfo_t **devices, uint32_t *numDevices );
+
 #ifdef __cplusplus
 }
 #endif
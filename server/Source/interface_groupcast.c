@@ -0,0 +1,431 @@
+/**************************************************************************************************
+ * Filename:       interface_groupcast.c
+ * Description:    Groupcast of commands sent to every member of a group, one frame instead of one per device.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+ 
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "interface_groupcast.h"
+#include "interface_grouplist.h"
+#include "interface_coalesce.h"
+#include "interface_shadow.h"
+#include "interface_srpcserver.h"
+#include "zbSocCmd.h"
+#include "reactor.h"
+#include "hal_types.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// destination endpoint of a groupcast, the members use their own
+#define GROUPCAST_ENDPOINT 0xFF
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint16_t nwkAddr;
+  uint8_t endpoint;
+  uint8_t state;
+} groupcastCmd_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static groupcastCmd_t groupcastBurst[GROUPCAST_MAX];
+static uint32_t groupcastNum = 0;
+static uint64_t groupcastWindowEnd; // reactorNow(), ms
+static uint32_t groupcastWindowMs = GROUPCAST_DEFAULT_WINDOW_MS;
+static int32_t groupcastTimer = -1;
+static groupcastStats_t groupcastStats;
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static void groupcastSendState( uint8_t state, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode );
+static void groupcastSendBurst( void );
+static void groupcastArmTimer( void );
+static void groupcastTimerCb( void );
+
+/*********************************************************************
+ * FUNCTIONS
+ *********************************************************************/
+
+/*********************************************************************
+ * @fn      groupcastSendState
+ *
+ * @brief   send an on/off command to the SoC.
+ *
+ * @param   state - 0: Off, 1: On
+ * @param   dstAddr - Nwk Addr or Group ID
+ * @param   endpoint - endpoint
+ * @param   addrMode - Unicast or Group cast
+ *
+ * @return  none
+ */
+static void groupcastSendState( uint8_t state, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode )
+{
+  uint8_t tsn;
+
+  tsn = zbSocSetState(state, dstAddr, endpoint, addrMode);
+  shadowSetPending(dstAddr, endpoint, addrMode, ZCL_CLUSTER_ID_GEN_ON_OFF, ATTRID_ON_OFF, state, tsn);
+}
+
+/*********************************************************************
+ * @fn      groupcastSendBurst
+ *
+ * @brief   send the commands of the burst. The devices switched to the
+ *          same state that are exactly the members of a known group
+ *          get one groupcast, the others a unicast each.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void groupcastSendBurst( void )
+{
+  uint16_t nwkAddrs[GROUPCAST_MAX];
+  uint8_t endpoints[GROUPCAST_MAX];
+  groupRecord_t *group;
+  uint8_t state, numDevices;
+  uint32_t i;
+
+  for (state = 0; state <= 1; state++)
+  {
+    numDevices = 0;
+    for (i = 0; i < groupcastNum; i++)
+    {
+      if (groupcastBurst[i].state == state)
+      {
+        nwkAddrs[numDevices] = groupcastBurst[i].nwkAddr;
+        endpoints[numDevices] = groupcastBurst[i].endpoint;
+        numDevices++;
+      }
+    }
+
+    if (numDevices == 0)
+    {
+      continue;
+    }
+
+    group = NULL;
+    if (numDevices >= GROUPCAST_MIN_MEMBERS)
+    {
+      group = groupListGetGroupByMembers(nwkAddrs, endpoints, numDevices);
+    }
+
+    if (group != NULL)
+    {
+      zbSocSetState(state, group->id, GROUPCAST_ENDPOINT, afAddrGroup);
+      groupcastStats.groupcasts++;
+      groupcastStats.replaced += numDevices;
+
+      //the members send no default response to a groupcast
+      for (i = 0; i < numDevices; i++)
+      {
+        shadowInvalidate(nwkAddrs[i], endpoints[i], afAddr16Bit);
+      }
+    }
+    else
+    {
+      for (i = 0; i < numDevices; i++)
+      {
+        groupcastSendState(state, nwkAddrs[i], endpoints[i], afAddr16Bit);
+      }
+    }
+  }
+
+  groupcastNum = 0;
+}
+
+/*********************************************************************
+ * @fn      groupcastArmTimer
+ *
+ * @brief   arm the timer for the end of the burst window, or disarm it
+ *          when no command is held.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void groupcastArmTimer( void )
+{
+  reactorArmTimer(groupcastTimer, (groupcastNum > 0) ? groupcastWindowEnd : 0);
+}
+
+/*********************************************************************
+ * @fn      groupcastTimerCb
+ *
+ * @brief   reactor callback of the window timer, sends the burst.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void groupcastTimerCb( void )
+{
+  if ((groupcastNum > 0) && (groupcastWindowEnd <= reactorNow()))
+  {
+    groupcastSendBurst();
+  }
+
+  groupcastArmTimer();
+}
+
+/*********************************************************************
+ * @fn      groupcastInit
+ *
+ * @brief   create the window timer and register it with the reactor.
+ *
+ * @param   none
+ *
+ * @return  0 on success, -1 on failure
+ */
+int32_t groupcastInit( void )
+{
+  groupcastNum = 0;
+
+  groupcastTimer = reactorAddTimer(groupcastTimerCb);
+  if (groupcastTimer < 0)
+  {
+    return -1;
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      groupcastSetWindow
+ *
+ * @brief   set how long unicast on/off commands are collected in a
+ *          burst after the first one, 0 sends every command as it
+ *          comes.
+ *
+ * @param   windowMs - window in ms
+ *
+ * @return  0 on success, -1 if the window is too long
+ */
+int32_t groupcastSetWindow( uint32_t windowMs )
+{
+  if (windowMs > GROUPCAST_MAX_WINDOW_MS)
+  {
+    return -1;
+  }
+
+  groupcastWindowMs = windowMs;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      groupcastSetState
+ *
+ * @brief   the first unicast on/off command opens a burst window, the
+ *          commands that come within it are held with it. A client
+ *          switching a room off device by device sends one groupcast
+ *          when the devices are the members of a group, and the lights
+ *          switch in sync. A destination that repeats ends the burst.
+ *
+ * @param   state - 0: Off, 1: On
+ * @param   dstAddr - Nwk Addr or Group ID
+ * @param   endpoint - endpoint
+ * @param   addrMode - Unicast or Group cast
+ *
+ * @return  none
+ */
+void groupcastSetState( uint8_t state, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode )
+{
+  uint32_t i;
+
+  if ((addrMode != afAddr16Bit) || (groupcastWindowMs == 0))
+  {
+    groupcastFlush(dstAddr, endpoint, addrMode);
+    groupcastSendState(state, dstAddr, endpoint, addrMode);
+    return;
+  }
+
+  for (i = 0; i < groupcastNum; i++)
+  {
+    if ((groupcastBurst[i].nwkAddr == dstAddr) && (groupcastBurst[i].endpoint == endpoint))
+    {
+      groupcastSendBurst();
+      break;
+    }
+  }
+
+  if (groupcastNum == GROUPCAST_MAX)
+  {
+    groupcastSendBurst();
+  }
+
+  if (groupcastNum == 0)
+  {
+    groupcastWindowEnd = reactorNow() + groupcastWindowMs;
+  }
+
+  groupcastBurst[groupcastNum].nwkAddr = dstAddr;
+  groupcastBurst[groupcastNum].endpoint = endpoint;
+  groupcastBurst[groupcastNum].state = state;
+  groupcastNum++;
+  groupcastStats.held++;
+
+  groupcastArmTimer();
+}
+
+/*********************************************************************
+ * @fn      groupcastFlush
+ *
+ * @brief   send the burst a destination is in. Called before a command
+ *          that must be ordered after it, so the SoC sees the commands
+ *          in the order the clients sent them. A group may have any
+ *          device of the burst as a member, a command to it sends the
+ *          burst.
+ *
+ * @param   dstAddr - Nwk Addr or Group ID
+ * @param   endpoint - endpoint
+ * @param   addrMode - Unicast or Group cast
+ *
+ * @return  none
+ */
+void groupcastFlush( uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode )
+{
+  uint32_t i;
+
+  for (i = 0; i < groupcastNum; i++)
+  {
+    if ((addrMode != afAddr16Bit) || 
+        ((groupcastBurst[i].nwkAddr == dstAddr) && (groupcastBurst[i].endpoint == endpoint)))
+    {
+      groupcastSendBurst();
+      groupcastArmTimer();
+      return;
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      groupcastSendZcl
+ *
+ * @brief   send a ZCL command to a set of devices. When they are
+ *          exactly the members of a known group one groupcast is sent,
+ *          otherwise a unicast to every device.
+ *
+ * @param   nwkAddrs - Nwk Addr of the devices
+ * @param   endpoints - endpoints of the devices
+ * @param   numDevices - number of devices
+ * @param   clusterId - cluster of the command
+ * @param   frameControl - ZCL frame control
+ * @param   manuCode - manufacturer code
+ * @param   commandId - ZCL command
+ * @param   payload - ZCL payload
+ * @param   payloadLen - length of the ZCL payload
+ *
+ * @return  ZCL transaction sequence number of the last frame, -1 if
+ *          the payload is too long
+ */
+int32_t groupcastSendZcl( const uint16_t *nwkAddrs, const uint8_t *endpoints, uint8_t numDevices, 
+                          uint16_t clusterId, uint8_t frameControl, uint16_t manuCode, 
+                          uint8_t commandId, uint8_t *payload, uint8_t payloadLen )
+{
+  groupRecord_t *group = NULL;
+  int32_t tsn = -1;
+  uint32_t i;
+
+  //after the commands held for the devices
+  for (i = 0; i < numDevices; i++)
+  {
+    groupcastFlush(nwkAddrs[i], endpoints[i], afAddr16Bit);
+    coalesceFlush(nwkAddrs[i], endpoints[i], afAddr16Bit);
+  }
+
+  if (numDevices >= GROUPCAST_MIN_MEMBERS)
+  {
+    group = groupListGetGroupByMembers(nwkAddrs, endpoints, numDevices);
+  }
+
+  if (group != NULL)
+  {
+    tsn = zbSocSendZcl(group->id, GROUPCAST_ENDPOINT, afAddrGroup, clusterId, frameControl, 
+      manuCode, commandId, payload, payloadLen);
+    if (tsn >= 0)
+    {
+      groupcastStats.groupcasts++;
+      groupcastStats.replaced += numDevices;
+    }
+  }
+  else
+  {
+    for (i = 0; i < numDevices; i++)
+    {
+      tsn = zbSocSendZcl(nwkAddrs[i], endpoints[i], afAddr16Bit, clusterId, frameControl, 
+        manuCode, commandId, payload, payloadLen);
+      if (tsn < 0)
+      {
+        break;
+      }
+    }
+  }
+
+  //the command may change any attribute of the devices
+  for (i = 0; i < numDevices; i++)
+  {
+    shadowInvalidate(nwkAddrs[i], endpoints[i], afAddr16Bit);
+  }
+
+  return tsn;
+}
+
+/*********************************************************************
+ * @fn      groupcastGetStats
+ *
+ * @brief   get the groupcast counters.
+ *
+ * @param   stats - counters are copied here
+ *
+ * @return  none
+ */
+void groupcastGetStats( groupcastStats_t *stats )
+{
+  *stats = groupcastStats;
+}
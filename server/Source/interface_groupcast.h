@@ -0,0 +1,121 @@
+/**************************************************************************************************
+ * Filename:       interface_groupcast.h
+ * Description:    Groupcast of commands sent to every member of a group, one frame instead of one per device.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+ 
+ 
+
+#ifndef INTERFACE_GROUPCAST_H
+#define INTERFACE_GROUPCAST_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// unicast on/off commands held in a burst, a full burst is sent
+#define GROUPCAST_MAX 32
+// unicast on/off commands that come within this long of the first one
+// are a burst, and sent as one groupcast if they go to every member
+// of a known group. A client sending them in a loop on a TCP socket
+// gets the rest held back by Nagle until the first is acked, ~40 ms,
+// so 50 ms is a good window. Off by default, as the window delays
+// every unicast on/off command, even one that comes alone
+#define GROUPCAST_DEFAULT_WINDOW_MS 0
+#define GROUPCAST_MAX_WINDOW_MS 1000
+// devices a groupcast replaces at least
+#define GROUPCAST_MIN_MEMBERS 2
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint32_t held;       // unicast on/off commands held in a burst
+  uint32_t replaced;   // unicast commands replaced by a groupcast
+  uint32_t groupcasts; // groupcasts sent instead
+} groupcastStats_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * groupcastInit - create the window timer and register it with the reactor.
+ */
+int32_t groupcastInit( void );
+
+/*
+ * groupcastSetWindow - set the burst window, 0 sends every on/off command as it comes.
+ */
+int32_t groupcastSetWindow( uint32_t windowMs );
+
+/*
+ * groupcastSetState - send or hold an on/off command.
+ */
+void groupcastSetState( uint8_t state, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode );
+
+/*
+ * groupcastFlush - send the burst a destination is in, before any other command to it.
+ */
+void groupcastFlush( uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode );
+
+/*
+ * groupcastSendZcl - send a ZCL command to a set of devices, as a groupcast if they are a known group.
+ */
+int32_t groupcastSendZcl( const uint16_t *nwkAddrs, const uint8_t *endpoints, uint8_t numDevices, 
+                          uint16_t clusterId, uint8_t frameControl, uint16_t manuCode, 
+                          uint8_t commandId, uint8_t *payload, uint8_t payloadLen );
+
+/*
+ * groupcastGetStats - get the held, replaced and groupcasts counters.
+ */
+void groupcastGetStats( groupcastStats_t *stats );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INTERFACE_GROUPCAST_H */
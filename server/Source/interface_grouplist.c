@@ -77,6 +77,9 @@ static char * groupListComposeRecord(groupRecord_t *group, char * record)
 		sprintf(record + strlen(record), " , 0x%04X , 0x%02X" , groupMembers->nwkAddr, groupMembers->endpoint);
 		groupMembers = groupMembers->next;
   }
+
+	//one record per line, like the device list
+	strcat(record, "\n");
   
 	return record;
 }
@@ -283,6 +286,27 @@ uint16_t groupListAddDeviceToGroup( char *groupNameStr, uint16_t nwkAddr, uint8_
   return groupId;
 }
 
+groupMembersRecord_t * groupListGetMembers(uint16_t groupId)
+{
+	char * rec;
+	groupRecord_t *group;
+
+	rec = SDB_GET_UNIQUE_RECORD(db, &groupId, (check_key_f)groupListCheckKeyId);
+	if (rec == NULL)
+	{
+		return NULL;
+	}
+
+	group = groupListParseRecord(rec);
+	if (group == NULL)
+	{
+		return NULL;
+	}
+
+	//valid until the next group is read
+	return group->members;
+}
+
 groupRecord_t * groupListGetNextGroup(uint32_t *context)
 {
 	char * rec;
@@ -304,3 +328,41 @@ groupRecord_t * groupListGetNextGroup(uint32_t *context)
 }
 
   
+
+groupRecord_t * groupListGetGroupByMembers(const uint16_t *nwkAddrs, const uint8_t *endpoints, uint8_t numMembers)
+{
+	uint32_t context = 0;
+	groupRecord_t *group;
+	groupMembersRecord_t *member;
+	uint8_t numGroupMembers, i;
+
+	while ((group = groupListGetNextGroup(&context)) != NULL)
+	{
+		//every member of the group must be one of the devices, and as
+		//many members as devices (the devices are distinct)
+		numGroupMembers = 0;
+		for (member = group->members; member != NULL; member = member->next)
+		{
+			for (i = 0; i < numMembers; i++)
+			{
+				if ((nwkAddrs[i] == member->nwkAddr) && (endpoints[i] == member->endpoint))
+				{
+					break;
+				}
+			}
+
+			if (i == numMembers)
+			{
+				break;
+			}
+			numGroupMembers++;
+		}
+
+		if ((member == NULL) && (numGroupMembers == numMembers))
+		{
+			return group;
+		}
+	}
+
+	return NULL;
+}
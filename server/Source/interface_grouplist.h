@@ -79,6 +79,16 @@ uint16_t groupListAddGroup( char *groupNameStr );
  */
 groupRecord_t * groupListGetNextGroup(uint32_t *context);
 
+/*
+ * groupListGetMembers - Return the members of a group, NULL if it has none or does not exist.
+ */
+groupMembersRecord_t * groupListGetMembers(uint16_t groupId);
+
+/*
+ * groupListGetGroupByMembers - Return the group whose members are exactly the given devices.
+ */
+groupRecord_t * groupListGetGroupByMembers(const uint16_t *nwkAddrs, const uint8_t *endpoints, uint8_t numMembers);
+
 /*
  * groupListInitDatabase - Restore Group List from file.
  */
@@ -0,0 +1,396 @@
+/**************************************************************************************************
+ * Filename:       interface_pendingreads.c
+ * Description:    Pending attribute reads, correlates ZCL read responses with the clients that asked for them.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "interface_pendingreads.h"
+#include "reactor.h"
+#include "hal_types.h"
+#include "hal_defs.h"
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint8_t inUse;
+  uint8_t tsn;
+  uint16_t nwkAddr;
+  uint8_t endpoint;
+  uint16_t clusterId;
+  uint8_t numAttrs;
+  uint64_t expiry; // reactorNow(), ms
+  pendingReadsAttr_t attrs[PENDING_READS_MAX_ATTRS];
+} pendingRead_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static pendingRead_t pendingReads[PENDING_READS_MAX];
+static uint32_t pendingReadsNum = 0;
+static int32_t pendingReadsTimer = -1;
+
+// result of pendingReadsComplete
+static pendingReadsAttr_t pendingReadsResult[PENDING_READS_MAX_ATTRS];
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static void pendingReadsFree( pendingRead_t *entry );
+static void pendingReadsArmTimer( void );
+static void pendingReadsTimerCb( void );
+
+/*********************************************************************
+ * FUNCTIONS
+ *********************************************************************/
+
+/*********************************************************************
+ * @fn      pendingReadsFree
+ *
+ * @brief   release a table entry.
+ *
+ * @param   entry - entry to release
+ *
+ * @return  none
+ */
+static void pendingReadsFree( pendingRead_t *entry )
+{
+  entry->inUse = FALSE;
+  entry->numAttrs = 0;
+  pendingReadsNum--;
+}
+
+/*********************************************************************
+ * @fn      pendingReadsArmTimer
+ *
+ * @brief   arm the expiry timer for the oldest pending read, or
+ *          disarm it when nothing is pending.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void pendingReadsArmTimer( void )
+{
+  uint64_t expiry = 0;
+  uint32_t i;
+
+  for (i = 0; (i < PENDING_READS_MAX) && (pendingReadsNum > 0); i++)
+  {
+    if ((pendingReads[i].inUse) && ((expiry == 0) || (pendingReads[i].expiry < expiry)))
+    {
+      expiry = pendingReads[i].expiry;
+    }
+  }
+
+  reactorArmTimer(pendingReadsTimer, expiry);
+}
+
+/*********************************************************************
+ * @fn      pendingReadsTimerCb
+ *
+ * @brief   reactor callback of the expiry timer, drops the reads
+ *          that timed out.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void pendingReadsTimerCb( void )
+{
+  uint64_t now = reactorNow();
+  uint32_t i;
+
+  for (i = 0; i < PENDING_READS_MAX; i++)
+  {
+    if ((pendingReads[i].inUse) && (pendingReads[i].expiry <= now))
+    {
+      printf("pendingReadsTimerCb: read %04x:%02x cluster %04x attr %04x (%d attrs) tsn %d timed out\n",
+        pendingReads[i].nwkAddr, pendingReads[i].endpoint, pendingReads[i].clusterId,
+        pendingReads[i].attrs[0].attrId, pendingReads[i].numAttrs, pendingReads[i].tsn);
+      pendingReadsFree(&pendingReads[i]);
+    }
+  }
+
+  pendingReadsArmTimer();
+}
+
+/*********************************************************************
+ * @fn      pendingReadsInit
+ *
+ * @brief   create the expiry timer and register it with the reactor.
+ *
+ * @param   none
+ *
+ * @return  0 on success, -1 on failure
+ */
+int32_t pendingReadsInit( void )
+{
+  memset(pendingReads, 0, sizeof(pendingReads));
+  pendingReadsNum = 0;
+
+  pendingReadsTimer = reactorAddTimer(pendingReadsTimerCb);
+  if (pendingReadsTimer < 0)
+  {
+    return -1;
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      pendingReadsJoin
+ *
+ * @brief   add a client to a read of the same attribute that is
+ *          already in flight, so concurrent requests result in one
+ *          over the air read.
+ *
+ * @param   clientFd - client asking for the attribute
+ * @param   nwkAddr - device
+ * @param   endpoint - endpoint of the device
+ * @param   clusterId - cluster of the attribute
+ * @param   attrId - attribute
+ *
+ * @return  TRUE if the client was added and no read must be sent
+ */
+uint8_t pendingReadsJoin( int clientFd, uint16_t nwkAddr, uint8_t endpoint,
+                          uint16_t clusterId, uint16_t attrId )
+{
+  pendingRead_t *entry;
+  pendingReadsAttr_t *attr;
+  uint32_t i, j, k;
+
+  for (i = 0; (i < PENDING_READS_MAX) && (pendingReadsNum > 0); i++)
+  {
+    entry = &pendingReads[i];
+
+    if ((!entry->inUse) || (entry->nwkAddr != nwkAddr) || (entry->endpoint != endpoint)
+      || (entry->clusterId != clusterId))
+    {
+      continue;
+    }
+
+    for (j = 0; j < entry->numAttrs; j++)
+    {
+      attr = &entry->attrs[j];
+
+      if (attr->attrId != attrId)
+      {
+        continue;
+      }
+
+      for (k = 0; k < attr->numFds; k++)
+      {
+        if (attr->fds[k] == clientFd)
+        {
+          return TRUE;
+        }
+      }
+
+      if (attr->numFds == PENDING_READS_MAX_CLIENTS)
+      {
+        //send a read of its own
+        return FALSE;
+      }
+
+      attr->fds[attr->numFds++] = clientFd;
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/*********************************************************************
+ * @fn      pendingReadsAdd
+ *
+ * @brief   track a read that was sent, the response of every attribute
+ *          is routed to the clients that asked for it and to the
+ *          clients that join it.
+ *
+ * @param   tsn - ZCL transaction sequence number of the read
+ * @param   nwkAddr - device
+ * @param   endpoint - endpoint of the device
+ * @param   clusterId - cluster of the attributes
+ * @param   attrs - attributes and their clients
+ * @param   numAttrs - number of attributes
+ *
+ * @return  none
+ */
+void pendingReadsAdd( uint8_t tsn, uint16_t nwkAddr, uint8_t endpoint, uint16_t clusterId,
+                      const pendingReadsAttr_t *attrs, uint8_t numAttrs )
+{
+  pendingRead_t *entry = NULL;
+  uint32_t i;
+
+  for (i = 0; i < PENDING_READS_MAX; i++)
+  {
+    if (!pendingReads[i].inUse)
+    {
+      if (entry == NULL)
+      {
+        entry = &pendingReads[i];
+      }
+    }
+    else if ((pendingReads[i].tsn == tsn) && (pendingReads[i].nwkAddr == nwkAddr)
+      && (pendingReads[i].endpoint == endpoint) && (pendingReads[i].clusterId == clusterId))
+    {
+      //the tsn wrapped while the old read was pending, it can not be
+      //told apart from the new one anymore
+      pendingReadsFree(&pendingReads[i]);
+      if (entry == NULL)
+      {
+        entry = &pendingReads[i];
+      }
+    }
+  }
+
+  if (entry == NULL)
+  {
+    printf("pendingReadsAdd: table full, response to tsn %d goes to all clients\n", tsn);
+    return;
+  }
+
+  entry->inUse = TRUE;
+  entry->tsn = tsn;
+  entry->nwkAddr = nwkAddr;
+  entry->endpoint = endpoint;
+  if (numAttrs > PENDING_READS_MAX_ATTRS)
+  {
+    numAttrs = PENDING_READS_MAX_ATTRS;
+  }
+
+  entry->clusterId = clusterId;
+  entry->expiry = reactorNow() + PENDING_READS_TIMEOUT_MS;
+  entry->numAttrs = numAttrs;
+  memcpy(entry->attrs, attrs, numAttrs * sizeof(pendingReadsAttr_t));
+  pendingReadsNum++;
+
+  pendingReadsArmTimer();
+}
+
+/*********************************************************************
+ * @fn      pendingReadsComplete
+ *
+ * @brief   get the attributes of a read and the clients waiting for
+ *          them, and stop tracking the read.
+ *
+ * @param   tsn - ZCL transaction sequence number of the response
+ * @param   nwkAddr - device that sent the response
+ * @param   endpoint - endpoint of the device
+ * @param   clusterId - cluster of the response
+ * @param   numAttrs - number of attributes returned
+ *
+ * @return  attributes, valid until the next call. NULL if the read
+ *          is not tracked (unsolicited, groupcast or timed out).
+ */
+pendingReadsAttr_t *pendingReadsComplete( uint8_t tsn, uint16_t nwkAddr, uint8_t endpoint, uint16_t clusterId,
+                                          uint8_t *numAttrs )
+{
+  pendingRead_t *entry;
+  uint32_t i;
+
+  *numAttrs = 0;
+
+  for (i = 0; (i < PENDING_READS_MAX) && (pendingReadsNum > 0); i++)
+  {
+    entry = &pendingReads[i];
+
+    if ((entry->inUse) && (entry->tsn == tsn) && (entry->nwkAddr == nwkAddr)
+      && (entry->endpoint == endpoint) && (entry->clusterId == clusterId))
+    {
+      *numAttrs = entry->numAttrs;
+      memcpy(pendingReadsResult, entry->attrs, entry->numAttrs * sizeof(pendingReadsAttr_t));
+      pendingReadsFree(entry);
+      pendingReadsArmTimer();
+
+      return pendingReadsResult;
+    }
+  }
+
+  return NULL;
+}
+
+/*********************************************************************
+ * @fn      pendingReadsRemoveClient
+ *
+ * @brief   drop a disconnected client from the pending reads, its fd
+ *          may be reused by a new client before the responses arrive.
+ *          A read nobody waits for anymore stays tracked, so its
+ *          response is dropped rather than sent to every client.
+ *
+ * @param   clientFd - client fd
+ *
+ * @return  none
+ */
+void pendingReadsRemoveClient( int clientFd )
+{
+  pendingRead_t *entry;
+  pendingReadsAttr_t *attr;
+  uint32_t i, j, k;
+
+  for (i = 0; (i < PENDING_READS_MAX) && (pendingReadsNum > 0); i++)
+  {
+    entry = &pendingReads[i];
+
+    if (!entry->inUse)
+    {
+      continue;
+    }
+
+    for (j = 0; j < entry->numAttrs; j++)
+    {
+      attr = &entry->attrs[j];
+
+      for (k = 0; k < attr->numFds; k++)
+      {
+        if (attr->fds[k] == clientFd)
+        {
+          attr->fds[k] = attr->fds[--attr->numFds];
+          break;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,114 @@
+/**************************************************************************************************
+ * Filename:       interface_pendingreads.h
+ * Description:    Pending attribute reads, correlates ZCL read responses with the clients that asked for them.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+
+#ifndef INTERFACE_PENDINGREADS_H
+#define INTERFACE_PENDINGREADS_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// reads in flight at the same time, further reads are sent untracked
+// and their responses go to every client as before
+#define PENDING_READS_MAX 64
+// clients merged into one over the air read
+#define PENDING_READS_MAX_CLIENTS 16
+// attributes read with one over the air read
+#define PENDING_READS_MAX_ATTRS 8
+// a read that got no response by then is dropped, ZCL reads to a
+// sleepy or lost device do not complete
+#define PENDING_READS_TIMEOUT_MS 5000
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+// an attribute of a read and the clients waiting for it
+typedef struct
+{
+  uint16_t attrId;
+  uint32_t numFds;
+  int fds[PENDING_READS_MAX_CLIENTS];
+} pendingReadsAttr_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * pendingReadsInit - create the expiry timer and register it with the reactor.
+ */
+int32_t pendingReadsInit( void );
+
+/*
+ * pendingReadsJoin - add a client to a read of the same attribute that is in flight.
+ */
+uint8_t pendingReadsJoin( int clientFd, uint16_t nwkAddr, uint8_t endpoint,
+                          uint16_t clusterId, uint16_t attrId );
+
+/*
+ * pendingReadsAdd - track a read of numAttrs attributes that was sent with transaction sequence number tsn.
+ */
+void pendingReadsAdd( uint8_t tsn, uint16_t nwkAddr, uint8_t endpoint, uint16_t clusterId,
+                      const pendingReadsAttr_t *attrs, uint8_t numAttrs );
+
+/*
+ * pendingReadsComplete - get the attributes of a read and the clients waiting for them.
+ */
+pendingReadsAttr_t *pendingReadsComplete( uint8_t tsn, uint16_t nwkAddr, uint8_t endpoint, uint16_t clusterId,
+                                          uint8_t *numAttrs );
+
+/*
+ * pendingReadsRemoveClient - drop a disconnected client from the pending reads.
+ */
+void pendingReadsRemoveClient( int clientFd );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INTERFACE_PENDINGREADS_H */
@@ -0,0 +1,408 @@
+/**************************************************************************************************
+ * Filename:       interface_readbatch.c
+ * Description:    Batching of attribute reads, reads one cluster of a device with one ZCL Read.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+ 
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "interface_readbatch.h"
+#include "interface_pendingreads.h"
+#include "interface_srpcserver.h"
+#include "zbSocCmd.h"
+#include "reactor.h"
+#include "hal_types.h"
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint8_t inUse;
+  uint16_t nwkAddr;
+  uint8_t endpoint;
+  uint16_t clusterId;
+  uint64_t windowEnd; // reactorNow(), ms
+  uint8_t numAttrs;
+  pendingReadsAttr_t attrs[PENDING_READS_MAX_ATTRS];
+} readBatchEntry_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static readBatchEntry_t readBatchEntries[READ_BATCH_MAX];
+static uint32_t readBatchWindowMs = READ_BATCH_DEFAULT_WINDOW_MS;
+static int32_t readBatchTimer = -1;
+static readBatchStats_t readBatchStats;
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static void readBatchSend( readBatchEntry_t *entry );
+static void readBatchArmTimer( void );
+static void readBatchTimerCb( void );
+
+/*********************************************************************
+ * FUNCTIONS
+ *********************************************************************/
+
+/*********************************************************************
+ * @fn      readBatchSend
+ *
+ * @brief   send the attributes of an entry in one ZCL Read and track
+ *          it, so the response of every attribute goes to the clients
+ *          that asked for it.
+ *
+ * @param   entry - device, cluster and attributes of the read
+ *
+ * @return  none
+ */
+static void readBatchSend( readBatchEntry_t *entry )
+{
+  uint16_t attrIds[PENDING_READS_MAX_ATTRS];
+  int32_t tsn;
+  uint8_t i;
+
+  entry->inUse = FALSE;
+
+  //every client of the read left before it was sent
+  if (entry->numAttrs == 0)
+  {
+    return;
+  }
+
+  for (i = 0; i < entry->numAttrs; i++)
+  {
+    attrIds[i] = entry->attrs[i].attrId;
+  }
+
+  tsn = zbSocReadAttrs(entry->clusterId, attrIds, entry->numAttrs, entry->nwkAddr, 
+    entry->endpoint, afAddr16Bit);
+  if (tsn < 0)
+  {
+    return;
+  }
+
+  readBatchStats.frames++;
+  pendingReadsAdd(tsn, entry->nwkAddr, entry->endpoint, entry->clusterId, entry->attrs, entry->numAttrs);
+}
+
+/*********************************************************************
+ * @fn      readBatchArmTimer
+ *
+ * @brief   arm the timer for the earliest end of a window, or disarm
+ *          it when no read is batched.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void readBatchArmTimer( void )
+{
+  uint64_t windowEnd = 0;
+  uint32_t i;
+
+  for (i = 0; i < READ_BATCH_MAX; i++)
+  {
+    if ((readBatchEntries[i].inUse) && ((windowEnd == 0) || (readBatchEntries[i].windowEnd < windowEnd)))
+    {
+      windowEnd = readBatchEntries[i].windowEnd;
+    }
+  }
+
+  reactorArmTimer(readBatchTimer, windowEnd);
+}
+
+/*********************************************************************
+ * @fn      readBatchTimerCb
+ *
+ * @brief   reactor callback of the window timer, sends the reads of the
+ *          windows that ended.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void readBatchTimerCb( void )
+{
+  uint64_t now = reactorNow();
+  uint32_t i;
+
+  for (i = 0; i < READ_BATCH_MAX; i++)
+  {
+    if ((readBatchEntries[i].inUse) && (readBatchEntries[i].windowEnd <= now))
+    {
+      readBatchSend(&readBatchEntries[i]);
+    }
+  }
+
+  readBatchArmTimer();
+}
+
+/*********************************************************************
+ * @fn      readBatchInit
+ *
+ * @brief   create the window timer and register it with the reactor.
+ *
+ * @param   none
+ *
+ * @return  0 on success, -1 on failure
+ */
+int32_t readBatchInit( void )
+{
+  memset(readBatchEntries, 0, sizeof(readBatchEntries));
+
+  readBatchTimer = reactorAddTimer(readBatchTimerCb);
+  if (readBatchTimer < 0)
+  {
+    return -1;
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      readBatchSetWindow
+ *
+ * @brief   set how long reads of a cluster of a device are collected
+ *          after the first one, 0 sends every read as it comes.
+ *
+ * @param   windowMs - window in ms
+ *
+ * @return  0 on success, -1 if the window is too long
+ */
+int32_t readBatchSetWindow( uint32_t windowMs )
+{
+  if (windowMs > READ_BATCH_MAX_WINDOW_MS)
+  {
+    return -1;
+  }
+
+  readBatchWindowMs = windowMs;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      readBatchAdd
+ *
+ * @brief   the first read of a cluster of a device opens a window. The
+ *          attributes read within the window are added to it, a client
+ *          reading an attribute already in it waits for the same
+ *          record, and all are sent in one ZCL Read when the window
+ *          ends or the read is full. A client refreshing a color light
+ *          gets hue and saturation with one round trip.
+ *
+ * @param   clientFd - client asking for the attribute
+ * @param   nwkAddr - device
+ * @param   endpoint - endpoint of the device
+ * @param   clusterId - cluster of the attribute
+ * @param   attrId - attribute
+ *
+ * @return  none
+ */
+void readBatchAdd( int clientFd, uint16_t nwkAddr, uint8_t endpoint, uint16_t clusterId, uint16_t attrId )
+{
+  readBatchEntry_t *entry = NULL, *freeEntry = NULL;
+  readBatchEntry_t direct;
+  pendingReadsAttr_t *attr = NULL;
+  uint32_t i;
+
+  readBatchStats.requested++;
+
+  for (i = 0; i < READ_BATCH_MAX; i++)
+  {
+    if (!readBatchEntries[i].inUse)
+    {
+      if (freeEntry == NULL)
+      {
+        freeEntry = &readBatchEntries[i];
+      }
+    }
+    else if ((readBatchEntries[i].nwkAddr == nwkAddr) && (readBatchEntries[i].endpoint == endpoint)
+      && (readBatchEntries[i].clusterId == clusterId))
+    {
+      entry = &readBatchEntries[i];
+      break;
+    }
+  }
+
+  if (entry != NULL)
+  {
+    for (i = 0; i < entry->numAttrs; i++)
+    {
+      if (entry->attrs[i].attrId == attrId)
+      {
+        attr = &entry->attrs[i];
+        break;
+      }
+    }
+
+    if (attr != NULL)
+    {
+      for (i = 0; i < attr->numFds; i++)
+      {
+        if (attr->fds[i] == clientFd)
+        {
+          return;
+        }
+      }
+
+      if (attr->numFds < PENDING_READS_MAX_CLIENTS)
+      {
+        attr->fds[attr->numFds++] = clientFd;
+        return;
+      }
+    }
+    else if (entry->numAttrs < PENDING_READS_MAX_ATTRS)
+    {
+      attr = &entry->attrs[entry->numAttrs++];
+      attr->attrId = attrId;
+      attr->numFds = 1;
+      attr->fds[0] = clientFd;
+
+      if (entry->numAttrs == PENDING_READS_MAX_ATTRS)
+      {
+        readBatchSend(entry);
+        readBatchArmTimer();
+      }
+      return;
+    }
+
+    //no room left, send the read and batch in a new one
+    readBatchSend(entry);
+    freeEntry = entry;
+  }
+
+  if ((readBatchWindowMs == 0) || (freeEntry == NULL))
+  {
+    //no batching, or too many devices batched
+    entry = &direct;
+  }
+  else
+  {
+    entry = freeEntry;
+    entry->windowEnd = reactorNow() + readBatchWindowMs;
+  }
+
+  entry->inUse = TRUE;
+  entry->nwkAddr = nwkAddr;
+  entry->endpoint = endpoint;
+  entry->clusterId = clusterId;
+  entry->numAttrs = 1;
+  entry->attrs[0].attrId = attrId;
+  entry->attrs[0].numFds = 1;
+  entry->attrs[0].fds[0] = clientFd;
+
+  if (entry == &direct)
+  {
+    readBatchSend(entry);
+  }
+
+  readBatchArmTimer();
+}
+
+/*********************************************************************
+ * @fn      readBatchRemoveClient
+ *
+ * @brief   drop a disconnected client from the batched reads, its fd
+ *          may be reused by a new client before the read is sent. An
+ *          attribute nobody waits for anymore is not read.
+ *
+ * @param   clientFd - client fd
+ *
+ * @return  none
+ */
+void readBatchRemoveClient( int clientFd )
+{
+  readBatchEntry_t *entry;
+  pendingReadsAttr_t *attr;
+  uint32_t i, j, k;
+
+  for (i = 0; i < READ_BATCH_MAX; i++)
+  {
+    entry = &readBatchEntries[i];
+
+    if (!entry->inUse)
+    {
+      continue;
+    }
+
+    for (j = 0; j < entry->numAttrs; )
+    {
+      attr = &entry->attrs[j];
+
+      for (k = 0; k < attr->numFds; k++)
+      {
+        if (attr->fds[k] == clientFd)
+        {
+          attr->fds[k] = attr->fds[--attr->numFds];
+          break;
+        }
+      }
+
+      if (attr->numFds == 0)
+      {
+        *attr = entry->attrs[--entry->numAttrs];
+      }
+      else
+      {
+        j++;
+      }
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      readBatchGetStats
+ *
+ * @brief   get the requested and frames counters, requested / frames
+ *          is the number of attribute reads per ZCL Read sent.
+ *
+ * @param   stats - the counters
+ *
+ * @return  none
+ */
+void readBatchGetStats( readBatchStats_t *stats )
+{
+  *stats = readBatchStats;
+}
@@ -0,0 +1,108 @@
+/**************************************************************************************************
+ * Filename:       interface_readbatch.h
+ * Description:    Batching of attribute reads, reads one cluster of a device with one ZCL Read.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+ 
+ 
+
+#ifndef INTERFACE_READBATCH_H
+#define INTERFACE_READBATCH_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// devices batched at the same time, reads of further devices are sent
+// as they come
+#define READ_BATCH_MAX 32
+// reads of a cluster of a device are collected this long after the
+// first one and sent as one ZCL Read
+#define READ_BATCH_DEFAULT_WINDOW_MS 10
+#define READ_BATCH_MAX_WINDOW_MS 1000
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint32_t requested; // attribute reads from the clients
+  uint32_t frames;    // ZCL Read frames sent to the SoC
+} readBatchStats_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * readBatchInit - create the window timer and register it with the reactor.
+ */
+int32_t readBatchInit( void );
+
+/*
+ * readBatchSetWindow - set the batching window, 0 sends every read as it comes.
+ */
+int32_t readBatchSetWindow( uint32_t windowMs );
+
+/*
+ * readBatchAdd - send or batch the read of an attribute for a client.
+ */
+void readBatchAdd( int clientFd, uint16_t nwkAddr, uint8_t endpoint, uint16_t clusterId, uint16_t attrId );
+
+/*
+ * readBatchRemoveClient - drop a disconnected client from the batched reads.
+ */
+void readBatchRemoveClient( int clientFd );
+
+/*
+ * readBatchGetStats - get the requested and frames counters.
+ */
+void readBatchGetStats( readBatchStats_t *stats );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INTERFACE_READBATCH_H */
@@ -0,0 +1,245 @@
+/**************************************************************************************************
+ * Filename:       interface_reporting.c
+ * Description:    Attribute reporting configured on the devices as they join.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+ 
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "interface_reporting.h"
+#include "interface_srpcserver.h"
+#include "zbSocCmd.h"
+#include "hal_types.h"
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint16_t clusterId;
+  uint16_t attrId;
+  uint8_t dataType;
+  uint8_t enabled;
+  uint16_t minInterval;      // s
+  uint16_t maxInterval;      // s
+  uint32_t reportableChange; // analog data types only
+  uint8_t numDeviceIds;
+  uint16_t deviceIds[REPORTING_MAX_DEVICE_IDS];
+} reportingConfig_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+// the attributes clients used to poll, and the devices that have them.
+// On/off and level are reported as they change, sensors at most every s
+static reportingConfig_t reportingConfigs[] =
+{
+  { ZCL_CLUSTER_ID_GEN_ON_OFF, ATTRID_ON_OFF, ZCL_DATATYPE_BOOLEAN, TRUE, 0, 300, 0,
+    10, { 0x0000, 0x0009, 0x0010, 0x0100, 0x0101, 0x0102, 0x0110, 0x0200, 0x0210, 0x0220 } },
+  { ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL, ATTRID_LEVEL_CURRENT_LEVEL, ZCL_DATATYPE_UINT8, TRUE, 0, 300, 1,
+    7, { 0x0100, 0x0101, 0x0102, 0x0110, 0x0200, 0x0210, 0x0220 } },
+  // 0.1 degC
+  { ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT, ATTRID_MS_TEMPERATURE_MEASURED_VALUE, ZCL_DATATYPE_INT16, TRUE, 1, 300, 10,
+    1, { 0x0302 } },
+  // 1 %RH
+  { ZCL_CLUSTER_ID_MS_REL_HUMIDITY_MEASUREMENT, ATTRID_MS_RELATIVE_HUMIDITY_MEASURED_VALUE, ZCL_DATATYPE_UINT16, TRUE, 1, 300, 100,
+    1, { 0x0302 } },
+  { ZCL_CLUSTER_ID_SE_SIMPLE_METERING, ATTRID_SE_INSTANTANEOUS_DEMAND, ZCL_DATATYPE_INT24, TRUE, 1, 300, 1,
+    3, { 0x0051, 0x0053, 0x0501 } },
+};
+
+#define REPORTING_NUM_CONFIGS (sizeof(reportingConfigs) / sizeof(reportingConfigs[0]))
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static reportingConfig_t *reportingFindCluster( uint16_t clusterId );
+static uint8_t reportingHasDevice( reportingConfig_t *config, uint16_t deviceId );
+
+/*********************************************************************
+ * FUNCTIONS
+ *********************************************************************/
+
+/*********************************************************************
+ * @fn      reportingFindCluster
+ *
+ * @brief   find the reporting configuration of a cluster.
+ *
+ * @param   clusterId - cluster
+ *
+ * @return  configuration, NULL if the cluster is not reported
+ */
+static reportingConfig_t *reportingFindCluster( uint16_t clusterId )
+{
+  uint32_t i;
+
+  for (i = 0; i < REPORTING_NUM_CONFIGS; i++)
+  {
+    if (reportingConfigs[i].clusterId == clusterId)
+    {
+      return &reportingConfigs[i];
+    }
+  }
+
+  return NULL;
+}
+
+/*********************************************************************
+ * @fn      reportingHasDevice
+ *
+ * @brief   check if a reporting configuration applies to a device.
+ *
+ * @param   config - configuration
+ * @param   deviceId - device ID of the endpoint
+ *
+ * @return  TRUE if it applies
+ */
+static uint8_t reportingHasDevice( reportingConfig_t *config, uint16_t deviceId )
+{
+  uint8_t i;
+
+  for (i = 0; i < config->numDeviceIds; i++)
+  {
+    if (config->deviceIds[i] == deviceId)
+    {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/*********************************************************************
+ * @fn      reportingSetCluster
+ *
+ * @brief   set the reporting intervals and reportable change of a
+ *          cluster, for the devices that join from now on.
+ *
+ * @param   clusterId - cluster
+ * @param   minInterval - minimum reporting interval in s
+ * @param   maxInterval - maximum reporting interval in s, 0 only reports
+ *                        changes
+ * @param   reportableChange - change that is reported
+ *
+ * @return  0 on success, -1 if the cluster is not reported
+ */
+int32_t reportingSetCluster( uint16_t clusterId, uint16_t minInterval, uint16_t maxInterval, 
+                             uint32_t reportableChange )
+{
+  reportingConfig_t *config = reportingFindCluster(clusterId);
+
+  if ((config == NULL) || ((maxInterval != 0) && (maxInterval < minInterval)))
+  {
+    return -1;
+  }
+
+  config->enabled = TRUE;
+  config->minInterval = minInterval;
+  config->maxInterval = maxInterval;
+  config->reportableChange = reportableChange;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      reportingDisableCluster
+ *
+ * @brief   do not configure reporting of a cluster, clients poll it.
+ *
+ * @param   clusterId - cluster
+ *
+ * @return  0 on success, -1 if the cluster is not reported
+ */
+int32_t reportingDisableCluster( uint16_t clusterId )
+{
+  reportingConfig_t *config = reportingFindCluster(clusterId);
+
+  if (config == NULL)
+  {
+    return -1;
+  }
+
+  config->enabled = FALSE;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      reportingConfigureDevice
+ *
+ * @brief   bind the reported clusters of a device that joined to the
+ *          gateway, so the device sends its reports to it, and
+ *          configure reporting of their attributes. The reports are
+ *          passed on to the clients as the read responses are.
+ *
+ * @param   epInfo - endpoint of the device
+ *
+ * @return  none
+ */
+void reportingConfigureDevice( epInfo_t *epInfo )
+{
+  uint8_t gatewayIeeeAddr[Z_EXTADDR_LEN];
+  uint8_t bind;
+  uint32_t i;
+
+  //without the address of the zbSoC the device may already be bound
+  bind = zbSocGetIeeeAddr(gatewayIeeeAddr);
+
+  for (i = 0; i < REPORTING_NUM_CONFIGS; i++)
+  {
+    reportingConfig_t *config = &reportingConfigs[i];
+
+    if ((!config->enabled) || (!reportingHasDevice(config, epInfo->deviceID)))
+    {
+      continue;
+    }
+
+    if (bind)
+    {
+      zbSocBind(epInfo->nwkAddr, epInfo->endpoint, epInfo->IEEEAddr, ZBSOC_APP_ENDPOINT, 
+        gatewayIeeeAddr, config->clusterId);
+    }
+
+    zbSocConfigReporting(config->clusterId, config->attrId, config->dataType, config->minInterval, 
+      config->maxInterval, config->reportableChange, epInfo->nwkAddr, epInfo->endpoint, afAddr16Bit);
+  }
+}
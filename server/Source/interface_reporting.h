@@ -0,0 +1,87 @@
+/**************************************************************************************************
+ * Filename:       interface_reporting.h
+ * Description:    Attribute reporting configured on the devices as they join.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+ 
+ 
+
+#ifndef INTERFACE_REPORTING_H
+#define INTERFACE_REPORTING_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+#include "zbSocCmd.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// device IDs a reporting configuration applies to
+#define REPORTING_MAX_DEVICE_IDS 12
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * reportingSetCluster - set the reporting intervals and reportable change of a cluster.
+ */
+int32_t reportingSetCluster( uint16_t clusterId, uint16_t minInterval, uint16_t maxInterval, 
+                             uint32_t reportableChange );
+
+/*
+ * reportingDisableCluster - do not configure reporting of a cluster.
+ */
+int32_t reportingDisableCluster( uint16_t clusterId );
+
+/*
+ * reportingConfigureDevice - bind the reported clusters of a device to the gateway and configure reporting.
+ */
+void reportingConfigureDevice( epInfo_t *epInfo );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INTERFACE_REPORTING_H */
@@ -0,0 +1,460 @@
+/**************************************************************************************************
+ * Filename:       interface_shadow.c
+ * Description:    Shadow of the device attributes, serves get requests without a read over the air.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+ 
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "interface_shadow.h"
+#include "interface_srpcserver.h"
+#include "zbSocCmd.h"
+#include "zbSocZcl.h"
+#include "reactor.h"
+#include "hal_types.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// attributes shadowed per endpoint
+#define SHADOW_ATTR_STATE 0
+#define SHADOW_ATTR_LEVEL 1
+#define SHADOW_ATTR_HUE   2
+#define SHADOW_ATTR_SAT   3
+#define SHADOW_NUM_ATTRS  4
+
+// slots looked at from the hash of an endpoint before replacing one
+#define SHADOW_MAX_PROBE 8
+
+// marks a key in use, so address 0x0000 endpoint 0 is not a free slot
+#define SHADOW_KEY_IN_USE 0x01000000
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+// 32 bytes, two entries per cache line
+typedef struct
+{
+  uint8_t value[SHADOW_NUM_ATTRS];
+  uint8_t pendingValue[SHADOW_NUM_ATTRS]; // value of a command sent
+  uint8_t pendingTsn[SHADOW_NUM_ATTRS];   // transaction of that command
+  uint8_t valid;                          // bit per attribute
+  uint8_t pending;                        // bit per attribute
+  uint32_t stamp[SHADOW_NUM_ATTRS];       // reactorNow(), ms, wraps around
+} shadowEntry_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+// the keys are probed apart from the values so a lookup touches
+// few cache lines
+static uint32_t shadowKeys[SHADOW_MAX];
+static shadowEntry_t shadowEntries[SHADOW_MAX];
+static shadowStats_t shadowStats;
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static int shadowAttrIndex( uint16_t clusterId, uint16_t attrId );
+static uint32_t shadowKey( uint16_t nwkAddr, uint8_t endpoint );
+static uint32_t shadowHash( uint32_t key );
+static uint32_t shadowLastUpdate( shadowEntry_t *entry );
+static shadowEntry_t *shadowFind( uint16_t nwkAddr, uint8_t endpoint, uint8_t create );
+
+/*********************************************************************
+ * FUNCTIONS
+ *********************************************************************/
+
+/*********************************************************************
+ * @fn      shadowAttrIndex
+ *
+ * @brief   get the index of a shadowed attribute.
+ *
+ * @param   clusterId - cluster of the attribute
+ * @param   attrId - attribute
+ *
+ * @return  index, -1 if the attribute is not shadowed
+ */
+static int shadowAttrIndex( uint16_t clusterId, uint16_t attrId )
+{
+  switch (clusterId)
+  {
+    case ZCL_CLUSTER_ID_GEN_ON_OFF:
+      return (attrId == ATTRID_ON_OFF) ? SHADOW_ATTR_STATE : -1;
+    case ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL:
+      return (attrId == ATTRID_LEVEL_CURRENT_LEVEL) ? SHADOW_ATTR_LEVEL : -1;
+    case ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL:
+      if (attrId == ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_HUE)
+      {
+        return SHADOW_ATTR_HUE;
+      }
+      return (attrId == ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_SATURATION) ? SHADOW_ATTR_SAT : -1;
+    default:
+      return -1;
+  }
+}
+
+/*********************************************************************
+ * @fn      shadowKey
+ *
+ * @brief   build the key of an endpoint.
+ *
+ * @param   nwkAddr - address of the device
+ * @param   endpoint - endpoint of the device
+ *
+ * @return  key
+ */
+static uint32_t shadowKey( uint16_t nwkAddr, uint8_t endpoint )
+{
+  return SHADOW_KEY_IN_USE | ((uint32_t)nwkAddr << 8) | endpoint;
+}
+
+/*********************************************************************
+ * @fn      shadowHash
+ *
+ * @brief   get the first slot to probe for a key.
+ *
+ * @param   key - key of the endpoint
+ *
+ * @return  slot
+ */
+static uint32_t shadowHash( uint32_t key )
+{
+  return ((key * 2654435761u) >> 16) & (SHADOW_MAX - 1);
+}
+
+/*********************************************************************
+ * @fn      shadowLastUpdate
+ *
+ * @brief   get the last time an attribute of an entry was stored.
+ *
+ * @param   entry - entry of the endpoint
+ *
+ * @return  age in ms
+ */
+static uint32_t shadowLastUpdate( shadowEntry_t *entry )
+{
+  uint32_t now = (uint32_t)reactorNow();
+  uint32_t age = UINT32_MAX;
+  int i;
+
+  for (i = 0; i < SHADOW_NUM_ATTRS; i++)
+  {
+    if ((entry->valid & (1 << i)) && ((now - entry->stamp[i]) < age))
+    {
+      age = now - entry->stamp[i];
+    }
+  }
+
+  return age;
+}
+
+/*********************************************************************
+ * @fn      shadowFind
+ *
+ * @brief   find the entry of an endpoint.
+ *
+ * @param   nwkAddr - address of the device
+ * @param   endpoint - endpoint of the device
+ * @param   create - take a slot when the endpoint has none
+ *
+ * @return  entry, NULL if not found
+ */
+static shadowEntry_t *shadowFind( uint16_t nwkAddr, uint8_t endpoint, uint8_t create )
+{
+  uint32_t key = shadowKey(nwkAddr, endpoint);
+  uint32_t slot = shadowHash(key);
+  uint32_t oldest = slot, oldestAge = 0, age;
+  int i;
+
+  for (i = 0; i < SHADOW_MAX_PROBE; i++, slot = (slot + 1) & (SHADOW_MAX - 1))
+  {
+    if (shadowKeys[slot] == key)
+    {
+      return &shadowEntries[slot];
+    }
+
+    if (shadowKeys[slot] == 0)
+    {
+      if (!create)
+      {
+        return NULL;
+      }
+      oldest = slot;
+      break;
+    }
+
+    age = shadowLastUpdate(&shadowEntries[slot]);
+    if (age >= oldestAge)
+    {
+      oldest = slot;
+      oldestAge = age;
+    }
+  }
+
+  if (!create)
+  {
+    return NULL;
+  }
+
+  // a free slot, or the endpoint updated longest ago in the probe window
+  shadowKeys[oldest] = key;
+  memset(&shadowEntries[oldest], 0, sizeof(shadowEntry_t));
+
+  return &shadowEntries[oldest];
+}
+
+/*********************************************************************
+ * @fn      shadowUpdate
+ *
+ * @brief   store an attribute value read or reported by a device.
+ *
+ * @param   nwkAddr - address of the device
+ * @param   endpoint - endpoint of the device
+ * @param   clusterId - cluster of the attribute
+ * @param   attrId - attribute
+ * @param   value - value of the attribute
+ *
+ * @return  none
+ */
+void shadowUpdate( uint16_t nwkAddr, uint8_t endpoint, uint16_t clusterId, uint16_t attrId, uint8_t value )
+{
+  shadowEntry_t *entry;
+  int idx = shadowAttrIndex(clusterId, attrId);
+
+  if ((idx < 0) || ((entry = shadowFind(nwkAddr, endpoint, TRUE)) == NULL))
+  {
+    return;
+  }
+
+  entry->value[idx] = value;
+  entry->stamp[idx] = (uint32_t)reactorNow();
+  entry->valid |= (1 << idx);
+}
+
+/*********************************************************************
+ * @fn      shadowSetPending
+ *
+ * @brief   store the value of a command sent, it is served once the
+ *          device confirms it with a default response. A command to a
+ *          group only forgets the attribute of every endpoint, the
+ *          members are not known.
+ *
+ * @param   dstAddr - Nwk Addr or Group ID
+ * @param   endpoint - endpoint of the device
+ * @param   addrMode - Unicast or Group cast
+ * @param   clusterId - cluster of the attribute
+ * @param   attrId - attribute set by the command
+ * @param   value - value set by the command
+ * @param   transSeqNum - transaction of the command
+ *
+ * @return  none
+ */
+void shadowSetPending( uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode, uint16_t clusterId, 
+                       uint16_t attrId, uint8_t value, uint8_t transSeqNum )
+{
+  shadowEntry_t *entry;
+  int idx = shadowAttrIndex(clusterId, attrId);
+  int i;
+
+  if (idx < 0)
+  {
+    return;
+  }
+
+  if (addrMode != afAddr16Bit)
+  {
+    for (i = 0; i < SHADOW_MAX; i++)
+    {
+      shadowEntries[i].valid &= ~(1 << idx);
+      shadowEntries[i].pending &= ~(1 << idx);
+    }
+    return;
+  }
+
+  if ((entry = shadowFind(dstAddr, endpoint, TRUE)) == NULL)
+  {
+    return;
+  }
+
+  entry->pendingValue[idx] = value;
+  entry->pendingTsn[idx] = transSeqNum;
+  entry->pending |= (1 << idx);
+}
+
+/*********************************************************************
+ * @fn      shadowDefaultRsp
+ *
+ * @brief   commit the values of a command when the device confirms it,
+ *          or drop them when it reports an error.
+ *
+ * @param   nwkAddr - address of the device
+ * @param   endpoint - endpoint of the device
+ * @param   clusterId - cluster of the command
+ * @param   transSeqNum - transaction of the command
+ * @param   status - ZCL status of the command
+ *
+ * @return  none
+ */
+void shadowDefaultRsp( uint16_t nwkAddr, uint8_t endpoint, uint16_t clusterId, uint8_t transSeqNum, uint8_t status )
+{
+  shadowEntry_t *entry = shadowFind(nwkAddr, endpoint, FALSE);
+  uint16_t attrId;
+  int idx;
+
+  if (entry == NULL)
+  {
+    return;
+  }
+
+  // a command of the color cluster sets hue and saturation
+  for (attrId = 0; attrId <= ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_SATURATION; attrId++)
+  {
+    idx = shadowAttrIndex(clusterId, attrId);
+    if ((idx < 0) || !(entry->pending & (1 << idx)) || (entry->pendingTsn[idx] != transSeqNum))
+    {
+      continue;
+    }
+
+    entry->pending &= ~(1 << idx);
+    if (status == ZCL_STATUS_SUCCESS)
+    {
+      entry->value[idx] = entry->pendingValue[idx];
+      entry->stamp[idx] = (uint32_t)reactorNow();
+      entry->valid |= (1 << idx);
+    }
+    else
+    {
+      entry->valid &= ~(1 << idx);
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      shadowInvalidate
+ *
+ * @brief   forget the values of a destination, e.g. after a scene
+ *          recall. A group forgets the values of every endpoint.
+ *
+ * @param   dstAddr - Nwk Addr or Group ID
+ * @param   endpoint - endpoint of the device
+ * @param   addrMode - Unicast or Group cast
+ *
+ * @return  none
+ */
+void shadowInvalidate( uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode )
+{
+  shadowEntry_t *entry;
+  int i;
+
+  if (addrMode != afAddr16Bit)
+  {
+    for (i = 0; i < SHADOW_MAX; i++)
+    {
+      shadowEntries[i].valid = 0;
+      shadowEntries[i].pending = 0;
+    }
+    return;
+  }
+
+  if ((entry = shadowFind(dstAddr, endpoint, FALSE)) != NULL)
+  {
+    entry->valid = 0;
+    entry->pending = 0;
+  }
+}
+
+/*********************************************************************
+ * @fn      shadowGet
+ *
+ * @brief   get an attribute value not older than maxAgeMs. A value a
+ *          command is pending for is not served, the device may not
+ *          have it yet.
+ *
+ * @param   nwkAddr - address of the device
+ * @param   endpoint - endpoint of the device
+ * @param   clusterId - cluster of the attribute
+ * @param   attrId - attribute
+ * @param   maxAgeMs - age of the value the caller accepts, 0 never
+ *          serves from the shadow
+ * @param   value - the value
+ *
+ * @return  TRUE if the value is served from the shadow
+ */
+uint8_t shadowGet( uint16_t nwkAddr, uint8_t endpoint, uint16_t clusterId, uint16_t attrId, 
+                   uint32_t maxAgeMs, uint8_t *value )
+{
+  shadowEntry_t *entry;
+  int idx = shadowAttrIndex(clusterId, attrId);
+
+  if ((maxAgeMs == 0) || (idx < 0))
+  {
+    return FALSE;
+  }
+
+  entry = shadowFind(nwkAddr, endpoint, FALSE);
+  if ((entry == NULL) || !(entry->valid & (1 << idx)) || (entry->pending & (1 << idx)) ||
+      (((uint32_t)reactorNow() - entry->stamp[idx]) > maxAgeMs))
+  {
+    shadowStats.misses++;
+    return FALSE;
+  }
+
+  *value = entry->value[idx];
+  shadowStats.hits++;
+
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn      shadowGetStats
+ *
+ * @brief   get the hit and miss counters.
+ *
+ * @param   stats - the counters
+ *
+ * @return  none
+ */
+void shadowGetStats( shadowStats_t *stats )
+{
+  *stats = shadowStats;
+}
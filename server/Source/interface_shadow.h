@@ -0,0 +1,111 @@
+/**************************************************************************************************
+ * Filename:       interface_shadow.h
+ * Description:    Shadow of the device attributes, serves get requests without a read over the air.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+ 
+ 
+
+#ifndef INTERFACE_SHADOW_H
+#define INTERFACE_SHADOW_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// endpoints shadowed at the same time, must be a power of 2. When the
+// table is full the endpoint updated longest ago is replaced
+#define SHADOW_MAX 256
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint32_t hits;   // get requests answered from the shadow
+  uint32_t misses; // get requests with a max age read over the air
+} shadowStats_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * shadowUpdate - store an attribute value read or reported by a device.
+ */
+void shadowUpdate( uint16_t nwkAddr, uint8_t endpoint, uint16_t clusterId, uint16_t attrId, uint8_t value );
+
+/*
+ * shadowSetPending - store the value of a command sent, until the device confirms it.
+ */
+void shadowSetPending( uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode, uint16_t clusterId, 
+                       uint16_t attrId, uint8_t value, uint8_t transSeqNum );
+
+/*
+ * shadowDefaultRsp - commit or drop the values of a command when its default response comes.
+ */
+void shadowDefaultRsp( uint16_t nwkAddr, uint8_t endpoint, uint16_t clusterId, uint8_t transSeqNum, uint8_t status );
+
+/*
+ * shadowInvalidate - forget the values of a destination, e.g. after a scene recall.
+ */
+void shadowInvalidate( uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode );
+
+/*
+ * shadowGet - get an attribute value not older than maxAgeMs.
+ */
+uint8_t shadowGet( uint16_t nwkAddr, uint8_t endpoint, uint16_t clusterId, uint16_t attrId, 
+                   uint32_t maxAgeMs, uint8_t *value );
+
+/*
+ * shadowGetStats - get the hit and miss counters.
+ */
+void shadowGetStats( shadowStats_t *stats );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INTERFACE_SHADOW_H */
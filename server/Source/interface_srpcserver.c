@@ -57,13 +57,23 @@
 #include "hal_defs.h"
 
 #include "zbSocCmd.h"
-
-void SRPC_RxCB( int clientFd );
+#include "zbSocIo.h"
+#include "zbSocSched.h"
+#include "interface_subscriptions.h"
+#include "interface_pendingreads.h"
+#include "interface_coalesce.h"
+#include "interface_shadow.h"
+#include "interface_readbatch.h"
+#include "interface_groupcast.h"
+
+uint32_t SRPC_RxCB( int clientFd, uint8_t *buf, uint32_t len );
 void SRPC_ConnectCB( int status ); 
+void SRPC_DisconnectCB( int clientFd ); 
 
 static uint8_t SRPC_setDeviceState(uint8_t *pBuf, uint32_t clientFd);
 static uint8_t SRPC_setDeviceLevel(uint8_t *pBuf, uint32_t clientFd);
 static uint8_t SRPC_setDeviceColor(uint8_t *pBuf, uint32_t clientFd);
+static uint8_t SRPC_sendZcl(uint8_t *pBuf, uint32_t clientFd);
 static uint8_t SRPC_getDeviceState(uint8_t *pBuf, uint32_t clientFd);
 static uint8_t SRPC_getDeviceLevel(uint8_t *pBuf, uint32_t clientFd);
 static uint8_t SRPC_getDeviceHue(uint8_t *pBuf, uint32_t clientFd);
@@ -88,6 +98,12 @@ static uint8_t SRPC_changeDeviceName(uint8_t *pBuf, uint32_t clientFd);
 static uint8_t SRPC_installCertificate(uint8_t *pBuf, uint32_t clientFd);
 static uint8_t SRPC_getLastMessage(uint8_t *pBuf, uint32_t clientFd);
 static uint8_t SRPC_getCurrentPrice(uint8_t *pBuf, uint32_t clientFd);
+static uint8_t SRPC_subscribe(uint8_t *pBuf, uint32_t clientFd);
+static uint8_t SRPC_getDeviceList(uint8_t *pBuf, uint32_t clientFd);
+static uint8_t SRPC_getServerStats(uint8_t *pBuf, uint32_t clientFd);
+static uint8_t SRPC_getSocStats(uint8_t *pBuf, uint32_t clientFd);
+static uint8_t SRPC_readAttrs(uint8_t *pBuf, uint32_t clientFd);
+static uint8_t SRPC_sendZclDevSet(uint8_t *pBuf, uint32_t clientFd);
 
 //SRPC Interface call back functions
 static void SRPC_CallBack_addGroupRsp(uint16_t groupId, char *nameStr, uint32_t clientFd);
@@ -95,6 +111,13 @@ static void SRPC_CallBack_addSceneRsp(uint16_t groupId, uint8_t sceneId, char *n
 
 static void srpcSend(uint8_t* srpcMsg, int fdClient);
 static void srpcSendAll(uint8_t* srpcMsg);
+static void srpcSendReadRsp(uint8_t* srpcMsg, uint8_t transSeqNum, uint16_t clusterId, uint16_t attrId);
+static uint8_t srpcReadRspClients(uint8_t transSeqNum, uint16_t nwkAddr, uint8_t endpoint, uint16_t clusterId,
+                                  uint16_t attrId, int *fds, uint32_t *numFds);
+static uint8_t srpcBuildAttrsMsg(uint8_t *pSrpcMessage, uint8_t funcId, uint16_t clusterId, zbSocZclAttr_t *attrs, 
+                                 uint8_t numAttrs, uint16_t srcAddr, uint8_t endpoint);
+static uint32_t srpcCoalesceKey(uint8_t* srpcMsg);
+static uint8_t *srpcSocStatsSection(uint8_t *pBuf, uint8_t id, const uint32_t *counters, uint8_t numCounters);
 
 
 //local definitions
@@ -102,13 +125,76 @@ static void srpcSendAll(uint8_t* srpcMsg);
 #define SOCKET_BOOTLOADING_STATE_IDLE 0
 #define SOCKET_BOOTLOADING_STATE_ACTIVE 1
 
+// SRPC_DEVICE_LIST frame: cursor, flags, numRecords, records. The
+// cursor is the IEEEAddr (8) and endpoint of the last record
+#define SRPC_DEVICE_LIST_CURSOR_LEN 9
+#define SRPC_DEVICE_LIST_HDR_LEN (SRPC_DEVICE_LIST_CURSOR_LEN + 2)
+// record: nwkAddr, endpoint, profileID, deviceID, version, name length,
+// name, status, IEEEAddr
+#define SRPC_DEVICE_LIST_REC_LEN(nameLen) (18 + (nameLen))
+
+// SRPC_SEND_ZCL message: addrMode, dstAddr (8), endpoint, panId (2),
+// clusterId (2), frame control, manufacturer code (2), command id and 
+// payload length, followed by the payload
+#define SRPC_SEND_ZCL_HDR_LEN 19
+
+// SRPC_READ_ATTRS message: addrMode, dstAddr (8), endpoint, panId (2),
+// clusterId (2) and number of attributes, followed by the attribute ids
+#define SRPC_READ_ATTRS_HDR_LEN 15
+// attribute id a read of several attributes is tracked under, reads
+// of one attribute never join it. Its clients get every message of
+// the response frame
+#define SRPC_READ_ATTRS_ATTR_ID 0xFFFF
+
+// SRPC_READ_ATTRS_RSP and SRPC_REPORT_ATTRS frame: nwkAddr (2), endpoint,
+// clusterId (2) and number of records, followed by the records
+#define SRPC_READ_ATTRS_RSP_HDR_LEN 6
+
+// SRPC_SEND_ZCL_DEV_SET message: clusterId (2), frame control, 
+// manufacturer code (2), command id and payload length, followed by the
+// payload, the number of devices and nwkAddr (2) and endpoint of each
+#define SRPC_SEND_ZCL_DEV_SET_HDR_LEN 8
+#define SRPC_SEND_ZCL_DEV_SET_DEV_LEN 3
+
+// SRPC_GET_DEV_STATE/LEVEL/HUE/SAT message: addrMode, dstAddr (8),
+// endpoint, panId (2), optionally followed by the max age in ms (2) of
+// a value served from the shadow
+#define SRPC_GET_MAX_AGE_LEN 14
+
 
 //type definitions
 
 typedef uint8_t (*srpcProcessMsg_t)(uint8_t *pBuf, uint32_t clientFd);
 
+// the event a reported attribute is sent as, the same as the one of a read
+typedef struct
+{
+  uint16_t clusterId;
+  uint16_t attrId;
+  uint8_t dataType;
+  uint8_t funcId;
+  uint8_t valueLen;  // of the value in the event, the value as sent padded with zeros
+  uint8_t shadowed;  // the value is kept in the shadow
+} srpcReportEvent_t;
+typedef uint8_t (*srpcZclRead_t)(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
+
+static void srpcReadAttr(srpcZclRead_t zclRead, uint16_t clusterId, uint16_t attrId,
+                         uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode, uint32_t clientFd,
+                         uint16_t maxAgeMs, uint8_t rspFuncId);
+
 //global constants
 
+static const srpcReportEvent_t srpcReportEvents[] =
+{
+  { ZCL_CLUSTER_ID_GEN_ON_OFF, ATTRID_ON_OFF, ZCL_DATATYPE_BOOLEAN, SRPC_GET_DEV_STATE_RSP, 1, TRUE },
+  { ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL, ATTRID_LEVEL_CURRENT_LEVEL, ZCL_DATATYPE_UINT8, SRPC_GET_DEV_LEVEL_RSP, 1, TRUE },
+  { ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL, ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_HUE, ZCL_DATATYPE_UINT8, SRPC_GET_DEV_HUE_RSP, 1, TRUE },
+  { ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL, ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_SATURATION, ZCL_DATATYPE_UINT8, SRPC_GET_DEV_SAT_RSP, 1, TRUE },
+  { ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT, ATTRID_MS_TEMPERATURE_MEASURED_VALUE, ZCL_DATATYPE_INT16, SRPC_TEMP_READING, 2, FALSE },
+  { ZCL_CLUSTER_ID_MS_REL_HUMIDITY_MEASUREMENT, ATTRID_MS_RELATIVE_HUMIDITY_MEASURED_VALUE, ZCL_DATATYPE_UINT16, SRPC_HUMID_READING, 2, FALSE },
+  { ZCL_CLUSTER_ID_SE_SIMPLE_METERING, ATTRID_SE_INSTANTANEOUS_DEMAND, ZCL_DATATYPE_INT24, SRPC_READ_POWER_RSP, 4, FALSE },
+};
+
 const srpcProcessMsg_t rpcsProcessIncoming[] =
 {
   SRPC_close,           //SRPC_CLOSE
@@ -124,7 +210,7 @@ const srpcProcessMsg_t rpcsProcessIncoming[] =
   SRPC_getDeviceTemp,   //SRPC_GET_THERM_READING 
   SRPC_getDevicePower,  //SRPC_GET_POWER_READING 
   SRPC_notSupported,    //SRPC_DISCOVER_DEVICES  
-  SRPC_notSupported,    //SRPC_SEND_ZCL          
+  SRPC_sendZcl,         //SRPC_SEND_ZCL          
   SRPC_getGroups,       //SRPC_GET_GROUPS    
   SRPC_addGroup,        //SRPC_ADD_GROUP     
   SRPC_getScenes,       //SRPC_GET_SCENES    
@@ -139,11 +225,30 @@ const srpcProcessMsg_t rpcsProcessIncoming[] =
   SRPC_installCertificate,  //SRPC_INSTALL_CERTIFICATE
   SRPC_getLastMessage,  //SRPC_GET_LAST_MESSAGE
   SRPC_getCurrentPrice, //SRPC_GET_CURRENT_PRICE
+  SRPC_subscribe,       //SRPC_SUBSCRIBE
+  SRPC_getDeviceList,   //SRPC_GET_DEVICE_LIST
+  SRPC_getServerStats,  //SRPC_GET_SERVER_STATS
+  SRPC_getSocStats,     //SRPC_GET_SOC_STATS
+  SRPC_readAttrs,       //SRPC_READ_ATTRS
+  SRPC_sendZclDevSet,   //SRPC_SEND_ZCL_DEV_SET
 };
 
 //global variables
 
 uint32_t bootloader_initiator_clientFd;
+
+// attributes and clients of the read response frame being sent
+static struct
+{
+  uint8_t valid;
+  uint8_t tracked;
+  uint8_t transSeqNum;
+  uint8_t endpoint;
+  uint16_t nwkAddr;
+  uint16_t clusterId;
+  uint8_t numAttrs;
+  pendingReadsAttr_t attrs[PENDING_READS_MAX_ATTRS];
+} srpcReadRsp;
 uint32 cert_install_clientFd = 0;
 uint32 get_last_message_clientFd = 0;
 uint32 get_current_price_clientFd = 0;
@@ -264,10 +369,85 @@ static void srpcSend(uint8_t* srpcMsg, int fdClient)
   return; 
 }
 
+/***************************************************************************************************
+ * @fn      srpcCoalesceKey
+ *
+ * @brief   Get the key under which a message may replace an older one still
+ *          queued to a slow client. Only messages that carry a latest value
+ *          (attribute readings and progress) are coalesced, events such as
+ *          zone state changes and device announcements never are.
+ * @param   uint8_t* srpcMsg - message to be sent
+ *
+ * @return  key, 0 if the message must not be coalesced
+ ***************************************************************************************************/
+static uint32_t srpcCoalesceKey(uint8_t* srpcMsg)
+{ 
+  switch (srpcMsg[SRPC_FUNC_ID])
+  {
+    case SRPC_GET_DEV_STATE_RSP:
+    case SRPC_GET_DEV_LEVEL_RSP:
+    case SRPC_GET_DEV_HUE_RSP:
+    case SRPC_GET_DEV_SAT_RSP:
+    case SRPC_TEMP_READING:
+    case SRPC_HUMID_READING:
+    case SRPC_READ_POWER_RSP:
+      //cmdId, nwkAddr, endpoint
+      return ((uint32_t) srpcMsg[SRPC_FUNC_ID] << 24) | ((uint32_t) srpcMsg[3] << 16) |
+             ((uint32_t) srpcMsg[2] << 8) | srpcMsg[4];
+    case SRPC_SBL_PROGRESS:
+      return ((uint32_t) srpcMsg[SRPC_FUNC_ID] << 24);
+    default:
+      return 0;
+  }
+}
+
+/***************************************************************************************************
+ * @fn      srpcEventCluster
+ *
+ * @brief   Get the cluster an event relates to, for matching cluster
+ *          subscriptions.
+ * @param   uint8_t* srpcMsg - message to be sent
+ *
+ * @return  cluster ID, SUBS_NO_CLUSTER if the event has none
+ ***************************************************************************************************/
+static uint16_t srpcEventCluster(uint8_t* srpcMsg)
+{ 
+  switch (srpcMsg[SRPC_FUNC_ID])
+  {
+    case SRPC_GET_DEV_STATE_RSP:
+      return ZCL_CLUSTER_ID_GEN_ON_OFF;
+    case SRPC_GET_DEV_LEVEL_RSP:
+      return ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL;
+    case SRPC_GET_DEV_HUE_RSP:
+    case SRPC_GET_DEV_SAT_RSP:
+      return ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL;
+    case SRPC_TEMP_READING:
+      return ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT;
+    case SRPC_HUMID_READING:
+      return ZCL_CLUSTER_ID_MS_REL_HUMIDITY_MEASUREMENT;
+    case SRPC_READ_POWER_RSP:
+      return ZCL_CLUSTER_ID_SE_SIMPLE_METERING;
+    case SRPC_ZONESTATE_CHANGE:
+      return ZCL_CLUSTER_ID_SS_IAS_ZONE;
+    case SRPC_DISPLAY_MESSAGE_IND:
+      return ZCL_CLUSTER_ID_SE_MESSAGE;
+    case SRPC_PUBLISH_PRICE_IND:
+      return ZCL_CLUSTER_ID_SE_PRICING;
+    case SRPC_KEY_ESTABLISHMENT_STATE_IND:
+      return ZCL_CLUSTER_ID_GEN_KEY_ESTABLISHMENT;
+    case SRPC_READ_ATTRS_RSP:
+    case SRPC_REPORT_ATTRS:
+      return BUILD_UINT16(srpcMsg[5], srpcMsg[6]);
+    default:
+      return SUBS_NO_CLUSTER;
+  }
+}
+
 /***************************************************************************************************
  * @fn      srpcSendAll
  *
- * @brief   Send a message over SRPC to all clients.
+ * @brief   Send a message over SRPC to all clients subscribed to it.
+ *          Clients without filters get every message.
  * @param   uint8_t* srpcMsg - message to be sent
  *
  * @return  Status
@@ -275,8 +455,45 @@ static void srpcSend(uint8_t* srpcMsg, int fdClient)
 static void srpcSendAll(uint8_t* srpcMsg)
 { 
   int rtn;
+  int *fds;
+  uint32_t numFds;
+  uint8_t hasDevice, endpoint = 0;
+  uint16_t nwkAddr = 0;
  
-  rtn = socketSeverSendAllclients(srpcMsg, (srpcMsg[SRPC_MSG_LEN] + 2));
+  switch (srpcMsg[SRPC_FUNC_ID])
+  {
+    case SRPC_NEW_DEVICE:
+    case SRPC_GET_DEV_STATE_RSP:
+    case SRPC_GET_DEV_LEVEL_RSP:
+    case SRPC_GET_DEV_HUE_RSP:
+    case SRPC_GET_DEV_SAT_RSP:
+    case SRPC_TEMP_READING:
+    case SRPC_HUMID_READING:
+    case SRPC_READ_POWER_RSP:
+    case SRPC_ZONESTATE_CHANGE:
+    case SRPC_READ_ATTRS_RSP:
+    case SRPC_REPORT_ATTRS:
+      //payload starts with nwkAddr, endpoint
+      hasDevice = TRUE;
+      nwkAddr = BUILD_UINT16(srpcMsg[2], srpcMsg[3]);
+      endpoint = srpcMsg[4];
+      break;
+    default:
+      hasDevice = FALSE;
+      break;
+  }
+
+  fds = subscriptionsGetSubscribers(srpcMsg[SRPC_FUNC_ID], srpcEventCluster(srpcMsg), hasDevice,
+                                    nwkAddr, endpoint, &numFds);
+  if (fds == NULL)
+  {
+    //out of memory, fall back to sending to everybody
+    rtn = socketSeverSendAllclientsKeyed(srpcMsg, (srpcMsg[SRPC_MSG_LEN] + 2), srpcCoalesceKey(srpcMsg));
+  }
+  else
+  {
+    rtn = socketSeverSendClientsKeyed(srpcMsg, (srpcMsg[SRPC_MSG_LEN] + 2), srpcCoalesceKey(srpcMsg), fds, numFds);
+  }
   if (rtn < 0) 
   {
     printf("ERROR writing to socket\n");
@@ -285,6 +502,107 @@ static void srpcSendAll(uint8_t* srpcMsg)
   return; 
 }
 
+/***************************************************************************************************
+ * @fn      srpcReadRspClients
+ *
+ * @brief   Get the clients waiting for an attribute of a read response.
+ *          A response frame is sent as an event per attribute and a
+ *          read attributes response, the attributes are kept until the
+ *          latter so every client gets the events of the attributes it
+ *          asked for and the read attributes response.
+ * @param   transSeqNum - ZCL transaction sequence number of the response
+ * @param   nwkAddr - device that sent the response
+ * @param   endpoint - endpoint of the device
+ * @param   clusterId - cluster of the response
+ * @param   attrId - attribute, SRPC_READ_ATTRS_ATTR_ID for the clients
+ *          that sent a SRPC_READ_ATTRS
+ * @param   fds - clients, PENDING_READS_MAX_ATTRS * PENDING_READS_MAX_CLIENTS
+ * @param   numFds - number of clients
+ *
+ * @return  FALSE if the read was not tracked
+ ***************************************************************************************************/
+static uint8_t srpcReadRspClients(uint8_t transSeqNum, uint16_t nwkAddr, uint8_t endpoint, uint16_t clusterId,
+                                  uint16_t attrId, int *fds, uint32_t *numFds)
+{
+  pendingReadsAttr_t *attrs;
+  uint32_t i, j, k;
+
+  if (!(srpcReadRsp.valid && (srpcReadRsp.transSeqNum == transSeqNum) && 
+      (srpcReadRsp.nwkAddr == nwkAddr) && (srpcReadRsp.endpoint == endpoint) && 
+      (srpcReadRsp.clusterId == clusterId)))
+  {
+    attrs = pendingReadsComplete(transSeqNum, nwkAddr, endpoint, clusterId, &srpcReadRsp.numAttrs);
+
+    srpcReadRsp.valid = TRUE;
+    srpcReadRsp.transSeqNum = transSeqNum;
+    srpcReadRsp.nwkAddr = nwkAddr;
+    srpcReadRsp.endpoint = endpoint;
+    srpcReadRsp.clusterId = clusterId;
+    srpcReadRsp.tracked = (attrs != NULL);
+    if (attrs != NULL)
+    {
+      memcpy(srpcReadRsp.attrs, attrs, srpcReadRsp.numAttrs * sizeof(pendingReadsAttr_t));
+    }
+  }
+
+  *numFds = 0;
+
+  for (i = 0; i < srpcReadRsp.numAttrs; i++)
+  {
+    pendingReadsAttr_t *attr = &srpcReadRsp.attrs[i];
+
+    if ((attr->attrId != attrId) && (attr->attrId != SRPC_READ_ATTRS_ATTR_ID))
+    {
+      continue;
+    }
+
+    //a client may wait for several attributes of the frame
+    for (j = 0; j < attr->numFds; j++)
+    {
+      for (k = 0; (k < *numFds) && (fds[k] != attr->fds[j]); k++);
+
+      if (k == *numFds)
+      {
+        fds[(*numFds)++] = attr->fds[j];
+      }
+    }
+  }
+
+  return srpcReadRsp.tracked;
+}
+
+/***************************************************************************************************
+ * @fn      srpcSendReadRsp
+ *
+ * @brief   Send an attribute read response to the clients that asked
+ *          for the attribute. Responses to reads the gateway did not
+ *          track (groupcast or timed out) go to all subscribed clients.
+ * @param   uint8_t* srpcMsg - message to be sent, starts with nwkAddr, endpoint
+ * @param   transSeqNum - ZCL transaction sequence number of the response
+ * @param   clusterId - cluster of the attribute
+ * @param   attrId - attribute of the message
+ *
+ * @return  Status
+ ***************************************************************************************************/
+static void srpcSendReadRsp(uint8_t* srpcMsg, uint8_t transSeqNum, uint16_t clusterId, uint16_t attrId)
+{ 
+  int fds[PENDING_READS_MAX_ATTRS * PENDING_READS_MAX_CLIENTS];
+  uint32_t numFds;
+
+  if (!srpcReadRspClients(transSeqNum, BUILD_UINT16(srpcMsg[2], srpcMsg[3]), srpcMsg[4], clusterId, attrId, 
+         fds, &numFds))
+  {
+    srpcSendAll(srpcMsg);
+  }
+  else if ((numFds > 0) && (socketSeverSendClientsKeyed(srpcMsg, (srpcMsg[SRPC_MSG_LEN] + 2),
+             srpcCoalesceKey(srpcMsg), fds, numFds) < 0))
+  {
+    printf("ERROR writing to socket\n");
+  }
+    
+  return; 
+}
+
 
 /***************************************************************************************************
  * @fn      SRPC_CallBack_loadImageRsp
@@ -372,15 +690,18 @@ static uint8_t SRPC_sblDownloadImage(uint8_t *pBuf, uint32_t clientFd)
 {
   uint16_t filenameLength;
   uint8_t progressReportingInterval;
-  char * filename;
+  char filename[256];
+  uint8_t msgLen = pBuf[SRPC_MSG_LEN];
 
   pBuf+=2; //increment past SRPC header
   filenameLength = BUILD_UINT16(pBuf[0], pBuf[1]);
   pBuf+=2;
   progressReportingInterval = *pBuf++;
-  //todo: verify that the actual received packet is long enough to contain the filename of the length reported.
-  filename = (char *)pBuf;
-  filename[filenameLength] = '\0'; //todo: make sure pBuf is long enough to contain this extra character
+  //the message is processed in place, so copy the filename out rather than
+  //terminating it in the buffer, which would overwrite the next message
+  filenameLength = MIN(filenameLength, (msgLen > 3) ? (msgLen - 3) : 0);
+  memcpy(filename, pBuf, filenameLength);
+  filename[filenameLength] = '\0';
 
   if (SocketBootloadingState != SOCKET_BOOTLOADING_STATE_IDLE)
   {
@@ -462,6 +783,11 @@ void SRPC_ProcessIncoming(uint8_t *pBuf, uint32_t clientFd)
   
 //  printf("SRPC_ProcessIncoming++[%x]\n", pBuf[SRPC_FUNC_ID]);
   /* look up and call processing function */
+  if ((pBuf[SRPC_FUNC_ID] & ~(0x80)) >= (sizeof(rpcsProcessIncoming) / sizeof(rpcsProcessIncoming[0])))
+  {
+    //printf("Error: no processing function for CMD 0x%x\n", pBuf[SRPC_FUNC_ID]); 
+    return;
+  }
   func = rpcsProcessIncoming[(pBuf[SRPC_FUNC_ID] & ~(0x80))];
   if (func)
   {
@@ -577,6 +903,9 @@ static uint8_t SRPC_storeScene(uint8_t *pBuf, uint32_t clientFd)
 
 //  printf("SRPC_storeScene++: name[%d] %s, group %d, scene %d \n", nameLen, nameStr + 1, groupId, sceneId);
 
+  //the scene must store the latest state, level and color
+  groupcastFlush(dstAddr, endpoint, addrMode);
+  coalesceFlush(dstAddr, endpoint, addrMode);
   zbSocStoreScene(groupId, sceneId, dstAddr, endpoint, addrMode);
   SRPC_CallBack_addSceneRsp(groupId, sceneId, nameStr, clientFd);
 
@@ -635,7 +964,10 @@ static uint8_t SRPC_recallScene(uint8_t *pBuf, uint32_t clientFd)
 
 //  printf("SRPC_recallScene++: name[%d] %s, group %d, scene %d \n", nameLen + 1, nameStr + 1, groupId, sceneId);
 
+  groupcastFlush(dstAddr, endpoint, addrMode);
+  coalesceFlush(dstAddr, endpoint, addrMode);
   zbSocRecallScene(groupId, sceneId, dstAddr, endpoint, addrMode);
+  shadowInvalidate(dstAddr, endpoint, addrMode);
 
   free(nameStr);
   
@@ -851,8 +1183,9 @@ static uint8_t SRPC_setDeviceState(uint8_t *pBuf, uint32_t clientFd)
   
 //  printf("SRPC_setDeviceState: dstAddr.addr.shortAddr=%x, endpoint=%x dstAddr.mode=%x, state=%x\n", dstAddr, endpoint, addrMode, state); 
     
-  // Set light state on/off
-  zbSocSetState(state, dstAddr, endpoint, addrMode);
+  // Set light state on/off, after the level and color commands held for it
+  coalesceFlush(dstAddr, endpoint, addrMode);
+  groupcastSetState(state, dstAddr, endpoint, addrMode);
 
   //printf("SRPC_setDeviceState--\n");
   
@@ -894,7 +1227,8 @@ static uint8_t SRPC_setDeviceLevel(uint8_t *pBuf, uint32_t clientFd)
   
 //  printf("SRPC_setDeviceLevel: dstAddr.addr.shortAddr=%x ,level=%x, tr=%x \n", dstAddr, level, transitionTime); 
     
-  zbSocSetLevel(level, transitionTime, dstAddr, endpoint, addrMode);
+  groupcastFlush(dstAddr, endpoint, addrMode);
+  coalesceSetLevel(level, transitionTime, dstAddr, endpoint, addrMode);
   
   //printf("SRPC_setDeviceLevel--\n");
   
@@ -938,13 +1272,276 @@ static uint8_t SRPC_setDeviceColor(uint8_t *pBuf, uint32_t clientFd)
   
 //  printf("SRPC_setDeviceColor: dstAddr=%x ,hue=%x, saturation=%x, tr=%x \n", dstAddr, hue, saturation, transitionTime); 
     
-  zbSocSetHueSat(hue, saturation, transitionTime, dstAddr, endpoint, addrMode);
+  groupcastFlush(dstAddr, endpoint, addrMode);
+  coalesceSetHueSat(hue, saturation, transitionTime, dstAddr, endpoint, addrMode);
   
   //printf("SRPC_setDeviceColor--\n");
   
   return 0;
 }
 
+/*********************************************************************
+ * @fn          srpcReadAttr
+ *
+ * @brief       Read an attribute for a client. A unicast read is merged
+ *              with a read of the same attribute that is in flight, or
+ *              sent and tracked so the response only goes to the clients
+ *              that asked for it.
+ *
+ * @param       zclRead - zbSoc function sending the read
+ * @param       clusterId - cluster of the attribute
+ * @param       attrId - attribute
+ * @param       dstAddr - Nwk Addr or Group ID
+ * @param       endpoint - endpoint of the device
+ * @param       addrMode - Unicast or Group cast
+ * @param       clientFd - client that asked for the attribute
+ * @param       maxAgeMs - age of a shadowed value the client accepts
+ *              instead of a read, 0 always reads
+ * @param       rspFuncId - response sent with a shadowed value
+ *
+ * @return      none
+ */
+static void srpcReadAttr(srpcZclRead_t zclRead, uint16_t clusterId, uint16_t attrId,
+                         uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode, uint32_t clientFd,
+                         uint16_t maxAgeMs, uint8_t rspFuncId)
+{
+  uint8_t pSrpcMessage[2 + 4];
+  uint8_t value;
+
+  //read the value of the commands the client already sent
+  groupcastFlush(dstAddr, endpoint, addrMode);
+  coalesceFlush(dstAddr, endpoint, addrMode);
+
+  if ((addrMode == afAddr16Bit) && 
+      shadowGet(dstAddr, endpoint, clusterId, attrId, maxAgeMs, &value))
+  {
+    //same response as a read, only to the client that asked
+    pSrpcMessage[0] = rspFuncId;
+    pSrpcMessage[1] = 4;
+    pSrpcMessage[2] = LO_UINT16(dstAddr);
+    pSrpcMessage[3] = HI_UINT16(dstAddr);
+    pSrpcMessage[4] = endpoint;
+    pSrpcMessage[5] = value;
+    srpcSend(pSrpcMessage, clientFd);
+    return;
+  }
+
+  if (addrMode != afAddr16Bit)
+  {
+    //every member of the group responds, send the responses to all clients
+    zclRead(dstAddr, endpoint, addrMode);
+    return;
+  }
+
+  if (pendingReadsJoin(clientFd, dstAddr, endpoint, clusterId, attrId))
+  {
+    return;
+  }
+
+  //read with the other attributes of the cluster asked for meanwhile
+  readBatchAdd(clientFd, dstAddr, endpoint, clusterId, attrId);
+}
+
+/*********************************************************************
+ * @fn          SRPC_sendZcl
+ *
+ * @brief       This function exposes an interface to send any ZCL command,
+ *              e.g. of a cluster the gateway has no command for. The 
+ *              message is addrMode, dstAddr, endpoint, panId, clusterId, 
+ *              frame control, manufacturer code, command id, payload 
+ *              length and the payload.
+ *
+ * @param       pBuf - incomin messages
+ *
+ * @return      afStatus_t
+ */
+static uint8_t SRPC_sendZcl(uint8_t *pBuf, uint32_t clientFd)
+{
+  uint8_t endpoint, addrMode, frameControl, commandId, payloadLen, msgLen;
+  uint16_t dstAddr, clusterId, manuCode;
+
+  msgLen = pBuf[SRPC_MSG_LEN];
+
+  //increment past SRPC header
+  pBuf+=2;
+
+  addrMode = (afAddrMode_t)*pBuf++;   
+  dstAddr = BUILD_UINT16(pBuf[0], pBuf[1]);
+  pBuf += Z_EXTADDR_LEN;
+  endpoint = *pBuf++;
+  // index past panId
+  pBuf += 2;
+
+  clusterId = BUILD_UINT16(pBuf[0], pBuf[1]);
+  pBuf += 2;
+  frameControl = *pBuf++;
+  manuCode = BUILD_UINT16(pBuf[0], pBuf[1]);
+  pBuf += 2;
+  commandId = *pBuf++;
+  payloadLen = *pBuf++;
+
+  if ((msgLen < SRPC_SEND_ZCL_HDR_LEN) || (payloadLen > (msgLen - SRPC_SEND_ZCL_HDR_LEN)))
+  {
+    printf("SRPC_sendZcl: payload len %d does not fit the message\n", payloadLen);
+    return 0;
+  }
+
+  //keep the order with the commands held for the device
+  groupcastFlush(dstAddr, endpoint, addrMode);
+  coalesceFlush(dstAddr, endpoint, addrMode);
+
+  if (zbSocSendZcl(dstAddr, endpoint, addrMode, clusterId, frameControl, manuCode, 
+        commandId, pBuf, payloadLen) < 0)
+  {
+    printf("SRPC_sendZcl: payload len %d too long\n", payloadLen);
+  }
+
+  //the command may change any value, e.g. a toggle or step
+  shadowInvalidate(dstAddr, endpoint, addrMode);
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn          SRPC_sendZclDevSet
+ *
+ * @brief       This function exposes an interface to send a ZCL command to
+ *              a set of devices. The message is clusterId, frame control,
+ *              manufacturer code, command id, payload length, the payload,
+ *              the number of devices and the nwkAddr and endpoint of each.
+ *              When the set is exactly the members of a group the command
+ *              is sent as one groupcast.
+ *
+ * @param       pBuf - incomin messages
+ *
+ * @return      afStatus_t
+ */
+static uint8_t SRPC_sendZclDevSet(uint8_t *pBuf, uint32_t clientFd)
+{
+  uint8_t frameControl, commandId, payloadLen, numDevices, msgLen, i;
+  uint16_t clusterId, manuCode;
+  uint16_t nwkAddrs[GROUPCAST_MAX];
+  uint8_t endpoints[GROUPCAST_MAX];
+  uint8_t *payload;
+
+  msgLen = pBuf[SRPC_MSG_LEN];
+
+  //increment past SRPC header
+  pBuf+=2;
+
+  clusterId = BUILD_UINT16(pBuf[0], pBuf[1]);
+  pBuf += 2;
+  frameControl = *pBuf++;
+  manuCode = BUILD_UINT16(pBuf[0], pBuf[1]);
+  pBuf += 2;
+  commandId = *pBuf++;
+  payloadLen = *pBuf++;
+
+  if ((msgLen < SRPC_SEND_ZCL_DEV_SET_HDR_LEN) || (payloadLen > (msgLen - SRPC_SEND_ZCL_DEV_SET_HDR_LEN)))
+  {
+    printf("SRPC_sendZclDevSet: payload len %d does not fit the message\n", payloadLen);
+    return 0;
+  }
+
+  payload = pBuf;
+  pBuf += payloadLen;
+  numDevices = *pBuf++;
+
+  if ((numDevices == 0) || (numDevices > GROUPCAST_MAX) || 
+      ((numDevices * SRPC_SEND_ZCL_DEV_SET_DEV_LEN) > (msgLen - SRPC_SEND_ZCL_DEV_SET_HDR_LEN - payloadLen)))
+  {
+    printf("SRPC_sendZclDevSet: %d devices do not fit the message\n", numDevices);
+    return 0;
+  }
+
+  for (i = 0; i < numDevices; i++)
+  {
+    nwkAddrs[i] = BUILD_UINT16(pBuf[0], pBuf[1]);
+    endpoints[i] = pBuf[2];
+    pBuf += SRPC_SEND_ZCL_DEV_SET_DEV_LEN;
+  }
+
+  if (groupcastSendZcl(nwkAddrs, endpoints, numDevices, clusterId, frameControl, manuCode, 
+        commandId, payload, payloadLen) < 0)
+  {
+    printf("SRPC_sendZclDevSet: payload len %d too long\n", payloadLen);
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn          SRPC_readAttrs
+ *
+ * @brief       This function exposes an interface to read attributes of a
+ *              cluster in one round trip. The message is addrMode, 
+ *              dstAddr, endpoint, panId, clusterId, number of attributes
+ *              and the attribute ids. The device answers with a
+ *              SRPC_READ_ATTRS_RSP.
+ *
+ * @param       pBuf - incomin messages
+ *
+ * @return      afStatus_t
+ */
+static uint8_t SRPC_readAttrs(uint8_t *pBuf, uint32_t clientFd)
+{
+  uint8_t endpoint, addrMode, numAttrs, msgLen, i;
+  uint16_t dstAddr, clusterId;
+  uint16_t attrIds[ZBSOC_ZCL_MAX_PAYLOAD / 2];
+  int32_t tsn;
+
+  msgLen = pBuf[SRPC_MSG_LEN];
+
+  //increment past SRPC header
+  pBuf+=2;
+
+  addrMode = (afAddrMode_t)*pBuf++;   
+  dstAddr = BUILD_UINT16(pBuf[0], pBuf[1]);
+  pBuf += Z_EXTADDR_LEN;
+  endpoint = *pBuf++;
+  // index past panId
+  pBuf += 2;
+
+  clusterId = BUILD_UINT16(pBuf[0], pBuf[1]);
+  pBuf += 2;
+  numAttrs = *pBuf++;
+
+  if ((msgLen < SRPC_READ_ATTRS_HDR_LEN) || (numAttrs == 0) || 
+      (numAttrs > (sizeof(attrIds) / sizeof(attrIds[0]))) ||
+      ((numAttrs * 2) > (msgLen - SRPC_READ_ATTRS_HDR_LEN)))
+  {
+    printf("SRPC_readAttrs: %d attributes do not fit the message\n", numAttrs);
+    return 0;
+  }
+
+  for (i = 0; i < numAttrs; i++)
+  {
+    attrIds[i] = BUILD_UINT16(pBuf[0], pBuf[1]);
+    pBuf += 2;
+  }
+
+  //read the value of the commands the client already sent
+  groupcastFlush(dstAddr, endpoint, addrMode);
+  coalesceFlush(dstAddr, endpoint, addrMode);
+
+  tsn = zbSocReadAttrs(clusterId, attrIds, numAttrs, dstAddr, endpoint, addrMode);
+
+  //every member of a group responds with the tsn of the groupcast, the
+  //responses can not be tracked and only go out as the events of the
+  //single attributes
+  if ((tsn >= 0) && (addrMode == afAddr16Bit))
+  {
+    pendingReadsAttr_t attr;
+
+    attr.attrId = SRPC_READ_ATTRS_ATTR_ID;
+    attr.numFds = 1;
+    attr.fds[0] = clientFd;
+    pendingReadsAdd(tsn, dstAddr, endpoint, clusterId, &attr, 1);
+  }
+
+  return 0;
+}
+
 /*********************************************************************
  * @fn          SRPC_getDeviceState
  *
@@ -956,11 +1553,13 @@ static uint8_t SRPC_setDeviceColor(uint8_t *pBuf, uint32_t clientFd)
  */
 static uint8_t SRPC_getDeviceState(uint8_t *pBuf, uint32_t clientFd)
 {
-  uint8_t endpoint, addrMode;
-  uint16_t dstAddr;
+  uint8_t endpoint, addrMode, msgLen;
+  uint16_t dstAddr, maxAge = 0;
  
   //printf("SRPC_getDeviceState++\n");
        
+  msgLen = pBuf[SRPC_MSG_LEN];
+
   //increment past SRPC header
   pBuf+=2;
 
@@ -970,11 +1569,17 @@ static uint8_t SRPC_getDeviceState(uint8_t *pBuf, uint32_t clientFd)
   endpoint = *pBuf++;
   // index past panId
   pBuf += 2;
+
+  if (msgLen >= SRPC_GET_MAX_AGE_LEN)
+  {
+    maxAge = BUILD_UINT16(pBuf[0], pBuf[1]);
+  }
   
 //  printf("SRPC_getDeviceState: dstAddr.addr.shortAddr=%x, endpoint=%x dstAddr.mode=%x", dstAddr, endpoint, addrMode); 
     
   // Get light state on/off
-  zbSocGetState(dstAddr, endpoint, addrMode);
+  srpcReadAttr(zbSocGetState, ZCL_CLUSTER_ID_GEN_ON_OFF, ATTRID_ON_OFF,
+    dstAddr, endpoint, addrMode, clientFd, maxAge, SRPC_GET_DEV_STATE_RSP);
 
   //printf("SRPC_getDeviceState--\n");
   
@@ -992,11 +1597,13 @@ static uint8_t SRPC_getDeviceState(uint8_t *pBuf, uint32_t clientFd)
  */
 static uint8_t SRPC_getDeviceLevel(uint8_t *pBuf, uint32_t clientFd)
 {
-  uint8_t endpoint, addrMode;
-  uint16_t dstAddr;
+  uint8_t endpoint, addrMode, msgLen;
+  uint16_t dstAddr, maxAge = 0;
  
   //printf("SRPC_getDeviceLevel++\n");
        
+  msgLen = pBuf[SRPC_MSG_LEN];
+
   //increment past SRPC header
   pBuf+=2;
 
@@ -1006,11 +1613,17 @@ static uint8_t SRPC_getDeviceLevel(uint8_t *pBuf, uint32_t clientFd)
   endpoint = *pBuf++;
   // index past panId
   pBuf += 2;
+
+  if (msgLen >= SRPC_GET_MAX_AGE_LEN)
+  {
+    maxAge = BUILD_UINT16(pBuf[0], pBuf[1]);
+  }
   
 //  printf("SRPC_getDeviceLevel: dstAddr.addr.shortAddr=%x, endpoint=%x dstAddr.mode=%x\n", dstAddr, endpoint, addrMode); 
     
   // Get light level
-  zbSocGetLevel(dstAddr, endpoint, addrMode);
+  srpcReadAttr(zbSocGetLevel, ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL, ATTRID_LEVEL_CURRENT_LEVEL,
+    dstAddr, endpoint, addrMode, clientFd, maxAge, SRPC_GET_DEV_LEVEL_RSP);
 
   //printf("SRPC_getDeviceLevel--\n");
   
@@ -1028,11 +1641,13 @@ static uint8_t SRPC_getDeviceLevel(uint8_t *pBuf, uint32_t clientFd)
  */
 static uint8_t SRPC_getDeviceHue(uint8_t *pBuf, uint32_t clientFd)
 {
-  uint8_t endpoint, addrMode;
-  uint16_t dstAddr;
+  uint8_t endpoint, addrMode, msgLen;
+  uint16_t dstAddr, maxAge = 0;
  
   //printf("SRPC_getDeviceHue++\n");
        
+  msgLen = pBuf[SRPC_MSG_LEN];
+
   //increment past SRPC header
   pBuf+=2;
 
@@ -1042,11 +1657,17 @@ static uint8_t SRPC_getDeviceHue(uint8_t *pBuf, uint32_t clientFd)
   endpoint = *pBuf++;
   // index past panId
   pBuf += 2;
+
+  if (msgLen >= SRPC_GET_MAX_AGE_LEN)
+  {
+    maxAge = BUILD_UINT16(pBuf[0], pBuf[1]);
+  }
   
 //  printf("SRPC_getDeviceHue: dstAddr.addr.shortAddr=%x, endpoint=%x dstAddr.mode=%x\n", dstAddr, endpoint, addrMode); 
     
   // Get light hue
-  zbSocGetHue(dstAddr, endpoint, addrMode);
+  srpcReadAttr(zbSocGetHue, ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL, ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_HUE,
+    dstAddr, endpoint, addrMode, clientFd, maxAge, SRPC_GET_DEV_HUE_RSP);
 
   //printf("SRPC_getDeviceHue--\n");
   
@@ -1064,11 +1685,13 @@ static uint8_t SRPC_getDeviceHue(uint8_t *pBuf, uint32_t clientFd)
  */
 static uint8_t SRPC_getDeviceSat(uint8_t *pBuf, uint32_t clientFd)
 {
-  uint8_t endpoint, addrMode;
-  uint16_t dstAddr;
+  uint8_t endpoint, addrMode, msgLen;
+  uint16_t dstAddr, maxAge = 0;
  
   //printf("SRPC_getDeviceSat++\n");
        
+  msgLen = pBuf[SRPC_MSG_LEN];
+
   //increment past SRPC header
   pBuf+=2;
 
@@ -1078,11 +1701,17 @@ static uint8_t SRPC_getDeviceSat(uint8_t *pBuf, uint32_t clientFd)
   endpoint = *pBuf++;
   // index past panId
   pBuf += 2;
+
+  if (msgLen >= SRPC_GET_MAX_AGE_LEN)
+  {
+    maxAge = BUILD_UINT16(pBuf[0], pBuf[1]);
+  }
   
 //  printf("SRPC_getDeviceSat: dstAddr.addr.shortAddr=%x, endpoint=%x dstAddr.mode=%x\n", dstAddr, endpoint, addrMode); 
     
   // Get light sat
-  zbSocGetSat(dstAddr, endpoint, addrMode);
+  srpcReadAttr(zbSocGetSat, ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL, ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_SATURATION,
+    dstAddr, endpoint, addrMode, clientFd, maxAge, SRPC_GET_DEV_SAT_RSP);
 
   //printf("SRPC_getDeviceSat--\n");
   
@@ -1118,7 +1747,8 @@ static uint8_t SRPC_getDeviceTemp(uint8_t *pBuf, uint32_t clientFd)
   printf("SRPC_getDeviceTemp: dstAddr.addr.shortAddr=%x, endpoint=%x dstAddr.mode=%x\n", dstAddr, endpoint, addrMode); 
     
   // Get light sat
-  zbSocGetTemp(dstAddr, endpoint, addrMode);
+  srpcReadAttr(zbSocGetTemp, ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT, ATTRID_MS_TEMPERATURE_MEASURED_VALUE,
+    dstAddr, endpoint, addrMode, clientFd, 0, 0);
 
   //printf("SRPC_getDeviceTemp--\n");
   
@@ -1155,7 +1785,8 @@ static uint8_t SRPC_getDeviceHumid(uint8_t *pBuf, uint32_t clientFd)
   printf("SRPC_getDeviceHumid: dstAddr.addr.shortAddr=%x, endpoint=%x dstAddr.mode=%x\n", dstAddr, endpoint, addrMode); 
     
   // Get light sat
-  zbSocGetHumid(dstAddr, endpoint, addrMode);
+  srpcReadAttr(zbSocGetHumid, ZCL_CLUSTER_ID_MS_REL_HUMIDITY_MEASUREMENT, ATTRID_MS_RELATIVE_HUMIDITY_MEASURED_VALUE,
+    dstAddr, endpoint, addrMode, clientFd, 0, 0);
 
   //printf("SRPC_getDeviceHumid--\n");
   
@@ -1191,7 +1822,8 @@ static uint8_t SRPC_getDevicePower(uint8_t *pBuf, uint32_t clientFd)
   printf("SRPC_getDevicePower: dstAddr.addr.shortAddr=%x, endpoint=%x dstAddr.mode=%x\n", dstAddr, endpoint, addrMode); 
     
   // Get light sat
-  zbSocReadPower(dstAddr, endpoint, addrMode);
+  srpcReadAttr(zbSocReadPower, ZCL_CLUSTER_ID_SE_SIMPLE_METERING, ATTRID_SE_INSTANTANEOUS_DEMAND,
+    dstAddr, endpoint, addrMode, clientFd, 0, 0);
 
   printf("SRPC_getDevicePower--\n");
   
@@ -1212,15 +1844,18 @@ static uint8_t SRPC_installCertificate(uint8_t *pBuf, uint32_t clientFd)
   uint16_t filenameLength;
   uint8_t status;
   uint8_t force2reset;
-  char * filename;
+  char filename[256];
+  uint8_t msgLen = pBuf[SRPC_MSG_LEN];
 
   pBuf+=2; //increment past SRPC header
   filenameLength = BUILD_UINT16(pBuf[0], pBuf[1]);
   pBuf+=2;
   force2reset = *pBuf++;
-  //todo: verify that the actual received packet is long enough to contain the filename of the length reported.
-  filename = (char *)pBuf;
-  filename[filenameLength] = '\0'; //todo: make sure pBuf is long enough to contain this extra character
+  //the message is processed in place, so copy the filename out rather than
+  //terminating it in the buffer, which would overwrite the next message
+  filenameLength = MIN(filenameLength, (msgLen > 3) ? (msgLen - 3) : 0);
+  memcpy(filename, pBuf, filenameLength);
+  filename[filenameLength] = '\0';
   
 //  printf("SRPC_installCertificate: filename = %s, force2reset = %d\n", filename, force2reset); 
     
@@ -1316,6 +1951,70 @@ static uint8_t SRPC_getCurrentPrice(uint8_t *pBuf, uint32_t clientFd)
   return 0;
 }
 
+/***************************************************************************************************
+ * @fn          SRPC_subscribe
+ *
+ * @brief       Adds or removes an event filter of the client, or clears
+ *              all of them. A client with no filters gets every event,
+ *              otherwise only the events matching one of its filters.
+ *              Responds with SRPC_SUBSCRIBE_RSP.
+ *
+ * @param       pBuf - incomin messages: op, filter type, filter value
+ *
+ * @return      afStatus_t
+ ***************************************************************************************************/
+static uint8_t SRPC_subscribe(uint8_t *pBuf, uint32_t clientFd)
+{
+  uint8_t op, type, status, valueLen;
+  uint8_t msgLen = pBuf[SRPC_MSG_LEN];
+  uint8_t pSrpcMessage[2 + 2];
+
+  //increment past SRPC header
+  pBuf+=2;
+
+  op = (msgLen > 0) ? pBuf[0] : 0xFF;
+  type = (msgLen > 1) ? pBuf[1] : 0;
+
+  switch (type)
+  {
+    case SUBS_FILTER_MSG_TYPE: valueLen = 1; break;
+    case SUBS_FILTER_CLUSTER: valueLen = 2; break;
+    case SUBS_FILTER_NWK_EP: valueLen = 3; break;
+    case SUBS_FILTER_IEEE: valueLen = Z_EXTADDR_LEN; break;
+    default: valueLen = 0xFF; break;
+  }
+
+  if (op == SUBS_OP_CLEAR)
+  {
+    status = subscriptionsClear(clientFd);
+  }
+  else if ((valueLen == 0xFF) || (msgLen < (2 + valueLen)))
+  {
+    status = SUBS_STATUS_INVALID;
+  }
+  else if (op == SUBS_OP_ADD)
+  {
+    status = subscriptionsAddFilter(clientFd, type, &pBuf[2]);
+  }
+  else if (op == SUBS_OP_REMOVE)
+  {
+    status = subscriptionsRemoveFilter(clientFd, type, &pBuf[2]);
+  }
+  else
+  {
+    status = SUBS_STATUS_INVALID;
+  }
+
+  pSrpcMessage[0] = SRPC_SUBSCRIBE_RSP;
+  pSrpcMessage[1] = 2;
+  pSrpcMessage[2] = status;
+  pSrpcMessage[3] = subscriptionsGetNumFilters(clientFd);
+
+  srpcSend(pSrpcMessage, clientFd);
+
+  return 0;
+}
+
 /*********************************************************************
  * @fn          SRPC_close
  *
@@ -1561,7 +2260,7 @@ void SRPC_CallBack_addSceneRsp(uint16_t groupId, uint8_t sceneId, char *nameStr,
   *
  * @return  Status
  ***************************************************************************************************/
-void SRPC_CallBack_getStateRsp(uint8_t state, uint16_t srcAddr, uint8_t endpoint, uint32_t clientFd)
+void SRPC_CallBack_getStateRsp(uint8_t state, uint16_t srcAddr, uint8_t endpoint, uint8_t transSeqNum)
 {
   uint8_t * pBuf;
   uint8_t pSrpcMessage[2 + 4];
@@ -1584,8 +2283,11 @@ void SRPC_CallBack_getStateRsp(uint8_t state, uint16_t srcAddr, uint8_t endpoint
         
   //printf("SRPC_CallBack_getStateRsp: state=%x\n", state);
   
-  //Store the device that sent the request, for now send to all clients
-  srpcSendAll(pSrpcMessage);  
+  //serve later gets with a max age from the shadow
+  shadowUpdate(srcAddr, endpoint, ZCL_CLUSTER_ID_GEN_ON_OFF, ATTRID_ON_OFF, state);
+
+  //send to the clients that asked for it
+  srpcSendReadRsp(pSrpcMessage, transSeqNum, ZCL_CLUSTER_ID_GEN_ON_OFF, ATTRID_ON_OFF);
 
   //printf("SRPC_CallBack_addSceneRsp--\n");
                     
@@ -1599,7 +2301,7 @@ void SRPC_CallBack_getStateRsp(uint8_t state, uint16_t srcAddr, uint8_t endpoint
   *
  * @return  Status
  ***************************************************************************************************/
-void SRPC_CallBack_getLevelRsp(uint8_t level, uint16_t srcAddr, uint8_t endpoint, uint32_t clientFd)
+void SRPC_CallBack_getLevelRsp(uint8_t level, uint16_t srcAddr, uint8_t endpoint, uint8_t transSeqNum)
 {
   uint8_t * pBuf;  
   uint8_t pSrpcMessage[2 + 4];
@@ -1622,8 +2324,11 @@ void SRPC_CallBack_getLevelRsp(uint8_t level, uint16_t srcAddr, uint8_t endpoint
         
   //printf("SRPC_CallBack_getLevelRsp: level=%x\n", level);
   
-  //Store the device that sent the request, for now send to all clients
-  srpcSendAll(pSrpcMessage);  
+  //serve later gets with a max age from the shadow
+  shadowUpdate(srcAddr, endpoint, ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL, ATTRID_LEVEL_CURRENT_LEVEL, level);
+
+  //send to the clients that asked for it
+  srpcSendReadRsp(pSrpcMessage, transSeqNum, ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL, ATTRID_LEVEL_CURRENT_LEVEL);
 
   //printf("SRPC_CallBack_getLevelRsp--\n");
                     
@@ -1637,7 +2342,7 @@ void SRPC_CallBack_getLevelRsp(uint8_t level, uint16_t srcAddr, uint8_t endpoint
   *
  * @return  Status
  ***************************************************************************************************/
-void SRPC_CallBack_getHueRsp(uint8_t hue, uint16_t srcAddr, uint8_t endpoint, uint32_t clientFd)
+void SRPC_CallBack_getHueRsp(uint8_t hue, uint16_t srcAddr, uint8_t endpoint, uint8_t transSeqNum)
 {
   uint8_t * pBuf;  
   uint8_t pSrpcMessage[2 + 4];
@@ -1660,8 +2365,11 @@ void SRPC_CallBack_getHueRsp(uint8_t hue, uint16_t srcAddr, uint8_t endpoint, ui
         
   //printf("SRPC_CallBack_getHueRsp: hue=%x\n", hue);
   
-  //Store the device that sent the request, for now send to all clients
-  srpcSendAll(pSrpcMessage);  
+  //serve later gets with a max age from the shadow
+  shadowUpdate(srcAddr, endpoint, ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL, ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_HUE, hue);
+
+  //send to the clients that asked for it
+  srpcSendReadRsp(pSrpcMessage, transSeqNum, ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL, ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_HUE);
 
   //printf("SRPC_CallBack_getHueRsp--\n");
                     
@@ -1675,7 +2383,7 @@ void SRPC_CallBack_getHueRsp(uint8_t hue, uint16_t srcAddr, uint8_t endpoint, ui
   *
  * @return  Status
  ***************************************************************************************************/
-void SRPC_CallBack_getSatRsp(uint8_t sat, uint16_t srcAddr, uint8_t endpoint, uint32_t clientFd)
+void SRPC_CallBack_getSatRsp(uint8_t sat, uint16_t srcAddr, uint8_t endpoint, uint8_t transSeqNum)
 {
   uint8_t * pBuf;  
   uint8_t pSrpcMessage[2 + 4];
@@ -1698,8 +2406,11 @@ void SRPC_CallBack_getSatRsp(uint8_t sat, uint16_t srcAddr, uint8_t endpoint, ui
         
   //printf("SRPC_CallBack_getSatRsp: sat=%x\n", sat);
   
-  //Store the device that sent the request, for now send to all clients
-  srpcSendAll(pSrpcMessage);  
+  //serve later gets with a max age from the shadow
+  shadowUpdate(srcAddr, endpoint, ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL, ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_SATURATION, sat);
+
+  //send to the clients that asked for it
+  srpcSendReadRsp(pSrpcMessage, transSeqNum, ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL, ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_SATURATION);
 
   //printf("SRPC_CallBack_getSatRsp--\n");
                     
@@ -1713,7 +2424,7 @@ void SRPC_CallBack_getSatRsp(uint8_t sat, uint16_t srcAddr, uint8_t endpoint, ui
   *
  * @return  Status
  ***************************************************************************************************/
-void SRPC_CallBack_getTempRsp(uint16_t temp, uint16_t srcAddr, uint8_t endpoint, uint32_t clientFd)
+void SRPC_CallBack_getTempRsp(uint16_t temp, uint16_t srcAddr, uint8_t endpoint, uint8_t transSeqNum)
 {
   uint8_t * pBuf;  
   uint8_t pSrpcMessage[2 + 5];
@@ -1737,8 +2448,8 @@ void SRPC_CallBack_getTempRsp(uint16_t temp, uint16_t srcAddr, uint8_t endpoint,
         
   //printf("SRPC_CallBack_getTempRsp: temp=%x\n", temp);
   
-  //Store the device that sent the request, for now send to all clients
-  srpcSendAll(pSrpcMessage);  
+  //send to the clients that asked for it
+  srpcSendReadRsp(pSrpcMessage, transSeqNum, ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT, ATTRID_MS_TEMPERATURE_MEASURED_VALUE);
 
   //printf("SRPC_CallBack_getSatRsp--\n");
                     
@@ -1752,7 +2463,7 @@ void SRPC_CallBack_getTempRsp(uint16_t temp, uint16_t srcAddr, uint8_t endpoint,
   *
  * @return  Status
  ***************************************************************************************************/
-void SRPC_CallBack_getHumidRsp(uint16_t humid, uint16_t srcAddr, uint8_t endpoint, uint32_t clientFd)
+void SRPC_CallBack_getHumidRsp(uint16_t humid, uint16_t srcAddr, uint8_t endpoint, uint8_t transSeqNum)
 {
   uint8_t * pBuf;  
   uint8_t pSrpcMessage[2 + 5];
@@ -1776,8 +2487,8 @@ void SRPC_CallBack_getHumidRsp(uint16_t humid, uint16_t srcAddr, uint8_t endpoin
         
   //printf("SRPC_CallBack_getHumidRsp: temp=%x\n", humid);
   
-  //Store the device that sent the request, for now send to all clients
-  srpcSendAll(pSrpcMessage);  
+  //send to the clients that asked for it
+  srpcSendReadRsp(pSrpcMessage, transSeqNum, ZCL_CLUSTER_ID_MS_REL_HUMIDITY_MEASUREMENT, ATTRID_MS_RELATIVE_HUMIDITY_MEASURED_VALUE);
 
   //printf("SRPC_CallBack_getHumidRsp--\n");
                     
@@ -1791,7 +2502,7 @@ void SRPC_CallBack_getHumidRsp(uint16_t humid, uint16_t srcAddr, uint8_t endpoin
   *
  * @return  Status
  ***************************************************************************************************/
-void SRPC_CallBack_readPowerRsp(uint32_t power, uint16_t srcAddr, uint8_t endpoint, uint32_t clientFd)
+void SRPC_CallBack_readPowerRsp(uint32_t power, uint16_t srcAddr, uint8_t endpoint, uint8_t transSeqNum)
 {
   uint8_t * pBuf;  
   uint8_t pSrpcMessage[2 + 7];
@@ -1818,14 +2529,187 @@ void SRPC_CallBack_readPowerRsp(uint32_t power, uint16_t srcAddr, uint8_t endpoi
         
   //printf("SRPC_CallBack_getPowerRsp: power=%x\n", power);
   
-  //Store the device that sent the request, for now send to all clients
-  srpcSendAll(pSrpcMessage);  
+  //send to the clients that asked for it
+  srpcSendReadRsp(pSrpcMessage, transSeqNum, ZCL_CLUSTER_ID_SE_SIMPLE_METERING, ATTRID_SE_INSTANTANEOUS_DEMAND);
 
   //printf("SRPC_CallBack_getPowerRsp--\n");
                     
   return;              
 }
 
+/***************************************************************************************************
+ * @fn      srpcBuildAttrsMsg
+ *
+ * @brief   Build a message with the attribute records of a frame. A
+ *          record is attrId, status and, if the status is success, the
+ *          data type and the value as sent over the air. Records that
+ *          do not fit the message are left out.
+ * @param   pSrpcMessage - message, of 2 + 0xFF bytes
+ * @param   funcId - SRPC_READ_ATTRS_RSP or SRPC_REPORT_ATTRS
+ *
+ * @return  length of the message
+ ***************************************************************************************************/
+static uint8_t srpcBuildAttrsMsg(uint8_t *pSrpcMessage, uint8_t funcId, uint16_t clusterId, zbSocZclAttr_t *attrs, 
+                                 uint8_t numAttrs, uint16_t srcAddr, uint8_t endpoint)
+{
+  uint8_t *pBuf, *pNumRecords;
+  uint32_t msgLen = SRPC_READ_ATTRS_RSP_HDR_LEN;
+  uint8_t i;
+
+  pBuf = pSrpcMessage;
+
+  //Set func ID in RPCS buffer
+  *pBuf++ = funcId;
+  //param size, set when the records are in
+  pBuf++;
+
+  *pBuf++ = srcAddr & 0xFF;
+  *pBuf++ = (srcAddr & 0xFF00) >> 8;
+  *pBuf++ = endpoint;
+  *pBuf++ = clusterId & 0xFF;
+  *pBuf++ = (clusterId & 0xFF00) >> 8;
+  pNumRecords = pBuf++;
+  *pNumRecords = 0;
+
+  for (i = 0; i < numAttrs; i++)
+  {
+    uint32_t recLen = 3 + ((attrs[i].status == ZCL_STATUS_SUCCESS) ? (1 + attrs[i].len) : 0);
+
+    if ((msgLen + recLen) > 0xFF)
+    {
+      printf("srpcBuildAttrsMsg: %d records do not fit the message\n", numAttrs - i);
+      break;
+    }
+
+    *pBuf++ = attrs[i].attrId & 0xFF;
+    *pBuf++ = (attrs[i].attrId & 0xFF00) >> 8;
+    *pBuf++ = attrs[i].status;
+    if (attrs[i].status == ZCL_STATUS_SUCCESS)
+    {
+      *pBuf++ = attrs[i].dataType;
+      memcpy(pBuf, attrs[i].data, attrs[i].len);
+      pBuf += attrs[i].len;
+    }
+
+    msgLen += recLen;
+    (*pNumRecords)++;
+  }
+
+  pSrpcMessage[SRPC_MSG_LEN] = msgLen;
+
+  return msgLen;
+}
+
+/***************************************************************************************************
+ * @fn      SRPC_CallBack_readAttrsRsp
+ *
+ * @brief   Sends all records of a read attributes response frame in one
+ *          message, to the clients that asked for it with a
+ *          SRPC_READ_ATTRS. Legacy clients only know the events of the
+ *          single attributes, so a response to a read the gateway did
+ *          not track is not sent.
+  *
+ * @return  Status
+ ***************************************************************************************************/
+void SRPC_CallBack_readAttrsRsp(uint16_t clusterId, zbSocZclAttr_t *attrs, uint8_t numAttrs, uint16_t srcAddr, uint8_t endpoint, uint8_t transSeqNum)
+{
+  uint8_t pSrpcMessage[2 + 0xFF];
+  uint8_t msgLen;
+  int fds[PENDING_READS_MAX_ATTRS * PENDING_READS_MAX_CLIENTS];
+  uint32_t numFds;
+
+  msgLen = srpcBuildAttrsMsg(pSrpcMessage, SRPC_READ_ATTRS_RSP, clusterId, attrs, numAttrs, srcAddr, endpoint);
+
+  if (srpcReadRspClients(transSeqNum, srcAddr, endpoint, clusterId, SRPC_READ_ATTRS_ATTR_ID, fds, &numFds) &&
+      (numFds > 0) && (socketSeverSendClientsKeyed(pSrpcMessage, (msgLen + 2), 0, fds, numFds) < 0))
+  {
+    printf("ERROR writing to socket\n");
+  }
+
+  //this is the last message of the frame
+  srpcReadRsp.valid = FALSE;
+
+  return;
+}
+
+/***************************************************************************************************
+ * @fn      SRPC_CallBack_reportAttrs
+ *
+ * @brief   Sends the reported attributes that have an event of their
+ *          own as that event, then all records of the report attributes
+ *          command in one message, to the subscribed clients. A report
+ *          is unsolicited, its tsn is the device's own and never
+ *          completes a pending read.
+  *
+ * @return  Status
+ ***************************************************************************************************/
+void SRPC_CallBack_reportAttrs(uint16_t clusterId, zbSocZclAttr_t *attrs, uint8_t numAttrs, uint16_t srcAddr, uint8_t endpoint, uint8_t transSeqNum)
+{
+  uint8_t pSrpcMessage[2 + 0xFF];
+  const srpcReportEvent_t *event;
+  uint32_t i, j;
+
+  for (i = 0; i < numAttrs; i++)
+  {
+    if (attrs[i].status != ZCL_STATUS_SUCCESS)
+    {
+      continue;
+    }
+
+    for (j = 0; j < (sizeof(srpcReportEvents) / sizeof(srpcReportEvents[0])); j++)
+    {
+      event = &srpcReportEvents[j];
+
+      if ((event->clusterId == clusterId) && (event->attrId == attrs[i].attrId) && 
+          (event->dataType == attrs[i].dataType) && (attrs[i].len <= event->valueLen))
+      {
+        pSrpcMessage[SRPC_FUNC_ID] = event->funcId;
+        pSrpcMessage[SRPC_MSG_LEN] = 3 + event->valueLen;
+        pSrpcMessage[2] = srcAddr & 0xFF;
+        pSrpcMessage[3] = (srcAddr & 0xFF00) >> 8;
+        pSrpcMessage[4] = endpoint;
+        memset(&pSrpcMessage[5], 0, event->valueLen);
+        memcpy(&pSrpcMessage[5], attrs[i].data, attrs[i].len);
+
+        if (event->shadowed)
+        {
+          shadowUpdate(srcAddr, endpoint, clusterId, attrs[i].attrId, attrs[i].data[0]);
+        }
+
+        srpcSendAll(pSrpcMessage);
+        break;
+      }
+    }
+  }
+
+  srpcBuildAttrsMsg(pSrpcMessage, SRPC_REPORT_ATTRS, clusterId, attrs, numAttrs, srcAddr, endpoint);
+
+  srpcSendAll(pSrpcMessage);
+
+  return;
+}
+
+/***************************************************************************************************
+ * @fn      SRPC_CallBack_defaultRsp
+ *
+ * @brief   Commits the values a set command stored in the shadow when
+ *          the device confirms the command.
+  *
+ * @return  Status
+ ***************************************************************************************************/
+void SRPC_CallBack_defaultRsp(uint16_t clusterId, uint8_t commandId, uint8_t status, uint16_t srcAddr, uint8_t endpoint, uint8_t transSeqNum)
+{
+  if (status != ZCL_STATUS_SUCCESS)
+  {
+    printf("SRPC_CallBack_defaultRsp: %x:%x cluster %x command %x failed, status %x\n", 
+      srcAddr, endpoint, clusterId, commandId, status);
+  }
+
+  shadowDefaultRsp(srcAddr, endpoint, clusterId, transSeqNum, status);
+
+  return;
+}
+
 void SRPC_CallBack_bootloadingDone(uint8_t result)
 {
 	SRPC_CallBack_loadImageRsp(result, bootloader_initiator_clientFd);
@@ -1925,6 +2809,343 @@ static uint8_t SRPC_getDevices(uint8_t *pBuf, uint32_t clientFd)
   return 0;  
 }
 
+/*********************************************************************
+ * @fn          srpcPackDevice
+ *
+ * @brief       Write a device record of an SRPC_DEVICE_LIST frame.
+ *
+ * @param       epInfo - device
+ * @param       pBuf - where to write the record
+ *
+ * @return      length of the record
+ */
+static uint8_t srpcPackDevice(epInfo_t *epInfo, uint8_t *pBuf)
+{
+  uint8_t nameLen = epInfo->deviceName ? strlen(epInfo->deviceName) : 0;
+
+  *pBuf++ = LO_UINT16(epInfo->nwkAddr);
+  *pBuf++ = HI_UINT16(epInfo->nwkAddr);
+  *pBuf++ = epInfo->endpoint;
+  *pBuf++ = LO_UINT16(epInfo->profileID);
+  *pBuf++ = HI_UINT16(epInfo->profileID);
+  *pBuf++ = LO_UINT16(epInfo->deviceID);
+  *pBuf++ = HI_UINT16(epInfo->deviceID);
+  *pBuf++ = epInfo->version;
+  *pBuf++ = nameLen;
+  if (nameLen)
+  {
+    memcpy(pBuf, epInfo->deviceName, nameLen);
+    pBuf += nameLen;
+  }
+  *pBuf++ = epInfo->status;
+  memcpy(pBuf, epInfo->IEEEAddr, Z_EXTADDR_LEN);
+
+  return SRPC_DEVICE_LIST_REC_LEN(nameLen);
+}
+
+/*********************************************************************
+ * @fn          SRPC_getDeviceList
+ *
+ * @brief       Bulk version of SRPC_GET_DEVICES. Sends the devices after
+ *              the cursor as SRPC_DEVICE_LIST frames, each packing as
+ *              many records as fit. The frames are sent in one go from
+ *              the in memory device list, which is sorted by IEEEAddr
+ *              and endpoint, so devices that join, leave or get a new
+ *              network address between pages do not shift the others.
+ *
+ *              Every frame carries the cursor of its last record. The
+ *              last frame of the response has
+ *              SRPC_DEVICE_LIST_FLAGS_LAST_FRAME set, and also
+ *              SRPC_DEVICE_LIST_FLAGS_END if the list is complete,
+ *              otherwise the client asks for the next page with the
+ *              cursor of that frame. A response the gateway could not
+ *              build is a single frame flagged
+ *              SRPC_DEVICE_LIST_FLAGS_ERROR.
+ *
+ * @param       pBuf - incomin messages: cursor (9, optional, the list
+ *                     starts at the first device without it),
+ *                     max records (2, optional, 0 for all)
+ *
+ * @return      afStatus_t
+ */
+static uint8_t SRPC_getDeviceList(uint8_t *pBuf, uint32_t clientFd)
+{
+  uint8_t msgLen = pBuf[SRPC_MSG_LEN];
+  uint8_t cursor[SRPC_DEVICE_LIST_CURSOR_LEN];
+  uint32_t first = 0, idx, end, maxRecords = 0, numDevices;
+  epInfo_t *devices;
+  uint8_t *pRsp, *pFrame;
+  uint32_t rspLen = 0;
+
+  //increment past SRPC header
+  pBuf+=2;
+
+  memset(cursor, 0, sizeof(cursor));
+  if (msgLen >= SRPC_DEVICE_LIST_CURSOR_LEN)
+  {
+    memcpy(cursor, pBuf, SRPC_DEVICE_LIST_CURSOR_LEN);
+  }
+  if (msgLen >= (SRPC_DEVICE_LIST_CURSOR_LEN + 2))
+  {
+    maxRecords = BUILD_UINT16(pBuf[SRPC_DEVICE_LIST_CURSOR_LEN], pBuf[SRPC_DEVICE_LIST_CURSOR_LEN + 1]);
+  }
+
+  if (devListGetSnapshot(&devices, &numDevices) < 0)
+  {
+    numDevices = 0;
+    pRsp = NULL;
+  }
+  else
+  {
+    //first device past the cursor
+    if (msgLen >= SRPC_DEVICE_LIST_CURSOR_LEN)
+    {
+      uint32_t last = numDevices;
+
+      while (first < last)
+      {
+        idx = (first + last) / 2;
+        if (devListCompareKey(&devices[idx], cursor, cursor[Z_EXTADDR_LEN]) <= 0)
+        {
+          first = idx + 1;
+        }
+        else
+        {
+          last = idx;
+        }
+      }
+    }
+
+    end = numDevices;
+    if ((maxRecords) && ((first + maxRecords) < end))
+    {
+      end = first + maxRecords;
+    }
+
+    //worst case every record starts a frame of its own
+    pRsp = malloc((end - first + 1) * (2 + SRPC_DEVICE_LIST_HDR_LEN
+                                         + SRPC_DEVICE_LIST_REC_LEN(MAX_SUPPORTED_DEVICE_NAME_LENGTH)));
+  }
+
+  if (pRsp == NULL)
+  {
+    uint8_t pSrpcMessage[2 + SRPC_DEVICE_LIST_HDR_LEN];
+
+    printf("SRPC_getDeviceList: out of memory\n");
+
+    pSrpcMessage[SRPC_FUNC_ID] = SRPC_DEVICE_LIST;
+    pSrpcMessage[SRPC_MSG_LEN] = SRPC_DEVICE_LIST_HDR_LEN;
+    memcpy(&pSrpcMessage[2], cursor, SRPC_DEVICE_LIST_CURSOR_LEN);
+    pSrpcMessage[2 + SRPC_DEVICE_LIST_CURSOR_LEN] = SRPC_DEVICE_LIST_FLAGS_LAST_FRAME | SRPC_DEVICE_LIST_FLAGS_ERROR;
+    pSrpcMessage[3 + SRPC_DEVICE_LIST_CURSOR_LEN] = 0;
+    srpcSend(pSrpcMessage, clientFd);
+
+    return 0;
+  }
+
+  idx = first;
+  do
+  {
+    uint8_t *pFlags, *pNumRecords;
+
+    pFrame = &pRsp[rspLen];
+    pFrame[SRPC_FUNC_ID] = SRPC_DEVICE_LIST;
+    pFrame[SRPC_MSG_LEN] = SRPC_DEVICE_LIST_HDR_LEN;
+    pFlags = &pFrame[2 + SRPC_DEVICE_LIST_CURSOR_LEN];
+    pNumRecords = &pFrame[3 + SRPC_DEVICE_LIST_CURSOR_LEN];
+    *pNumRecords = 0;
+
+    while ((idx < end) && ((pFrame[SRPC_MSG_LEN] + SRPC_DEVICE_LIST_REC_LEN(
+             devices[idx].deviceName ? strlen(devices[idx].deviceName) : 0)) <= 0xFF))
+    {
+      pFrame[SRPC_MSG_LEN] += srpcPackDevice(&devices[idx], &pFrame[2 + pFrame[SRPC_MSG_LEN]]);
+      (*pNumRecords)++;
+      memcpy(cursor, devices[idx].IEEEAddr, Z_EXTADDR_LEN);
+      cursor[Z_EXTADDR_LEN] = devices[idx].endpoint;
+      idx++;
+    }
+
+    memcpy(&pFrame[2], cursor, SRPC_DEVICE_LIST_CURSOR_LEN);
+    *pFlags = 0;
+    if (idx == end)
+    {
+      *pFlags |= SRPC_DEVICE_LIST_FLAGS_LAST_FRAME;
+    }
+    if (idx == numDevices)
+    {
+      *pFlags |= SRPC_DEVICE_LIST_FLAGS_END;
+    }
+
+    rspLen += pFrame[SRPC_MSG_LEN] + 2;
+  } while (idx < end);
+
+  if (socketSeverSend(pRsp, rspLen, clientFd) < 0)
+  {
+    printf("ERROR writing to socket\n");
+  }
+
+  free(pRsp);
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn          SRPC_getServerStats
+ *
+ * @brief       Sends the client counts and the admission and eviction
+ *              counters of the socket server in SRPC_SERVER_STATS.
+ *
+ * @param       pBuf - incomin messages
+ *
+ * @return      afStatus_t
+ */
+static uint8_t SRPC_getServerStats(uint8_t *pBuf, uint32_t clientFd)
+{
+  socketServerStats_t stats;
+  uint32_t counters[7];
+  uint8_t pSrpcMessage[2 + 6 + sizeof(counters)];
+  uint8_t *pTmp = pSrpcMessage;
+  uint8_t i;
+
+  socketSeverGetStats(&stats);
+  counters[0] = stats.accepted;
+  counters[1] = stats.rejectedMaxClients;
+  counters[2] = stats.rejectedNoMemory;
+  counters[3] = stats.acceptErrors;
+  counters[4] = stats.evictedSlowConsumer;
+  counters[5] = stats.evictedRxOverflow;
+  counters[6] = stats.txDropped;
+
+  *pTmp++ = SRPC_SERVER_STATS;
+  *pTmp++ = sizeof(pSrpcMessage) - 2;
+  *pTmp++ = LO_UINT16(socketSeverGetNumClients());
+  *pTmp++ = HI_UINT16(socketSeverGetNumClients());
+  *pTmp++ = LO_UINT16(socketSeverGetMaxClients());
+  *pTmp++ = HI_UINT16(socketSeverGetMaxClients());
+  *pTmp++ = LO_UINT16(stats.peakClients);
+  *pTmp++ = HI_UINT16(stats.peakClients);
+  for (i = 0; i < (sizeof(counters) / sizeof(counters[0])); i++)
+  {
+    *pTmp++ = BREAK_UINT32(counters[i], 0);
+    *pTmp++ = BREAK_UINT32(counters[i], 1);
+    *pTmp++ = BREAK_UINT32(counters[i], 2);
+    *pTmp++ = BREAK_UINT32(counters[i], 3);
+  }
+
+  srpcSend(pSrpcMessage, clientFd);
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn          srpcSocStatsSection
+ *
+ * @brief       Writes a section of the SRPC_SOC_STATS frame.
+ *
+ * @param       pBuf - where the section starts
+ * @param       id - SRPC_SOC_STATS_* section ID
+ * @param       counters - counters of the section
+ * @param       numCounters - number of counters
+ *
+ * @return      end of the section
+ */
+static uint8_t *srpcSocStatsSection(uint8_t *pBuf, uint8_t id, const uint32_t *counters, uint8_t numCounters)
+{
+  uint8_t i;
+
+  *pBuf++ = id;
+  *pBuf++ = numCounters * sizeof(uint32_t);
+  for (i = 0; i < numCounters; i++)
+  {
+    *pBuf++ = BREAK_UINT32(counters[i], 0);
+    *pBuf++ = BREAK_UINT32(counters[i], 1);
+    *pBuf++ = BREAK_UINT32(counters[i], 2);
+    *pBuf++ = BREAK_UINT32(counters[i], 3);
+  }
+
+  return pBuf;
+}
+
+/*********************************************************************
+ * @fn          SRPC_getSocStats
+ *
+ * @brief       Sends the counters of the zbSoC command queue, the Rx
+ *              deframer, coalescing, the shadow, read batching and
+ *              groupcasts in SRPC_SOC_STATS, one section per module.
+ *              Latencies are averages in us.
+ *
+ * @param       pBuf - incomin messages
+ *
+ * @return      afStatus_t
+ */
+static uint8_t SRPC_getSocStats(uint8_t *pBuf, uint32_t clientFd)
+{
+  zbSocSchedStats_t txStats;
+  zbSocMtParserStats_t rxStats;
+  coalesceStats_t coalesce;
+  shadowStats_t shadow;
+  readBatchStats_t readBatch;
+  groupcastStats_t groupcast;
+  uint32_t sched[15];
+  uint32_t rx[3];
+  uint32_t counters[2];
+  uint8_t pSrpcMessage[2 + 1 + (6 * 2) + sizeof(sched) + sizeof(rx) + (4 * sizeof(counters))];
+  uint8_t *pTmp = pSrpcMessage;
+
+  zbSocSchedGetStats(&txStats);
+  zbSocIoGetRxStats(&rxStats);
+  coalesceGetStats(&coalesce);
+  shadowGetStats(&shadow);
+  readBatchGetStats(&readBatch);
+  groupcastGetStats(&groupcast);
+
+  *pTmp++ = SRPC_SOC_STATS;
+  *pTmp++ = sizeof(pSrpcMessage) - 2;
+  *pTmp++ = SRPC_SOC_STATS_VERSION;
+
+  sched[0] = txStats.depth;
+  sched[1] = txStats.peakDepth;
+  sched[2] = txStats.sreqInFlight;
+  sched[3] = txStats.areqInFlight;
+  sched[4] = txStats.enqueued;
+  sched[5] = txStats.sent;
+  sched[6] = txStats.completed;
+  sched[7] = txStats.retries;
+  sched[8] = txStats.timeouts;
+  sched[9] = txStats.errorStatus;
+  sched[10] = txStats.dropped;
+  sched[11] = txStats.failed;
+  sched[12] = txStats.completed ? (txStats.latencySumUs / txStats.completed) : 0;
+  sched[13] = txStats.latencyMaxUs;
+  sched[14] = txStats.enqueued ? (txStats.waitSumUs / txStats.enqueued) : 0;
+  pTmp = srpcSocStatsSection(pTmp, SRPC_SOC_STATS_SCHED, sched, 15);
+
+  rx[0] = rxStats.frames;
+  rx[1] = rxStats.fcsErrors + rxStats.lenErrors;
+  rx[2] = rxStats.discardedBytes;
+  pTmp = srpcSocStatsSection(pTmp, SRPC_SOC_STATS_RX, rx, 3);
+
+  counters[0] = coalesce.received;
+  counters[1] = coalesce.saved;
+  pTmp = srpcSocStatsSection(pTmp, SRPC_SOC_STATS_COALESCE, counters, 2);
+
+  counters[0] = shadow.hits;
+  counters[1] = shadow.misses;
+  pTmp = srpcSocStatsSection(pTmp, SRPC_SOC_STATS_SHADOW, counters, 2);
+
+  counters[0] = readBatch.requested;
+  counters[1] = readBatch.frames;
+  pTmp = srpcSocStatsSection(pTmp, SRPC_SOC_STATS_READ_BATCH, counters, 2);
+
+  counters[0] = groupcast.replaced;
+  counters[1] = groupcast.groupcasts;
+  srpcSocStatsSection(pTmp, SRPC_SOC_STATS_GROUPCAST, counters, 2);
+
+  srpcSend(pSrpcMessage, clientFd);
+
+  return 0;
+}
+
 /*********************************************************************
  * @fn          SRPC_notSupported
  *
@@ -2081,19 +3302,50 @@ void SRPC_CallBack_publishPriceInd(uint8_t *zclPayload, uint8_t len)
  * @fn      SRPC_Init
  *
  * @brief   initialises the RPC interface and waitsfor a client to connect.
- * @param   
+ * @param   unixPath - also listen on this unix socket ('@' for the abstract
+ *                     namespace), NULL for TCP only
  *
  * @return  Status
  ***************************************************************************************************/      
-void SRPC_Init( void )
+void SRPC_Init( const char *unixPath )
 {
+  static const uint8_t busyMaxClients[] = {SRPC_SERVER_BUSY, 1, SRPC_SERVER_BUSY_MAX_CLIENTS};
+  static const uint8_t busyNoMemory[] = {SRPC_SERVER_BUSY, 1, SRPC_SERVER_BUSY_NO_MEMORY};
+
   if(socketSeverInit(SRPC_TCP_PORT) == -1)
   {
     //exit if the server does not start
     exit(-1);
   }
+
+  if((unixPath) && (socketSeverInitUnix(unixPath) == -1))
+  {
+    exit(-1);
+  }
   
-  serverSocketConfig(SRPC_RxCB, SRPC_ConnectCB);  
+  serverSocketConfig(SRPC_RxCB, SRPC_ConnectCB, SRPC_DisconnectCB);  
+  socketSeverSetRejectMsg(SOCKET_REJECT_MAX_CLIENTS, busyMaxClients, sizeof(busyMaxClients));
+  socketSeverSetRejectMsg(SOCKET_REJECT_NO_MEMORY, busyNoMemory, sizeof(busyNoMemory));
+
+  if(pendingReadsInit() == -1)
+  {
+    exit(-1);
+  }
+
+  if(coalesceInit() == -1)
+  {
+    exit(-1);
+  }
+
+  if(readBatchInit() == -1)
+  {
+    exit(-1);
+  }
+
+  if(groupcastInit() == -1)
+  {
+    exit(-1);
+  }
 }
 
 /*********************************************************************
@@ -2110,6 +3362,9 @@ uint8_t RSPC_SendEpInfo(epInfoExtended_t *epInfoEx)
   uint8_t *pSrpcMessage = srpcParseEpInfo(epInfoEx);  
   
   printf("RSPC_SendEpInfo++ %x:%x:%x:%x\n", epInfoEx->epInfo->nwkAddr, epInfoEx->epInfo->endpoint, epInfoEx->epInfo->profileID, epInfoEx->epInfo->deviceID);
+
+  //IEEE subscriptions follow the device to its current nwkAddr
+  subscriptionsDeviceUpdated(epInfoEx->epInfo->IEEEAddr, epInfoEx->epInfo->nwkAddr);
     
   //Send SRPC
   srpcSendAll(pSrpcMessage);  
@@ -2129,6 +3384,8 @@ uint8_t RSPC_SendEpInfo(epInfoExtended_t *epInfoEx)
 void SRPC_ConnectCB( int clientFd )
 {
   //printf("SRPC_ConnectCB++ \n");
+
+  subscriptionsAddClient(clientFd);
 /*
   epInfo = devListGetNextDev(0xFFFF, 0);
   
@@ -2149,49 +3406,66 @@ void SRPC_ConnectCB( int clientFd )
 */     
   //printf("SRPC_ConnectCB--\n");
 }
+
+/***************************************************************************************************
+ * @fn      SRPC_DisconnectCB
+ *
+ * @brief   Callback for disconnecting SRPC clients, called before the
+ *          socket is closed.
+ *
+ * @return  Status
+ ***************************************************************************************************/
+void SRPC_DisconnectCB( int clientFd )
+{
+  if ((SocketBootloadingState != SOCKET_BOOTLOADING_STATE_IDLE) && (clientFd == bootloader_initiator_clientFd))
+  {
+    SRPC_killLoadingImage( );
+    printf("Image download aborted by client disconnection\n");
+  }
+
+  subscriptionsRemoveClient(clientFd);
+  pendingReadsRemoveClient(clientFd);
+  readBatchRemoveClient(clientFd);
+}
   
 /***************************************************************************************************
  * @fn      SRPC_RxCB
  *
- * @brief   Callback for Rx'ing SRPC messages.
+ * @brief   Callback for Rx'ing SRPC messages. Processes every complete
+ *          [cmdId, len, payload] message in the buffer in place, a
+ *          message split over several reads is left for the next call.
  *
- * @return  Status
+ * @param   clientFd - client the data came from
+ * @param   buf - received data
+ * @param   len - length of the received data
+ *
+ * @return  number of bytes consumed
  ***************************************************************************************************/
-void SRPC_RxCB( int clientFd )
+uint32_t SRPC_RxCB( int clientFd, uint8_t *buf, uint32_t len )
 {
-  char buffer[256]; 
-  int byteToRead;
-  int byteRead;
-  int rtn;
+  uint32_t consumed = 0;
       
   //printf("SRPC_RxCB++[%x]\n", clientFd);
     
-  rtn = ioctl(clientFd, FIONREAD, &byteToRead);
-  
-  if(rtn !=0)
+  while ((len - consumed) >= 2)
   {
-    printf("SRPC_RxCB: Socket error\n");
-  }      
+    uint8_t *pMsg = &buf[consumed];
+    uint32_t msgLen = pMsg[SRPC_MSG_LEN] + 2;
 
-  while(byteToRead)
-  {
-    bzero(buffer,256);
-    byteRead = 0;
-    //Get the CMD-ID and Len
-    byteRead += read(clientFd,buffer,2);   
-    //Get the rest of the message
-    //printf("SRPC: reading %x byte message\n",buffer[SRPC_MSG_LEN]);
-    byteRead += read(clientFd,&buffer[2],buffer[SRPC_MSG_LEN]);
-    byteToRead -= byteRead;
-    if (byteRead < 0) error("SRPC ERROR: error reading from socket\n");
-    if (byteRead < buffer[SRPC_MSG_LEN]) error("SRPC ERROR: full message not read\n");         
-    //printf("Read the message[%x]\n",byteRead);
-    SRPC_ProcessIncoming((uint8_t*)buffer, clientFd);
+    if ((len - consumed) < msgLen)
+    {
+      //wait for the rest of the message
+      break;
+    }
+
+    //printf("Read the message[%x]\n",msgLen);
+    SRPC_ProcessIncoming(pMsg, clientFd);
+    consumed += msgLen;
   }
   
   //printf("SRPC_RxCB--\n");
     
-  return; 
+  return consumed; 
 }
 
 
@@ -72,6 +72,13 @@ extern "C"
 #define SRPC_DISPLAY_MESSAGE_IND          0x0015
 #define SRPC_PUBLISH_PRICE_IND            0x0016
 #define SRPC_DEVICE_REMOVED 0x0017
+#define SRPC_SUBSCRIBE_RSP  0x0018
+#define SRPC_DEVICE_LIST    0x0019
+#define SRPC_SERVER_BUSY    0x001a
+#define SRPC_SERVER_STATS   0x001b
+#define SRPC_SOC_STATS      0x001c
+#define SRPC_READ_ATTRS_RSP 0x001d
+#define SRPC_REPORT_ATTRS   0x001e
 
 //define incoming RPCS command ID's
 #define SRPC_CLOSE              0x80
@@ -102,6 +109,12 @@ extern "C"
 #define SRPC_INSTALL_CERTIFICATE 0x99
 #define SRPC_GET_LAST_MESSAGE    0x9a
 #define SRPC_GET_CURRENT_PRICE   0x9b
+#define SRPC_SUBSCRIBE           0x9c
+#define SRPC_GET_DEVICE_LIST     0x9d
+#define SRPC_GET_SERVER_STATS    0x9e
+#define SRPC_GET_SOC_STATS       0x9f
+#define SRPC_READ_ATTRS          0xa0
+#define SRPC_SEND_ZCL_DEV_SET    0xa1
 
 #define SRPC_FUNC_ID 0
 #define SRPC_MSG_LEN 1
@@ -116,6 +129,27 @@ extern "C"
 #define MT_NEW_DEVICE_FLAGS_FIRST 0x01
 #define MT_NEW_DEVICE_FLAGS_LAST  0x02
 
+// flags of the SRPC_DEVICE_LIST frames
+#define SRPC_DEVICE_LIST_FLAGS_LAST_FRAME 0x01 // last frame of this response
+#define SRPC_DEVICE_LIST_FLAGS_END        0x02 // no devices past this frame
+#define SRPC_DEVICE_LIST_FLAGS_ERROR      0x04 // the list could not be read, try again
+
+// SRPC_SOC_STATS is a version byte and then sections of an ID byte, a
+// length byte and the 32 bit counters of one module. A section only
+// grows at its end and new modules get a new ID, so clients skip the
+// IDs they do not know and read the counters they know at fixed offsets.
+#define SRPC_SOC_STATS_VERSION 1
+#define SRPC_SOC_STATS_SCHED      0x01 // depth, peak depth, SREQs and AREQs in flight, counters
+#define SRPC_SOC_STATS_RX         0x02 // frames, FCS and length errors, discarded bytes
+#define SRPC_SOC_STATS_COALESCE   0x03 // received, saved
+#define SRPC_SOC_STATS_SHADOW     0x04 // hits, misses
+#define SRPC_SOC_STATS_READ_BATCH 0x05 // attributes requested, frames sent
+#define SRPC_SOC_STATS_GROUPCAST  0x06 // unicasts replaced, groupcasts sent
+
+// reason of the SRPC_SERVER_BUSY frame sent before a rejected client is closed
+#define SRPC_SERVER_BUSY_MAX_CLIENTS 0x01
+#define SRPC_SERVER_BUSY_NO_MEMORY   0x02
+
 typedef enum
 {
   afAddrNotPresent = 0,
@@ -138,16 +172,16 @@ typedef struct
 } afAddrType_t;
 
 //SRPC Interface functions
-void SRPC_Init(void);
+void SRPC_Init(const char *unixPath);
 uint8_t RSPC_SendEpInfo(epInfoExtended_t *epInfoEx);
 
-void SRPC_CallBack_getStateRsp(uint8_t state, uint16_t srcAddr, uint8_t endpoint, uint32_t clientFd);
-void SRPC_CallBack_getLevelRsp(uint8_t level, uint16_t srcAddr, uint8_t endpoint, uint32_t clientFd);
-void SRPC_CallBack_getHueRsp(uint8_t hue, uint16_t srcAddr, uint8_t endpoint, uint32_t clientFd);
-void SRPC_CallBack_getSatRsp(uint8_t sat, uint16_t srcAddr, uint8_t endpoint, uint32_t clientFd);
-void SRPC_CallBack_getTempRsp(uint16_t temp, uint16_t srcAddr, uint8_t endpoint, uint32_t clientFd);
-void SRPC_CallBack_readPowerRsp(uint32_t power, uint16_t srcAddr, uint8_t endpoint, uint32_t clientFd);
-void SRPC_CallBack_getHumidRsp(uint16_t humid, uint16_t srcAddr, uint8_t endpoint, uint32_t clientFd);
+void SRPC_CallBack_getStateRsp(uint8_t state, uint16_t srcAddr, uint8_t endpoint, uint8_t transSeqNum);
+void SRPC_CallBack_getLevelRsp(uint8_t level, uint16_t srcAddr, uint8_t endpoint, uint8_t transSeqNum);
+void SRPC_CallBack_getHueRsp(uint8_t hue, uint16_t srcAddr, uint8_t endpoint, uint8_t transSeqNum);
+void SRPC_CallBack_getSatRsp(uint8_t sat, uint16_t srcAddr, uint8_t endpoint, uint8_t transSeqNum);
+void SRPC_CallBack_getTempRsp(uint16_t temp, uint16_t srcAddr, uint8_t endpoint, uint8_t transSeqNum);
+void SRPC_CallBack_readPowerRsp(uint32_t power, uint16_t srcAddr, uint8_t endpoint, uint8_t transSeqNum);
+void SRPC_CallBack_getHumidRsp(uint16_t humid, uint16_t srcAddr, uint8_t endpoint, uint8_t transSeqNum);
 void SRPC_CallBack_zoneSateInd(uint32_t zoneState, uint16_t srcAddr, uint8_t endpoint, uint32_t clientFd);
 void SRPC_CallBack_bootloadingDone(uint8_t result);
 void SRPC_CallBack_loadImageProgress(uint8_t phase, uint32_t location);
@@ -155,6 +189,9 @@ void SRPC_CallBack_certInstallResultInd(uint8_t result);
 void SRPC_CallBack_keyEstablishmentStateInd(uint8_t state);
 void SRPC_CallBack_displayMessageInd(uint8_t *zclPayload, uint8_t len);
 void SRPC_CallBack_publishPriceInd(uint8_t *zclPayload, uint8_t len);
+void SRPC_CallBack_readAttrsRsp(uint16_t clusterId, zbSocZclAttr_t *attrs, uint8_t numAttrs, uint16_t srcAddr, uint8_t endpoint, uint8_t transSeqNum);
+void SRPC_CallBack_reportAttrs(uint16_t clusterId, zbSocZclAttr_t *attrs, uint8_t numAttrs, uint16_t srcAddr, uint8_t endpoint, uint8_t transSeqNum);
+void SRPC_CallBack_defaultRsp(uint16_t clusterId, uint8_t commandId, uint8_t status, uint16_t srcAddr, uint8_t endpoint, uint8_t transSeqNum);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,788 @@
+/**************************************************************************************************
+ * Filename:       interface_subscriptions.c
+ * Description:    Per client event subscriptions and the subscriber index used for SRPC fan-out.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "interface_subscriptions.h"
+#include "interface_devicelist.h"
+#include "hal_types.h"
+#include "hal_defs.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define SUBS_INDEX_BUCKETS 256
+// client table grows in steps of this many fd's
+#define SUBS_TABLE_STEP 64
+
+// Keys of the subscriber index, IEEE filters are indexed by the
+// nwkAddr of the device (any endpoint) once it is known
+#define SUBS_KEY_MSG_TYPE 0x01
+#define SUBS_KEY_CLUSTER  0x02
+#define SUBS_KEY_NWK_EP   0x03
+
+#define SUBS_KEY_UNRESOLVED 0x00
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct subsIndexEntry_s
+{
+  struct subsIndexEntry_s *next;
+  uint8_t keyType;
+  uint32_t key;
+  int *fds;
+  uint32_t numFds;
+  uint32_t maxFds;
+} subsIndexEntry_t;
+
+typedef struct
+{
+  uint8_t type;
+  uint8_t value[8];
+  uint8_t keyType; // SUBS_KEY_UNRESOLVED while an IEEE is not in the device list
+  uint32_t key;
+} subsFilter_t;
+
+typedef struct
+{
+  uint8_t numFilters;
+  subsFilter_t filters[SUBS_MAX_FILTERS_PER_CLIENT];
+  uint32_t stamp; // last lookup the client was added to the result
+  uint32_t unfilteredIdx;
+} subsClient_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static subsIndexEntry_t *subsIndex[SUBS_INDEX_BUCKETS];
+
+// clients indexed by fd
+static subsClient_t **subsClients = NULL;
+static int subsClientsSize = 0;
+static uint32_t subsNumClients = 0;
+
+// fd's of the clients without filters, they get every event
+static int *subsUnfiltered = NULL;
+static uint32_t subsNumUnfiltered = 0;
+static uint32_t subsMaxUnfiltered = 0;
+
+// result of subscriptionsGetSubscribers
+static int *subsResult = NULL;
+static uint32_t subsMaxResult = 0;
+static uint32_t subsStamp = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static subsClient_t *subsGetClient( int clientFd );
+static int32 subsFdArrayAdd( int **fds, uint32_t *numFds, uint32_t *maxFds, int fd );
+static subsIndexEntry_t *subsIndexLookup( uint8_t keyType, uint32_t key );
+static int32 subsIndexAdd( uint8_t keyType, uint32_t key, int clientFd );
+static void subsIndexRemove( uint8_t keyType, uint32_t key, int clientFd );
+static uint8_t subsParseFilter( uint8_t type, uint8_t *value, subsFilter_t *filter );
+static uint8_t subsResolveIeee( subsFilter_t *filter );
+static int32 subsUnfilteredAdd( subsClient_t *client, int clientFd );
+static void subsUnfilteredRemove( subsClient_t *client );
+static void subsClearFilters( subsClient_t *client, int clientFd );
+static void subsAddToResult( uint8_t keyType, uint32_t key, uint32_t *numFds );
+
+/*********************************************************************
+ * FUNCTIONS
+ *********************************************************************/
+
+/*********************************************************************
+ * @fn      subsGetClient
+ *
+ * @brief   look up a client.
+ *
+ * @param   clientFd - client fd
+ *
+ * @return  client, NULL if not tracked
+ */
+static subsClient_t *subsGetClient( int clientFd )
+{
+  if ((clientFd < 0) || (clientFd >= subsClientsSize))
+  {
+    return NULL;
+  }
+
+  return subsClients[clientFd];
+}
+
+/*********************************************************************
+ * @fn      subsFdArrayAdd
+ *
+ * @brief   append an fd to a growable array.
+ *
+ * @return  0 on success, -1 if out of memory
+ */
+static int32 subsFdArrayAdd( int **fds, uint32_t *numFds, uint32_t *maxFds, int fd )
+{
+  if (*numFds == *maxFds)
+  {
+    uint32_t newMax = (*maxFds) ? (*maxFds * 2) : 4;
+    int *newFds = realloc(*fds, newMax * sizeof(int));
+
+    if (newFds == NULL)
+    {
+      return -1;
+    }
+    *fds = newFds;
+    *maxFds = newMax;
+  }
+
+  (*fds)[(*numFds)++] = fd;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      subsIndexLookup
+ *
+ * @brief   find the subscribers of a key.
+ *
+ * @param   keyType - SUBS_KEY_xxx
+ * @param   key - key value
+ *
+ * @return  index entry, NULL if nobody subscribed
+ */
+static subsIndexEntry_t *subsIndexLookup( uint8_t keyType, uint32_t key )
+{
+  subsIndexEntry_t *entry = subsIndex[(key ^ (key >> 8) ^ (key >> 16) ^ keyType) % SUBS_INDEX_BUCKETS];
+
+  while ((entry) && ((entry->keyType != keyType) || (entry->key != key)))
+  {
+    entry = entry->next;
+  }
+
+  return entry;
+}
+
+/*********************************************************************
+ * @fn      subsIndexAdd
+ *
+ * @brief   add a client to the subscribers of a key.
+ *
+ * @return  0 on success, -1 if out of memory
+ */
+static int32 subsIndexAdd( uint8_t keyType, uint32_t key, int clientFd )
+{
+  subsIndexEntry_t *entry = subsIndexLookup(keyType, key);
+  uint32_t idx;
+
+  if (entry == NULL)
+  {
+    uint32_t bucket = (key ^ (key >> 8) ^ (key >> 16) ^ keyType) % SUBS_INDEX_BUCKETS;
+
+    entry = calloc(1, sizeof(subsIndexEntry_t));
+    if (entry == NULL)
+    {
+      return -1;
+    }
+    entry->keyType = keyType;
+    entry->key = key;
+    entry->next = subsIndex[bucket];
+    subsIndex[bucket] = entry;
+  }
+
+  //a client has each filter once, but an IEEE and a nwkAddr filter can map to the same key
+  for (idx = 0; idx < entry->numFds; idx++)
+  {
+    if (entry->fds[idx] == clientFd)
+    {
+      return 0;
+    }
+  }
+
+  return subsFdArrayAdd(&entry->fds, &entry->numFds, &entry->maxFds, clientFd);
+}
+
+/*********************************************************************
+ * @fn      subsIndexRemove
+ *
+ * @brief   remove a client from the subscribers of a key.
+ *
+ * @return  none
+ */
+static void subsIndexRemove( uint8_t keyType, uint32_t key, int clientFd )
+{
+  uint32_t bucket = (key ^ (key >> 8) ^ (key >> 16) ^ keyType) % SUBS_INDEX_BUCKETS;
+  subsIndexEntry_t *entry = subsIndex[bucket], *prev = NULL;
+  uint32_t idx;
+
+  while ((entry) && ((entry->keyType != keyType) || (entry->key != key)))
+  {
+    prev = entry;
+    entry = entry->next;
+  }
+
+  if (entry == NULL)
+  {
+    return;
+  }
+
+  for (idx = 0; idx < entry->numFds; idx++)
+  {
+    if (entry->fds[idx] == clientFd)
+    {
+      entry->fds[idx] = entry->fds[--entry->numFds];
+      break;
+    }
+  }
+
+  if (entry->numFds == 0)
+  {
+    if (prev)
+    {
+      prev->next = entry->next;
+    }
+    else
+    {
+      subsIndex[bucket] = entry->next;
+    }
+    free(entry->fds);
+    free(entry);
+  }
+}
+
+/*********************************************************************
+ * @fn      subsResolveIeee
+ *
+ * @brief   find the nwkAddr of the device an IEEE filter refers to.
+ *
+ * @param   filter - IEEE filter
+ *
+ * @return  TRUE if the device is known
+ */
+static uint8_t subsResolveIeee( subsFilter_t *filter )
+{
+  uint32 context = 0;
+  epInfo_t *epInfo;
+
+  while ((epInfo = devListGetNextDev(&context)) != NULL)
+  {
+    if (memcmp(epInfo->IEEEAddr, filter->value, 8) == 0)
+    {
+      filter->keyType = SUBS_KEY_NWK_EP;
+      filter->key = ((uint32_t) epInfo->nwkAddr << 8) | SUBS_ANY_ENDPOINT;
+      return TRUE;
+    }
+  }
+
+  filter->keyType = SUBS_KEY_UNRESOLVED;
+
+  return FALSE;
+}
+
+/*********************************************************************
+ * @fn      subsParseFilter
+ *
+ * @brief   build a filter from its SRPC encoding.
+ *
+ * @return  SUBS_STATUS_xxx
+ */
+static uint8_t subsParseFilter( uint8_t type, uint8_t *value, subsFilter_t *filter )
+{
+  memset(filter, 0, sizeof(subsFilter_t));
+  filter->type = type;
+
+  switch (type)
+  {
+    case SUBS_FILTER_MSG_TYPE:
+      filter->value[0] = value[0];
+      filter->keyType = SUBS_KEY_MSG_TYPE;
+      filter->key = value[0];
+      break;
+    case SUBS_FILTER_CLUSTER:
+      memcpy(filter->value, value, 2);
+      filter->keyType = SUBS_KEY_CLUSTER;
+      filter->key = BUILD_UINT16(value[0], value[1]);
+      break;
+    case SUBS_FILTER_NWK_EP:
+      memcpy(filter->value, value, 3);
+      filter->keyType = SUBS_KEY_NWK_EP;
+      filter->key = ((uint32_t) BUILD_UINT16(value[0], value[1]) << 8) | value[2];
+      break;
+    case SUBS_FILTER_IEEE:
+      memcpy(filter->value, value, 8);
+      subsResolveIeee(filter);
+      break;
+    default:
+      return SUBS_STATUS_INVALID;
+  }
+
+  return SUBS_STATUS_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      subsUnfilteredAdd
+ *
+ * @brief   put a client on the list of clients without filters.
+ *
+ * @return  0 on success, -1 if out of memory
+ */
+static int32 subsUnfilteredAdd( subsClient_t *client, int clientFd )
+{
+  client->unfilteredIdx = subsNumUnfiltered;
+
+  return subsFdArrayAdd(&subsUnfiltered, &subsNumUnfiltered, &subsMaxUnfiltered, clientFd);
+}
+
+/*********************************************************************
+ * @fn      subsUnfilteredRemove
+ *
+ * @brief   take a client off the list of clients without filters.
+ *
+ * @return  none
+ */
+static void subsUnfilteredRemove( subsClient_t *client )
+{
+  int lastFd = subsUnfiltered[--subsNumUnfiltered];
+
+  subsUnfiltered[client->unfilteredIdx] = lastFd;
+  subsClients[lastFd]->unfilteredIdx = client->unfilteredIdx;
+}
+
+/*********************************************************************
+ * @fn      subsClearFilters
+ *
+ * @brief   remove all filters of a client from the index.
+ *
+ * @return  none
+ */
+static void subsClearFilters( subsClient_t *client, int clientFd )
+{
+  while (client->numFilters)
+  {
+    subsFilter_t *filter = &client->filters[--client->numFilters];
+
+    if (filter->keyType != SUBS_KEY_UNRESOLVED)
+    {
+      subsIndexRemove(filter->keyType, filter->key, clientFd);
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      subscriptionsAddClient
+ *
+ * @brief   start tracking a connected client, it gets every event until
+ *          it adds a filter.
+ *
+ * @param   clientFd - client fd
+ *
+ * @return  none
+ */
+void subscriptionsAddClient( int clientFd )
+{
+  subsClient_t *client;
+
+  if ((clientFd < 0) || (subsGetClient(clientFd) != NULL))
+  {
+    return;
+  }
+
+  if (clientFd >= subsClientsSize)
+  {
+    int newSize = ((clientFd / SUBS_TABLE_STEP) + 1) * SUBS_TABLE_STEP;
+    subsClient_t **newTable = realloc(subsClients, newSize * sizeof(subsClient_t *));
+
+    if (newTable == NULL)
+    {
+      printf("subscriptionsAddClient: out of memory\n");
+      return;
+    }
+    memset(&newTable[subsClientsSize], 0, (newSize - subsClientsSize) * sizeof(subsClient_t *));
+    subsClients = newTable;
+    subsClientsSize = newSize;
+  }
+
+  client = calloc(1, sizeof(subsClient_t));
+  if (client == NULL)
+  {
+    printf("subscriptionsAddClient: out of memory\n");
+    return;
+  }
+
+  if (subsUnfilteredAdd(client, clientFd) < 0)
+  {
+    free(client);
+    return;
+  }
+
+  subsClients[clientFd] = client;
+  subsNumClients++;
+}
+
+/*********************************************************************
+ * @fn      subscriptionsRemoveClient
+ *
+ * @brief   drop a disconnected client and its filters.
+ *
+ * @param   clientFd - client fd
+ *
+ * @return  none
+ */
+void subscriptionsRemoveClient( int clientFd )
+{
+  subsClient_t *client = subsGetClient(clientFd);
+
+  if (client == NULL)
+  {
+    return;
+  }
+
+  if (client->numFilters)
+  {
+    subsClearFilters(client, clientFd);
+  }
+  else
+  {
+    subsUnfilteredRemove(client);
+  }
+
+  subsClients[clientFd] = NULL;
+  subsNumClients--;
+  free(client);
+}
+
+/*********************************************************************
+ * @fn      subscriptionsAddFilter
+ *
+ * @brief   add a filter to a client.
+ *
+ * @param   clientFd - client fd
+ * @param   type - SUBS_FILTER_xxx
+ * @param   value - filter value, encoded as in the SRPC_SUBSCRIBE command
+ *
+ * @return  SUBS_STATUS_xxx
+ */
+uint8_t subscriptionsAddFilter( int clientFd, uint8_t type, uint8_t *value )
+{
+  subsClient_t *client = subsGetClient(clientFd);
+  subsFilter_t filter;
+  uint8_t idx, status;
+
+  if (client == NULL)
+  {
+    return SUBS_STATUS_INVALID;
+  }
+
+  if ((status = subsParseFilter(type, value, &filter)) != SUBS_STATUS_SUCCESS)
+  {
+    return status;
+  }
+
+  for (idx = 0; idx < client->numFilters; idx++)
+  {
+    if ((client->filters[idx].type == type) && (memcmp(client->filters[idx].value, filter.value, 8) == 0))
+    {
+      //already subscribed
+      return SUBS_STATUS_SUCCESS;
+    }
+  }
+
+  if (client->numFilters == SUBS_MAX_FILTERS_PER_CLIENT)
+  {
+    return SUBS_STATUS_TOO_MANY;
+  }
+
+  if ((filter.keyType != SUBS_KEY_UNRESOLVED) && (subsIndexAdd(filter.keyType, filter.key, clientFd) < 0))
+  {
+    return SUBS_STATUS_NO_MEMORY;
+  }
+
+  client->filters[client->numFilters++] = filter;
+  if (client->numFilters == 1)
+  {
+    subsUnfilteredRemove(client);
+  }
+
+  return SUBS_STATUS_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      subscriptionsRemoveFilter
+ *
+ * @brief   remove a filter from a client.
+ *
+ * @param   clientFd - client fd
+ * @param   type - SUBS_FILTER_xxx
+ * @param   value - filter value, encoded as in the SRPC_SUBSCRIBE command
+ *
+ * @return  SUBS_STATUS_xxx
+ */
+uint8_t subscriptionsRemoveFilter( int clientFd, uint8_t type, uint8_t *value )
+{
+  subsClient_t *client = subsGetClient(clientFd);
+  subsFilter_t filter;
+  uint8_t idx, otherIdx;
+
+  if ((client == NULL) || (subsParseFilter(type, value, &filter) != SUBS_STATUS_SUCCESS))
+  {
+    return SUBS_STATUS_INVALID;
+  }
+
+  for (idx = 0; idx < client->numFilters; idx++)
+  {
+    subsFilter_t *found = &client->filters[idx];
+
+    if ((found->type == type) && (memcmp(found->value, filter.value, 8) == 0))
+    {
+      uint8_t shared = FALSE;
+
+      //without its last filter the client gets every event, keep the
+      //filter if there is no room for that
+      if ((client->numFilters == 1) && (subsUnfilteredAdd(client, clientFd) < 0))
+      {
+        return SUBS_STATUS_NO_MEMORY;
+      }
+
+      //keep the index entry if another filter of the client maps to it
+      for (otherIdx = 0; otherIdx < client->numFilters; otherIdx++)
+      {
+        if ((otherIdx != idx) && (client->filters[otherIdx].keyType == found->keyType) &&
+            (client->filters[otherIdx].key == found->key))
+        {
+          shared = TRUE;
+        }
+      }
+      if ((found->keyType != SUBS_KEY_UNRESOLVED) && (!shared))
+      {
+        subsIndexRemove(found->keyType, found->key, clientFd);
+      }
+
+      client->filters[idx] = client->filters[--client->numFilters];
+      return SUBS_STATUS_SUCCESS;
+    }
+  }
+
+  return SUBS_STATUS_NOT_FOUND;
+}
+
+/*********************************************************************
+ * @fn      subscriptionsClear
+ *
+ * @brief   remove all filters of a client, it gets every event again.
+ *          The filters are kept if there is no room for that.
+ *
+ * @param   clientFd - client fd
+ *
+ * @return  SUBS_STATUS_xxx
+ */
+uint8_t subscriptionsClear( int clientFd )
+{
+  subsClient_t *client = subsGetClient(clientFd);
+
+  if (client == NULL)
+  {
+    return SUBS_STATUS_INVALID;
+  }
+
+  if (client->numFilters == 0)
+  {
+    return SUBS_STATUS_SUCCESS;
+  }
+
+  if (subsUnfilteredAdd(client, clientFd) < 0)
+  {
+    return SUBS_STATUS_NO_MEMORY;
+  }
+
+  subsClearFilters(client, clientFd);
+
+  return SUBS_STATUS_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      subscriptionsGetNumFilters
+ *
+ * @brief   get the number of filters of a client.
+ *
+ * @param   clientFd - client fd
+ *
+ * @return  number of filters
+ */
+uint8_t subscriptionsGetNumFilters( int clientFd )
+{
+  subsClient_t *client = subsGetClient(clientFd);
+
+  return client ? client->numFilters : 0;
+}
+
+/*********************************************************************
+ * @fn      subscriptionsDeviceUpdated
+ *
+ * @brief   called when a device joins or changes its nwkAddr, moves the
+ *          IEEE filters for the device to the new nwkAddr.
+ *
+ * @param   ieeeAddr - IEEE address of the device
+ * @param   nwkAddr - current nwkAddr of the device
+ *
+ * @return  none
+ */
+void subscriptionsDeviceUpdated( uint8_t ieeeAddr[8], uint16_t nwkAddr )
+{
+  uint32_t key = ((uint32_t) nwkAddr << 8) | SUBS_ANY_ENDPOINT;
+  int fd;
+
+  for (fd = 0; fd < subsClientsSize; fd++)
+  {
+    subsClient_t *client = subsClients[fd];
+    uint8_t idx;
+
+    if ((client == NULL) || (client->numFilters == 0))
+    {
+      continue;
+    }
+
+    for (idx = 0; idx < client->numFilters; idx++)
+    {
+      subsFilter_t *filter = &client->filters[idx];
+
+      if ((filter->type != SUBS_FILTER_IEEE) || (memcmp(filter->value, ieeeAddr, 8) != 0) ||
+          ((filter->keyType == SUBS_KEY_NWK_EP) && (filter->key == key)))
+      {
+        continue;
+      }
+
+      if (filter->keyType != SUBS_KEY_UNRESOLVED)
+      {
+        subsIndexRemove(filter->keyType, filter->key, fd);
+      }
+      filter->keyType = SUBS_KEY_NWK_EP;
+      filter->key = key;
+      subsIndexAdd(filter->keyType, filter->key, fd);
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      subsAddToResult
+ *
+ * @brief   add the subscribers of a key to the lookup result, once.
+ *
+ * @return  none
+ */
+static void subsAddToResult( uint8_t keyType, uint32_t key, uint32_t *numFds )
+{
+  subsIndexEntry_t *entry = subsIndexLookup(keyType, key);
+  uint32_t idx;
+
+  if (entry == NULL)
+  {
+    return;
+  }
+
+  for (idx = 0; idx < entry->numFds; idx++)
+  {
+    subsClient_t *client = subsClients[entry->fds[idx]];
+
+    if (client->stamp != subsStamp)
+    {
+      client->stamp = subsStamp;
+      subsResult[(*numFds)++] = entry->fds[idx];
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      subscriptionsGetSubscribers
+ *
+ * @brief   get the clients an event must be sent to: the clients without
+ *          filters plus the clients with a filter matching the event,
+ *          looked up in the subscriber index.
+ *
+ * @param   cmdId - SRPC command ID of the event
+ * @param   clusterId - cluster the event relates to, SUBS_NO_CLUSTER if none
+ * @param   hasDevice - TRUE if the event relates to a device
+ * @param   nwkAddr - nwkAddr of the device
+ * @param   endpoint - endpoint of the device
+ * @param   numFds - returns the number of clients
+ *
+ * @return  fd's of the clients, valid until the next call
+ */
+int *subscriptionsGetSubscribers( uint8_t cmdId, uint16_t clusterId, uint8_t hasDevice,
+                                  uint16_t nwkAddr, uint8_t endpoint, uint32_t *numFds )
+{
+  *numFds = 0;
+
+  if (subsMaxResult < subsNumClients)
+  {
+    int *newResult = realloc(subsResult, subsNumClients * sizeof(int));
+
+    if (newResult == NULL)
+    {
+      return NULL;
+    }
+    subsResult = newResult;
+    subsMaxResult = subsNumClients;
+  }
+
+  if (subsNumClients == 0)
+  {
+    return subsResult;
+  }
+
+  memcpy(subsResult, subsUnfiltered, subsNumUnfiltered * sizeof(int));
+  *numFds = subsNumUnfiltered;
+
+  if (subsNumUnfiltered < subsNumClients)
+  {
+    subsStamp++;
+
+    subsAddToResult(SUBS_KEY_MSG_TYPE, cmdId, numFds);
+    if (clusterId != SUBS_NO_CLUSTER)
+    {
+      subsAddToResult(SUBS_KEY_CLUSTER, clusterId, numFds);
+    }
+    if (hasDevice)
+    {
+      subsAddToResult(SUBS_KEY_NWK_EP, ((uint32_t) nwkAddr << 8) | endpoint, numFds);
+      subsAddToResult(SUBS_KEY_NWK_EP, ((uint32_t) nwkAddr << 8) | SUBS_ANY_ENDPOINT, numFds);
+    }
+  }
+
+  return subsResult;
+}
@@ -0,0 +1,124 @@
+/**************************************************************************************************
+ * Filename:       interface_subscriptions.h
+ * Description:    Per client event subscriptions and the subscriber index used for SRPC fan-out.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+
+#ifndef INTERFACE_SUBSCRIPTIONS_H
+#define INTERFACE_SUBSCRIPTIONS_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// Filter types of the SRPC_SUBSCRIBE command, a client with no filters
+// gets every event, otherwise only events that match any of its filters
+#define SUBS_FILTER_MSG_TYPE  0x01 // value: SRPC command ID (1 byte)
+#define SUBS_FILTER_CLUSTER   0x02 // value: cluster ID (2 bytes)
+#define SUBS_FILTER_NWK_EP    0x03 // value: nwkAddr (2 bytes), endpoint (1 byte, 0xFF for any)
+#define SUBS_FILTER_IEEE      0x04 // value: IEEE address (8 bytes), any endpoint
+
+// Operations of the SRPC_SUBSCRIBE command
+#define SUBS_OP_CLEAR  0x00 // remove all filters, the client gets every event again
+#define SUBS_OP_ADD    0x01
+#define SUBS_OP_REMOVE 0x02
+
+#define SUBS_MAX_FILTERS_PER_CLIENT 32
+
+#define SUBS_ANY_ENDPOINT 0xFF
+#define SUBS_NO_CLUSTER   0xFFFF
+
+// Status of the subscribe operations
+#define SUBS_STATUS_SUCCESS        0x00
+#define SUBS_STATUS_INVALID        0x01
+#define SUBS_STATUS_TOO_MANY       0x02
+#define SUBS_STATUS_NOT_FOUND      0x03
+#define SUBS_STATUS_NO_MEMORY      0x04
+
+/*
+ * subscriptionsAddClient - start tracking a connected client.
+ */
+void subscriptionsAddClient( int clientFd );
+
+/*
+ * subscriptionsRemoveClient - drop a disconnected client and its filters.
+ */
+void subscriptionsRemoveClient( int clientFd );
+
+/*
+ * subscriptionsAddFilter - add a filter to a client.
+ */
+uint8_t subscriptionsAddFilter( int clientFd, uint8_t type, uint8_t *value );
+
+/*
+ * subscriptionsRemoveFilter - remove a filter from a client.
+ */
+uint8_t subscriptionsRemoveFilter( int clientFd, uint8_t type, uint8_t *value );
+
+/*
+ * subscriptionsClear - remove all filters of a client.
+ */
+uint8_t subscriptionsClear( int clientFd );
+
+/*
+ * subscriptionsGetNumFilters - get the number of filters of a client.
+ */
+uint8_t subscriptionsGetNumFilters( int clientFd );
+
+/*
+ * subscriptionsDeviceUpdated - rebind IEEE filters to a device's (new) nwkAddr.
+ */
+void subscriptionsDeviceUpdated( uint8_t ieeeAddr[8], uint16_t nwkAddr );
+
+/*
+ * subscriptionsGetSubscribers - get the clients an event must be sent to.
+ */
+int *subscriptionsGetSubscribers( uint8_t cmdId, uint16_t clusterId, uint8_t hasDevice,
+                                  uint16_t nwkAddr, uint8_t endpoint, uint32_t *numFds );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INTERFACE_SUBSCRIPTIONS_H */
@@ -0,0 +1,483 @@
+/**************************************************************************************************
+ * Filename:       reactor.c
+ * Description:    epoll based event dispatcher for the gateway main loop.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+#include "reactor.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// Max number of ready fd's serviced per epoll_wait()
+#define REACTOR_MAX_EVENTS 64
+// Handler table grows in steps of this many fd's
+#define REACTOR_TABLE_STEP 64
+// Max number of deadline timers
+#define REACTOR_MAX_TIMERS 8
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  reactorCb_t cb;
+  uint32_t gen; // changes whenever the fd is registered or removed
+} reactorHandler_t;
+
+typedef struct
+{
+  int fd;
+  reactorTimerCb_t cb;
+} reactorTimer_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static int reactorFd = -1;
+
+// Handlers indexed by fd, a NULL cb means the fd is not registered
+static reactorHandler_t *reactorHandlers = NULL;
+static int reactorHandlersSize = 0;
+
+static reactorTimer_t reactorTimers[REACTOR_MAX_TIMERS];
+static int32_t reactorNumTimers = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static int32_t reactorSetHandler( int fd, reactorCb_t cb );
+static uint64_t reactorEventData( int fd );
+static void reactorTimerEventCb( int fd, uint32_t events );
+
+/*********************************************************************
+ * FUNCTIONS
+ *********************************************************************/
+
+/*********************************************************************
+ * @fn      reactorSetHandler
+ *
+ * @brief   stores the handler of an fd, growing the table if needed,
+ *          and starts a new generation of the fd.
+ *
+ * @param   fd - file descriptor
+ * @param   cb - handler, NULL to clear
+ *
+ * @return  0 on success, -1 on failure
+ */
+static int32_t reactorSetHandler( int fd, reactorCb_t cb )
+{
+  if (fd >= reactorHandlersSize)
+  {
+    int newSize = ((fd / REACTOR_TABLE_STEP) + 1) * REACTOR_TABLE_STEP;
+    reactorHandler_t *newTable;
+
+    if (cb == NULL)
+    {
+      return 0;
+    }
+
+    newTable = realloc(reactorHandlers, newSize * sizeof(reactorHandler_t));
+    if (newTable == NULL)
+    {
+      printf("reactorSetHandler: out of memory\n");
+      return -1;
+    }
+
+    memset(&newTable[reactorHandlersSize], 0, (newSize - reactorHandlersSize) * sizeof(reactorHandler_t));
+    reactorHandlers = newTable;
+    reactorHandlersSize = newSize;
+  }
+
+  reactorHandlers[fd].cb = cb;
+  reactorHandlers[fd].gen++;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      reactorEventData
+ *
+ * @brief   get the epoll data of a registered fd, the fd and its
+ *          generation. A handler may remove an fd and accept() give its
+ *          number to a new client while events of the old one are still
+ *          in the batch, the generation tells them apart.
+ *
+ * @param   fd - file descriptor
+ *
+ * @return  epoll data
+ */
+static uint64_t reactorEventData( int fd )
+{
+  return ((uint64_t)reactorHandlers[fd].gen << 32) | (uint32_t)fd;
+}
+
+/*********************************************************************
+ * @fn      reactorInit
+ *
+ * @brief   creates the epoll instance.
+ *
+ * @param   none
+ *
+ * @return  0 on success, -1 on failure
+ */
+int32_t reactorInit( void )
+{
+  if (reactorFd >= 0)
+  {
+    return 0;
+  }
+
+  reactorFd = epoll_create1(EPOLL_CLOEXEC);
+  if (reactorFd < 0)
+  {
+    printf("reactorInit: epoll_create1 failed: %s\n", strerror(errno));
+    return -1;
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      reactorAddFd
+ *
+ * @brief   registers an fd and its handler. An fd that is already
+ *          registered is updated in place, so it is safe to call this
+ *          again after a device was reopened on the same fd number.
+ *
+ * @param   fd - file descriptor
+ * @param   events - epoll events to wait for (EPOLLIN, EPOLLPRI, ...)
+ * @param   cb - handler called when the fd is ready
+ *
+ * @return  0 on success, -1 on failure
+ */
+int32_t reactorAddFd( int fd, uint32_t events, reactorCb_t cb )
+{
+  struct epoll_event ev;
+
+  if ((reactorFd < 0) || (fd < 0) || (cb == NULL))
+  {
+    return -1;
+  }
+
+  if (reactorSetHandler(fd, cb) < 0)
+  {
+    return -1;
+  }
+
+  memset(&ev, 0, sizeof(ev));
+  ev.events = events;
+  ev.data.u64 = reactorEventData(fd);
+
+  if (epoll_ctl(reactorFd, EPOLL_CTL_ADD, fd, &ev) < 0)
+  {
+    if ((errno != EEXIST) || (epoll_ctl(reactorFd, EPOLL_CTL_MOD, fd, &ev) < 0))
+    {
+      printf("reactorAddFd: fd %d: %s\n", fd, strerror(errno));
+      reactorSetHandler(fd, NULL);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      reactorModFd
+ *
+ * @brief   changes the events a registered fd is waiting for.
+ *
+ * @param   fd - file descriptor
+ * @param   events - epoll events to wait for
+ *
+ * @return  0 on success, -1 on failure
+ */
+int32_t reactorModFd( int fd, uint32_t events )
+{
+  struct epoll_event ev;
+
+  if ((reactorFd < 0) || (fd < 0) || (fd >= reactorHandlersSize) || (reactorHandlers[fd].cb == NULL))
+  {
+    return -1;
+  }
+
+  memset(&ev, 0, sizeof(ev));
+  ev.events = events;
+  ev.data.u64 = reactorEventData(fd);
+
+  if (epoll_ctl(reactorFd, EPOLL_CTL_MOD, fd, &ev) < 0)
+  {
+    printf("reactorModFd: fd %d: %s\n", fd, strerror(errno));
+    return -1;
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      reactorRemoveFd
+ *
+ * @brief   unregisters an fd. Must be called before the fd is closed so
+ *          that events already collected for it are not dispatched.
+ *
+ * @param   fd - file descriptor
+ *
+ * @return  none
+ */
+void reactorRemoveFd( int fd )
+{
+  if ((reactorFd < 0) || (fd < 0))
+  {
+    return;
+  }
+
+  //the fd may already be closed, in which case the kernel has dropped it
+  epoll_ctl(reactorFd, EPOLL_CTL_DEL, fd, NULL);
+  reactorSetHandler(fd, NULL);
+}
+
+/*********************************************************************
+ * @fn      reactorPoll
+ *
+ * @brief   waits for events and calls the handlers of the ready fd's.
+ *
+ * @param   timeout - timeout in ms, -1 to wait forever
+ *
+ * @return  number of fd's serviced, -1 on failure
+ */
+int32_t reactorPoll( int timeout )
+{
+  struct epoll_event events[REACTOR_MAX_EVENTS];
+  int numEvents, idx;
+
+  numEvents = epoll_wait(reactorFd, events, REACTOR_MAX_EVENTS, timeout);
+  if (numEvents < 0)
+  {
+    if (errno != EINTR)
+    {
+      printf("reactorPoll: epoll_wait failed: %s\n", strerror(errno));
+      return -1;
+    }
+    return 0;
+  }
+
+  for (idx = 0; idx < numEvents; idx++)
+  {
+    int fd = (int)(uint32_t)events[idx].data.u64;
+    uint32_t gen = (uint32_t)(events[idx].data.u64 >> 32);
+
+    //a previous handler in this batch may have removed this fd, or
+    //registered another one under its number
+    if ((fd < reactorHandlersSize) && (reactorHandlers[fd].cb != NULL) && (reactorHandlers[fd].gen == gen))
+    {
+      reactorHandlers[fd].cb(fd, events[idx].events);
+    }
+  }
+
+  return numEvents;
+}
+
+/*********************************************************************
+ * @fn      reactorNowUs
+ *
+ * @brief   get the monotonic time the timers run on.
+ *
+ * @param   none
+ *
+ * @return  time in us
+ */
+uint64_t reactorNowUs( void )
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+/*********************************************************************
+ * @fn      reactorNow
+ *
+ * @brief   get the monotonic time the timers run on.
+ *
+ * @param   none
+ *
+ * @return  time in ms
+ */
+uint64_t reactorNow( void )
+{
+  return reactorNowUs() / 1000;
+}
+
+/*********************************************************************
+ * @fn      reactorTimerEventCb
+ *
+ * @brief   handler of the timer fd's, calls the callback of the timer
+ *          that expired.
+ *
+ * @param   fd - timer fd
+ * @param   events - epoll events
+ *
+ * @return  none
+ */
+static void reactorTimerEventCb( int fd, uint32_t events )
+{
+  uint64_t expirations;
+  int32_t timer;
+
+  //consume the expiration so the level triggered fd stops reporting
+  read(fd, &expirations, sizeof(expirations));
+
+  for (timer = 0; timer < reactorNumTimers; timer++)
+  {
+    if (reactorTimers[timer].fd == fd)
+    {
+      reactorTimers[timer].cb();
+      return;
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      reactorAddTimer
+ *
+ * @brief   creates a one-shot deadline timer, it is disarmed until
+ *          reactorArmTimer() is called.
+ *
+ * @param   cb - called from reactorPoll() when the deadline is reached
+ *
+ * @return  timer, -1 on failure
+ */
+int32_t reactorAddTimer( reactorTimerCb_t cb )
+{
+  int fd;
+
+  if ((cb == NULL) || (reactorNumTimers >= REACTOR_MAX_TIMERS))
+  {
+    return -1;
+  }
+
+  fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (fd < 0)
+  {
+    perror("reactorAddTimer: timerfd_create");
+    return -1;
+  }
+
+  if (reactorAddFd(fd, EPOLLIN, reactorTimerEventCb) < 0)
+  {
+    close(fd);
+    return -1;
+  }
+
+  reactorTimers[reactorNumTimers].fd = fd;
+  reactorTimers[reactorNumTimers].cb = cb;
+
+  return reactorNumTimers++;
+}
+
+/*********************************************************************
+ * @fn      reactorArmTimer
+ *
+ * @brief   sets the deadline of a timer, replacing the previous one.
+ *          A deadline that has passed expires on the next poll.
+ *
+ * @param   timer - timer returned by reactorAddTimer()
+ * @param   deadline - reactorNow() time in ms, 0 disarms the timer
+ *
+ * @return  none
+ */
+void reactorArmTimer( int32_t timer, uint64_t deadline )
+{
+  struct itimerspec its;
+
+  if ((timer < 0) || (timer >= reactorNumTimers))
+  {
+    return;
+  }
+
+  //an all zero it_value disarms the timer
+  memset(&its, 0, sizeof(its));
+  its.it_value.tv_sec = deadline / 1000;
+  its.it_value.tv_nsec = (deadline % 1000) * 1000000;
+
+  if (timerfd_settime(reactorTimers[timer].fd, TFD_TIMER_ABSTIME, &its, NULL) != 0)
+  {
+    perror("reactorArmTimer: timerfd_settime");
+  }
+}
+
+/*********************************************************************
+ * @fn      reactorClose
+ *
+ * @brief   closes the epoll instance and the timers and frees the
+ *          handler table.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void reactorClose( void )
+{
+  int32_t timer;
+
+  for (timer = 0; timer < reactorNumTimers; timer++)
+  {
+    close(reactorTimers[timer].fd);
+  }
+  reactorNumTimers = 0;
+
+  if (reactorFd >= 0)
+  {
+    close(reactorFd);
+    reactorFd = -1;
+  }
+
+  free(reactorHandlers);
+  reactorHandlers = NULL;
+  reactorHandlersSize = 0;
+}
@@ -0,0 +1,121 @@
+/**************************************************************************************************
+ * Filename:       reactor.h
+ * Description:    epoll based event dispatcher for the gateway main loop.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <sys/epoll.h>
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Handler called from reactorPoll() with the ready fd and its epoll events
+typedef void (*reactorCb_t)( int fd, uint32_t events );
+
+// Callback called from reactorPoll() when the deadline of a timer is reached
+typedef void (*reactorTimerCb_t)( void );
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * reactorInit - creates the epoll instance.
+ */
+int32_t reactorInit( void );
+
+/*
+ * reactorAddFd - registers (or re-registers) an fd and its handler.
+ */
+int32_t reactorAddFd( int fd, uint32_t events, reactorCb_t cb );
+
+/*
+ * reactorModFd - changes the events an fd is waiting for.
+ */
+int32_t reactorModFd( int fd, uint32_t events );
+
+/*
+ * reactorRemoveFd - unregisters an fd, must be called before closing it.
+ */
+void reactorRemoveFd( int fd );
+
+/*
+ * reactorPoll - waits for events and calls the handlers of the ready fd's.
+ */
+int32_t reactorPoll( int timeout );
+
+/*
+ * reactorNow - monotonic time in ms, the clock of the timer deadlines.
+ */
+uint64_t reactorNow( void );
+
+/*
+ * reactorNowUs - the same monotonic time in us.
+ */
+uint64_t reactorNowUs( void );
+
+/*
+ * reactorAddTimer - creates a one-shot deadline timer.
+ */
+int32_t reactorAddTimer( reactorTimerCb_t cb );
+
+/*
+ * reactorArmTimer - sets the absolute deadline of a timer, 0 disarms it.
+ */
+void reactorArmTimer( int32_t timer, uint64_t deadline );
+
+/*
+ * reactorClose - closes the epoll instance.
+ */
+void reactorClose( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REACTOR_H */
@@ -45,160 +45,655 @@
 #include <unistd.h>
 #include <sys/types.h> 
 #include <sys/socket.h>
+#include <sys/un.h>
+#include <stddef.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <fcntl.h>
 #include <sys/signal.h>
 #include <sys/ioctl.h>
-#include <poll.h>
+#include <sys/uio.h>
 #include <errno.h>
 
 #include "socket_server.h"
+#include "reactor.h"
 
-#define MAX_CLIENTS 50
+// fd table grows in steps of this many fd's
+#define SOCKET_FD_TABLE_STEP 64
+// Bytes past the received data that Rx handlers may read without faulting
+#define SOCKET_RX_BUF_GUARD 256
+// Max messages gathered in one sendmsg()
+#define SOCKET_TX_IOV_MAX 64
 
-#define SOCKET_BOOTLOADING_STATE_IDLE 0
-#define SOCKET_BOOTLOADING_STATE_ACTIVE 1
-
-//todo: use a callback instead.
-void SRPC_killLoadingImage(void);
-extern uint16_t SocketBootloadingState;
-extern uint32_t bootloader_initiator_clientFd;
+#define SOCKET_CLIENT_EVENTS (EPOLLIN | EPOLLRDHUP)
 
 
 /*********************************************************************
- * TYPEDEFS
- */ 
-typedef struct
-{
-  void   *next;
-  int socketFd;
-  socklen_t clilen;
-  struct sockaddr_in cli_addr;
-} socketRecord_t;
-
+ * GLOBAL VARIABLES
+ */
+socketServerRxCb_t socketServerRxCb;
+socketServerCb_t socketServerConnectCb;
+socketServerCb_t socketServerDisconnectCb;
 
 /*********************************************************************
- * GLOBAL VARIABLES
+ * LOCAL VARIABLES
  */
-socketRecord_t *socketRecordHead = NULL;
+static int socketListenFd = -1;
+static int socketUnixListenFd = -1;
+// filesystem path of the unix socket, removed on close (empty if abstract)
+static char socketUnixPath[sizeof(((struct sockaddr_un *)0)->sun_path)];
 
-socketServerCb_t socketServerRxCb;
-socketServerCb_t socketServerConnectCb;
-	
+// Client records indexed by fd, NULL if the fd is not a client
+static socketRecord_t **socketFdTable = NULL;
+static int socketFdTableSize = 0;
+
+// Dense array of the connected clients, used for iteration
+static socketRecord_t **socketClients = NULL;
+static uint32_t socketNumClients = 0;
+static uint32_t socketMaxClients = SOCKET_SERVER_DEFAULT_MAX_CLIENTS;
+
+static uint32_t socketTxQueueLen = SOCKET_SERVER_DEFAULT_TXQ_LEN;
+static uint8_t socketTxPolicy = SOCKET_TXQ_POLICY_DROP_OLDEST;
+
+static uint32_t socketBacklog = SOCKET_SERVER_DEFAULT_BACKLOG;
+static uint8_t socketRejectMsg[SOCKET_REJECT_NUM][SOCKET_REJECT_MSG_MAX_LEN];
+static uint32_t socketRejectMsgLen[SOCKET_REJECT_NUM];
+
+static socketServerStats_t socketStats;
  
 /*********************************************************************
  * LOCAL FUNCTION PROTOTYPES
  */ 
 static void deleteSocketRec( int rmSocketFd );
-static int createSocketRec( void );
+static int32 createSocketRec( int listenFd, int clientFd, struct sockaddr_storage *cliAddr, socklen_t cliLen );
+static void socketReject( int clientFd, uint8_t reason );
+static void socketAccept( int listenFd );
+static int32 socketFdTableReserve( int fd );
+static socketBuf_t *socketBufAlloc( uint8_t *buf, uint32_t len, uint32_t key );
+static void socketBufRelease( socketBuf_t *sBuf );
+static int32 socketTxEnqueue( socketRecord_t *rec, socketBuf_t *sBuf );
+static int32 socketTxFlush( socketRecord_t *rec );
+static void socketTxAbort( socketRecord_t *rec );
+static void socketTxUpdateEvents( socketRecord_t *rec );
+static void socketTxQueue( socketRecord_t *rec, socketBuf_t *sBuf );
+static int32 socketRxService( socketRecord_t *rec );
 
 /*********************************************************************
  * FUNCTIONS
  *********************************************************************/
 
+/*********************************************************************
+ * @fn      socketFdTableReserve
+ *
+ * @brief   make sure the fd table can hold an fd.
+ *
+ * @param   fd - file descriptor
+ *
+ * @return  0 on success, -1 on failure
+ */
+static int32 socketFdTableReserve( int fd )
+{
+  if (fd >= socketFdTableSize)
+  {
+    int newSize = ((fd / SOCKET_FD_TABLE_STEP) + 1) * SOCKET_FD_TABLE_STEP;
+    socketRecord_t **newTable = realloc(socketFdTable, newSize * sizeof(socketRecord_t *));
+
+    if (newTable == NULL)
+    {
+      return -1;
+    }
+
+    memset(&newTable[socketFdTableSize], 0, (newSize - socketFdTableSize) * sizeof(socketRecord_t *));
+    socketFdTable = newTable;
+    socketFdTableSize = newSize;
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      socketBufAlloc
+ *
+ * @brief   copy a message into a new refcounted buffer.
+ *
+ * @param   buf - message
+ * @param   len - message length
+ * @param   key - coalescing key, 0 for none
+ *
+ * @return  buffer with a refCnt of 1, NULL if out of memory
+ */
+static socketBuf_t *socketBufAlloc( uint8_t *buf, uint32_t len, uint32_t key )
+{
+  socketBuf_t *sBuf = malloc(sizeof(socketBuf_t) + len);
+
+  if (sBuf)
+  {
+    sBuf->refCnt = 1;
+    sBuf->len = len;
+    sBuf->key = key;
+    memcpy(sBuf->data, buf, len);
+  }
+
+  return sBuf;
+}
+
+/*********************************************************************
+ * @fn      socketBufRelease
+ *
+ * @brief   drop a reference to a buffer, freeing it with the last one.
+ *
+ * @param   sBuf - buffer
+ *
+ * @return  none
+ */
+static void socketBufRelease( socketBuf_t *sBuf )
+{
+  if (--sBuf->refCnt == 0)
+  {
+    free(sBuf);
+  }
+}
+
+/*********************************************************************
+ * @fn      socketTxEnqueue
+ *
+ * @brief   add a buffer to the outbound queue of a client, applying the
+ *          full queue policy.
+ *
+ * @param   rec - client
+ * @param   sBuf - buffer, a reference is taken when it is queued
+ *
+ * @return  0 on success, -1 if the client must be disconnected
+ */
+static int32 socketTxEnqueue( socketRecord_t *rec, socketBuf_t *sBuf )
+{
+  uint32_t first = (rec->txOffset ? 1 : 0); //the head is in flight if partly sent
+  uint32_t idx;
+
+  if ((socketTxPolicy == SOCKET_TXQ_POLICY_COALESCE) && (sBuf->key != 0))
+  {
+    //replace the newest queued message for the same key
+    for (idx = rec->txCount; idx > first; idx--)
+    {
+      uint32_t slot = (rec->txHead + idx - 1) % socketTxQueueLen;
+
+      if (rec->txQueue[slot]->key == sBuf->key)
+      {
+        socketBufRelease(rec->txQueue[slot]);
+        sBuf->refCnt++;
+        rec->txQueue[slot] = sBuf;
+        rec->txDropped++;
+        socketStats.txDropped++;
+        return 0;
+      }
+    }
+  }
+
+  if (rec->txCount == socketTxQueueLen)
+  {
+    if (socketTxPolicy == SOCKET_TXQ_POLICY_DISCONNECT)
+    {
+      printf("Client fd:%d outbound queue full, disconnecting\n", rec->socketFd);
+      socketStats.evictedSlowConsumer++;
+      return -1;
+    }
+
+    //drop the oldest message that is not in flight
+    if (first)
+    {
+      uint32_t next = (rec->txHead + 1) % socketTxQueueLen;
+
+      socketBufRelease(rec->txQueue[next]);
+      rec->txQueue[next] = rec->txQueue[rec->txHead];
+    }
+    else
+    {
+      socketBufRelease(rec->txQueue[rec->txHead]);
+    }
+    rec->txHead = (rec->txHead + 1) % socketTxQueueLen;
+    rec->txCount--;
+    rec->txDropped++;
+    socketStats.txDropped++;
+  }
+
+  sBuf->refCnt++;
+  rec->txQueue[(rec->txHead + rec->txCount) % socketTxQueueLen] = sBuf;
+  rec->txCount++;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      socketTxFlush
+ *
+ * @brief   write as much of the outbound queue as the socket accepts,
+ *          gathering the queued messages into one sendmsg(). A client
+ *          that reset fails the call with EPIPE, not a SIGPIPE.
+ *
+ * @param   rec - client
+ *
+ * @return  0 on success, -1 on a socket error
+ */
+static int32 socketTxFlush( socketRecord_t *rec )
+{
+  while (rec->txCount)
+  {
+    struct iovec iov[SOCKET_TX_IOV_MAX];
+    struct msghdr msg;
+    uint32_t numIov, idx;
+    ssize_t total = 0, rtn;
+
+    for (numIov = 0; (numIov < rec->txCount) && (numIov < SOCKET_TX_IOV_MAX); numIov++)
+    {
+      socketBuf_t *sBuf = rec->txQueue[(rec->txHead + numIov) % socketTxQueueLen];
+      uint32_t offset = (numIov == 0) ? rec->txOffset : 0;
+
+      iov[numIov].iov_base = sBuf->data + offset;
+      iov[numIov].iov_len = sBuf->len - offset;
+      total += iov[numIov].iov_len;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = numIov;
+    rtn = sendmsg(rec->socketFd, &msg, MSG_NOSIGNAL);
+    if (rtn < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+      {
+        break;
+      }
+      printf("ERROR writing to socket %d: %s\n", rec->socketFd, strerror( errno ));
+      return -1;
+    }
+
+    rec->txBytes += rtn;
+
+    //release the messages that were sent completely
+    for (idx = 0; idx < numIov; idx++)
+    {
+      if ((size_t) rtn < iov[idx].iov_len)
+      {
+        rec->txOffset += rtn;
+        break;
+      }
+      rtn -= iov[idx].iov_len;
+      socketBufRelease(rec->txQueue[rec->txHead]);
+      rec->txHead = (rec->txHead + 1) % socketTxQueueLen;
+      rec->txCount--;
+      rec->txOffset = 0;
+    }
+
+    if (idx < numIov)
+    {
+      //short write, the socket buffer is full
+      break;
+    }
+  }
+
+  socketTxUpdateEvents(rec);
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      socketTxUpdateEvents
+ *
+ * @brief   wait for EPOLLOUT only while the client has queued data.
+ *
+ * @param   rec - client
+ *
+ * @return  none
+ */
+static void socketTxUpdateEvents( socketRecord_t *rec )
+{
+  uint8_t waiting = (rec->txCount > 0);
+
+  if (waiting != rec->txWaiting)
+  {
+    reactorModFd(rec->socketFd, SOCKET_CLIENT_EVENTS | (waiting ? EPOLLOUT : 0));
+    rec->txWaiting = waiting;
+  }
+}
+
+/*********************************************************************
+ * @fn      socketTxAbort
+ *
+ * @brief   drop the queue of a failed client and shut its socket down.
+ *          The record is deleted when the hang up event is serviced, so
+ *          it is safe to call this while iterating the client table or
+ *          from within the client's own Rx callback.
+ *
+ * @param   rec - client
+ *
+ * @return  none
+ */
+static void socketTxAbort( socketRecord_t *rec )
+{
+  while (rec->txCount)
+  {
+    socketBufRelease(rec->txQueue[rec->txHead]);
+    rec->txHead = (rec->txHead + 1) % socketTxQueueLen;
+    rec->txCount--;
+  }
+  rec->txOffset = 0;
+  rec->txFailed = TRUE;
+
+  shutdown(rec->socketFd, SHUT_RDWR);
+  socketTxUpdateEvents(rec);
+}
+
+/*********************************************************************
+ * @fn      socketTxQueue
+ *
+ * @brief   queue a buffer to a client and try to send it straight away.
+ *
+ * @param   rec - client
+ * @param   sBuf - buffer
+ *
+ * @return  none
+ */
+static void socketTxQueue( socketRecord_t *rec, socketBuf_t *sBuf )
+{
+  if (rec->txFailed)
+  {
+    return;
+  }
+
+  if (socketTxEnqueue(rec, sBuf) < 0)
+  {
+    socketTxAbort(rec);
+    return;
+  }
+
+  //if we are already waiting for EPOLLOUT the socket is full, the
+  //message goes out with the rest of the queue
+  if ((!rec->txWaiting) && (socketTxFlush(rec) < 0))
+  {
+    socketTxAbort(rec);
+  }
+}
+
+/*********************************************************************
+ * @fn      socketRxService
+ *
+ * @brief   read what the client sent in one read() and pass everything
+ *          not yet consumed to the Rx callback, in place. What the
+ *          callback does not consume (a partial message) is moved to the
+ *          start of the buffer for the next event.
+ *
+ * @param   rec - client
+ *
+ * @return  1 if data was read, 0 if there was none, -1 if the client
+ *          closed or must be closed
+ */
+static int32 socketRxService( socketRecord_t *rec )
+{
+  int fd = rec->socketFd;
+  ssize_t rtn;
+  uint32_t consumed;
+
+  rtn = read(fd, rec->rxBuf + rec->rxLen, SOCKET_SERVER_RX_BUF_SIZE - rec->rxLen);
+  if (rtn == 0)
+  {
+    return -1;
+  }
+  if (rtn < 0)
+  {
+    if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))
+    {
+      return 0;
+    }
+    printf("ERROR reading from socket %d: %s\n", fd, strerror( errno ));
+    return -1;
+  }
+
+  rec->rxLen += rtn;
+  rec->rxBytes += rtn;
+
+  if (socketServerRxCb == NULL)
+  {
+    rec->rxLen = 0;
+    return 1;
+  }
+
+  consumed = socketServerRxCb(fd, rec->rxBuf, rec->rxLen);
+
+  //the Rx callback may have closed the client
+  if (socketSeverGetClient(fd) != rec)
+  {
+    return 1;
+  }
+
+  if (consumed >= rec->rxLen)
+  {
+    rec->rxLen = 0;
+  }
+  else if (consumed > 0)
+  {
+    rec->rxLen -= consumed;
+    memmove(rec->rxBuf, rec->rxBuf + consumed, rec->rxLen);
+  }
+  else if (rec->rxLen == SOCKET_SERVER_RX_BUF_SIZE)
+  {
+    printf("Client fd:%d message does not fit the receive buffer\n", fd);
+    socketStats.evictedRxOverflow++;
+    return -1;
+  }
+
+  return 1;
+}
+
+/*********************************************************************
+ * @fn      socketReject
+ *
+ * @brief   tell a client why it was not accepted and close it. The
+ *          message is small enough for the empty socket buffer of a new
+ *          connection, so it is sent without waiting.
+ *
+ * @param   clientFd - accepted socket
+ * @param   reason - SOCKET_REJECT_xxx
+ *
+ * @return  none
+ */
+static void socketReject( int clientFd, uint8_t reason )
+{
+  if (socketRejectMsgLen[reason] > 0)
+  {
+    send(clientFd, socketRejectMsg[reason], socketRejectMsgLen[reason], MSG_DONTWAIT | MSG_NOSIGNAL);
+  }
+  close(clientFd);
+}
+
 /*********************************************************************
  * @fn      createSocketRec
  *
- * @brief   create a socket and add a rec fto the list.
+ * @brief   admit an accepted client and add it to the client table.
  *
- * @param   table
- * @param   rmTimer
+ * @param   listenFd - listening socket the client connected to
+ * @param   clientFd - accepted socket
+ * @param   cliAddr - address of the client
+ * @param   cliLen - length of cliAddr
  *
- * @return  new clint fd
+ * @return  0 if the client was added, -1 if it was rejected and closed
  */
-int createSocketRec( void  )
+static int32 createSocketRec( int listenFd, int clientFd, struct sockaddr_storage *cliAddr, socklen_t cliLen )
 {
   int tr=1;
-  socketRecord_t *srchRec;
-  
-  socketRecord_t *newSocket = malloc( sizeof( socketRecord_t ) );
-  
-  //open a new client connection with the listening socket (at head of list)
-  newSocket->clilen = sizeof(newSocket->cli_addr);
-      
-  //Head is always the listening socket
-  newSocket->socketFd = accept(socketRecordHead->socketFd, 
-               (struct sockaddr *) &(newSocket->cli_addr), 
-               &(newSocket->clilen));
-
-   //printf("connected\n");
-                 
-   if (newSocket->socketFd < 0) 
-        printf("ERROR on accept");
-
-   // Set the socket option SO_REUSEADDR to reduce the chance of a 
-   // "Address Already in Use" error on the bind
-   setsockopt(newSocket->socketFd,SOL_SOCKET,SO_REUSEADDR,&tr,sizeof(int));
-   // Set the fd to none blocking
-   fcntl(newSocket->socketFd, F_SETFL, O_NONBLOCK);
+  socketRecord_t *newSocket;
+
+  //enforce the capacity policy before spending memory on the client
+  if (socketNumClients >= socketMaxClients)
+  {
+    printf("Rejecting client fd:%d, %d of %d clients connected\n", 
+      clientFd, socketNumClients, socketMaxClients);
+    socketStats.rejectedMaxClients++;
+    socketReject(clientFd, SOCKET_REJECT_MAX_CLIENTS);
+    return -1;
+  }
+
+  newSocket = calloc(1, sizeof(socketRecord_t));
+  if ((newSocket == NULL) || (socketFdTableReserve(clientFd) < 0) ||
+      ((newSocket->txQueue = calloc(socketTxQueueLen, sizeof(socketBuf_t *))) == NULL) ||
+      ((newSocket->rxBuf = calloc(1, SOCKET_SERVER_RX_BUF_SIZE + SOCKET_RX_BUF_GUARD)) == NULL))
+  {
+    printf("Rejecting client fd:%d, out of memory\n", clientFd);
+    socketStats.rejectedNoMemory++;
+    socketReject(clientFd, SOCKET_REJECT_NO_MEMORY);
+    if (newSocket)
+    {
+      free(newSocket->txQueue);
+      free(newSocket);
+    }
+    return -1;
+  }
+
+  newSocket->socketFd = clientFd;
+  newSocket->cli_addr = *cliAddr;
+  newSocket->clilen = cliLen;
+
+  // Set the socket option SO_REUSEADDR to reduce the chance of a 
+  // "Address Already in Use" error on the bind
+  setsockopt(newSocket->socketFd,SOL_SOCKET,SO_REUSEADDR,&tr,sizeof(int));
    
-   //printf("New Client Connected fd:%d - IP:%s\n", newSocket->socketFd, inet_ntoa(newSocket->cli_addr.sin_addr));
+  newSocket->connectTime = time(NULL);
+
+  //identify local clients by the credentials of the connecting process
+  if (listenFd == socketUnixListenFd)
+  {
+    struct ucred cred;
+    socklen_t credLen = sizeof(cred);
+
+    newSocket->isLocal = TRUE;
+    if (getsockopt(newSocket->socketFd, SOL_SOCKET, SO_PEERCRED, &cred, &credLen) == 0)
+    {
+      newSocket->peerPid = cred.pid;
+      newSocket->peerUid = cred.uid;
+      newSocket->peerGid = cred.gid;
+    }
+    printf("New local client fd:%d pid:%d uid:%d gid:%d\n", newSocket->socketFd,
+      (int) newSocket->peerPid, (int) newSocket->peerUid, (int) newSocket->peerGid);
+  }
    
-   newSocket->next = NULL;
+  //printf("New Client Connected fd:%d\n", newSocket->socketFd);
    
-   //find the end of the list and add the record
-   srchRec = socketRecordHead;
-   // Stop at the last record
-   while ( srchRec->next )
-     srchRec = srchRec->next;
+  // Add to the fd table and the end of the dense array
+  newSocket->idx = socketNumClients;
+  socketClients[socketNumClients++] = newSocket;
+  socketFdTable[newSocket->socketFd] = newSocket;
+
+  socketStats.accepted++;
+  if (socketNumClients > socketStats.peakClients)
+  {
+    socketStats.peakClients = socketNumClients;
+  }
 
-   // Add to the list
-   srchRec->next = newSocket; 
+  // Wait for Rx and shutdown events on the new client
+  reactorAddFd(newSocket->socketFd, SOCKET_CLIENT_EVENTS, socketSeverPoll);
 
-   return(newSocket->socketFd);
+  return 0;
 }
 
+/*********************************************************************
+ * @fn      socketAccept
+ *
+ * @brief   accept the pending connections of a listening socket, at
+ *          most SOCKET_SERVER_ACCEPT_BATCH of them. The listening socket
+ *          is level triggered, connections left over are accepted on
+ *          the next reactor pass after the other ready fd's.
+ *
+ * @param   listenFd - listening socket
+ *
+ * @return  none
+ */
+static void socketAccept( int listenFd )
+{
+  struct sockaddr_storage cliAddr;
+  socklen_t cliLen;
+  int clientFd;
+  uint32_t batch;
+
+  for (batch = 0; batch < SOCKET_SERVER_ACCEPT_BATCH; batch++)
+  {
+    cliLen = sizeof(cliAddr);
+    clientFd = accept4(listenFd, (struct sockaddr *) &cliAddr, &cliLen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+    if (clientFd < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      //ECONNABORTED: the client gave up while queued, try the next one
+      if (errno == ECONNABORTED)
+      {
+        socketStats.acceptErrors++;
+        continue;
+      }
+      if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+      {
+        printf("ERROR on accept: %s\n", strerror( errno ));
+        socketStats.acceptErrors++;
+      }
+      break;
+    }
+
+    if ((createSocketRec(listenFd, clientFd, &cliAddr, cliLen) == 0) && (socketServerConnectCb))
+    {
+      socketServerConnectCb(clientFd);
+    }
+  }
+}
 
  
 /*********************************************************************
  * @fn      deleteSocketRec
  *
- * @brief   Delete a rec from list.
+ * @brief   remove a client from the table and close its socket.
  *
- * @param   table
- * @param   rmTimer
+ * @param   rmSocketFd - client fd
  *
  * @return  none
  */
-void deleteSocketRec( int rmSocketFd )
+static void deleteSocketRec( int rmSocketFd )
 {
-  socketRecord_t *srchRec, *prevRec=NULL;
+  socketRecord_t *rmRec = socketSeverGetClient(rmSocketFd);
+  socketRecord_t *lastRec;
 
-  // Head of the timer list
-  srchRec = socketRecordHead;        
-  
-  // Stop when rec found or at the end
-  while ( (srchRec->socketFd != rmSocketFd) && (srchRec->next) )
-  {
-    prevRec = srchRec;  
-    // over to next
-    srchRec = srchRec->next;        
-  }
-  
-  if (srchRec->socketFd != rmSocketFd)
+  if (rmRec == NULL)
   {
       printf("deleteSocketRec: record not found\n");
       return;    
   }
+
+  if (socketServerDisconnectCb)
+  {
+    socketServerDisconnectCb(rmSocketFd);
+  }
   
-  // Does the record exist
-  if ( srchRec )
-  {               
-    // delete the timer from the list
-    if ( prevRec == NULL )      
-    {
-      //trying to remove first rec, which is always the listining socket
-      printf("deleteSocketRec: removing first rec, which is always the listining socket\n");
-      return; 
-    }
-    
-    //remove record from list    
-    prevRec->next = srchRec->next;    
+  // move the last client into the freed slot of the dense array
+  lastRec = socketClients[--socketNumClients];
+  socketClients[rmRec->idx] = lastRec;
+  lastRec->idx = rmRec->idx;
+  socketClients[socketNumClients] = NULL;
+  socketFdTable[rmSocketFd] = NULL;
       
-    close(srchRec->socketFd);
-    free(srchRec);        
+  while (rmRec->txCount)
+  {
+    socketBufRelease(rmRec->txQueue[rmRec->txHead]);
+    rmRec->txHead = (rmRec->txHead + 1) % socketTxQueueLen;
+    rmRec->txCount--;
   }
+      
+  reactorRemoveFd(rmRec->socketFd);
+  close(rmRec->socketFd);
+  free(rmRec->txQueue);
+  free(rmRec->rxBuf);
+  free(rmRec);        
 }
 
 /***************************************************************************************************
@@ -214,13 +709,20 @@ int32 socketSeverInit( uint32_t port )
   struct sockaddr_in serv_addr;
   int stat, tr=1;
   
-  if(socketRecordHead == NULL)   
+  if(socketListenFd < 0)   
   {
-    // New record
-    socketRecord_t *lsSocket = malloc( sizeof( socketRecord_t ) );
-  
-    lsSocket->socketFd = socket(AF_INET, SOCK_STREAM, 0);
-    if (lsSocket->socketFd < 0) 
+    if (socketClients == NULL)
+    {
+      socketClients = calloc(socketMaxClients, sizeof(socketRecord_t *));
+      if (socketClients == NULL)
+      {
+        printf("ERROR allocating the client table\n");
+        return -1;
+      }
+    }
+
+    socketListenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (socketListenFd < 0) 
     {
        printf("ERROR opening socket");
        return -1;
@@ -228,27 +730,28 @@ int32 socketSeverInit( uint32_t port )
     
     // Set the socket option SO_REUSEADDR to reduce the chance of a 
     // "Address Already in Use" error on the bind
-    setsockopt(lsSocket->socketFd,SOL_SOCKET,SO_REUSEADDR,&tr,sizeof(int));
+    setsockopt(socketListenFd,SOL_SOCKET,SO_REUSEADDR,&tr,sizeof(int));
     // Set the fd to none blocking
-    fcntl(lsSocket->socketFd, F_SETFL, O_NONBLOCK);
+    fcntl(socketListenFd, F_SETFL, O_NONBLOCK);
       
     bzero((char *) &serv_addr, sizeof(serv_addr));
     serv_addr.sin_family = AF_INET;
     serv_addr.sin_addr.s_addr = INADDR_ANY;
     serv_addr.sin_port = htons(port);
-    stat = bind(lsSocket->socketFd, (struct sockaddr *) &serv_addr,
+    stat = bind(socketListenFd, (struct sockaddr *) &serv_addr,
              sizeof(serv_addr));
     if ( stat < 0) 
     {
       printf("ERROR on binding: %s\n", strerror( errno ) );
+      close(socketListenFd);
+      socketListenFd = -1;
       return -1;
     }
-    //will have 5 pending open client requests
-    listen(lsSocket->socketFd,5); 
-    
-    lsSocket->next = NULL;
-    //Head is always the listening socket
-    socketRecordHead = lsSocket;   
+    //queue up to socketBacklog connections while we are busy
+    listen(socketListenFd, socketBacklog); 
+
+    // New connections are serviced from the reactor
+    reactorAddFd(socketListenFd, EPOLLIN, socketSeverPoll);
   }
     
   //printf("waiting for socket new connection\n");  
@@ -256,45 +759,277 @@ int32 socketSeverInit( uint32_t port )
   return 0;
 }
 
+/***************************************************************************************************
+ * @fn      socketSeverInitUnix
+ *
+ * @brief   adds a unix domain socket listener next to the TCP one, clients
+ *          of both share the client table and the Rx/connect callbacks.
+ * @param   path - socket path, a leading '@' puts the socket in the
+ *                 abstract namespace
+ *
+ * @return  Status
+ */      
+int32 socketSeverInitUnix( const char *path )
+{
+  struct sockaddr_un serv_addr;
+  socklen_t addrLen;
+  size_t pathLen = strlen(path);
+
+  if (socketUnixListenFd >= 0)
+  {
+    return 0;
+  }
+
+  if ((pathLen == 0) || (pathLen >= sizeof(serv_addr.sun_path)) ||
+      ((path[0] == SOCKET_SERVER_ABSTRACT_PREFIX) && (pathLen == 1)))
+  {
+    printf("ERROR invalid unix socket path: %s\n", path);
+    return -1;
+  }
+
+  if (socketClients == NULL)
+  {
+    socketClients = calloc(socketMaxClients, sizeof(socketRecord_t *));
+    if (socketClients == NULL)
+    {
+      printf("ERROR allocating the client table\n");
+      return -1;
+    }
+  }
+
+  bzero((char *) &serv_addr, sizeof(serv_addr));
+  serv_addr.sun_family = AF_UNIX;
+  if (path[0] == SOCKET_SERVER_ABSTRACT_PREFIX)
+  {
+    //abstract names start with a NUL and are not NUL terminated
+    memcpy(&serv_addr.sun_path[1], &path[1], pathLen - 1);
+    addrLen = offsetof(struct sockaddr_un, sun_path) + pathLen;
+  }
+  else
+  {
+    memcpy(serv_addr.sun_path, path, pathLen);
+    addrLen = sizeof(serv_addr);
+    //remove a socket left behind by a previous run
+    unlink(path);
+  }
+
+  socketUnixListenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (socketUnixListenFd < 0) 
+  {
+     printf("ERROR opening unix socket: %s\n", strerror( errno ));
+     return -1;
+  }
+  fcntl(socketUnixListenFd, F_SETFL, O_NONBLOCK);
+
+  if ((bind(socketUnixListenFd, (struct sockaddr *) &serv_addr, addrLen) < 0) ||
+      (listen(socketUnixListenFd, socketBacklog) < 0))
+  {
+    printf("ERROR on binding %s: %s\n", path, strerror( errno ) );
+    close(socketUnixListenFd);
+    socketUnixListenFd = -1;
+    return -1;
+  }
+
+  if (path[0] != SOCKET_SERVER_ABSTRACT_PREFIX)
+  {
+    strcpy(socketUnixPath, path);
+  }
+
+  reactorAddFd(socketUnixListenFd, EPOLLIN, socketSeverPoll);
+
+  return 0;
+}
+
 /***************************************************************************************************
  * @fn      serverSocketConfig
  *
- * @brief   register the Rx Callback.
+ * @brief   register the Rx, connect and disconnect Callbacks.
  * @param   
  *
  * @return  Status
  */      
-int32 serverSocketConfig(socketServerCb_t rxCb, socketServerCb_t connectCb)
+int32 serverSocketConfig(socketServerRxCb_t rxCb, socketServerCb_t connectCb, socketServerCb_t disconnectCb)
 {
   socketServerRxCb = rxCb;
   socketServerConnectCb = connectCb;
+  socketServerDisconnectCb = disconnectCb;
   
   return 0;
 }
+
+/***************************************************************************************************
+ * @fn      socketSeverSetMaxClients
+ *
+ * @brief   set the maximum number of connected clients, further
+ *          connections are rejected. Can not be set below the number of
+ *          clients currently connected.
+ * @param   maxClients - max number of clients
+ *
+ * @return  Status
+ */      
+int32 socketSeverSetMaxClients(uint32_t maxClients)
+{
+  if ((maxClients == 0) || (maxClients < socketNumClients))
+  {
+    return -1;
+  }
+
+  if (socketClients != NULL)
+  {
+    socketRecord_t **newClients = realloc(socketClients, maxClients * sizeof(socketRecord_t *));
+    if (newClients == NULL)
+    {
+      return -1;
+    }
+    socketClients = newClients;
+  }
+
+  socketMaxClients = maxClients;
+  
+  return 0;
+}
+
+/***************************************************************************************************
+ * @fn      socketSeverSetTxQueue
+ *
+ * @brief   set the outbound queue length and what to do when a client's
+ *          queue is full. Must be called before the server is started.
+ * @param   maxLen - max queued messages per client
+ * @param   policy - SOCKET_TXQ_POLICY_xxx
+ *
+ * @return  Status
+ */      
+int32 socketSeverSetTxQueue(uint32_t maxLen, uint8_t policy)
+{
+  //at least one message besides the one in flight
+  if ((maxLen < 2) || (policy > SOCKET_TXQ_POLICY_DISCONNECT) || (socketNumClients > 0))
+  {
+    return -1;
+  }
+
+  socketTxQueueLen = maxLen;
+  socketTxPolicy = policy;
+  
+  return 0;
+}
+
+/***************************************************************************************************
+ * @fn      socketSeverSetBacklog
+ *
+ * @brief   set the listen() backlog of the listening sockets, the kernel
+ *          caps it at net.core.somaxconn. Must be called before the
+ *          server is started.
+ * @param   backlog - max pending connections
+ *
+ * @return  Status
+ */      
+int32 socketSeverSetBacklog(uint32_t backlog)
+{
+  if ((backlog == 0) || (socketListenFd >= 0) || (socketUnixListenFd >= 0))
+  {
+    return -1;
+  }
+
+  socketBacklog = backlog;
+  
+  return 0;
+}
+
+/***************************************************************************************************
+ * @fn      socketSeverSetRejectMsg
+ *
+ * @brief   set the message sent to a client that is not accepted,
+ *          before its socket is closed.
+ * @param   reason - SOCKET_REJECT_xxx
+ * @param   buf - message, NULL to close without a message
+ * @param   len - length of the message
+ *
+ * @return  Status
+ */      
+int32 socketSeverSetRejectMsg(uint8_t reason, const uint8_t *buf, uint32_t len)
+{
+  if ((reason >= SOCKET_REJECT_NUM) || (len > SOCKET_REJECT_MSG_MAX_LEN))
+  {
+    return -1;
+  }
+
+  if (buf == NULL)
+  {
+    len = 0;
+  }
+  if (len > 0)
+  {
+    memcpy(socketRejectMsg[reason], buf, len);
+  }
+  socketRejectMsgLen[reason] = len;
+  
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      socketSeverGetStats()
+ *
+ * @brief   get the admission and eviction counters.
+ *
+ * @param   stats - where to copy the counters
+ *
+ * @return  none
+ */
+void socketSeverGetStats(socketServerStats_t *stats)
+{
+  *stats = socketStats;
+}
+
+/*********************************************************************
+ * @fn      socketSeverGetMaxClients()
+ *
+ * @brief   get the max number of connected clients.
+ *
+ * @param   none
+ *
+ * @return  max number of clients
+ */
+uint32_t socketSeverGetMaxClients(void)
+{
+  return socketMaxClients;
+}
+
+/*********************************************************************
+ * @fn      socketSeverGetClient()
+ *
+ * @brief   look up a client record.
+ *
+ * @param   clientFd - client fd
+ *
+ * @return  client record, NULL if the fd is not a connected client
+ */
+socketRecord_t *socketSeverGetClient(int clientFd)
+{
+  if ((clientFd < 0) || (clientFd >= socketFdTableSize))
+  {
+    return NULL;
+  }
+
+  return socketFdTable[clientFd];
+}
+
 /*********************************************************************
  * @fn      socketSeverGetClientFds()
  *
  * @brief   get clients fd's.
  *
- * @param   none
+ * @param   fds - buffer for the fd's
+ * @param   maxFds - size of fds
  *
- * @return  list of Timerfd's
+ * @return  none
  */
 void socketSeverGetClientFds(int *fds, int maxFds)
 {  
-  uint32_t recordCnt=0;
-  socketRecord_t *srchRec;
+  uint32_t recordCnt;
 
-  // Head of the timer list
-  srchRec = socketRecordHead; 
-    
-  // Stop when at the end or max is reached
-  while ( (srchRec) && (recordCnt < maxFds) )
+  for (recordCnt = 0; (recordCnt < socketNumClients) && (recordCnt < maxFds); recordCnt++)
   {  
-    //printf("getClientFds: adding fd%d, to idx:%d \n", srchRec->socketFd, recordCnt);
-    fds[recordCnt++] = srchRec->socketFd;
-    
-    srchRec = srchRec->next;      
+    fds[recordCnt] = socketClients[recordCnt]->socketFd;
   }
       	
   return;
@@ -303,90 +1038,72 @@ void socketSeverGetClientFds(int *fds, int maxFds)
 /*********************************************************************
  * @fn      socketSeverGetNumClients()
  *
- * @brief   get clients fd's.
+ * @brief   get the number of connected clients.
  *
  * @param   none
  *
- * @return  list of Timerfd's
+ * @return  number of clients
  */
 uint32_t socketSeverGetNumClients(void)
 {  
-  uint32_t recordCnt=0;
-  socketRecord_t *srchRec;
-  
-  //printf("socketSeverGetNumClients++\n", recordCnt);
-  
-  // Head of the timer list
-  srchRec = socketRecordHead;
-  
-  if(srchRec==NULL)
-  {
-    //printf("socketSeverGetNumClients: socketRecordHead NULL\n");
-    return -1;
-  }
-    
-  // Stop when rec found or at the end
-  while ( srchRec )
-  {  
-    //printf("socketSeverGetNumClients: recordCnt=%d\n", recordCnt);
-    srchRec = srchRec->next;  
-    recordCnt++;      
-  }
-  
-  //printf("socketSeverGetNumClients %d\n", recordCnt);
-  return (recordCnt);
+  return socketNumClients;
 }
 
-
 /*********************************************************************
  * @fn      socketSeverPoll()
  *
  * @brief   services the Socket events.
  *
  * @param   clinetFd - Fd to services
- * @param   revent - event to services
+ * @param   revent - epoll event(s) to services
  *
  * @return  none
  */
-void socketSeverPoll(int clientFd, int revent)
+void socketSeverPoll(int clientFd, uint32_t revent)
 {
   //printf("pollSocket++\n");
 
   //is this a new connection on the listening socket
-  if(clientFd == socketRecordHead->socketFd)
+  if((clientFd == socketListenFd) || (clientFd == socketUnixListenFd))
   {
-    int newClientFd = createSocketRec();
-    
-    if(socketServerConnectCb)
-    {
-      socketServerConnectCb(newClientFd);
-    }            
+    socketAccept(clientFd);
   }
   else
   {
+    socketRecord_t *rec = socketSeverGetClient(clientFd);
+    uint8_t hangup = (revent & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) ? TRUE : FALSE;
+
+    //the socket can take more of the outbound queue
+    if ((revent & EPOLLOUT) && (rec) && (socketTxFlush(rec) < 0))
+    {
+      socketTxAbort(rec);
+    }
+
     //this is a client socket is it a input or shutdown event
-    if (revent & POLLIN)
+    if ((revent & EPOLLIN) && (rec) && (!rec->txFailed))
     {
       //its a Rx event
 //      printf("got Rx on fd %d, pakcetCnt=%d\n", clientFd, pakcetCnt++);      
-      if(socketServerRxCb)
+      int32 rtn = socketRxService(rec);
+
+      //on a hang up drain what the client sent before it closed
+      while ((hangup) && (rtn > 0) && ((rec = socketSeverGetClient(clientFd)) != NULL))
+      {
+        rtn = socketRxService(rec);
+      }
+      if (rtn < 0)
       {
-        socketServerRxCb(clientFd);
+        hangup = TRUE;
       }
-             
+      
+      //the Rx callback may have closed the client
+      rec = socketSeverGetClient(clientFd);
     } 
-    if (revent & POLLRDHUP)
+    if ((rec) && ((hangup) || (rec->txFailed)))
     {
       //its a shut down close the socket
 //      printf("Client fd:%d disconnected\n", clientFd); 
 
-//todo: use a callback instead.
-	  if ((SocketBootloadingState != SOCKET_BOOTLOADING_STATE_IDLE) && (clientFd == bootloader_initiator_clientFd))
-	  {
-	  	SRPC_killLoadingImage( );
-		printf("Image download aborted by client disconnection\n");
-	  }
-      
       //remove the record and close the socket
       deleteSocketRec(clientFd);              
     }     
@@ -401,7 +1118,8 @@ void socketSeverPoll(int clientFd, int revent)
 /***************************************************************************************************
  * @fn      socketSeverSend
  *
- * @brief   Send a buffer to a clients.
+ * @brief   Send a buffer to a clients. The buffer is queued if the
+ *          socket can not take it straight away.
  * @param   uint8* srpcMsg - message to be sent
  *          int32 fdClient - Client fd
  *
@@ -409,22 +1127,27 @@ void socketSeverPoll(int clientFd, int revent)
  */
 int32 socketSeverSend(uint8* buf, uint32_t len, int32 fdClient)
 { 
-  int32 rtn;
+  socketRecord_t *rec = socketSeverGetClient(fdClient);
+  socketBuf_t *sBuf;
 
   //printf("socketSeverSend++: writing to socket fd %d\n", fdClient);
   
-  if(fdClient)
+  if ((rec == NULL) || (rec->txFailed))
   {
-    rtn = write(fdClient, buf, len);
-    if (rtn < 0) 
-    {
-      printf("ERROR writing to socket %d\n", fdClient);       
-      return rtn;
-    }
+    printf("ERROR writing to socket %d\n", fdClient);       
+    return -1;
+  }
+
+  if ((sBuf = socketBufAlloc(buf, len, 0)) == NULL)
+  {
+    return -1;
   }
+
+  socketTxQueue(rec, sBuf);
+  socketBufRelease(sBuf);
    
   //printf("socketSeverSend--\n");
-  return 0;
+  return (rec->txFailed ? -1 : 0);
 }  
   
   
@@ -438,30 +1161,100 @@ int32 socketSeverSend(uint8* buf, uint32_t len, int32 fdClient)
  */
 int32 socketSeverSendAllclients(uint8* buf, uint32_t len)
 { 
-  int rtn;
-  socketRecord_t *srchRec;
+  return socketSeverSendAllclientsKeyed(buf, len, 0);
+}
+
+/***************************************************************************************************
+ * @fn      socketSeverSendAllclientsKeyed
+ *
+ * @brief   Send a buffer to all clients. The message is copied once into
+ *          a refcounted buffer shared by all client queues, a client that
+ *          fails does not stop the others from getting the message.
+ * @param   uint8* srpcMsg - message to be sent
+ *          uint32_t key - coalescing key, 0 for none
+ *
+ * @return  Status
+ */
+int32 socketSeverSendAllclientsKeyed(uint8* buf, uint32_t len, uint32_t key)
+{ 
+  int32 rtn = 0;
+  uint32_t idx;
+  socketBuf_t *sBuf;
+
+  if (socketNumClients == 0)
+  {
+    return 0;
+  }
+
+  if ((sBuf = socketBufAlloc(buf, len, key)) == NULL)
+  {
+    return -1;
+  }
    
-  // first client socket
-  srchRec = socketRecordHead->next; 
+  for (idx = 0; idx < socketNumClients; idx++)
+  { 
+    socketRecord_t *rec = socketClients[idx];
+
+    socketTxQueue(rec, sBuf);
+    if (rec->txFailed)
+    {
+      rtn = -1;
+    }
+  }    
+
+  socketBufRelease(sBuf);
     
-  // Stop when at the end or max is reached
-  while ( srchRec )
+  return rtn; 
+}
+
+/***************************************************************************************************
+ * @fn      socketSeverSendClientsKeyed
+ *
+ * @brief   Send a buffer to a set of clients, sharing one refcounted
+ *          buffer like socketSeverSendAllclientsKeyed.
+ * @param   uint8* srpcMsg - message to be sent
+ *          uint32_t key - coalescing key, 0 for none
+ *          int *fds - client fd's
+ *          uint32_t numFds - number of client fd's
+ *
+ * @return  Status
+ */
+int32 socketSeverSendClientsKeyed(uint8* buf, uint32_t len, uint32_t key, int *fds, uint32_t numFds)
+{ 
+  int32 rtn = 0;
+  uint32_t idx;
+  socketBuf_t *sBuf;
+
+  if (numFds == 0)
+  {
+    return 0;
+  }
+
+  if ((sBuf = socketBufAlloc(buf, len, key)) == NULL)
+  {
+    return -1;
+  }
+   
+  for (idx = 0; idx < numFds; idx++)
   { 
-//    printf("SRPC_Send: client %d\n", cnt++);
-    rtn = write(srchRec->socketFd, buf, len);
-    if (rtn < 0) 
+    socketRecord_t *rec = socketSeverGetClient(fds[idx]);
+
+    if ((rec == NULL) || (rec->txFailed))
     {
-      printf("ERROR writing to socket %d\n", srchRec->socketFd);
-      printf("closing client socket\n");
-      //remove the record and close the socket
-      deleteSocketRec(srchRec->socketFd);
-      
-      return rtn;
+      rtn = -1;
+      continue;
+    }
+
+    socketTxQueue(rec, sBuf);
+    if (rec->txFailed)
+    {
+      rtn = -1;
     }
-    srchRec = srchRec->next;      
   }    
+
+  socketBufRelease(sBuf);
     
-  return 0; 
+  return rtn; 
 }
 
 /***************************************************************************************************
@@ -473,21 +1266,31 @@ int32 socketSeverSendAllclients(uint8* buf, uint32_t len)
  */
 void socketSeverClose(void)
 {
-  int fds[MAX_CLIENTS], idx=0;
-  
-  socketSeverGetClientFds(fds, MAX_CLIENTS);
-  
-  while(socketSeverGetNumClients() > 1)
+  while(socketNumClients > 0)
   {         
-    printf("socketSeverClose: Closing socket fd:%d\n", fds[idx]);
-    deleteSocketRec( fds[idx++] );
+    printf("socketSeverClose: Closing socket fd:%d\n", socketClients[0]->socketFd);
+    deleteSocketRec( socketClients[0]->socketFd );
   }
     
   //Now remove the listening socket
-  if(fds[0])
+  if(socketListenFd >= 0)
   {
     printf("socketSeverClose: Closing the listening socket\n");
-    close(fds[0]);
+    reactorRemoveFd(socketListenFd);
+    close(socketListenFd);
+    socketListenFd = -1;
   }
-}
 
+  if(socketUnixListenFd >= 0)
+  {
+    printf("socketSeverClose: Closing the unix socket\n");
+    reactorRemoveFd(socketUnixListenFd);
+    close(socketUnixListenFd);
+    socketUnixListenFd = -1;
+    if (socketUnixPath[0])
+    {
+      unlink(socketUnixPath);
+      socketUnixPath[0] = 0;
+    }
+  }
+}
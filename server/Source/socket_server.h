@@ -52,23 +52,148 @@ typedef void (*socketServerCb_t)( int clientFd );
 /*********************************************************************
  * INCLUDES
  */
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
 #include "hal_types.h"
 
 /*********************************************************************
  * CONSTANTS
  */
 //#define SOCKET_SERVER_PORT 1234
-#define MAX_CLIENTS 50
+// Max connected clients unless changed with socketSeverSetMaxClients
+#define SOCKET_SERVER_DEFAULT_MAX_CLIENTS 50
+// Size of the per client receive buffer
+#define SOCKET_SERVER_RX_BUF_SIZE 4096
+
+// listen() backlog unless changed with socketSeverSetBacklog
+#define SOCKET_SERVER_DEFAULT_BACKLOG 128
+// Max connections accepted per listening socket wakeup, the rest wait
+// for the next reactor pass so a reconnect storm can not starve the
+// other fd's
+#define SOCKET_SERVER_ACCEPT_BATCH 16
+
+// Reasons a connection is rejected, a message can be set for each one
+// with socketSeverSetRejectMsg and is sent before the socket is closed
+#define SOCKET_REJECT_MAX_CLIENTS 0
+#define SOCKET_REJECT_NO_MEMORY   1
+#define SOCKET_REJECT_NUM         2
+#define SOCKET_REJECT_MSG_MAX_LEN 16
+
+// Max queued outbound messages per client unless changed with socketSeverSetTxQueue
+#define SOCKET_SERVER_DEFAULT_TXQ_LEN 64
+
+// What to do when a client's outbound queue is full
+#define SOCKET_TXQ_POLICY_DROP_OLDEST 0 // drop the oldest queued message
+#define SOCKET_TXQ_POLICY_COALESCE    1 // replace a queued message with the same key, else drop oldest
+#define SOCKET_TXQ_POLICY_DISCONNECT  2 // close the client
+
+// Unix socket paths starting with this are in the abstract namespace
+#define SOCKET_SERVER_ABSTRACT_PREFIX '@'
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+// Rx callback, gets the received bytes not yet consumed and returns how
+// many of them it consumed, the rest is kept for the next call
+typedef uint32_t (*socketServerRxCb_t)( int clientFd, uint8_t *buf, uint32_t len );
+
+// Refcounted outbound message, shared by every client queue it is on
+typedef struct
+{
+  uint32_t refCnt;
+  uint32_t len;
+  uint32_t key; // coalescing key, 0 if the message must not be coalesced
+  uint8_t data[];
+} socketBuf_t;
+
+// Admission and eviction counters, since the server started
+typedef struct
+{
+  uint32_t accepted;
+  uint32_t rejectedMaxClients; // over the max clients limit
+  uint32_t rejectedNoMemory; // the client record could not be allocated
+  uint32_t acceptErrors; // accept() failed, e.g. out of fd's
+  uint32_t evictedSlowConsumer; // closed by the disconnect queue policy
+  uint32_t evictedRxOverflow; // sent a message larger than the receive buffer
+  uint32_t txDropped; // messages dropped or coalesced by the queue policy
+  uint32_t peakClients;
+} socketServerStats_t;
+
+typedef struct
+{
+  int socketFd;
+  socklen_t clilen;
+  struct sockaddr_storage cli_addr;
+  time_t connectTime;
+  uint8_t isLocal; // connected over the unix socket
+  pid_t peerPid; // SO_PEERCRED of a local client
+  uid_t peerUid;
+  gid_t peerGid;
+  uint64_t rxBytes;
+  uint64_t txBytes;
+  uint32_t txDropped; // messages dropped or coalesced by the queue policy
+  uint8_t *rxBuf;
+  uint32_t rxLen; // bytes received but not yet consumed
+  socketBuf_t **txQueue;
+  uint32_t txHead;
+  uint32_t txCount;
+  uint32_t txOffset; // bytes of the head message already sent
+  uint8_t txWaiting; // waiting for EPOLLOUT
+  uint8_t txFailed; // socket shut down, waiting for the hang up event
+  uint32_t idx; // position in the client table, internal
+} socketRecord_t;
 
 /*
  * serverSocketInit - initialises the server.
  */      
 int32 socketSeverInit( uint32_t port );
 
+/*
+ * socketSeverInitUnix - adds a unix domain socket listener, '@' selects the abstract namespace.
+ */      
+int32 socketSeverInitUnix( const char *path );
+
 /*
  * serverSocketConfig - initialises the server.
  */      
-int32 serverSocketConfig(socketServerCb_t rxCb, socketServerCb_t connectCb);
+int32 serverSocketConfig(socketServerRxCb_t rxCb, socketServerCb_t connectCb, socketServerCb_t disconnectCb);
+
+/*
+ * socketSeverSetMaxClients - set the max number of connected clients.
+ */
+int32 socketSeverSetMaxClients(uint32_t maxClients);
+
+/*
+ * socketSeverSetTxQueue - set the outbound queue length and full queue policy.
+ */
+int32 socketSeverSetTxQueue(uint32_t maxLen, uint8_t policy);
+
+/*
+ * socketSeverSetBacklog - set the listen() backlog of the listening sockets.
+ */
+int32 socketSeverSetBacklog(uint32_t backlog);
+
+/*
+ * socketSeverSetRejectMsg - set the message sent to a rejected client.
+ */
+int32 socketSeverSetRejectMsg(uint8_t reason, const uint8_t *buf, uint32_t len);
+
+/*
+ * socketSeverGetStats - get the admission and eviction counters.
+ */
+void socketSeverGetStats(socketServerStats_t *stats);
+
+/*
+ * socketSeverGetMaxClients - get the max number of connected clients.
+ */
+uint32_t socketSeverGetMaxClients(void);
+
+/*
+ * socketSeverGetClient - look up a client record, NULL if not connected.
+ */
+socketRecord_t *socketSeverGetClient(int clientFd);
 
 /*
  * getClientFds -  get clients fd's.
@@ -76,20 +201,31 @@ int32 serverSocketConfig(socketServerCb_t rxCb, socketServerCb_t connectCb);
 void socketSeverGetClientFds(int *fds, int maxFds);
 
 /* 
- * getClientFds - get clients fd's. 
+ * socketSeverGetNumClients - get the number of connected clients. 
  */
 uint32_t socketSeverGetNumClients(void);
 
 /*
  * socketSeverPoll - services the Socket events.
  */
-void socketSeverPoll(int clinetFd, int revent);
+void socketSeverPoll(int clinetFd, uint32_t revent);
 
 /*
  * socketSeverSendAllclients - Send a buffer to all clients.
  */
 int32 socketSeverSendAllclients(uint8_t* buf, uint32_t len);
 
+/*
+ * socketSeverSendAllclientsKeyed - Send a buffer to all clients, a queued
+ * message with the same key may be replaced by this one (0 for none).
+ */
+int32 socketSeverSendAllclientsKeyed(uint8_t* buf, uint32_t len, uint32_t key);
+
+/*
+ * socketSeverSendClientsKeyed - Send a buffer to a set of clients.
+ */
+int32 socketSeverSendClientsKeyed(uint8_t* buf, uint32_t len, uint32_t key, int *fds, uint32_t numFds);
+
 /*
  * socketSeverSend - Send a buffer to a clients.
  */
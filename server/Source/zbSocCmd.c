@@ -58,11 +58,8 @@
 
 #include "zbSocCmd.h"
 #include "zbSocTransport.h"
-#if (!HAL_UART_SPI)
-#include "zbSocTransportUart.c"
-#else
-#include "zbSocTransportSpi.c"
-#endif
+#include "zbSocIo.h"
+#include "zbSocSched.h"
 
 /*********************************************************************
  * MACROS
@@ -109,6 +106,7 @@ len,   /*RPC payload Len                                      */     \
 #define MT_APP_RPC_CMD_SEND_RESET_TO_FN   0x06
 #define MT_APP_RPC_CMD_INSTALL_CERTIFICATE   0x07
 
+#define MT_APP_MSG                           0x00
 #define MT_APP_RSP                           0x80
 #define MT_APP_ZLL_TL_IND                    0x81
 #define MT_APP_NEW_DEV_IND               0x82
@@ -116,69 +114,12 @@ len,   /*RPC payload Len                                      */     \
 
 #define MT_DEBUG_MSG                         0x80
 
-#define COMMAND_LIGHTING_MOVE_TO_HUE  0x00
-#define COMMAND_LIGHTING_MOVE_TO_SATURATION 0x03
-#define COMMAND_LEVEL_MOVE_TO_LEVEL 0x00
-
-/*** Foundation Command IDs ***/
-#define ZCL_CMD_READ                                    0x00
-#define ZCL_CMD_READ_RSP                                0x01
-#define ZCL_CMD_WRITE                                   0x02
-#define ZCL_CMD_WRITE_UNDIVIDED                         0x03
-#define ZCL_CMD_WRITE_RSP                               0x04
-
-// General Clusters
-#define ZCL_CLUSTER_ID_GEN_IDENTIFY                    0x0003
-#define ZCL_CLUSTER_ID_GEN_GROUPS                      0x0004
-#define ZCL_CLUSTER_ID_GEN_SCENES                      0x0005
-#define ZCL_CLUSTER_ID_GEN_ON_OFF                      0x0006
-#define ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL               0x0008
-#define ZCL_CLUSTER_ID_GEN_KEY_ESTABLISHMENT                 0x0800
-// Lighting Clusters
-#define ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL          0x0300
-// Mettering and Sensing Clusters
-#define ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT			 0x0402
-#define ZCL_CLUSTER_ID_MS_REL_HUMIDITY_MEASUREMENT		 0x0405
-// Pricing
-#define ZCL_CLUSTER_ID_SE_PRICING                            0x0700
-//Metering
-#define ZCL_CLUSTER_ID_SE_SIMPLE_METERING              0x0702
-// Messaging
-#define ZCL_CLUSTER_ID_SE_MESSAGE                            0x0703
-// Security and Safety (SS) Clusters
-#define ZCL_CLUSTER_ID_SS_IAS_ZONE                     0x0500
-
-// Data Types
-#define ZCL_DATATYPE_BOOLEAN                            0x10
-#define ZCL_DATATYPE_UINT8                              0x20
-#define ZCL_DATATYPE_UINT16                             0x21
-#define ZCL_DATATYPE_INT16                              0x29
-#define ZCL_DATATYPE_INT24                              0x2a
-
-/*******************************/
-/*** Generic Cluster ATTR's  ***/
-/*******************************/
-#define ATTRID_ON_OFF                                     0x0000
-#define ATTRID_LEVEL_CURRENT_LEVEL                        0x0000
-
-/*******************************/
-/*** Lighting Cluster ATTR's  ***/
-/*******************************/
-#define ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_HUE         0x0000
-#define ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_SATURATION  0x0001
+#define MT_UTIL_GET_DEVICE_INFO              0x00
 
+#define MT_RPC_SUCCESS                       0x00
 
-/*******************************/
-/*** Mettering and Sensing Cluster ATTR's  ***/
-/*******************************/
-#define ATTRID_MS_TEMPERATURE_MEASURED_VALUE              0x0000
-#define ATTRID_MS_RELATIVE_HUMIDITY_MEASURED_VALUE        0x0000
-
-/*******************************/
-/*** SE SIMPLE METERING Cluster ATTR's  ***/
-/*******************************/
-#define ATTRID_MASK_SE_HISTORICAL_CONSUMPTION             0x0400
-#define ATTRID_SE_INSTANTANEOUS_DEMAND               ( 0x0000 | ATTRID_MASK_SE_HISTORICAL_CONSUMPTION )
+// MT_APP_MSG: app endpoint, dst addr, dst endpoint, cluster, data len and addr mode
+#define MT_APP_MSG_HDR_LEN                   8
 
 /*******************************/
 /*** Scenes Cluster Commands ***/
@@ -361,6 +302,13 @@ typedef struct {
   uint8_t devPrivateKey[ZCL_KE_DEVICE_PRIVATE_KEY_LEN];
 } certInfo_t;
 
+// MT frame being written, the FCS is kept as the bytes are written
+typedef struct {
+  uint8_t *buf;
+  uint8_t len;
+  uint8_t fcs;
+} mtEncoder_t;
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -389,6 +337,10 @@ zllTimer timers[2] = {
 
 timerFDs_t * timerFDs = NULL;
 
+// IEEE address of the zbSoC, reports are bound to it
+static uint8_t zbSocIeeeAddr[Z_EXTADDR_LEN];
+static uint8_t zbSocIeeeAddrValid = FALSE;
+
 /*********************************************************************
  * EXTERNAL VARIABLES
  */
@@ -399,12 +351,30 @@ extern uint8_t uartDebugPrintsEnabled;
  * LOCAL FUNCTIONS
  */
 static void calcFcs(uint8_t *msg, int size);
+static void mtEncStart(mtEncoder_t *enc, uint8_t *buf, uint8_t payloadLen, uint8_t cmd0, uint8_t cmd1);
+static void mtEncPut8(mtEncoder_t *enc, uint8_t value);
+static void mtEncPut16(mtEncoder_t *enc, uint16_t value);
+static void mtEncPutBuf(mtEncoder_t *enc, uint8_t *data, uint8_t len);
+static uint8_t mtEncFinish(mtEncoder_t *enc);
+static int32_t zbSocSendZclFromEp(uint8_t appEp, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode, 
+                                  uint16_t clusterId, uint8_t frameControl, uint16_t manuCode, 
+                                  uint8_t commandId, uint8_t *payload, uint8_t payloadLen);
+static uint8_t zbSocReadAttr(uint16_t clusterId, uint16_t attrId, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
 static void processRpcSysAppTlInd(uint8_t *TlIndBuff);
 static void processRpcSysAppNewDevInd(uint8_t *TlIndBuff);
 static void processRpcSysAppZcl(uint8_t *zclRspBuff);
-static void processRpcSysAppZclFoundation(uint8_t *zclRspBuff, uint8_t zclFrameLen, uint16_t clusterID, uint16_t nwkAddr, uint8_t endpoint);
+static void processRpcSysAppZclFoundation(uint8_t *zclRspBuff, uint8_t zclFrameLen, uint8_t zclHdrLen, uint16_t clusterID, uint16_t nwkAddr, uint8_t endpoint);
+static void zbSocZclRegisterAttrs(void);
+static void zbSocZclStateAttrCb(uint16_t clusterId, zbSocZclAttr_t *attr, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+static void zbSocZclLevelAttrCb(uint16_t clusterId, zbSocZclAttr_t *attr, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+static void zbSocZclHueAttrCb(uint16_t clusterId, zbSocZclAttr_t *attr, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+static void zbSocZclSatAttrCb(uint16_t clusterId, zbSocZclAttr_t *attr, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+static void zbSocZclTempAttrCb(uint16_t clusterId, zbSocZclAttr_t *attr, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+static void zbSocZclHumidAttrCb(uint16_t clusterId, zbSocZclAttr_t *attr, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+static void zbSocZclPowerAttrCb(uint16_t clusterId, zbSocZclAttr_t *attr, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
 static void processRpcSysAppZclCluster(uint8_t *zclRspBuff, uint8_t zclFrameLen, uint16_t clusterID, uint16_t nwkAddr, uint8_t endpoint);
 static void processRpcSysSys(uint8_t *rpcBuff);
+static void processRpcSysUtil(uint8_t *rpcBuff, uint8_t len);
 static void processRpcSysApp(uint8_t *rpcBuff);
 static void processRpcSysDbg(uint8_t *rpcBuff, uint8_t len);
 void zbSocSblEnableBootloader();
@@ -438,6 +408,99 @@ static void calcFcs(uint8_t *msg, int size)
 	msg[(size-1)] = result;
 }
 
+/*********************************************************************
+ * @fn      mtEncStart
+ *
+ * @brief   starts an MT frame in a buffer.
+ *
+ * @param   enc - encoder
+ * @param   buf - buffer of at least payloadLen + 5 bytes
+ * @param   payloadLen - length of the payload that will be written
+ * @param   cmd0 - command type and subsystem
+ * @param   cmd1 - command id
+ *
+ * @return  none
+ */
+static void mtEncStart(mtEncoder_t *enc, uint8_t *buf, uint8_t payloadLen, uint8_t cmd0, uint8_t cmd1)
+{
+  enc->buf = buf;
+  enc->len = 0;
+  enc->fcs = 0;
+
+  //SOF is not part of the FCS
+  enc->buf[enc->len++] = MT_RPC_SOF;
+  mtEncPut8(enc, payloadLen);
+  mtEncPut8(enc, cmd0);
+  mtEncPut8(enc, cmd1);
+}
+
+/*********************************************************************
+ * @fn      mtEncPut8
+ *
+ * @brief   writes a byte to an MT frame.
+ *
+ * @param   enc - encoder
+ * @param   value - byte to write
+ *
+ * @return  none
+ */
+static void mtEncPut8(mtEncoder_t *enc, uint8_t value)
+{
+  enc->buf[enc->len++] = value;
+  enc->fcs ^= value;
+}
+
+/*********************************************************************
+ * @fn      mtEncPut16
+ *
+ * @brief   writes a little endian 16 bit value to an MT frame.
+ *
+ * @param   enc - encoder
+ * @param   value - value to write
+ *
+ * @return  none
+ */
+static void mtEncPut16(mtEncoder_t *enc, uint16_t value)
+{
+  mtEncPut8(enc, (value & 0x00ff));
+  mtEncPut8(enc, (value & 0xff00) >> 8);
+}
+
+/*********************************************************************
+ * @fn      mtEncPutBuf
+ *
+ * @brief   writes bytes to an MT frame.
+ *
+ * @param   enc - encoder
+ * @param   data - bytes to write
+ * @param   len - number of bytes
+ *
+ * @return  none
+ */
+static void mtEncPutBuf(mtEncoder_t *enc, uint8_t *data, uint8_t len)
+{
+  while (len--)
+  {
+    mtEncPut8(enc, *data++);
+  }
+}
+
+/*********************************************************************
+ * @fn      mtEncFinish
+ *
+ * @brief   ends an MT frame with its FCS.
+ *
+ * @param   enc - encoder
+ *
+ * @return  length of the frame
+ */
+static uint8_t mtEncFinish(mtEncoder_t *enc)
+{
+  enc->buf[enc->len++] = enc->fcs;
+
+  return enc->len;
+}
+
 /*********************************************************************
  * @fn      hexStr2Array
  *
@@ -498,6 +561,13 @@ static uint8_t hexStr2Array(char *str, int len, uint8_t *array)
  */
 int32_t zbSocOpen( char *_devicePath  )
 {
+  if ((zbSocIoInit(zbSocProcessRpc) < 0) || (zbSocSchedInit() < 0))
+  {
+    return(-1);
+  }
+
+  zbSocZclRegisterAttrs();
+
   serialPortFd = zbSocTransportOpen(_devicePath);
   if (serialPortFd <0) 
   {
@@ -505,6 +575,14 @@ int32_t zbSocOpen( char *_devicePath  )
     printf("%s open failed\n",_devicePath);
     return(-1);
   }
+
+  //from here on the I/O thread owns the port
+  if (zbSocIoStart() < 0)
+  {
+    zbSocTransportClose();
+    serialPortFd = -1;
+    return(-1);
+  }
   
   return serialPortFd;
 }
@@ -515,12 +593,13 @@ void zbSocForceRun(void)
 	uint8_t forceBoot = SB_FORCE_RUN;
 	
 	//Send the bootloader force boot incase we have a bootloader that waits
-	zbSocTransportWrite(&forceBoot, 1);
+	zbSocIoWrite(&forceBoot, 1);
 	
 }
 	
 void zbSocClose( void )
 {
+  zbSocIoStop();
   zbSocTransportClose();
 
   return;
@@ -567,7 +646,7 @@ void zbSocTouchLink(void)
     };
 	  
     calcFcs(tlCmd, sizeof(tlCmd));
-    zbSocTransportWrite(tlCmd, sizeof(tlCmd));  
+    zbSocSchedSend(tlCmd, sizeof(tlCmd));  
 }
 
 /*********************************************************************
@@ -594,7 +673,7 @@ void zbSocResetToFn(void)
     };
 	  
     calcFcs(tlCmd, sizeof(tlCmd));
-    zbSocTransportWrite(tlCmd, sizeof(tlCmd));
+    zbSocSchedSend(tlCmd, sizeof(tlCmd));
 }
 
 /*********************************************************************
@@ -621,7 +700,7 @@ void zbSocSendResetToFn(void)
     };
 	  
     calcFcs(tlCmd, sizeof(tlCmd));
-    zbSocTransportWrite(tlCmd, sizeof(tlCmd)); 
+    zbSocSchedSend(tlCmd, sizeof(tlCmd)); 
 }
 
 /*********************************************************************
@@ -648,7 +727,251 @@ void zbSocOpenNwk(void)
     };
 	  
     calcFcs(cmd, sizeof(cmd));
-    zbSocTransportWrite(cmd, sizeof(cmd)); 
+    zbSocSchedSend(cmd, sizeof(cmd)); 
+}
+
+/*********************************************************************
+ * @fn      zbSocSendZclFromEp
+ *
+ * @brief   Send a ZCL command from an endpoint of the SoC. The MT frame
+ *          is written once into a buffer on the stack with its FCS.
+ *
+ * @param   appEp - endpoint of the SoC the command is sent from
+ * @param   dstAddr - Nwk Addr or Group ID of the device(s).
+ * @param   endpoint - endpoint of the device.
+ * @param   addrMode - Unicast or Group cast.
+ * @param   clusterId - cluster of the command
+ * @param   frameControl - ZCL frame control, the manufacturer code is
+ *          sent if ZCL_FRAME_CONTROL_MANU_SPECIFIC is set
+ * @param   manuCode - manufacturer code
+ * @param   commandId - ZCL command
+ * @param   payload - ZCL payload
+ * @param   payloadLen - length of the ZCL payload
+ *
+ * @return  ZCL transaction sequence number, -1 if the payload is too long
+ */
+static int32_t zbSocSendZclFromEp(uint8_t appEp, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode, 
+                                  uint16_t clusterId, uint8_t frameControl, uint16_t manuCode, 
+                                  uint8_t commandId, uint8_t *payload, uint8_t payloadLen)
+{
+  uint8_t frame[ZBSOC_MT_MAX_PAYLOAD + ZBSOC_MT_FRAME_OVERHEAD];
+  uint8_t zclHdrLen = 3;
+  uint8_t tsn;
+  mtEncoder_t enc;
+
+  //Manufacturer specif commands have 2 extra byte in te header
+  if (frameControl & ZCL_FRAME_CONTROL_MANU_SPECIFIC)
+  {
+    zclHdrLen += 2;
+  }
+
+  if (payloadLen > (ZBSOC_MT_MAX_PAYLOAD - MT_APP_MSG_HDR_LEN - zclHdrLen))
+  {
+    return -1;
+  }
+
+  tsn = transSeqNumber++;
+
+  mtEncStart(&enc, frame, MT_APP_MSG_HDR_LEN + zclHdrLen + payloadLen, 
+    (MT_RPC_CMD_SREQ | MT_RPC_SYS_APP), MT_APP_MSG);
+  mtEncPut8(&enc, appEp);
+  mtEncPut16(&enc, dstAddr);
+  mtEncPut8(&enc, endpoint);
+  mtEncPut16(&enc, clusterId);
+  //Data Len, the SoC counts the addr mode that follows
+  mtEncPut8(&enc, zclHdrLen + payloadLen + 1);
+  mtEncPut8(&enc, addrMode);
+  mtEncPut8(&enc, frameControl);
+  if (frameControl & ZCL_FRAME_CONTROL_MANU_SPECIFIC)
+  {
+    mtEncPut16(&enc, manuCode);
+  }
+  mtEncPut8(&enc, tsn);
+  mtEncPut8(&enc, commandId);
+  mtEncPutBuf(&enc, payload, payloadLen);
+
+  zbSocSchedSend(frame, mtEncFinish(&enc));
+
+  return tsn;
+}
+
+/*********************************************************************
+ * @fn      zbSocSendZcl
+ *
+ * @brief   Send any ZCL command, including ones of clusters the gateway
+ *          has no API for.
+ *
+ * @param   dstAddr - Nwk Addr or Group ID of the device(s).
+ * @param   endpoint - endpoint of the device.
+ * @param   addrMode - Unicast or Group cast.
+ * @param   clusterId - cluster of the command
+ * @param   frameControl - ZCL frame control, the manufacturer code is
+ *          sent if ZCL_FRAME_CONTROL_MANU_SPECIFIC is set
+ * @param   manuCode - manufacturer code
+ * @param   commandId - ZCL command
+ * @param   payload - ZCL payload
+ * @param   payloadLen - length of the ZCL payload
+ *
+ * @return  ZCL transaction sequence number, -1 if the payload is too long
+ */
+int32_t zbSocSendZcl(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode, uint16_t clusterId, uint8_t frameControl, 
+                     uint16_t manuCode, uint8_t commandId, uint8_t *payload, uint8_t payloadLen)
+{
+  return zbSocSendZclFromEp(ZBSOC_APP_ENDPOINT, dstAddr, endpoint, addrMode, clusterId, frameControl, 
+    manuCode, commandId, payload, payloadLen);
+}
+
+/*********************************************************************
+ * @fn      zbSocReadAttrs
+ *
+ * @brief   Send a ZCL read of attributes of a cluster, the device
+ *          answers all of them in one read attributes response.
+ *
+ * @param   clusterId - cluster of the attributes
+ * @param   attrIds - attributes
+ * @param   numAttrs - number of attributes
+ * @param   dstAddr - Nwk Addr or Group ID of the device(s).
+ * @param   endpoint - endpoint of the device.
+ * @param   addrMode - Unicast or Group cast.
+ *
+ * @return  ZCL transaction sequence number of the read, -1 if the
+ *          attributes do not fit a frame
+ */
+int32_t zbSocReadAttrs(uint16_t clusterId, uint16_t *attrIds, uint8_t numAttrs, uint16_t dstAddr, 
+                       uint8_t endpoint, uint8_t addrMode)
+{
+  uint8_t payload[ZBSOC_ZCL_MAX_PAYLOAD];
+  uint8_t i;
+
+  if (numAttrs > (sizeof(payload) / 2))
+  {
+    return -1;
+  }
+
+  for (i = 0; i < numAttrs; i++)
+  {
+    payload[i * 2] = attrIds[i] & 0x00ff;
+    payload[(i * 2) + 1] = (attrIds[i] & 0xff00) >> 8;
+  }
+
+  return zbSocSendZcl(dstAddr, endpoint, addrMode, clusterId, ZCL_FRAME_TYPE_PROFILE_CMD, 0, 
+    ZCL_CMD_READ, payload, numAttrs * 2);
+}
+
+/*********************************************************************
+ * @fn      zbSocConfigReporting
+ *
+ * @brief   Send a ZCL configure reporting of an attribute, the device
+ *          reports it to its bindings at least every maxInterval s and
+ *          when it changes, but not more often than every minInterval s.
+ *
+ * @param   clusterId - cluster of the attribute
+ * @param   attrId - attribute
+ * @param   dataType - ZCL data type of the attribute
+ * @param   minInterval - minimum reporting interval in s
+ * @param   maxInterval - maximum reporting interval in s, 0 only reports
+ *                        changes, 0xFFFF stops reporting
+ * @param   reportableChange - change that is reported, for analog data
+ *                             types only
+ * @param   dstAddr - Nwk Addr or Group ID of the device(s).
+ * @param   endpoint - endpoint of the device.
+ * @param   addrMode - Unicast or Group cast.
+ *
+ * @return  ZCL transaction sequence number, -1 if the data type is
+ *          analog without a fixed length
+ */
+int32_t zbSocConfigReporting(uint16_t clusterId, uint16_t attrId, uint8_t dataType, uint16_t minInterval, 
+                             uint16_t maxInterval, uint32_t reportableChange, uint16_t dstAddr, 
+                             uint8_t endpoint, uint8_t addrMode)
+{
+  uint8_t payload[8 + sizeof(uint32_t)];
+  uint8_t len = 0;
+  int32_t changeLen = 0, i;
+
+  if (zbSocZclIsAnalog(dataType))
+  {
+    changeLen = zbSocZclDataTypeLen(dataType);
+    if ((changeLen < 0) || (changeLen > sizeof(uint32_t)))
+    {
+      return -1;
+    }
+  }
+
+  payload[len++] = 0x00; //attribute is reported
+  payload[len++] = attrId & 0x00ff;
+  payload[len++] = (attrId & 0xff00) >> 8;
+  payload[len++] = dataType;
+  payload[len++] = minInterval & 0x00ff;
+  payload[len++] = (minInterval & 0xff00) >> 8;
+  payload[len++] = maxInterval & 0x00ff;
+  payload[len++] = (maxInterval & 0xff00) >> 8;
+  for (i = 0; i < changeLen; i++)
+  {
+    payload[len++] = (reportableChange >> (i * 8)) & 0xff;
+  }
+
+  return zbSocSendZcl(dstAddr, endpoint, addrMode, clusterId, ZCL_FRAME_TYPE_PROFILE_CMD, 0, 
+    ZCL_CMD_CONFIG_REPORT, payload, len);
+}
+
+/*********************************************************************
+ * @fn      zbSocGetDeviceInfo
+ *
+ * @brief   Ask the zbSoC for its IEEE address.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void zbSocGetDeviceInfo(void)
+{
+  uint8_t cmd[] = {
+    0xFE,
+    0,                        /*RPC payload Len */
+    0x27,                     /*MT_RPC_CMD_SREQ + MT_RPC_SYS_UTIL */
+    MT_UTIL_GET_DEVICE_INFO,
+    0x00                      //FCS - fill in later
+  };
+
+  calcFcs(cmd, sizeof(cmd));
+  zbSocSchedSend(cmd, sizeof(cmd));
+}
+
+/*********************************************************************
+ * @fn      zbSocGetIeeeAddr
+ *
+ * @brief   Get the IEEE address of the zbSoC.
+ *
+ * @param   ieeeAddr - IEEE address
+ *
+ * @return  TRUE if the zbSoC reported its address
+ */
+uint8_t zbSocGetIeeeAddr(uint8_t ieeeAddr[8])
+{
+  if (zbSocIeeeAddrValid)
+  {
+    memcpy(ieeeAddr, zbSocIeeeAddr, Z_EXTADDR_LEN);
+  }
+
+  return zbSocIeeeAddrValid;
+}
+
+/*********************************************************************
+ * @fn      zbSocReadAttr
+ *
+ * @brief   Send a ZCL read of one attribute.
+ *
+ * @param   clusterId - cluster of the attribute
+ * @param   attrId - attribute
+ * @param   dstAddr - Nwk Addr or Group ID of the device(s).
+ * @param   endpoint - endpoint of the device.
+ * @param   addrMode - Unicast or Group cast.
+ *
+ * @return  ZCL transaction sequence number of the read
+ */
+static uint8_t zbSocReadAttr(uint16_t clusterId, uint16_t attrId, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
+{
+  return zbSocReadAttrs(clusterId, &attrId, 1, dstAddr, endpoint, addrMode);
 }
 
 /*********************************************************************
@@ -661,31 +984,12 @@ void zbSocOpenNwk(void)
  * @param   endpoint - endpoint of the Light.
  * @param   addrMode - Unicast or Group cast.
  *
- * @return  none
+ * @return  ZCL transaction sequence number
  */
-void zbSocSetState(uint8_t state, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
-{
-  	uint8_t cmd[] = {
-  		0xFE,                                                                                      
-  		11,   /*RPC payload Len */          
-  		0x29, /*MT_RPC_CMD_AREQ + MT_RPC_SYS_APP */          
-  		0x00, /*MT_APP_MSG  */          
-  		0x0B, /*Application Endpoint */          
-  		(dstAddr & 0x00ff),
-  		(dstAddr & 0xff00) >> 8,
-  		endpoint, /*Dst EP */          
-  		(ZCL_CLUSTER_ID_GEN_ON_OFF & 0x00ff),
-  		(ZCL_CLUSTER_ID_GEN_ON_OFF & 0xff00) >> 8,
-  		0x04, //Data Len
-  		addrMode, 
-  		0x01, //0x01 ZCL frame control field.  (send to the light cluster only)
-  		transSeqNumber++,
-		(state ? 1:0),
-  		0x00       //FCS - fill in later
-  	};
-
-  	calcFcs(cmd, sizeof(cmd));
-    zbSocTransportWrite(cmd,sizeof(cmd));
+uint8_t zbSocSetState(uint8_t state, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
+{
+  return zbSocSendZcl(dstAddr, endpoint, addrMode, ZCL_CLUSTER_ID_GEN_ON_OFF, ZCL_FRAME_TYPE_SPECIFIC_CMD, 0, 
+    (state ? COMMAND_ON : COMMAND_OFF), NULL, 0);
 }
 
 
@@ -760,7 +1064,7 @@ void zbSocNVWrite(uint16_t id, uint8_t offset, uint8_t len, uint8_t *data)
       
 	calcFcs(cmd, len + 9);
 	
-  zbSocTransportWrite(cmd, len + 9);
+  zbSocSchedSend(cmd, len + 9);
   free(cmd);
 }
 
@@ -1045,34 +1349,18 @@ void zbSocFinishLoadingImage(void)
  * @param   endpoint - endpoint of the Light.
  * @param   addrMode - Unicast or Group cast.
  *
- * @return  none
+ * @return  ZCL transaction sequence number
  */
-void zbSocSetLevel(uint8_t level, uint16_t time, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
-{
-  	uint8_t cmd[] = {
-  		0xFE,                                                                                                                                                                                    
-  		14,   //RPC payload Len
-  		0x29, //MT_RPC_CMD_AREQ + MT_RPC_SYS_APP
-  		0x00, //MT_APP_MSG
-  		0x0B, //Application Endpoint
-  		(dstAddr & 0x00ff),
-  		(dstAddr & 0xff00) >> 8,
-  		endpoint, //Dst EP
-  		(ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL & 0x00ff),
-  		(ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL & 0xff00) >> 8,      
-  		0x07, //Data Len
-  		addrMode, 
-  		0x01, //0x01 ZCL frame control field.  (send to the light cluster only)
-  		transSeqNumber++,
-  		COMMAND_LEVEL_MOVE_TO_LEVEL,
-  		(level & 0xff),
-  		(time & 0xff),
-  		(time & 0xff00) >> 8,
-  		0x00       //FCS - fill in later
-  	};    
-    
-    calcFcs(cmd, sizeof(cmd));
-    zbSocTransportWrite(cmd,sizeof(cmd));
+uint8_t zbSocSetLevel(uint8_t level, uint16_t time, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
+{
+  uint8_t payload[] = {
+    (level & 0xff),
+    (time & 0xff),
+    (time & 0xff00) >> 8
+  };
+
+  return zbSocSendZcl(dstAddr, endpoint, addrMode, ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL, ZCL_FRAME_TYPE_SPECIFIC_CMD, 0, 
+    COMMAND_LEVEL_MOVE_TO_LEVEL, payload, sizeof(payload));
 }
 
 /*********************************************************************
@@ -1085,35 +1373,19 @@ void zbSocSetLevel(uint8_t level, uint16_t time, uint16_t dstAddr, uint8_t endpo
  * @param   endpoint - endpoint of the Light.
  * @param   addrMode - Unicast or Group cast.
  *
- * @return  none
+ * @return  ZCL transaction sequence number
  */
-void zbSocSetHue(uint8_t hue, uint16_t time, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
+uint8_t zbSocSetHue(uint8_t hue, uint16_t time, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
 {
-	uint8_t cmd[] = {
-		0xFE,                                                                                                                                                                                    
-		15,   //RPC payload Len          
-		0x29, //MT_RPC_CMD_AREQ + MT_RPC_SYS_APP          
-		0x00, //MT_APP_MSG          
-		0x0B, //Application Endpoint          
-		(dstAddr & 0x00ff),
-		(dstAddr & 0xff00) >> 8,
-		endpoint, //Dst EP
-		(ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL & 0x00ff),
-		(ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL & 0xff00) >> 8,     		   
-		0x08, //Data Len
-		addrMode, 
-		0x01, //0x01 ZCL frame control field.  (send to the light cluster only)
-		transSeqNumber++,
-		COMMAND_LIGHTING_MOVE_TO_HUE,
-		(hue & 0xff),
-		0x00, //Move with shortest distance
-		(time & 0xff),
-		(time & 0xff00) >> 8,
-		0x00       //FCS - fill in later
-	};    
-
-  calcFcs(cmd, sizeof(cmd));
-  zbSocTransportWrite(cmd,sizeof(cmd));
+  uint8_t payload[] = {
+    (hue & 0xff),
+    0x00, //Move with shortest distance
+    (time & 0xff),
+    (time & 0xff00) >> 8
+  };
+
+  return zbSocSendZcl(dstAddr, endpoint, addrMode, ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL, ZCL_FRAME_TYPE_SPECIFIC_CMD, 0, 
+    COMMAND_LIGHTING_MOVE_TO_HUE, payload, sizeof(payload));
 }
 
 /*********************************************************************
@@ -1126,34 +1398,18 @@ void zbSocSetHue(uint8_t hue, uint16_t time, uint16_t dstAddr, uint8_t endpoint,
  * @param   endpoint - endpoint of the Light.
  * @param   addrMode - Unicast or Group cast.
  *
- * @return  none
+ * @return  ZCL transaction sequence number
  */
-void zbSocSetSat(uint8_t sat, uint16_t time, uint16_t dstAddr, uint8_t  endpoint, uint8_t addrMode)
+uint8_t zbSocSetSat(uint8_t sat, uint16_t time, uint16_t dstAddr, uint8_t  endpoint, uint8_t addrMode)
 {
-  uint8_t cmd[] = {
-		0xFE,                                                                                                                                                                                    
-		14,   //RPC payload Len          
-		0x29, //MT_RPC_CMD_AREQ + MT_RPC_SYS_APP         
-		0x00, //MT_APP_MSG          
-		0x0B, //Application Endpoint          
-		(dstAddr & 0x00ff),
-		(dstAddr & 0xff00) >> 8,
-		endpoint, //Dst EP         
-  	(ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL & 0x00ff),
-  	(ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL & 0xff00) >> 8,
-		0x07, //Data Len
-		addrMode, 
-		0x01, //0x01 ZCL frame control field.  (send to the light cluster only)
-    transSeqNumber++,
-		COMMAND_LIGHTING_MOVE_TO_SATURATION,
-		(sat & 0xff),
-		(time & 0xff),
-		(time & 0xff00) >> 8,
-		0x00       //FCS - fill in later
-	};
-	
-	calcFcs(cmd, sizeof(cmd));
-  zbSocTransportWrite(cmd,sizeof(cmd));
+  uint8_t payload[] = {
+    (sat & 0xff),
+    (time & 0xff),
+    (time & 0xff00) >> 8
+  };
+
+  return zbSocSendZcl(dstAddr, endpoint, addrMode, ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL, ZCL_FRAME_TYPE_SPECIFIC_CMD, 0, 
+    COMMAND_LIGHTING_MOVE_TO_SATURATION, payload, sizeof(payload));
 }
 
 
@@ -1180,7 +1436,7 @@ void zbSocSblSendMtFrame(uint8_t cmd, uint8_t * payload, uint8_t payload_len)
 		memcpy(buf + 4, payload, payload_len);
 	}
 	calcFcs(buf, payload_len + 5);
-	zbSocTransportWrite(buf, payload_len + 5);
+	zbSocIoWrite(buf, payload_len + 5);
 }
 
 
@@ -1205,7 +1461,7 @@ void zbSocResetLocalDevice(void)
 	};
 	
 	calcFcs(cmd, sizeof(cmd));
-  zbSocTransportWrite(cmd,sizeof(cmd));
+  zbSocSchedSend(cmd,sizeof(cmd));
 }
 
 
@@ -1258,7 +1514,7 @@ void zbSocSblEnableBootloader()
 		SB_FORCE_BOOT,
 	};
 	
-	zbSocTransportWrite(cmd,sizeof(cmd));
+	zbSocIoWrite(cmd,sizeof(cmd));
 }
 
 
@@ -1285,7 +1541,7 @@ void zbSocRemoveDevice(uint8_t ieeeAddr[])
 	memcpy(cmd + 4, ieeeAddr, Z_EXTADDR_LEN);
 	
 	calcFcs(cmd, sizeof(cmd));
-	zbSocTransportWrite(cmd,sizeof(cmd));	
+	zbSocSchedSend(cmd,sizeof(cmd));	
 }
 
 /*********************************************************************
@@ -1299,35 +1555,19 @@ void zbSocRemoveDevice(uint8_t ieeeAddr[])
  * @param   endpoint - endpoint of the Light.
  * @param   addrMode - Unicast or Group cast.
  *
- * @return  none
+ * @return  ZCL transaction sequence number
  */
-void zbSocSetHueSat(uint8_t hue, uint8_t sat, uint16_t time, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
-{
-	uint8_t cmd[] = { 
-		0xFE, 
-		15, //RPC payload Len
-		0x29, //MT_RPC_CMD_AREQ + MT_RPC_SYS_APP
-		0x00, //MT_APP_MSG
-		0x0B, //Application Endpoint         
-		(dstAddr & 0x00ff),
-		(dstAddr & 0xff00) >> 8,
-		endpoint, //Dst EP
-  	(ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL & 0x00ff),
-  	(ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL & 0xff00) >> 8,
-		0x08, //Data Len
-    addrMode,
-		0x01, //ZCL Header Frame Control
-		transSeqNumber++,
-		0x06, //ZCL Header Frame Command (COMMAND_LEVEL_MOVE_TO_HUE_AND_SAT)
-		hue, //HUE - fill it in later
-		sat, //SAT - fill it in later
-		(time & 0xff),
-		(time & 0xff00) >> 8,
-		0x00 //fcs
-  }; 
-
-  calcFcs(cmd, sizeof(cmd));
-  zbSocTransportWrite(cmd,sizeof(cmd));       
+uint8_t zbSocSetHueSat(uint8_t hue, uint8_t sat, uint16_t time, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
+{
+  uint8_t payload[] = {
+    hue,
+    sat,
+    (time & 0xff),
+    (time & 0xff00) >> 8
+  };
+
+  return zbSocSendZcl(dstAddr, endpoint, addrMode, ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL, ZCL_FRAME_TYPE_SPECIFIC_CMD, 0, 
+    COMMAND_LIGHTING_MOVE_TO_HUE_AND_SATURATION, payload, sizeof(payload));
 }
 
 /*********************************************************************
@@ -1343,33 +1583,17 @@ void zbSocSetHueSat(uint8_t hue, uint8_t sat, uint16_t time, uint16_t dstAddr, u
  * @return  none
  */
 void zbSocAddGroup(uint16_t groupId, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
-{  
-	uint8_t cmd[] = {
-		0xFE,                                                                                      
-		14,   /*RPC payload Len */          
-		0x29, /*MT_RPC_CMD_AREQ + MT_RPC_SYS_APP */          
-		0x00, /*MT_APP_MSG  */          
-		0x0B, /*Application Endpoint */          
-		(dstAddr & 0x00ff),
-		(dstAddr & 0xff00) >> 8,
-		endpoint, /*Dst EP */          
-		(ZCL_CLUSTER_ID_GEN_GROUPS & 0x00ff),
-		(ZCL_CLUSTER_ID_GEN_GROUPS & 0xff00) >> 8,
-		0x07, //Data Len
-		addrMode, 
-		0x01, //0x01 ZCL frame control field.  (send to the light cluster only)
-		transSeqNumber++,
-		COMMAND_GROUP_ADD,
- 		(groupId & 0x00ff),
-		(groupId & 0xff00) >> 8, 
-		0, //Null group name - Group Name not pushed to the devices	
-		0x00       //FCS - fill in later
-	};
-	
-	printf("zbSocAddGroup: dstAddr 0x%x\n", dstAddr);
-    
-	calcFcs(cmd, sizeof(cmd));
-  zbSocTransportWrite(cmd,sizeof(cmd));
+{
+  uint8_t payload[] = {
+    (groupId & 0x00ff),
+    (groupId & 0xff00) >> 8,
+    0 //Null group name - Group Name not pushed to the devices
+  };
+
+  printf("zbSocAddGroup: dstAddr 0x%x\n", dstAddr);
+
+  zbSocSendZcl(dstAddr, endpoint, addrMode, ZCL_CLUSTER_ID_GEN_GROUPS, ZCL_FRAME_TYPE_SPECIFIC_CMD, 0, 
+    COMMAND_GROUP_ADD, payload, sizeof(payload));
 }
 
 /*********************************************************************
@@ -1386,31 +1610,15 @@ void zbSocAddGroup(uint16_t groupId, uint16_t dstAddr, uint8_t endpoint, uint8_t
  * @return  none
  */
 void zbSocStoreScene(uint16_t groupId, uint8_t sceneId, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
-{  
-	uint8_t cmd[] = {
-		0xFE,                                                                                      
-		14,   /*RPC payload Len */          
-		0x29, /*MT_RPC_CMD_AREQ + MT_RPC_SYS_APP */          
-		0x00, /*MT_APP_MSG  */          
-		0x0B, /*Application Endpoint */          
-		(dstAddr & 0x00ff),
-		(dstAddr & 0xff00) >> 8,
-		endpoint, /*Dst EP */          
-		(ZCL_CLUSTER_ID_GEN_SCENES & 0x00ff),
-		(ZCL_CLUSTER_ID_GEN_SCENES & 0xff00) >> 8,
-		0x07, //Data Len
-		addrMode, 
-		0x01, //0x01 ZCL frame control field.  (send to the light cluster only)
-		transSeqNumber++,
-		COMMAND_SCENE_STORE,
- 		(groupId & 0x00ff),
-		(groupId & 0xff00) >> 8, 	
-		sceneId++,	
-		0x00       //FCS - fill in later
-	};
-    
-	calcFcs(cmd, sizeof(cmd));
-  zbSocTransportWrite(cmd,sizeof(cmd));
+{
+  uint8_t payload[] = {
+    (groupId & 0x00ff),
+    (groupId & 0xff00) >> 8,
+    sceneId
+  };
+
+  zbSocSendZcl(dstAddr, endpoint, addrMode, ZCL_CLUSTER_ID_GEN_SCENES, ZCL_FRAME_TYPE_SPECIFIC_CMD, 0, 
+    COMMAND_SCENE_STORE, payload, sizeof(payload));
 }
 
 /*********************************************************************
@@ -1427,31 +1635,15 @@ void zbSocStoreScene(uint16_t groupId, uint8_t sceneId, uint16_t dstAddr, uint8_
  * @return  none
  */
 void zbSocRecallScene(uint16_t groupId, uint8_t sceneId, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
-{  
-	uint8_t cmd[] = {
-		0xFE,                                                                                      
-		14,   /*RPC payload Len */          
-		0x29, /*MT_RPC_CMD_AREQ + MT_RPC_SYS_APP */          
-		0x00, /*MT_APP_MSG  */          
-		0x0B, /*Application Endpoint */          
-		(dstAddr & 0x00ff),
-		(dstAddr & 0xff00) >> 8,
-		endpoint, /*Dst EP */          
-		(ZCL_CLUSTER_ID_GEN_SCENES & 0x00ff),
-		(ZCL_CLUSTER_ID_GEN_SCENES & 0xff00) >> 8,
-		0x07, //Data Len
-		addrMode, 
-		0x01, //0x01 ZCL frame control field.  (send to the light cluster only)
-		transSeqNumber++,
-		COMMAND_SCENE_RECALL,
- 		(groupId & 0x00ff),
-		(groupId & 0xff00) >> 8, 	
-		sceneId++,	
-		0x00       //FCS - fill in later
-	};
-    
-	calcFcs(cmd, sizeof(cmd));
-  zbSocTransportWrite(cmd,sizeof(cmd));
+{
+  uint8_t payload[] = {
+    (groupId & 0x00ff),
+    (groupId & 0xff00) >> 8,
+    sceneId
+  };
+
+  zbSocSendZcl(dstAddr, endpoint, addrMode, ZCL_CLUSTER_ID_GEN_SCENES, ZCL_FRAME_TYPE_SPECIFIC_CMD, 0, 
+    COMMAND_SCENE_RECALL, payload, sizeof(payload));
 }
 
 /*********************************************************************
@@ -1501,7 +1693,7 @@ void zbSocBind(uint16_t srcNwkAddr, uint8_t srcEndpoint, uint8_t srcIEEE[8], uin
 	          srcEndpoint, dstIEEE[0], dstIEEE[1], dstIEEE[2], dstIEEE[3], dstIEEE[4], dstIEEE[5], dstIEEE[6], dstIEEE[7], clusterID);
 	
 	calcFcs(cmd, sizeof(cmd));		
-  zbSocTransportWrite(cmd,sizeof(cmd));
+  zbSocSchedSend(cmd,sizeof(cmd));
 }
 
 /*********************************************************************
@@ -1513,34 +1705,12 @@ void zbSocBind(uint16_t srcNwkAddr, uint8_t srcEndpoint, uint8_t srcIEEE[8], uin
  * @param   endpoint - endpoint of the Light.
  * @param   addrMode - Unicast or Group cast.
  *
- * @return  none
+ * @return  ZCL transaction sequence number of the read
  */
-void zbSocGetState(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
-{  	  
-  	uint8_t cmd[] = {
-  		0xFE,                                                                                      
-  		13,   /*RPC payload Len */          
-  		0x29, /*MT_RPC_CMD_AREQ + MT_RPC_SYS_APP */          
-  		0x00, /*MT_APP_MSG  */          
-  		0x0B, /*Application Endpoint */          
-  		(dstAddr & 0x00ff),
-  		(dstAddr & 0xff00) >> 8,
-  		endpoint, /*Dst EP */          
-  		(ZCL_CLUSTER_ID_GEN_ON_OFF & 0x00ff),
-  		(ZCL_CLUSTER_ID_GEN_ON_OFF & 0xff00) >> 8,
-  		0x06, //Data Len
-  		addrMode, 
-  		0x00, //0x00 ZCL frame control field.  not specific to a cluster (i.e. a SCL founadation command)
-  		transSeqNumber++,
-  		ZCL_CMD_READ,
-  		(ATTRID_ON_OFF & 0x00ff),
-  		(ATTRID_ON_OFF & 0xff00) >> 8,
-  		0x00       //FCS - fill in later
-  	};
-      
-  	calcFcs(cmd, sizeof(cmd));
-    zbSocTransportWrite(cmd,sizeof(cmd));
-} 
+uint8_t zbSocGetState(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
+{
+  return zbSocReadAttr(ZCL_CLUSTER_ID_GEN_ON_OFF, ATTRID_ON_OFF, dstAddr, endpoint, addrMode);
+}
  
 /*********************************************************************
  * @fn      zbSocGetLevel
@@ -1551,34 +1721,12 @@ void zbSocGetState(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
  * @param   endpoint - endpoint of the Light.
  * @param   addrMode - Unicast or Group cast.
  *
- * @return  none
+ * @return  ZCL transaction sequence number of the read
  */
-void zbSocGetLevel(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
-{
-  	uint8_t cmd[] = {
-  		0xFE,                                                                                      
-  		13,   /*RPC payload Len */          
-  		0x29, /*MT_RPC_CMD_AREQ + MT_RPC_SYS_APP */          
-  		0x00, /*MT_APP_MSG  */          
-  		0x0B, /*Application Endpoint */          
-  		(dstAddr & 0x00ff),
-  		(dstAddr & 0xff00) >> 8,
-  		endpoint, /*Dst EP */          
-  		(ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL & 0x00ff),
-  		(ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL & 0xff00) >> 8,
-  		0x06, //Data Len
-  		addrMode, 
-  		0x00, //0x00 ZCL frame control field.  not specific to a cluster (i.e. a SCL founadation command)
-  		transSeqNumber++,
-  		ZCL_CMD_READ,
-  		(ATTRID_LEVEL_CURRENT_LEVEL & 0x00ff),
-  		(ATTRID_LEVEL_CURRENT_LEVEL & 0xff00) >> 8,
-  		0x00       //FCS - fill in later
-  	};
-      
-  	calcFcs(cmd, sizeof(cmd));
-  	zbSocTransportWrite(cmd,sizeof(cmd));
-} 
+uint8_t zbSocGetLevel(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
+{
+  return zbSocReadAttr(ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL, ATTRID_LEVEL_CURRENT_LEVEL, dstAddr, endpoint, addrMode);
+}
 
 /*********************************************************************
  * @fn      zbSocGetHue
@@ -1589,34 +1737,12 @@ void zbSocGetLevel(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
  * @param   endpoint - endpoint of the Light.
  * @param   addrMode - Unicast or Group cast.
  *
- * @return  none
+ * @return  ZCL transaction sequence number of the read
  */
-void zbSocGetHue(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
-{
-  	uint8_t cmd[] = {
-  		0xFE,                                                                                      
-  		13,   /*RPC payload Len */          
-  		0x29, /*MT_RPC_CMD_AREQ + MT_RPC_SYS_APP */          
-  		0x00, /*MT_APP_MSG  */          
-  		0x0B, /*Application Endpoint */          
-  		(dstAddr & 0x00ff),
-  		(dstAddr & 0xff00) >> 8,
-  		endpoint, /*Dst EP */          
-  		(ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL & 0x00ff),
-  		(ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL & 0xff00) >> 8,
-  		0x06, //Data Len
-  		addrMode, 
-  		0x00, //0x00 ZCL frame control field.  not specific to a cluster (i.e. a SCL founadation command)
-  		transSeqNumber++,
-  		ZCL_CMD_READ,
-  		(ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_HUE & 0x00ff),
-  		(ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_HUE & 0xff00) >> 8,
-  		0x00       //FCS - fill in later
-  	};
-      
-  	calcFcs(cmd, sizeof(cmd));
-  	zbSocTransportWrite(cmd,sizeof(cmd));
-} 
+uint8_t zbSocGetHue(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
+{
+  return zbSocReadAttr(ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL, ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_HUE, dstAddr, endpoint, addrMode);
+}
 
 /*********************************************************************
  * @fn      zbSocGetSat
@@ -1627,34 +1753,12 @@ void zbSocGetHue(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
  * @param   endpoint - endpoint of the Light.
  * @param   addrMode - Unicast or Group cast.
  *
- * @return  none
+ * @return  ZCL transaction sequence number of the read
  */
-void zbSocGetSat(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
-{
-  	uint8_t cmd[] = {
-  		0xFE,                                                                                      
-  		13,   /*RPC payload Len */          
-  		0x29, /*MT_RPC_CMD_AREQ + MT_RPC_SYS_APP */          
-  		0x00, /*MT_APP_MSG  */          
-  		0x0B, /*Application Endpoint */          
-  		(dstAddr & 0x00ff),
-  		(dstAddr & 0xff00) >> 8,
-  		endpoint, /*Dst EP */          
-  		(ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL & 0x00ff),
-  		(ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL & 0xff00) >> 8,
-  		0x06, //Data Len
-  		addrMode, 
-  		0x00, //0x00 ZCL frame control field.  not specific to a cluster (i.e. a SCL founadation command)
-  		transSeqNumber++,
-  		ZCL_CMD_READ,
-  		(ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_SATURATION & 0x00ff),
-  		(ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_SATURATION & 0xff00) >> 8,
-  		0x00       //FCS - fill in later
-  	};
-      
-  	calcFcs(cmd, sizeof(cmd));
-  	zbSocTransportWrite(cmd,sizeof(cmd));
-} 
+uint8_t zbSocGetSat(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
+{
+  return zbSocReadAttr(ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL, ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_SATURATION, dstAddr, endpoint, addrMode);
+}
 /*********************************************************************
  * @fn      zbSocPowerRead
  *
@@ -1664,35 +1768,12 @@ void zbSocGetSat(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
  * @param   endpoint - endpoint of the Light.
  * @param   addrMode - Unicast or Group cast.
  *
- * @return  none
+ * @return  ZCL transaction sequence number of the read
  */
-void zbSocReadPower(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
-{
-  	uint8_t cmd[] = {
-  		0xFE,                                                                                      
-  		13,   /*RPC payload Len */          
-  		0x29, /*MT_RPC_CMD_AREQ + MT_RPC_SYS_APP */          
-  		0x00, /*MT_APP_MSG  */          
-  		0x0B, /*Application Endpoint */          
-  		(dstAddr & 0x00ff),
-  		(dstAddr & 0xff00) >> 8,
-  		endpoint, /*Dst EP */          
-  		(ZCL_CLUSTER_ID_SE_SIMPLE_METERING & 0x00ff),
-  		(ZCL_CLUSTER_ID_SE_SIMPLE_METERING & 0xff00) >> 8,
-  		0x06, //Data Len
-  		addrMode, 
-  		0x00, //0x00 ZCL frame control field.  not specific to a cluster (i.e. a SCL founadation command)
-  		transSeqNumber++,
-  		ZCL_CMD_READ,
-  		(ATTRID_SE_INSTANTANEOUS_DEMAND & 0x00ff),
-  		(ATTRID_SE_INSTANTANEOUS_DEMAND & 0xff00) >> 8,
-  		0x00       //FCS - fill in later
-  	};
-      
-  	calcFcs(cmd, sizeof(cmd));
-  	
-    zbSocTransportWrite(cmd,sizeof(cmd));
-} 
+uint8_t zbSocReadPower(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
+{
+  return zbSocReadAttr(ZCL_CLUSTER_ID_SE_SIMPLE_METERING, ATTRID_SE_INSTANTANEOUS_DEMAND, dstAddr, endpoint, addrMode);
+}
 
 /*********************************************************************
  * @fn      zbSocGetTemp
@@ -1703,34 +1784,12 @@ void zbSocReadPower(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
  * @param   endpoint - endpoint of the Light.
  * @param   addrMode - Unicast or Group cast.
  *
- * @return  none
+ * @return  ZCL transaction sequence number of the read
  */
-void zbSocGetTemp(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
-{
-  	uint8_t cmd[] = {
-  		0xFE,                                                                                      
-  		13,   /*RPC payload Len */          
-  		0x29, /*MT_RPC_CMD_AREQ + MT_RPC_SYS_APP */          
-  		0x00, /*MT_APP_MSG  */          
-  		0x0B, /*Application Endpoint */          
-  		(dstAddr & 0x00ff),
-  		(dstAddr & 0xff00) >> 8,
-  		endpoint, /*Dst EP */          
-  		(ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT & 0x00ff),
-  		(ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT & 0xff00) >> 8,
-  		0x06, //Data Len
-  		addrMode, 
-  		0x00, //0x00 ZCL frame control field.  not specific to a cluster (i.e. a SCL founadation command)
-  		transSeqNumber++,
-  		ZCL_CMD_READ,
-  		(ATTRID_MS_TEMPERATURE_MEASURED_VALUE & 0x00ff),
-  		(ATTRID_MS_TEMPERATURE_MEASURED_VALUE & 0xff00) >> 8,
-  		0x00       //FCS - fill in later
-  	};
-      
-  	calcFcs(cmd, sizeof(cmd));
-    zbSocTransportWrite(cmd,sizeof(cmd));
-} 
+uint8_t zbSocGetTemp(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
+{
+  return zbSocReadAttr(ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT, ATTRID_MS_TEMPERATURE_MEASURED_VALUE, dstAddr, endpoint, addrMode);
+}
 
 /*********************************************************************
  * @fn      zbSocGetHumid
@@ -1741,34 +1800,11 @@ void zbSocGetTemp(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
  * @param   endpoint - endpoint of the Light.
  * @param   addrMode - Unicast or Group cast.
  *
- * @return  none
+ * @return  ZCL transaction sequence number of the read
  */
-void zbSocGetHumid(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
-{
-  	uint8_t cmd[] = {
-  		0xFE,                                                                                      
-  		13,   /*RPC payload Len */          
-  		0x29, /*MT_RPC_CMD_AREQ + MT_RPC_SYS_APP */          
-  		0x00, /*MT_APP_MSG  */          
-  		0x0B, /*Application Endpoint */          
-  		(dstAddr & 0x00ff),
-  		(dstAddr & 0xff00) >> 8,
-  		endpoint, /*Dst EP */          
-  		(ZCL_CLUSTER_ID_MS_REL_HUMIDITY_MEASUREMENT & 0x00ff),
-  		(ZCL_CLUSTER_ID_MS_REL_HUMIDITY_MEASUREMENT & 0xff00) >> 8,
-  		0x06, //Data Len
-  		addrMode, 
-  		0x00, //0x00 ZCL frame control field.  not specific to a cluster (i.e. a SCL founadation command)
-  		transSeqNumber++,
-  		ZCL_CMD_READ,
-  		(ATTRID_MS_RELATIVE_HUMIDITY_MEASURED_VALUE & 0x00ff),
-  		(ATTRID_MS_RELATIVE_HUMIDITY_MEASURED_VALUE & 0xff00) >> 8,
-  		0x00       //FCS - fill in later
-  	};
-      
-  	calcFcs(cmd, sizeof(cmd));
-  	
-    zbSocTransportWrite(cmd,sizeof(cmd));
+uint8_t zbSocGetHumid(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
+{
+  return zbSocReadAttr(ZCL_CLUSTER_ID_MS_REL_HUMIDITY_MEASUREMENT, ATTRID_MS_RELATIVE_HUMIDITY_MEASURED_VALUE, dstAddr, endpoint, addrMode);
 }
 
 
@@ -1781,28 +1817,8 @@ void zbSocGetHumid(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
  */
 void zbSocGetLastMessage(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
 {
-  	uint8_t cmd[] = {
-  		0xFE,                                                                                                                                                                                    
-  		11,   //RPC payload Len
-  		0x29, //MT_RPC_CMD_AREQ + MT_RPC_SYS_APP
-  		0x00, //MT_APP_MSG
-  		0x09, //Application Endpoint
-  		(dstAddr & 0x00ff),
-  		(dstAddr & 0xff00) >> 8,
-  		endpoint, //Dst EP
-  		(ZCL_CLUSTER_ID_SE_MESSAGE & 0x00ff),
-  		(ZCL_CLUSTER_ID_SE_MESSAGE & 0xff00) >> 8,      
-  		0x04, //Data Len
-  		addrMode, 
-  		0x01, //0x01 ZCL frame control field.  (send to the light cluster only)
-  		transSeqNumber++,
-  		COMMAND_SE_GET_LAST_MESSAGE,
-  		0x00       //FCS - fill in later
-  	};    
-    
-    calcFcs(cmd, sizeof(cmd));
-    
-    zbSocTransportWrite(cmd,sizeof(cmd));
+  zbSocSendZclFromEp(ZBSOC_SE_ENDPOINT, dstAddr, endpoint, addrMode, ZCL_CLUSTER_ID_SE_MESSAGE, 
+    ZCL_FRAME_TYPE_SPECIFIC_CMD, 0, COMMAND_SE_GET_LAST_MESSAGE, NULL, 0);
 }
 
 /*********************************************************************
@@ -1814,29 +1830,8 @@ void zbSocGetLastMessage(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
  */
 void zbSocGetCurrentPrice(uint8_t rxOnIdle, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode)
 {
-  	uint8_t cmd[] = {
-  		0xFE,                                                                                                                                                                                    
-  		12,   //RPC payload Len
-  		0x29, //MT_RPC_CMD_AREQ + MT_RPC_SYS_APP
-  		0x00, //MT_APP_MSG
-  		0x09, //Application Endpoint
-  		(dstAddr & 0x00ff),
-  		(dstAddr & 0xff00) >> 8,
-  		endpoint, //Dst EP
-  		(ZCL_CLUSTER_ID_SE_PRICING & 0x00ff),
-  		(ZCL_CLUSTER_ID_SE_PRICING & 0xff00) >> 8,      
-  		0x05, //Data Len
-  		addrMode, 
-  		0x01, //0x01 ZCL frame control field.  (send to the light cluster only)
-  		transSeqNumber++,
-  		COMMAND_SE_GET_CURRENT_PRICE,
-  		rxOnIdle,
-  		0x00       //FCS - fill in later
-  	};    
-    
-    calcFcs(cmd, sizeof(cmd));
-
-    zbSocTransportWrite(cmd,sizeof(cmd));
+  zbSocSendZclFromEp(ZBSOC_SE_ENDPOINT, dstAddr, endpoint, addrMode, ZCL_CLUSTER_ID_SE_PRICING, 
+    ZCL_FRAME_TYPE_SPECIFIC_CMD, 0, COMMAND_SE_GET_CURRENT_PRICE, &rxOnIdle, 1);
 }
 
 /*************************************************************************************************
@@ -1977,7 +1972,7 @@ static void processRpcSysAppZcl(uint8_t *zclRspBuff)
   if( (zclFrameFrameControl & 0x3) == 0)
   {
 //    printf("processRpcSysAppZcl: Foundation messagex\n");
-    processRpcSysAppZclFoundation(zclRspBuff, zclFrameLen, clusterID, nwkAddr, endpoint);
+    processRpcSysAppZclFoundation(zclRspBuff, zclFrameLen, zclHdrLen, clusterID, nwkAddr, endpoint);
   }
   else
   {
@@ -1989,110 +1984,182 @@ static void processRpcSysAppZcl(uint8_t *zclRspBuff)
 /*************************************************************************************************
  * @fn      processRpcSysAppZclFoundation()
  *
- * @brief  process the ZCL Rsp from the ZLL controller
+ * @brief  process the ZCL Rsp from the ZLL controller. Every attribute
+ *         record of a read response is passed to the handler registered
+ *         for it, then all records of the frame to the read attributes
+ *         response callback.
  *
- * @param   none
+ * @param   zclRspBuff - ZCL frame past the frame control and manufacturer code
+ * @param   zclFrameLen - length of the ZCL frame
+ * @param   zclHdrLen - length of the ZCL header
+ * @param   clusterID - cluster of the frame
+ * @param   nwkAddr - device that sent the frame
+ * @param   endpoint - endpoint of the device
  *
- * @return  length of current Rx Buffer
+ * @return  none
  *************************************************************************************************/
-static void processRpcSysAppZclFoundation(uint8_t *zclRspBuff, uint8_t zclFrameLen, uint16_t clusterID, uint16_t nwkAddr, uint8_t endpoint)
+static void processRpcSysAppZclFoundation(uint8_t *zclRspBuff, uint8_t zclFrameLen, uint8_t zclHdrLen, uint16_t clusterID, uint16_t nwkAddr, uint8_t endpoint)
 {
   uint8_t transSeqNum, commandID;
   
   transSeqNum = *zclRspBuff++;
   commandID = *zclRspBuff++;
   
-  if(commandID == ZCL_CMD_READ_RSP)
+  if((commandID == ZCL_CMD_READ_RSP) && (zclFrameLen >= zclHdrLen))
   {
-    uint16_t attrID;
-    uint8_t status;
-    uint8_t dataType;
-    
-    attrID = BUILD_UINT16(zclRspBuff[0], zclRspBuff[1]);      
-    zclRspBuff+=2;
-    status = *zclRspBuff++;
-    //get data type;
-    dataType = *zclRspBuff++;
+    zbSocZclAttr_t attrs[ZBSOC_ZCL_MAX_ATTRS];
+    uint8_t numAttrs;
 
+    numAttrs = zbSocZclParseReadRsp(zclRspBuff, zclFrameLen - zclHdrLen, attrs, ZBSOC_ZCL_MAX_ATTRS);
 
-//    printf("processRpcSysAppZclFoundation: clusterID:%x, attrID:%x, dataType=%x\n", clusterID, attrID, dataType);
-    
-    if( (clusterID == ZCL_CLUSTER_ID_GEN_ON_OFF) && (attrID == ATTRID_ON_OFF) && (dataType == ZCL_DATATYPE_BOOLEAN) )
-    {              
-      if(zbSocCb.pfnZclGetStateCb)
-      {
-        uint8_t state = zclRspBuff[0];            
-        zbSocCb.pfnZclGetStateCb(state, nwkAddr, endpoint);
-      }                       
-    }
-    else if( (clusterID == ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL) && (attrID == ATTRID_LEVEL_CURRENT_LEVEL) && (dataType == ZCL_DATATYPE_UINT8) )
-    {    
-      if(zbSocCb.pfnZclGetLevelCb)
-      {
-        uint8_t level = zclRspBuff[0];                             
-        zbSocCb.pfnZclGetLevelCb(level, nwkAddr, endpoint);
-      }                       
-    }
-    else if( (clusterID == ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL) && (attrID == ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_HUE) && (dataType == ZCL_DATATYPE_UINT8) )
-    {
-      if(zbSocCb.pfnZclGetHueCb)      
-      {
-        uint8_t hue = zclRspBuff[0];            
-        zbSocCb.pfnZclGetHueCb(hue, nwkAddr, endpoint);
-      }    
-    }                   
-    else if( (clusterID == ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL) && (attrID == ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_SATURATION) && (dataType == ZCL_DATATYPE_UINT8) )
+    zbSocZclDispatchAttrs(clusterID, attrs, numAttrs, nwkAddr, endpoint, transSeqNum);
+
+    if(zbSocCb.pfnZclReadAttrsRspCb)
     {
-      if(zbSocCb.pfnZclGetSatCb)      
-      {
-        uint8_t sat = zclRspBuff[0];            
-        zbSocCb.pfnZclGetSatCb(sat, nwkAddr, endpoint);
-      }    
+      zbSocCb.pfnZclReadAttrsRspCb(clusterID, attrs, numAttrs, nwkAddr, endpoint, transSeqNum);
     }
-    else if( (clusterID == ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT) && (attrID == ATTRID_MS_TEMPERATURE_MEASURED_VALUE) && (dataType == ZCL_DATATYPE_INT16) )
+  }
+  else if((commandID == ZCL_CMD_REPORT) && (zclFrameLen >= zclHdrLen))
+  {
+    zbSocZclAttr_t attrs[ZBSOC_ZCL_MAX_ATTRS];
+    uint8_t numAttrs;
+
+    //not through the read handlers, the device's tsn of a report may
+    //match a read the gateway has pending
+    numAttrs = zbSocZclParseReport(zclRspBuff, zclFrameLen - zclHdrLen, attrs, ZBSOC_ZCL_MAX_ATTRS);
+
+    if(zbSocCb.pfnZclReportAttrsCb)
     {
-      if(zbSocCb.pfnZclGetTempCb)      
-      {
-        uint16_t temp;
-        temp = BUILD_UINT16(zclRspBuff[0], zclRspBuff[1]);             
-        zbSocCb.pfnZclGetTempCb(temp, nwkAddr, endpoint);
-      }    
+      zbSocCb.pfnZclReportAttrsCb(clusterID, attrs, numAttrs, nwkAddr, endpoint, transSeqNum);
     }
-    else if( (clusterID == ZCL_CLUSTER_ID_MS_REL_HUMIDITY_MEASUREMENT) && (attrID == ATTRID_MS_RELATIVE_HUMIDITY_MEASURED_VALUE) && (dataType == ZCL_DATATYPE_UINT16) )
-    {
-      if(zbSocCb.pfnZclGetHumidCb)      
-      {
-        uint16_t humid;        
-        humid = BUILD_UINT16(zclRspBuff[0], zclRspBuff[1]);             
-        zbSocCb.pfnZclGetHumidCb(humid, nwkAddr, endpoint);
-      }    
-    }    
-    else if( (clusterID == ZCL_CLUSTER_ID_SE_SIMPLE_METERING) && (attrID == ATTRID_SE_INSTANTANEOUS_DEMAND) && (dataType == ZCL_DATATYPE_INT24) )
+  }
+  else if((commandID == ZCL_CMD_CONFIG_REPORT_RSP) && (zclFrameLen > zclHdrLen))
+  {
+    //one success status, or status, direction and attrId of every failed record
+    if(zclRspBuff[0] != ZCL_STATUS_SUCCESS)
     {
-      if(zbSocCb.pfnZclReadPowerRspCb)      
-      {
-        uint32_t power;  
-        power = BUILD_UINT32(zclRspBuff[0], zclRspBuff[1], zclRspBuff[2], 0);            
-        printf("processRpcSysAppZclFoundation: Power:%x, %x:%x:%x:%x\n", power, zclRspBuff[0], zclRspBuff[1], zclRspBuff[3], 0);
-        zbSocCb.pfnZclReadPowerRspCb(power, nwkAddr, endpoint);
-      }    
+      printf("processRpcSysAppZclFoundation: %x:%x cluster %x reporting not configured, status %x\n", 
+        nwkAddr, endpoint, clusterID, zclRspBuff[0]);
     }
-    else                
+  }
+  else if((commandID == ZCL_CMD_DEFAULT_RSP) && ((zclFrameLen - zclHdrLen) >= 2))
+  {
+    //command id and status of the command sent with transSeqNum
+    if(zbSocCb.pfnZclDefaultRspCb)
     {
-      //unsupported ZCL Read Rsp
-      printf("processRpcSysAppZclFoundation: Unsupported ZCL Rsp\n");
-    } 
+      zbSocCb.pfnZclDefaultRspCb(clusterID, zclRspBuff[0], zclRspBuff[1], nwkAddr, endpoint, transSeqNum);
+    }
   }
   else
   {
     //unsupported ZCL Rsp
-    printf("processRpcSysAppZclFoundation: Unsupported ZCL Rsp");;
+    printf("processRpcSysAppZclFoundation: Unsupported ZCL Rsp\n");
   }
   
   return;                    
 }  
  
- /*************************************************************************************************
+/*********************************************************************
+ * @fn      zbSocZclRegisterAttrs
+ *
+ * @brief   Register the handlers of the attributes the gateway has a
+ *          callback for.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void zbSocZclRegisterAttrs(void)
+{
+  zbSocZclRegisterAttr(ZCL_CLUSTER_ID_GEN_ON_OFF, ATTRID_ON_OFF, 
+    ZCL_DATATYPE_BOOLEAN, zbSocZclStateAttrCb);
+  zbSocZclRegisterAttr(ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL, ATTRID_LEVEL_CURRENT_LEVEL, 
+    ZCL_DATATYPE_UINT8, zbSocZclLevelAttrCb);
+  zbSocZclRegisterAttr(ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL, ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_HUE, 
+    ZCL_DATATYPE_UINT8, zbSocZclHueAttrCb);
+  zbSocZclRegisterAttr(ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL, ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_SATURATION, 
+    ZCL_DATATYPE_UINT8, zbSocZclSatAttrCb);
+  zbSocZclRegisterAttr(ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT, ATTRID_MS_TEMPERATURE_MEASURED_VALUE, 
+    ZCL_DATATYPE_INT16, zbSocZclTempAttrCb);
+  zbSocZclRegisterAttr(ZCL_CLUSTER_ID_MS_REL_HUMIDITY_MEASUREMENT, ATTRID_MS_RELATIVE_HUMIDITY_MEASURED_VALUE, 
+    ZCL_DATATYPE_UINT16, zbSocZclHumidAttrCb);
+  zbSocZclRegisterAttr(ZCL_CLUSTER_ID_SE_SIMPLE_METERING, ATTRID_SE_INSTANTANEOUS_DEMAND, 
+    ZCL_DATATYPE_INT24, zbSocZclPowerAttrCb);
+}
+
+/*********************************************************************
+ * @fn      zbSocZcl<Attribute>AttrCb
+ *
+ * @brief   Pass the value of an attribute record to the callback of
+ *          the attribute.
+ *
+ * @param   clusterId - cluster of the record
+ * @param   attr - record
+ * @param   nwkAddr - device that sent the record
+ * @param   endpoint - endpoint of the device
+ * @param   transSeqNum - ZCL transaction sequence number of the frame
+ *
+ * @return  none
+ */
+static void zbSocZclStateAttrCb(uint16_t clusterId, zbSocZclAttr_t *attr, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum)
+{
+  if(zbSocCb.pfnZclGetStateCb)
+  {
+    zbSocCb.pfnZclGetStateCb((uint8_t)attr->value.u, nwkAddr, endpoint, transSeqNum);
+  }
+}
+
+static void zbSocZclLevelAttrCb(uint16_t clusterId, zbSocZclAttr_t *attr, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum)
+{
+  if(zbSocCb.pfnZclGetLevelCb)
+  {
+    zbSocCb.pfnZclGetLevelCb((uint8_t)attr->value.u, nwkAddr, endpoint, transSeqNum);
+  }
+}
+
+static void zbSocZclHueAttrCb(uint16_t clusterId, zbSocZclAttr_t *attr, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum)
+{
+  if(zbSocCb.pfnZclGetHueCb)
+  {
+    zbSocCb.pfnZclGetHueCb((uint8_t)attr->value.u, nwkAddr, endpoint, transSeqNum);
+  }
+}
+
+static void zbSocZclSatAttrCb(uint16_t clusterId, zbSocZclAttr_t *attr, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum)
+{
+  if(zbSocCb.pfnZclGetSatCb)
+  {
+    zbSocCb.pfnZclGetSatCb((uint8_t)attr->value.u, nwkAddr, endpoint, transSeqNum);
+  }
+}
+
+static void zbSocZclTempAttrCb(uint16_t clusterId, zbSocZclAttr_t *attr, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum)
+{
+  if(zbSocCb.pfnZclGetTempCb)
+  {
+    //the callback takes the value as sent
+    zbSocCb.pfnZclGetTempCb((uint16_t)attr->value.s, nwkAddr, endpoint, transSeqNum);
+  }
+}
+
+static void zbSocZclHumidAttrCb(uint16_t clusterId, zbSocZclAttr_t *attr, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum)
+{
+  if(zbSocCb.pfnZclGetHumidCb)
+  {
+    zbSocCb.pfnZclGetHumidCb((uint16_t)attr->value.u, nwkAddr, endpoint, transSeqNum);
+  }
+}
+
+static void zbSocZclPowerAttrCb(uint16_t clusterId, zbSocZclAttr_t *attr, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum)
+{
+  if(zbSocCb.pfnZclReadPowerRspCb)
+  {
+    //the callback takes the 24 bits as sent
+    zbSocCb.pfnZclReadPowerRspCb((uint32_t)attr->value.s & 0x00FFFFFF, nwkAddr, endpoint, transSeqNum);
+  }
+}
+
+/*************************************************************************************************
  * @fn      processRpcSysAppZclCluster()
  *
  * @brief  process the ZCL Rsp from the ZLL controller
@@ -2171,6 +2238,30 @@ static void processRpcSysSys(uint8_t *rpcBuff)
 }
 
 
+/*************************************************************************************************
+ * @fn      processRpcSysUtil()
+ *
+ * @brief   read and process the RPC Util message from the zbSoC
+ *
+ * @param   rpcBuff - CMD0, CMD1 and payload
+ * @param   len - length of the payload
+ *
+ * @return  none
+ *************************************************************************************************/
+static void processRpcSysUtil(uint8_t *rpcBuff, uint8_t len)
+{
+  //device info: status, IEEE address, short address, ...
+  if ( (rpcBuff[1] == MT_UTIL_GET_DEVICE_INFO) && (len >= (1 + Z_EXTADDR_LEN)) && 
+       (rpcBuff[2] == MT_RPC_SUCCESS) )
+  {
+    memcpy(zbSocIeeeAddr, &rpcBuff[3], Z_EXTADDR_LEN);
+    zbSocIeeeAddrValid = TRUE;
+  }
+
+  return;
+}
+
+
 /*************************************************************************************************
  * @fn      processRpcSysApp()
  *
@@ -2200,6 +2291,9 @@ static void processRpcSysApp(uint8_t *rpcBuff)
   }    
   else if( rpcBuff[1] == 0 )
   {
+    //MT_APP_MSG status, releases the command from the Tx window
+    zbSocSchedAppStatus(rpcBuff[2]);
+
     if( rpcBuff[2] == 0)
     {
 //      printf("processRpcSysApp: Command Received Successfully\n\n");
@@ -2565,108 +2659,65 @@ static void processRpcSysDbg(uint8_t *rpcBuff, uint8_t len)
 /*************************************************************************************************
  * @fn      zbSocProcessRpc()
  *
- * @brief   read and process the RPC from the ZLL controller
+ * @brief   process an RPC from the ZLL controller, called on the main loop
+ *          for every frame the I/O thread received
  *
- * @param   none
+ * @param   rpcFrame - MT frame, from the SOF to the FCS
+ * @param   frameLen - length of the frame
  *
- * @return  length of current Rx Buffer
+ * @return  none
  *************************************************************************************************/
-void zbSocProcessRpc (void)
+void zbSocProcessRpc (uint8_t *rpcFrame, uint16_t frameLen)
 {
-  uint8_t rpcLen, bytesRead, sofByte, *rpcBuff, rpcBuffIdx;    
-  static uint8_t retryAttempts = 0;
+  uint8_t *rpcBuff = &rpcFrame[2];
+  uint8_t len = rpcFrame[1];
   int x;
-  uint8_t len;
-
-  //read first byte and check it is a SOF
-  read(serialPortFd, &sofByte, 1);
-  if ( sofByte == MT_RPC_SOF )
-  { 
-    retryAttempts = 0;     
-        
-    //read len
-    bytesRead = read(serialPortFd, &rpcLen, 1);
-
-    if( bytesRead == 1)
-    {    
-      len = rpcLen;
-	  
-      //allocating RPC payload (+ cmd0, cmd1 and fcs)
-      rpcLen += 3;
-
-      rpcBuff = malloc(rpcLen);
 
-      //non blocking read, so we need to wait for the rpc to be read
-      rpcBuffIdx = 0;
-      while(rpcLen > 0)
-      {
-        //read rpc
-        bytesRead = read(serialPortFd, &(rpcBuff[rpcBuffIdx]), rpcLen);  
-
-        //check for error
-        if( bytesRead > rpcLen)
-        {
-          //there was an error
-          printf("zbSocProcessRpc: read of %d bytes failed - %s\n", rpcLen, strerror(errno) );
-
-          if( retryAttempts++ < 50 )
-          {
-            //sleep for 10ms
-	          usleep(100000);
-            //try again
-            bytesRead = 0;
-          }
-          else
-          {
-            //something went wrong.
-            printf("zbSocProcessRpc: failed\n");
-            free(rpcBuff);
-            return;
-          }
-        }
-
-        rpcLen -= bytesRead;	
-        rpcBuffIdx += bytesRead;
-      }
-
-	  if (uartDebugPrintsEnabled)
-	  {
-		  printf("UART IN  <-- %d Bytes: SOF:%02X, Len:%02X, CMD0:%02X, CMD1:%02X, Payload:", len+5, MT_RPC_SOF, len, rpcBuff[0], rpcBuff[1]); \
-		  for (x = 0; x < len; x++)
-		  {
-	        printf("%02X%s", rpcBuff[x + 2], x < len - 1 ? ":" : ",");
-		  }
-		  printf(" FCS:%02X\n", rpcBuff[x + 2]);
-	  }
-
-//todo: verify FCS of incoming MT frames
-
-      //Read CMD0
-      switch (rpcBuff[0] & MT_RPC_SUBSYSTEM_MASK) 
-      {
-        case MT_RPC_SYS_SYS:
-          processRpcSysSys(rpcBuff);
-          break;
-        case MT_RPC_SYS_DBG:
-          processRpcSysDbg(rpcBuff, len);        
-          break;       
-        case MT_RPC_SYS_APP:
-          processRpcSysApp(rpcBuff);        
-          break;       
-		case MT_RPC_SYS_SBL:
-          processRpcSysSbl(rpcBuff);		  
-          break;
-        default:
-          printf("zbSocProcessRpc: CMD0:%x, CMD1:%x, not handled\n", rpcBuff[0], rpcBuff[1] );
-          break;
-      }
-      
-      free(rpcBuff);
-    }
-    else
+  if (uartDebugPrintsEnabled)
+  {
+    printf("UART IN  <-- %d Bytes: SOF:%02X, Len:%02X, CMD0:%02X, CMD1:%02X, Payload:", len+5, MT_RPC_SOF, len, rpcBuff[0], rpcBuff[1]);
+    for (x = 0; x < len; x++)
     {
-      printf("zbSocProcessRpc: No valid Start Of Frame found\n");
+      printf("%02X%s", rpcBuff[x + 2], x < len - 1 ? ":" : ",");
     }
+    printf(" FCS:%02X\n", rpcBuff[x + 2]);
+  }
+
+  //MT_APP_MSG status is handled by processRpcSysApp
+  if ((rpcBuff[0] == (MT_RPC_CMD_SRSP | MT_RPC_SYS_RES0)) && (len >= 3))
+  {
+    //the zbSoC does not support the SREQ: error code, CMD0 and CMD1 of it
+    printf("zbSocProcessRpc: CMD0:%x, CMD1:%x not supported by the zbSoC\n", rpcBuff[3], rpcBuff[4]);
+    zbSocSchedSrsp(rpcBuff[3], rpcBuff[4]);
+    return;
+  }
+  else if (((rpcBuff[0] & MT_RPC_CMD_TYPE_MASK) == MT_RPC_CMD_SRSP) &&
+      ((rpcBuff[0] & MT_RPC_SUBSYSTEM_MASK) != MT_RPC_SYS_APP))
+  {
+    zbSocSchedSrsp(rpcBuff[0], rpcBuff[1]);
+  }
+
+  //Read CMD0
+  switch (rpcBuff[0] & MT_RPC_SUBSYSTEM_MASK) 
+  {
+    case MT_RPC_SYS_SYS:
+      processRpcSysSys(rpcBuff);
+      break;
+    case MT_RPC_SYS_UTIL:
+      processRpcSysUtil(rpcBuff, len);
+      break;
+    case MT_RPC_SYS_DBG:
+      processRpcSysDbg(rpcBuff, len);        
+      break;       
+    case MT_RPC_SYS_APP:
+      processRpcSysApp(rpcBuff);        
+      break;       
+    case MT_RPC_SYS_SBL:
+      processRpcSysSbl(rpcBuff);		  
+      break;
+    default:
+      printf("zbSocProcessRpc: CMD0:%x, CMD1:%x, not handled\n", rpcBuff[0], rpcBuff[1] );
+      break;
   }
   
   return; 
@@ -46,10 +46,21 @@ extern "C"
 
 #include <stdint.h>
 
+#include "zbSocMtParser.h"
+#include "zbSocZcl.h"
+
 
 /********************************************************************/
 // ZigBee Soc Definitions
 
+// Largest ZCL payload zbSocSendZcl can send, the MT payload less the
+// MT_APP_MSG header and a manufacturer specific ZCL header
+#define ZBSOC_ZCL_MAX_PAYLOAD (ZBSOC_MT_MAX_PAYLOAD - 8 - 5)
+
+// source endpoints of the ZCL commands on the SoC
+#define ZBSOC_APP_ENDPOINT                   0x0B
+#define ZBSOC_SE_ENDPOINT                    0x09
+
 #define SBL_SUCCESS 0
 #define SBL_INTERNAL_ERROR 1
 #define SBL_BUSY 2
@@ -86,6 +97,85 @@ extern "C"
 
 #define BOOTLOADER_TIMEOUT 100 //milliseconds
 
+/********************************************************************/
+// ZCL Definitions
+
+/*** Foundation Command IDs ***/
+#define ZCL_CMD_READ                                    0x00
+#define ZCL_CMD_READ_RSP                                0x01
+#define ZCL_CMD_WRITE                                   0x02
+#define ZCL_CMD_WRITE_UNDIVIDED                         0x03
+#define ZCL_CMD_WRITE_RSP                               0x04
+#define ZCL_CMD_WRITE_NO_RSP                            0x05
+#define ZCL_CMD_CONFIG_REPORT                           0x06
+#define ZCL_CMD_CONFIG_REPORT_RSP                       0x07
+#define ZCL_CMD_REPORT                                  0x0a
+#define ZCL_CMD_DEFAULT_RSP                             0x0b
+
+/*** Frame Control bit mask ***/
+#define ZCL_FRAME_CONTROL_TYPE                          0x03
+#define ZCL_FRAME_CONTROL_MANU_SPECIFIC                 0x04
+#define ZCL_FRAME_CONTROL_DIRECTION                     0x08
+#define ZCL_FRAME_CONTROL_DISABLE_DEFAULT_RSP           0x10
+
+/*** Frame Types ***/
+#define ZCL_FRAME_TYPE_PROFILE_CMD                      0x00
+#define ZCL_FRAME_TYPE_SPECIFIC_CMD                     0x01
+
+// Cluster Commands
+#define COMMAND_OFF 0x00
+#define COMMAND_ON 0x01
+#define COMMAND_LIGHTING_MOVE_TO_HUE  0x00
+#define COMMAND_LIGHTING_MOVE_TO_SATURATION 0x03
+#define COMMAND_LIGHTING_MOVE_TO_HUE_AND_SATURATION 0x06
+#define COMMAND_LEVEL_MOVE_TO_LEVEL 0x00
+
+// General Clusters
+#define ZCL_CLUSTER_ID_GEN_IDENTIFY                    0x0003
+#define ZCL_CLUSTER_ID_GEN_GROUPS                      0x0004
+#define ZCL_CLUSTER_ID_GEN_SCENES                      0x0005
+#define ZCL_CLUSTER_ID_GEN_ON_OFF                      0x0006
+#define ZCL_CLUSTER_ID_GEN_LEVEL_CONTROL               0x0008
+#define ZCL_CLUSTER_ID_GEN_KEY_ESTABLISHMENT                 0x0800
+// Lighting Clusters
+#define ZCL_CLUSTER_ID_LIGHTING_COLOR_CONTROL          0x0300
+// Mettering and Sensing Clusters
+#define ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT			 0x0402
+#define ZCL_CLUSTER_ID_MS_REL_HUMIDITY_MEASUREMENT		 0x0405
+// Pricing
+#define ZCL_CLUSTER_ID_SE_PRICING                            0x0700
+//Metering
+#define ZCL_CLUSTER_ID_SE_SIMPLE_METERING              0x0702
+// Messaging
+#define ZCL_CLUSTER_ID_SE_MESSAGE                            0x0703
+// Security and Safety (SS) Clusters
+#define ZCL_CLUSTER_ID_SS_IAS_ZONE                     0x0500
+
+/*******************************/
+/*** Generic Cluster ATTR's  ***/
+/*******************************/
+#define ATTRID_ON_OFF                                     0x0000
+#define ATTRID_LEVEL_CURRENT_LEVEL                        0x0000
+
+/*******************************/
+/*** Lighting Cluster ATTR's  ***/
+/*******************************/
+#define ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_HUE         0x0000
+#define ATTRID_LIGHTING_COLOR_CONTROL_CURRENT_SATURATION  0x0001
+
+
+/*******************************/
+/*** Mettering and Sensing Cluster ATTR's  ***/
+/*******************************/
+#define ATTRID_MS_TEMPERATURE_MEASURED_VALUE              0x0000
+#define ATTRID_MS_RELATIVE_HUMIDITY_MEASURED_VALUE        0x0000
+
+/*******************************/
+/*** SE SIMPLE METERING Cluster ATTR's  ***/
+/*******************************/
+#define ATTRID_MASK_SE_HISTORICAL_CONSUMPTION             0x0400
+#define ATTRID_SE_INSTANTANEOUS_DEMAND               ( 0x0000 | ATTRID_MASK_SE_HISTORICAL_CONSUMPTION )
+
 /********************************************************************/
 // ZigBee Soc Types
 
@@ -170,13 +260,13 @@ typedef struct
 
 typedef uint8_t (*zbSocTlIndicationCb_t)(epInfo_t *epInfo);
 typedef uint8_t (*zbSocNewDevIndicationCb_t)(epInfo_t *epInfo);
-typedef uint8_t (*zbSocZclGetStateCb_t)(uint8_t state, uint16_t nwkAddr, uint8_t endpoint);
-typedef uint8_t (*zbSocZclGetLevelCb_t)(uint8_t level, uint16_t nwkAddr, uint8_t endpoint);
-typedef uint8_t (*zbSocZclGetHueCb_t)(uint8_t hue, uint16_t nwkAddr, uint8_t endpoint);
-typedef uint8_t (*zbSocZclGetSatCb_t)(uint8_t sat, uint16_t nwkAddr, uint8_t endpoint);
-typedef uint8_t (*zbSocZclGetTempCb_t)(uint16_t sat, uint16_t nwkAddr, uint8_t endpoint);
-typedef uint8_t (*zbSocZclReadPowerRspCb_t) (uint32_t power, uint16_t nwkAddr, uint8_t endpoint);
-typedef uint8_t (*zbSocZclGetHumidCb_t)(uint16_t humnidity, uint16_t nwkAddr, uint8_t endpoint);
+typedef uint8_t (*zbSocZclGetStateCb_t)(uint8_t state, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+typedef uint8_t (*zbSocZclGetLevelCb_t)(uint8_t level, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+typedef uint8_t (*zbSocZclGetHueCb_t)(uint8_t hue, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+typedef uint8_t (*zbSocZclGetSatCb_t)(uint8_t sat, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+typedef uint8_t (*zbSocZclGetTempCb_t)(uint16_t sat, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+typedef uint8_t (*zbSocZclReadPowerRspCb_t) (uint32_t power, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+typedef uint8_t (*zbSocZclGetHumidCb_t)(uint16_t humnidity, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
 typedef uint8_t (*zbSocZoneStateChangeCb_t)(uint32_t zoneState, uint16_t nwkAddr, uint8_t endpoint);
 typedef uint8_t (*zbSocBootloadingDoneCb_t)(uint8_t State);
 typedef uint8_t (*zbSocBootloadingProgressReportingCb_t)(uint8_t Phase, uint32_t location);
@@ -184,6 +274,12 @@ typedef uint8_t (*zbSocCertInstallResultIndCb_t)(uint8_t result);
 typedef uint8_t (*zbSocKeyEstablishmentStateIndCb_t)(uint8_t state);
 typedef uint8_t (*zbSocZclDisplayMessageIndCb_t)(uint8_t *zclPayload, uint8_t len);
 typedef uint8_t (*zbSocZclPublishPriceIndCb_t)(uint8_t *zclPayload, uint8_t len);
+typedef uint8_t (*zbSocZclReadAttrsRspCb_t)(uint16_t clusterId, zbSocZclAttr_t *attrs, uint8_t numAttrs, 
+                                            uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+typedef uint8_t (*zbSocZclReportAttrsCb_t)(uint16_t clusterId, zbSocZclAttr_t *attrs, uint8_t numAttrs, 
+                                           uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+typedef uint8_t (*zbSocZclDefaultRspCb_t)(uint16_t clusterId, uint8_t commandId, uint8_t status, 
+                                          uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
 
 typedef struct
 {
@@ -203,6 +299,9 @@ typedef struct
   zbSocKeyEstablishmentStateIndCb_t   pfnKeyEstablishmentStateIndCb;  // Key Establishment state change reporting
   zbSocZclDisplayMessageIndCb_t  pfnZclDisplayMessageIndCb;  // ZCL response callback for GetLastMessage or ZCL unsolicited message callback for DisplayMessage
   zbSocZclPublishPriceIndCb_t    pfnZclPublishPriceIndCb;    // ZCL response callback for GetCurrentPrice or ZCL unsolicited message callback for PublishPrice
+  zbSocZclReadAttrsRspCb_t       pfnZclReadAttrsRspCb;       // ZCL read attributes response, every record of the frame
+  zbSocZclReportAttrsCb_t        pfnZclReportAttrsCb;        // ZCL report attributes, every record of the frame
+  zbSocZclDefaultRspCb_t         pfnZclDefaultRspCb;         // ZCL default response to a command sent
 } zbSocCallbacks_t;
 
 typedef void (*timerCallback_t)(void);
@@ -234,7 +333,7 @@ void zbSocGetTimerFds(timerFDs_t *fds);
 int32_t zbSocOpen( char *devicePath );
 void zbSocRegisterCallbacks( zbSocCallbacks_t zbSocCallbacks);
 void zbSocClose( void );
-void zbSocProcessRpc (void);
+void zbSocProcessRpc (uint8_t *rpcFrame, uint16_t frameLen);
 
 //ZigBee Control API's
 void zbSocTouchLink(void);
@@ -243,23 +342,34 @@ void zbSocSendResetToFn(void);
 void zbSocOpenNwk(void);
 uint8_t zbSocInitiateCertInstall(char *filename, uint8_t force2reset);
 //ZCL Set API's
-void zbSocSetState(uint8_t state, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
-void zbSocSetLevel(uint8_t level, uint16_t time, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
-void zbSocSetHue(uint8_t hue, uint16_t time, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
-void zbSocSetSat(uint8_t sat, uint16_t time, uint16_t dstAddr, uint8_t  endpoint, uint8_t addrMode);
-void zbSocSetHueSat(uint8_t hue, uint8_t sat, uint16_t time, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
+uint8_t zbSocSetState(uint8_t state, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
+uint8_t zbSocSetLevel(uint8_t level, uint16_t time, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
+uint8_t zbSocSetHue(uint8_t hue, uint16_t time, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
+uint8_t zbSocSetSat(uint8_t sat, uint16_t time, uint16_t dstAddr, uint8_t  endpoint, uint8_t addrMode);
+uint8_t zbSocSetHueSat(uint8_t hue, uint8_t sat, uint16_t time, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
 void zbSocAddGroup(uint16_t groupId, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
 void zbSocStoreScene(uint16_t groupId, uint8_t sceneId, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
 void zbSocRecallScene(uint16_t groupId, uint8_t sceneId, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
 void zbSocBind(uint16_t srcNwkAddr, uint8_t srcEndpoint, uint8_t srcIEEE[8], uint8_t dstEndpoint, uint8_t dstIEEE[8], uint16_t clusterID);
+//Generic ZCL API
+int32_t zbSocSendZcl(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode, uint16_t clusterId, uint8_t frameControl, 
+                     uint16_t manuCode, uint8_t commandId, uint8_t *payload, uint8_t payloadLen);
+int32_t zbSocReadAttrs(uint16_t clusterId, uint16_t *attrIds, uint8_t numAttrs, uint16_t dstAddr, 
+                       uint8_t endpoint, uint8_t addrMode);
+int32_t zbSocConfigReporting(uint16_t clusterId, uint16_t attrId, uint8_t dataType, uint16_t minInterval, 
+                             uint16_t maxInterval, uint32_t reportableChange, uint16_t dstAddr, 
+                             uint8_t endpoint, uint8_t addrMode);
+//zbSoC device info
+void zbSocGetDeviceInfo(void);
+uint8_t zbSocGetIeeeAddr(uint8_t ieeeAddr[8]);
 //ZCL Get API's
-void zbSocGetState(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
-void zbSocGetLevel(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
-void zbSocGetHue(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
-void zbSocGetSat(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
-void zbSocGetTemp(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
-void zbSocReadPower(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
-void zbSocGetHumid(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
+uint8_t zbSocGetState(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
+uint8_t zbSocGetLevel(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
+uint8_t zbSocGetHue(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
+uint8_t zbSocGetSat(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
+uint8_t zbSocGetTemp(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
+uint8_t zbSocReadPower(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
+uint8_t zbSocGetHumid(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
 void zbSocGetLastMessage(uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
 void zbSocGetCurrentPrice(uint8_t rxOnIdle, uint16_t dstAddr, uint8_t endpoint, uint8_t addrMode);
 
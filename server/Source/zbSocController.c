@@ -39,7 +39,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <poll.h>
+#include <stdint.h>
 #include <time.h>
 #include <unistd.h>
 #include <sys/timerfd.h>
@@ -50,18 +50,26 @@
 #include "interface_scenelist.h"
 #include "interface_srpcserver.h"
 #include "socket_server.h"
+#include "reactor.h"
+#include "zbSocIo.h"
+#include "zbSocSched.h"
+#include "zbSocTransport.h"
+#include "interface_coalesce.h"
+#include "interface_reporting.h"
+#include "interface_readbatch.h"
+#include "interface_groupcast.h"
 
 #define MAX_DB_FILENAMR_LEN 255
 
 uint8_t zclTlIndicationCb(epInfo_t *epInfo);
 uint8_t zclNewDevIndicationCb(epInfo_t *epInfo);
-uint8_t zclGetStateCb(uint8_t state, uint16_t nwkAddr, uint8_t endpoint);
-uint8_t zclGetLevelCb(uint8_t level, uint16_t nwkAddr, uint8_t endpoint);
-uint8_t zclGetHueCb(uint8_t hue, uint16_t nwkAddr, uint8_t endpoint);
-uint8_t zclGetSatCb(uint8_t sat, uint16_t nwkAddr, uint8_t endpoint);
-uint8_t zclGetTempCb(uint16_t temp, uint16_t nwkAddr, uint8_t endpoint);
-uint8_t zclReadPowerRspCb(uint32_t power, uint16_t nwkAddr, uint8_t endpoint);
-uint8_t zclGetHumidCb(uint16_t temp, uint16_t nwkAddr, uint8_t endpoint);
+uint8_t zclGetStateCb(uint8_t state, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+uint8_t zclGetLevelCb(uint8_t level, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+uint8_t zclGetHueCb(uint8_t hue, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+uint8_t zclGetSatCb(uint8_t sat, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+uint8_t zclGetTempCb(uint16_t temp, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+uint8_t zclReadPowerRspCb(uint32_t power, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+uint8_t zclGetHumidCb(uint16_t temp, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
 uint8_t zclZoneSateChangeCb(uint32_t zoneState, uint16_t nwkAddr, uint8_t endpoint);
 uint8_t SblDoneCb(uint8_t status);
 uint8_t SblReportingCb(uint8_t phase, uint32_t location);
@@ -69,6 +77,9 @@ uint8_t certInstallResultIndCb(uint8_t result);
 uint8_t keyEstablishmentStateIndCb(uint8_t state);
 uint8_t zclDisplayMessageIndCb(uint8_t *zclPayload, uint8_t len);
 uint8_t zclPublishPriceIndCb(uint8_t *zclPayload, uint8_t len);
+uint8_t zclReadAttrsRspCb(uint16_t clusterId, zbSocZclAttr_t *attrs, uint8_t numAttrs, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+uint8_t zclReportAttrsCb(uint16_t clusterId, zbSocZclAttr_t *attrs, uint8_t numAttrs, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
+uint8_t zclDefaultRspCb(uint16_t clusterId, uint8_t commandId, uint8_t status, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum);
 
 static zbSocCallbacks_t zbSocCbs =
 {
@@ -88,31 +99,227 @@ static zbSocCallbacks_t zbSocCbs =
   keyEstablishmentStateIndCb,  //pfnkeyEstablishmentStateIndCb - Key Establishment state change reporting
   zclDisplayMessageIndCb, //pfnZclDisplayMessageIndCb - ZCL response callback for DisplayMessage or request callback for unsolicited message
   zclPublishPriceIndCb, //pfnZclPublishPriceIndCb - ZCL response callback for GetCurrentMessage or request callback for unsolicited message
+  zclReadAttrsRspCb,    //pfnZclReadAttrsRspCb - ZCL read attributes response, every record of the frame
+  zclReportAttrsCb,     //pfnZclReportAttrsCb - ZCL report attributes, every record of the frame
+  zclDefaultRspCb,      //pfnZclDefaultRspCb - ZCL default response to a command sent
 };
 
 uint8_t uartDebugPrintsEnabled = 0;
 int current_poll_timeout = -1;
 
+static timerFDs_t *zbSocTimerFds = NULL;
+
+static void zbSocSerialEventCb( int fd, uint32_t events );
+static void zbSocTimerEventCb( int fd, uint32_t events );
+
 
 void usage( char* exeName )
 {
-    printf("Usage: ./%s <port>\n", exeName);
+    printf("Usage: ./%s [options] <port> [debug] [reset]\n", exeName);
     printf("Eample: ./%s /dev/ttyACM0\n", exeName);
+    printf("Options:\n");
+    printf("  -m <num>  max number of connected clients (default %d)\n", SOCKET_SERVER_DEFAULT_MAX_CLIENTS);
+    printf("  -b <num>  pending connection backlog (default %d)\n", SOCKET_SERVER_DEFAULT_BACKLOG);
+    printf("  -q <num>  max queued outbound messages per client (default %d)\n", SOCKET_SERVER_DEFAULT_TXQ_LEN);
+    printf("  -p <policy>  full outbound queue policy: drop (default), coalesce or disconnect\n");
+    printf("  -u <path>  also listen on a unix socket, @<name> for the abstract namespace\n");
+    printf("  -w <num>  MT SREQs, e.g. ZCL commands, in flight at the zbSoC (default %d)\n", ZBSOC_SCHED_DEFAULT_SREQ_WINDOW);
+    printf("  -a <num>  MT AREQs sent to the zbSoC per %d ms (default %d)\n", ZBSOC_SCHED_AREQ_HOLD_MS, ZBSOC_SCHED_DEFAULT_AREQ_WINDOW);
+    printf("  -c <ms>  hold level and color commands to a device this long and send the latest, 0 disables (default %d)\n", COALESCE_DEFAULT_WINDOW_MS);
+    printf("  -d <ms>  read the attributes of a cluster of a device asked for within this long with one ZCL Read, 0 disables (default %d)\n", READ_BATCH_DEFAULT_WINDOW_MS);
+    printf("  -g <ms>  send on/off commands to every member of a group within this long as one groupcast, 0 disables (default %d)\n", GROUPCAST_DEFAULT_WINDOW_MS);
+    printf("  -t uart|spi|pty|tcp  transport to the zbSoC, by default from the port: /dev/spidev* is SPI,\n");
+    printf("           pty:[<link>] a pseudo-terminal for a simulator, tcp:<host>:<port> TCP, anything else a UART\n");
+    printf("  -s <baud>[:noflow][:lowlat][:vmin=<bytes>][:vtime=<1/10 s>]  UART profile, up to 921600 (default 38400 with RTS/CTS)\n");
+    printf("  -s sysfs|mock|chardev=<chip>,<srdy line>[,<enable line>]  SPI SRDY GPIO backend (default sysfs)\n");
+    printf("  -s [backoff=<ms>][:maxbackoff=<ms>][:connect=<ms>][:keepalive=<s>]  TCP reconnect profile (default 100, 10000, 3000 and 10)\n");
+    printf("  -r <cluster>:<min s>:<max s>[:<change>]  reporting configured on joining devices, 0 max only reports changes\n");
+    printf("  -r <cluster>:off  do not configure reporting of a cluster\n");
+}
+
+
+/*********************************************************************
+ * @fn      zbSocSerialEventCb
+ *
+ * @brief   reactor handler for the frames the zbSoC I/O thread received.
+ *
+ * @param   fd - Rx eventfd of the I/O thread
+ * @param   events - epoll events
+ *
+ * @return  none
+ */
+static void zbSocSerialEventCb( int fd, uint32_t events )
+{
+  zbSocIoProcessRx();
 }
 
+/*********************************************************************
+ * @fn      zbSocTimerEventCb
+ *
+ * @brief   reactor handler for the zbSoC timer fd's.
+ *
+ * @param   fd - expired timer fd
+ * @param   events - epoll events
+ *
+ * @return  none
+ */
+static void zbSocTimerEventCb( int fd, uint32_t events )
+{
+  int timerFdIdx;
+  uint64_t expirations;
+
+  //consume the expiration so the level triggered fd stops reporting
+  read(fd, &expirations, sizeof(expirations));
+
+  for(timerFdIdx=0; timerFdIdx < NUM_OF_TIMERS; timerFdIdx++)
+  {
+    if (zbSocTimerFds[timerFdIdx].fd == fd)
+    {
+      printf("Timer expired: #%d\n", timerFdIdx);
+      zbSocTimerFds[timerFdIdx].callback();
+      break;
+    }
+  }
+}
 
 int main(int argc, char* argv[])
 {
   int retval = 0;
+  int opt, numArgs;
+  uint32_t txQueueLen = SOCKET_SERVER_DEFAULT_TXQ_LEN;
+  uint8_t txPolicy = SOCKET_TXQ_POLICY_DROP_OLDEST;
   char * selected_serial_port;
+  char * unixSocketPath = NULL;
+  char * transportName = NULL;
+  char * transportProfile = NULL;
   int numTimerFDs = NUM_OF_TIMERS;
+  int timerFdIdx;
   timerFDs_t *timer_fds = malloc(  NUM_OF_TIMERS * sizeof( timerFDs_t ) );
   char dbFilename[MAX_DB_FILENAMR_LEN];
  
   printf("%s -- %s %s\n", argv[0], __DATE__, __TIME__ );
  
+  while ((opt = getopt(argc, argv, "m:b:q:p:u:w:a:c:d:g:t:s:r:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'm':
+        if (socketSeverSetMaxClients(atoi(optarg)) != 0)
+        {
+          printf("Invalid max clients: %s\n", optarg);
+          exit(-1);
+        }
+        break;
+      case 'b':
+        if (socketSeverSetBacklog(atoi(optarg)) != 0)
+        {
+          printf("Invalid backlog: %s\n", optarg);
+          exit(-1);
+        }
+        break;
+      case 'q':
+        txQueueLen = atoi(optarg);
+        break;
+      case 'p':
+        if (!strcmp(optarg, "drop"))
+        {
+          txPolicy = SOCKET_TXQ_POLICY_DROP_OLDEST;
+        }
+        else if (!strcmp(optarg, "coalesce"))
+        {
+          txPolicy = SOCKET_TXQ_POLICY_COALESCE;
+        }
+        else if (!strcmp(optarg, "disconnect"))
+        {
+          txPolicy = SOCKET_TXQ_POLICY_DISCONNECT;
+        }
+        else
+        {
+          printf("Invalid queue policy: %s\n", optarg);
+          exit(-1);
+        }
+        break;
+      case 'u':
+        unixSocketPath = optarg;
+        break;
+      case 'w':
+      case 'a':
+        if ((atoi(optarg) <= 0) || (atoi(optarg) > ZBSOC_SCHED_MAX_WINDOW))
+        {
+          printf("Invalid window: %s\n", optarg);
+          exit(-1);
+        }
+        //0 keeps the current window
+        zbSocSchedSetWindow((opt == 'w') ? atoi(optarg) : 0, (opt == 'a') ? atoi(optarg) : 0);
+        break;
+      case 'c':
+        if ((atoi(optarg) < 0) || (coalesceSetWindow(atoi(optarg)) != 0))
+        {
+          printf("Invalid coalescing window: %s\n", optarg);
+          exit(-1);
+        }
+        break;
+      case 'd':
+        if ((atoi(optarg) < 0) || (readBatchSetWindow(atoi(optarg)) != 0))
+        {
+          printf("Invalid read batching window: %s\n", optarg);
+          exit(-1);
+        }
+        break;
+      case 'g':
+        if ((atoi(optarg) < 0) || (groupcastSetWindow(atoi(optarg)) != 0))
+        {
+          printf("Invalid groupcast window: %s\n", optarg);
+          exit(-1);
+        }
+        break;
+      case 't':
+        transportName = optarg;
+        break;
+      case 's':
+        //the format is the transport's, known once the port is
+        transportProfile = optarg;
+        break;
+      case 'r':
+        {
+          unsigned int clusterId, minInterval, maxInterval, reportableChange = 0;
+          char off[4];
+          int32_t rtn = -1;
+
+          if (sscanf(optarg, "%i:%3s", &clusterId, off) == 2 && !strcmp(off, "off"))
+          {
+            rtn = reportingDisableCluster(clusterId);
+          }
+          else if ((sscanf(optarg, "%i:%u:%u:%i", &clusterId, &minInterval, &maxInterval, &reportableChange) >= 3) &&
+                   (minInterval <= 0xFFFF) && (maxInterval <= 0xFFFF))
+          {
+            rtn = reportingSetCluster(clusterId, minInterval, maxInterval, reportableChange);
+          }
+
+          if (rtn != 0)
+          {
+            printf("Invalid reporting configuration: %s\n", optarg);
+            exit(-1);
+          }
+        }
+        break;
+      default:
+        usage(argv[0]);
+        exit(-1);
+    }
+  }
+  
+  if (socketSeverSetTxQueue(txQueueLen, txPolicy) != 0)
+  {
+    printf("Invalid outbound queue length: %d\n", txQueueLen);
+    exit(-1);
+  }
+  
+  //positional arguments follow the options
+  numArgs = argc - optind;
+  
   // accept only 1
-  if( argc < 2 )
+  if( numArgs < 1 )
   {
     usage(argv[0]);
     printf("attempting to use /dev/ttyACM0\n\n");
@@ -120,9 +327,27 @@ int main(int argc, char* argv[])
   }
   else
   {
-  	selected_serial_port = argv[1];
+  	selected_serial_port = argv[optind];
+  }
+
+  if (zbSocTransportSelect(transportName, selected_serial_port) != 0)
+  {
+    printf("Invalid transport: %s\n", transportName);
+    exit(-1);
+  }
+
+  if ((transportProfile != NULL) && (zbSocTransportSetProfile(transportProfile) != 0))
+  {
+    printf("Invalid %s transport profile: %s\n", zbSocTransportGetName(), transportProfile);
+    exit(-1);
   }
   
+  //the command queue of the zbSoC puts its timer in the reactor
+  if(reactorInit() < 0)
+  {
+    exit(-1);
+  }
+
   zbSocOpen( selected_serial_port );
   zbSocForceRun(); //skip the bootloader wait period
   
@@ -131,24 +356,25 @@ int main(int argc, char* argv[])
     exit(-1);
   }
 
-  if (argc > 2)
+  if (numArgs > 1)
   {
-  	uartDebugPrintsEnabled = atoi(argv[2]);
+  	uartDebugPrintsEnabled = atoi(argv[optind + 1]);
   }
 
-  if (argc > 3)
+  if (numArgs > 2)
   {
-    if (atoi(argv[3]) == 1)
+    if (atoi(argv[optind + 2]) == 1)
     {
       zbSocResetToFn();
       printf("Sent Reset to Factory New\n");
     }
-      else if (atoi(argv[3])  > 1)
+      else if (atoi(argv[optind + 2])  > 1)
     {
       //...
     }
   }
   
+  zbSocTimerFds = timer_fds;
   zbSocGetTimerFds(timer_fds);
   
   sprintf(dbFilename, "%.*s/devicelistfile.dat",strrchr(argv[0],'/') - argv[0] , argv[0]);
@@ -158,97 +384,23 @@ int main(int argc, char* argv[])
   sceneListRestorScenes();
   
   zbSocRegisterCallbacks( zbSocCbs );    
-  SRPC_Init();
+  SRPC_Init(unixSocketPath);
+
+  //devices that join bind their reports to the zbSoC
+  zbSocGetDeviceInfo();
+  
+  //the listening socket and the clients register themselves with the reactor,
+  //the zbSoC port is owned by the I/O thread which queues frames for us
+  reactorAddFd(zbSocIoGetRxFd(), EPOLLIN, zbSocSerialEventCb);
+  for(timerFdIdx=0; timerFdIdx < numTimerFDs; timerFdIdx++)
+  {
+    reactorAddFd(timer_fds[timerFdIdx].fd, EPOLLIN, zbSocTimerEventCb);
+  }
   
   while(1)
   {          
-    int numClientFds = socketSeverGetNumClients(); 
-    
-	  //poll on client socket fd's and the zbSoC serial port for any activity
-		if(numClientFds)
-		{
-		  int pollFdIdx;  		   
-      int timerFdIdx;
-		  int *client_fds = malloc(  numClientFds * sizeof( int ) );
-
-		  //socket client FD's + serialPortFd serial port FD
-      struct pollfd *pollFds = malloc(  ((numClientFds + 1 + numTimerFDs) * sizeof( struct pollfd )) );
-		  
-		  if(client_fds && pollFds)	
-		  {
-		    //set the serialPortFd serial port FD in the poll file descriptors
-		    pollFds[0].fd = serialPortFd;
-#if (!HAL_UART_SPI)
-          //Fd will be a characture driver
-  			pollFds[0].events = POLLIN;
-#else	      
-          //Fd Will be GPIO
-    	  pollFds[0].events = POLLPRI;
-  			
-          //try to read any messages that might already be wating
-          if(zbSocTransportPoll())
-          {
-            zbSocProcessRpc();
-          }
-    	 
-          //flush events
-          int buf[1];
-          lseek(pollFds[0].fd, SEEK_SET, 0);
-          read(pollFds[0].fd, buf, 1);
-            	  
-#endif  			
-		    //Set the socket file descriptors  		    
-	  	  socketSeverGetClientFds(client_fds, numClientFds);  			    	  	    	  	 
-		  	for(pollFdIdx=0; pollFdIdx < numClientFds; pollFdIdx++)
-  	  	{
-  			  pollFds[pollFdIdx+1].fd = client_fds[pollFdIdx];
-  			  pollFds[pollFdIdx+1].events = POLLIN | POLLRDHUP;
-  			  //printf("%s: adding fd %d to poll()\n", argv[0], pollFds[pollFdIdx].fd); 	  				
-  		  }	
-        for(timerFdIdx=0; timerFdIdx < numTimerFDs; timerFdIdx++)
-        {
-          pollFds[numClientFds+1+timerFdIdx].fd = timer_fds[timerFdIdx].fd;
-          pollFds[numClientFds+1+timerFdIdx].events =POLLIN;
-          //printf("%s: adding fd %d to poll()\n", argv[0], pollFds[pollFdIdx].fd); 					
-        } 
-
-//        printf("%s: waiting for poll()\n", argv[0]);
-
-        poll(pollFds, (numClientFds+1+numTimerFDs), current_poll_timeout);
-
-        //printf("%s: got poll()\n", argv[0]);
-        
-        //did the poll unblock because of the zllSoC serial?
-        if(pollFds[0].revents)
-        {
-          printf("Message from the ZigBee SoC\n");
-          zbSocProcessRpc();
-        }
-
-        //did the poll unblock because of activity on the socket interface?
-        for(pollFdIdx=1; pollFdIdx < (numClientFds+1); pollFdIdx++)
-        {
-          if ( (pollFds[pollFdIdx].revents) )
-          {
-            printf("Message from the client\n");
-            socketSeverPoll(pollFds[pollFdIdx].fd, pollFds[pollFdIdx].revents);
-          }
-        }          
-		
-        //did the poll unblock because of timer expiration?
-        for(timerFdIdx=0; timerFdIdx < numTimerFDs; timerFdIdx++)
-        {
-          if (pollFds[numClientFds+1+timerFdIdx].revents)
-        {
-            printf("Timer expired: #%d\n", timerFdIdx);
-            timer_fds[timerFdIdx].callback();
-        }
-        }
-        	  
-        free( client_fds );	  
-        free( pollFds );	  		
-        }
-      }  		           
+    //wait for frames from the zbSoC, activity on the sockets or the timers
+    reactorPoll(current_poll_timeout);
   }    
 
   return retval;
@@ -293,37 +445,38 @@ uint8_t zclNewDevIndicationCb(epInfo_t *epInfo)
   devListAddDevice(epInfo);
 		epInfoEx.epInfo = epInfo;
 		RSPC_SendEpInfo(&epInfoEx);
+		reportingConfigureDevice(epInfo);
 	}
   return 0;  
 }
 
-uint8_t zclGetStateCb(uint8_t state, uint16_t nwkAddr, uint8_t endpoint)
+uint8_t zclGetStateCb(uint8_t state, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum)
 {
-  SRPC_CallBack_getStateRsp(state, nwkAddr, endpoint, 0);
+  SRPC_CallBack_getStateRsp(state, nwkAddr, endpoint, transSeqNum);
   return 0;  
 }
 
-uint8_t zclGetLevelCb(uint8_t level, uint16_t nwkAddr, uint8_t endpoint)
+uint8_t zclGetLevelCb(uint8_t level, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum)
 {
-  SRPC_CallBack_getLevelRsp(level, nwkAddr, endpoint, 0);
+  SRPC_CallBack_getLevelRsp(level, nwkAddr, endpoint, transSeqNum);
   return 0;  
 }
 
-uint8_t zclGetHueCb(uint8_t hue, uint16_t nwkAddr, uint8_t endpoint)
+uint8_t zclGetHueCb(uint8_t hue, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum)
 {
-  SRPC_CallBack_getHueRsp(hue, nwkAddr, endpoint, 0);
+  SRPC_CallBack_getHueRsp(hue, nwkAddr, endpoint, transSeqNum);
   return 0;  
 }
 
-uint8_t zclGetSatCb(uint8_t sat, uint16_t nwkAddr, uint8_t endpoint)
+uint8_t zclGetSatCb(uint8_t sat, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum)
 {
-  SRPC_CallBack_getSatRsp(sat, nwkAddr, endpoint, 0);
+  SRPC_CallBack_getSatRsp(sat, nwkAddr, endpoint, transSeqNum);
   return 0;  
 }
 
-uint8_t zclGetTempCb(uint16_t temp, uint16_t nwkAddr, uint8_t endpoint)
+uint8_t zclGetTempCb(uint16_t temp, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum)
 {
-  SRPC_CallBack_getTempRsp(temp, nwkAddr, endpoint, 0);
+  SRPC_CallBack_getTempRsp(temp, nwkAddr, endpoint, transSeqNum);
   
   printf("\nzclGetTempCb:\n    Network Addr : 0x%04x\n    End Point    : 0x%02x\n    temp   : %02x\n\n", 
     nwkAddr, endpoint, temp); 
@@ -331,9 +484,9 @@ uint8_t zclGetTempCb(uint16_t temp, uint16_t nwkAddr, uint8_t endpoint)
   return 0;  
 }
 
-uint8_t zclReadPowerRspCb(uint32_t power, uint16_t nwkAddr, uint8_t endpoint)
+uint8_t zclReadPowerRspCb(uint32_t power, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum)
 {
-  SRPC_CallBack_readPowerRsp(power, nwkAddr, endpoint, 0);
+  SRPC_CallBack_readPowerRsp(power, nwkAddr, endpoint, transSeqNum);
 
   printf("\nzclReadPowerRspCb:\n    Network Addr : 0x%04x\n    End Point    : 0x%02x\n    power   : %02x\n\n", 
     nwkAddr, endpoint, power); 
@@ -341,9 +494,9 @@ uint8_t zclReadPowerRspCb(uint32_t power, uint16_t nwkAddr, uint8_t endpoint)
   return 0;  
 }
 
-uint8_t zclGetHumidCb(uint16_t Humid, uint16_t nwkAddr, uint8_t endpoint)
+uint8_t zclGetHumidCb(uint16_t Humid, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum)
 {
-  SRPC_CallBack_getHumidRsp(Humid, nwkAddr, endpoint, 0);
+  SRPC_CallBack_getHumidRsp(Humid, nwkAddr, endpoint, transSeqNum);
   
   printf("\nzclGetTempCb:\n    Network Addr : 0x%04x\n    End Point    : 0x%02x\n    Humid   : %02x\n\n", 
     nwkAddr, endpoint, Humid); 
@@ -401,4 +554,25 @@ uint8_t zclPublishPriceIndCb(uint8_t *zclPayload, uint8_t len)
   return 0;
 }
 
+uint8_t zclReadAttrsRspCb(uint16_t clusterId, zbSocZclAttr_t *attrs, uint8_t numAttrs, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum)
+{
+  SRPC_CallBack_readAttrsRsp(clusterId, attrs, numAttrs, nwkAddr, endpoint, transSeqNum);
+
+  return 0;
+}
+
+uint8_t zclReportAttrsCb(uint16_t clusterId, zbSocZclAttr_t *attrs, uint8_t numAttrs, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum)
+{
+  SRPC_CallBack_reportAttrs(clusterId, attrs, numAttrs, nwkAddr, endpoint, transSeqNum);
+
+  return 0;
+}
+
+uint8_t zclDefaultRspCb(uint16_t clusterId, uint8_t commandId, uint8_t status, uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum)
+{
+  SRPC_CallBack_defaultRsp(clusterId, commandId, status, nwkAddr, endpoint, transSeqNum);
+
+  return 0;
+}
+
 
@@ -0,0 +1,781 @@
+/**************************************************************************************************
+ * Filename:       zbSocGpio.c
+ * Description:    SRDY GPIO of the SPI transport, sysfs, GPIO character device and mock backends.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+ 
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+#include "zbSocGpio.h"
+#include "hal_types.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+//RF2_GPIO0/SRDY GPIO74
+//RF1_SPI_ENABLE GPIO74
+//RF2_SPI_ENABLE GPIO74
+#define HAL_SRDY_VALUE "/sys/class/gpio/gpio9/value"
+#define HAL_SRDY_DIR "/sys/class/gpio/gpio9/direction"
+#define HAL_SRDY_EDGE "/sys/class/gpio/gpio9/edge"
+#define HAL_SPIENABLE_VALUE "/sys/class/gpio/gpio73/value"
+#define HAL_SPIENABLE_DIR "/sys/class/gpio/gpio73/direction"
+
+// line events read from the kernel at once
+#define GPIO_EVENT_BATCH 16
+
+#define GPIO_CONSUMER "zbGateway"
+
+// GPIO_V2_LINE_FLAG_EVENT_CLOCK_HTE is an enum of the 5.19 headers, the
+// 5.10-5.18 ones have the v2 API without it. Kernels that do not know
+// the flag reject the request and the SRDY line falls back to the
+// monotonic clock.
+#ifdef GPIO_V2_GET_LINE_IOCTL
+#define GPIO_FLAG_EVENT_CLOCK_HTE _BITULL(12)
+#endif
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  int (*open)( const zbSocGpioConfig_t *config );
+  void (*close)( void );
+  int32_t (*getSrdy)( void );
+  uint32_t (*drain)( void );
+  short pollEvents;
+} zbSocGpioBackend_t;
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static uint64_t gpioNow( void );
+static void gpioRecordEdge( uint64_t timestampNs, uint8_t timestampValid, uint64_t now );
+
+static void gpioSysfsWrite( const char *path, const char *value );
+static int gpioSysfsOpen( const zbSocGpioConfig_t *config );
+static void gpioSysfsClose( void );
+static int32_t gpioSysfsGetSrdy( void );
+static uint32_t gpioSysfsDrain( void );
+
+static int gpioChardevOpen( const zbSocGpioConfig_t *config );
+static void gpioChardevClose( void );
+static int32_t gpioChardevGetSrdy( void );
+static uint32_t gpioChardevDrain( void );
+
+static int gpioMockOpen( const zbSocGpioConfig_t *config );
+static void gpioMockClose( void );
+static int32_t gpioMockGetSrdy( void );
+static uint32_t gpioMockDrain( void );
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static const zbSocGpioBackend_t gpioSysfsBackend =
+{
+  gpioSysfsOpen, gpioSysfsClose, gpioSysfsGetSrdy, gpioSysfsDrain, POLLPRI
+};
+
+static const zbSocGpioBackend_t gpioChardevBackend =
+{
+  gpioChardevOpen, gpioChardevClose, gpioChardevGetSrdy, gpioChardevDrain, POLLIN
+};
+
+static const zbSocGpioBackend_t gpioMockBackend =
+{
+  gpioMockOpen, gpioMockClose, gpioMockGetSrdy, gpioMockDrain, POLLIN
+};
+
+static const zbSocGpioBackend_t *gpioBackend = NULL;
+static zbSocGpioStats_t gpioStats;
+
+static int gpioSysfsSrdyFd = -1;
+
+static int gpioChardevSrdyFd = -1;
+static int gpioChardevEnableFd = -1;
+static uint8_t gpioChardevMonotonic; // timestamps are CLOCK_MONOTONIC, not from a HTE
+
+static int gpioMockFds[2] = { -1, -1 };
+static uint8_t gpioMockValue = 1;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      gpioNow
+ *
+ * @brief   get the monotonic time, the clock of the line event 
+ *          timestamps.
+ *
+ * @param   none
+ *
+ * @return  time in ns
+ */
+static uint64_t gpioNow( void )
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+/*********************************************************************
+ * @fn      gpioRecordEdge
+ *
+ * @brief   count a consumed edge and the time since it happened.
+ *
+ * @param   timestampNs - time of the edge
+ * @param   timestampValid - TRUE if the edge time is CLOCK_MONOTONIC
+ * @param   now - time it was consumed
+ *
+ * @return  none
+ */
+static void gpioRecordEdge( uint64_t timestampNs, uint8_t timestampValid, uint64_t now )
+{
+  uint64_t latency;
+
+  gpioStats.edges++;
+
+  if ((timestampValid) && (now >= timestampNs))
+  {
+    latency = now - timestampNs;
+    gpioStats.timestamped++;
+    gpioStats.latencySumNs += latency;
+    if (latency > gpioStats.latencyMaxNs)
+    {
+      gpioStats.latencyMaxNs = latency;
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      gpioSysfsWrite
+ *
+ * @brief   write a sysfs GPIO attribute.
+ *
+ * @param   path - attribute file
+ * @param   value - value to write
+ *
+ * @return  none
+ */
+static void gpioSysfsWrite( const char *path, const char *value )
+{
+  int fd = open(path, O_WRONLY);
+
+  if (fd < 0)
+  {
+    perror(path);
+    return;
+  }
+
+  write(fd, value, strlen(value));
+  close(fd);
+}
+
+/*********************************************************************
+ * @fn      gpioSysfsOpen
+ *
+ * @brief   drive SPI enable high and set SRDY as an input signalling
+ *          its falling edge on the value file.
+ *
+ * @param   config - unused, the sysfs lines are fixed
+ *
+ * @return  fd of the SRDY value file, -1 on failure
+ */
+static int gpioSysfsOpen( const zbSocGpioConfig_t *config )
+{
+  gpioSysfsWrite(HAL_SPIENABLE_DIR, "out");
+  gpioSysfsWrite(HAL_SPIENABLE_VALUE, "1");
+
+  //SRDY is active low
+  gpioSysfsWrite(HAL_SRDY_DIR, "in");
+  gpioSysfsWrite(HAL_SRDY_EDGE, "falling");
+
+  //open the SRDY GPIO VALUE file so it can be poll'ed to using the file handle later
+  gpioSysfsSrdyFd = open(HAL_SRDY_VALUE, O_RDWR | O_NONBLOCK);
+  if (gpioSysfsSrdyFd < 0)
+  {
+    perror(HAL_SRDY_VALUE);
+  }
+
+  return gpioSysfsSrdyFd;
+}
+
+/*********************************************************************
+ * @fn      gpioSysfsClose
+ *
+ * @brief   close the SRDY value file.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void gpioSysfsClose( void )
+{
+  close(gpioSysfsSrdyFd);
+  gpioSysfsSrdyFd = -1;
+}
+
+/*********************************************************************
+ * @fn      gpioSysfsGetSrdy
+ *
+ * @brief   read the SRDY value file.
+ *
+ * @param   none
+ *
+ * @return  level of SRDY
+ */
+static int32_t gpioSysfsGetSrdy( void )
+{
+  char ch;
+
+  lseek(gpioSysfsSrdyFd, 0, SEEK_SET);
+  if (read(gpioSysfsSrdyFd, &ch, 1) != 1)
+  {
+    return -1;
+  }
+
+  //srdy will be '1' or '0' in Ascii
+  return ch - '0';
+}
+
+/*********************************************************************
+ * @fn      gpioSysfsDrain
+ *
+ * @brief   clear the POLLPRI of the value file. sysfs does not queue
+ *          edges, so none are counted.
+ *
+ * @param   none
+ *
+ * @return  0
+ */
+static uint32_t gpioSysfsDrain( void )
+{
+  gpioSysfsGetSrdy();
+
+  return 0;
+}
+
+#ifdef GPIO_V2_GET_LINE_IOCTL
+/*********************************************************************
+ * @fn      gpioChardevRequest
+ *
+ * @brief   request a line of a GPIO chip.
+ *
+ * @param   chipFd - fd of the GPIO chip
+ * @param   line - line offset
+ * @param   flags - GPIO_V2_LINE_FLAG_*
+ * @param   value - level of an output line
+ *
+ * @return  fd of the line, -1 on failure
+ */
+static int gpioChardevRequest( int chipFd, uint32_t line, uint64_t flags, uint8_t value )
+{
+  struct gpio_v2_line_request req;
+
+  memset(&req, 0, sizeof(req));
+  req.offsets[0] = line;
+  req.num_lines = 1;
+  strncpy(req.consumer, GPIO_CONSUMER, sizeof(req.consumer) - 1);
+  req.config.flags = flags;
+
+  if (flags & GPIO_V2_LINE_FLAG_OUTPUT)
+  {
+    req.config.num_attrs = 1;
+    req.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+    req.config.attrs[0].attr.values = value;
+    req.config.attrs[0].mask = 1;
+  }
+
+  if (ioctl(chipFd, GPIO_V2_GET_LINE_IOCTL, &req) < 0)
+  {
+    return -1;
+  }
+
+  return req.fd;
+}
+#endif
+
+/*********************************************************************
+ * @fn      gpioChardevOpen
+ *
+ * @brief   request SRDY as an input with falling edge events, and SPI
+ *          enable as an output driven high. The edges are timestamped
+ *          by the hardware timestamp engine of the chip if it has one,
+ *          by the kernel when the edge interrupt runs otherwise.
+ *
+ * @param   config - chip and lines
+ *
+ * @return  fd of the SRDY line events, -1 on failure
+ */
+static int gpioChardevOpen( const zbSocGpioConfig_t *config )
+{
+#ifdef GPIO_V2_GET_LINE_IOCTL
+  uint64_t flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_FALLING;
+  int chipFd;
+
+  chipFd = open(config->chip, O_RDWR | O_CLOEXEC);
+  if (chipFd < 0)
+  {
+    perror(config->chip);
+    return -1;
+  }
+
+  if (config->enableLine >= 0)
+  {
+    gpioChardevEnableFd = gpioChardevRequest(chipFd, config->enableLine, GPIO_V2_LINE_FLAG_OUTPUT, 1);
+    if (gpioChardevEnableFd < 0)
+    {
+      printf("gpioChardevOpen: SPI enable line %d - %s\n", config->enableLine, strerror(errno));
+    }
+  }
+
+  gpioChardevMonotonic = FALSE;
+  gpioChardevSrdyFd = gpioChardevRequest(chipFd, config->srdyLine, flags | GPIO_FLAG_EVENT_CLOCK_HTE, 0);
+  if (gpioChardevSrdyFd < 0)
+  {
+    gpioChardevMonotonic = TRUE;
+    gpioChardevSrdyFd = gpioChardevRequest(chipFd, config->srdyLine, flags, 0);
+  }
+
+  if (gpioChardevSrdyFd < 0)
+  {
+    printf("gpioChardevOpen: SRDY line %d - %s\n", config->srdyLine, strerror(errno));
+  }
+  else
+  {
+    fcntl(gpioChardevSrdyFd, F_SETFL, fcntl(gpioChardevSrdyFd, F_GETFL) | O_NONBLOCK);
+  }
+
+  close(chipFd);
+
+  return gpioChardevSrdyFd;
+#else
+  printf("gpioChardevOpen: built without the GPIO v2 character device API\n");
+
+  return -1;
+#endif
+}
+
+/*********************************************************************
+ * @fn      gpioChardevClose
+ *
+ * @brief   release the lines.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void gpioChardevClose( void )
+{
+  close(gpioChardevSrdyFd);
+  gpioChardevSrdyFd = -1;
+
+  if (gpioChardevEnableFd >= 0)
+  {
+    close(gpioChardevEnableFd);
+    gpioChardevEnableFd = -1;
+  }
+}
+
+/*********************************************************************
+ * @fn      gpioChardevGetSrdy
+ *
+ * @brief   get the level of the SRDY line.
+ *
+ * @param   none
+ *
+ * @return  level of SRDY, -1 on failure
+ */
+static int32_t gpioChardevGetSrdy( void )
+{
+#ifdef GPIO_V2_GET_LINE_IOCTL
+  struct gpio_v2_line_values values;
+
+  values.bits = 0;
+  values.mask = 1;
+  if (ioctl(gpioChardevSrdyFd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) < 0)
+  {
+    return -1;
+  }
+
+  return values.bits & 1;
+#else
+  return -1;
+#endif
+}
+
+/*********************************************************************
+ * @fn      gpioChardevDrain
+ *
+ * @brief   read the queued line events.
+ *
+ * @param   none
+ *
+ * @return  number of edges
+ */
+static uint32_t gpioChardevDrain( void )
+{
+  uint32_t count = 0;
+#ifdef GPIO_V2_GET_LINE_IOCTL
+  struct gpio_v2_line_event events[GPIO_EVENT_BATCH];
+  uint64_t now = gpioNow();
+  ssize_t bytesRead;
+  uint32_t i;
+
+  while ((bytesRead = read(gpioChardevSrdyFd, events, sizeof(events))) > 0)
+  {
+    for (i = 0; i < (bytesRead / sizeof(events[0])); i++)
+    {
+      gpioRecordEdge(events[i].timestamp_ns, gpioChardevMonotonic, now);
+      count++;
+    }
+  }
+#endif
+
+  return count;
+}
+
+/*********************************************************************
+ * @fn      gpioMockOpen
+ *
+ * @brief   create the pipe the mock edges are queued on, SRDY starts
+ *          deasserted.
+ *
+ * @param   config - unused
+ *
+ * @return  read end of the pipe, -1 on failure
+ */
+static int gpioMockOpen( const zbSocGpioConfig_t *config )
+{
+  if (pipe2(gpioMockFds, O_NONBLOCK | O_CLOEXEC) < 0)
+  {
+    perror("gpioMockOpen: pipe2");
+    return -1;
+  }
+
+  __atomic_store_n(&gpioMockValue, 1, __ATOMIC_SEQ_CST);
+
+  return gpioMockFds[0];
+}
+
+/*********************************************************************
+ * @fn      gpioMockClose
+ *
+ * @brief   close the pipe.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void gpioMockClose( void )
+{
+  close(gpioMockFds[0]);
+  close(gpioMockFds[1]);
+  gpioMockFds[0] = gpioMockFds[1] = -1;
+}
+
+/*********************************************************************
+ * @fn      gpioMockGetSrdy
+ *
+ * @brief   get the level the mock line is driven to.
+ *
+ * @param   none
+ *
+ * @return  level of SRDY
+ */
+static int32_t gpioMockGetSrdy( void )
+{
+  return __atomic_load_n(&gpioMockValue, __ATOMIC_SEQ_CST);
+}
+
+/*********************************************************************
+ * @fn      gpioMockDrain
+ *
+ * @brief   read the queued edge timestamps.
+ *
+ * @param   none
+ *
+ * @return  number of edges
+ */
+static uint32_t gpioMockDrain( void )
+{
+  uint64_t timestamps[GPIO_EVENT_BATCH];
+  uint64_t now = gpioNow();
+  ssize_t bytesRead;
+  uint32_t i, count = 0;
+
+  while ((bytesRead = read(gpioMockFds[0], timestamps, sizeof(timestamps))) > 0)
+  {
+    for (i = 0; i < (bytesRead / sizeof(timestamps[0])); i++)
+    {
+      gpioRecordEdge(timestamps[i], TRUE, now);
+      count++;
+    }
+  }
+
+  return count;
+}
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      zbSocGpioParse
+ *
+ * @brief   parse a GPIO backend, sysfs, mock or 
+ *          chardev=<chip>,<srdy line>[,<enable line>].
+ *
+ * @param   str - backend string
+ * @param   config - parsed config
+ *
+ * @return  0 on success, -1 if the string is invalid
+ */
+int32_t zbSocGpioParse( const char *str, zbSocGpioConfig_t *config )
+{
+  unsigned int srdyLine;
+  int enableLine, len;
+
+  memset(config, 0, sizeof(*config));
+  config->enableLine = -1;
+
+  if (!strcmp(str, "sysfs"))
+  {
+    config->backend = ZBSOC_GPIO_SYSFS;
+    return 0;
+  }
+
+  if (!strcmp(str, "mock"))
+  {
+    config->backend = ZBSOC_GPIO_MOCK;
+    return 0;
+  }
+
+  //63 is ZBSOC_GPIO_MAX_CHIP_LEN - 1
+  if (sscanf(str, "chardev=%63[^,],%u%n", config->chip, &srdyLine, &len) != 2)
+  {
+    return -1;
+  }
+  str += len;
+
+  if ((*str == ',') && (sscanf(str, ",%d%n", &enableLine, &len) == 1) && (enableLine >= 0))
+  {
+    config->enableLine = enableLine;
+    str += len;
+  }
+
+  if (*str != '\0')
+  {
+    return -1;
+  }
+
+  config->backend = ZBSOC_GPIO_CHARDEV;
+  config->srdyLine = srdyLine;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      zbSocGpioOpen
+ *
+ * @brief   set up SRDY as an input with falling edge events. The fd 
+ *          signals zbSocGpioPollEvents on an edge, so the I/O thread 
+ *          sleeps in poll until the SoC has a frame.
+ *
+ * @param   config - backend and lines
+ *
+ * @return  fd to poll, -1 on failure
+ */
+int zbSocGpioOpen( const zbSocGpioConfig_t *config )
+{
+  int fd;
+
+  switch (config->backend)
+  {
+    case ZBSOC_GPIO_CHARDEV:
+      gpioBackend = &gpioChardevBackend;
+      break;
+    case ZBSOC_GPIO_MOCK:
+      gpioBackend = &gpioMockBackend;
+      break;
+    default:
+      gpioBackend = &gpioSysfsBackend;
+      break;
+  }
+
+  memset(&gpioStats, 0, sizeof(gpioStats));
+
+  fd = gpioBackend->open(config);
+  if (fd < 0)
+  {
+    gpioBackend = NULL;
+  }
+
+  return fd;
+}
+
+/*********************************************************************
+ * @fn      zbSocGpioClose
+ *
+ * @brief   release the lines.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void zbSocGpioClose( void )
+{
+  if (gpioBackend != NULL)
+  {
+    gpioBackend->close();
+    gpioBackend = NULL;
+  }
+}
+
+/*********************************************************************
+ * @fn      zbSocGpioPollEvents
+ *
+ * @brief   get the poll events the fd signals an edge with.
+ *
+ * @param   none
+ *
+ * @return  POLLPRI or POLLIN
+ */
+short zbSocGpioPollEvents( void )
+{
+  return (gpioBackend != NULL) ? gpioBackend->pollEvents : POLLIN;
+}
+
+/*********************************************************************
+ * @fn      zbSocGpioGetSrdy
+ *
+ * @brief   get the level of SRDY.
+ *
+ * @param   none
+ *
+ * @return  0 while asserted, 1 while deasserted or not open
+ */
+int32_t zbSocGpioGetSrdy( void )
+{
+  int32_t srdy;
+
+  if (gpioBackend == NULL)
+  {
+    return 1;
+  }
+
+  srdy = gpioBackend->getSrdy();
+
+  return (srdy < 0) ? 1 : srdy;
+}
+
+/*********************************************************************
+ * @fn      zbSocGpioDrain
+ *
+ * @brief   consume the pending edge events so the fd stops signalling.
+ *
+ * @param   none
+ *
+ * @return  number of edges consumed
+ */
+uint32_t zbSocGpioDrain( void )
+{
+  uint32_t count;
+
+  if (gpioBackend == NULL)
+  {
+    return 0;
+  }
+
+  count = gpioBackend->drain();
+  if (count > 0)
+  {
+    gpioStats.wakeups++;
+  }
+
+  return count;
+}
+
+/*********************************************************************
+ * @fn      zbSocGpioGetStats
+ *
+ * @brief   get the edge and latency counters.
+ *
+ * @param   stats - counters are copied here
+ *
+ * @return  none
+ */
+void zbSocGpioGetStats( zbSocGpioStats_t *stats )
+{
+  *stats = gpioStats;
+}
+
+/*********************************************************************
+ * @fn      zbSocGpioMockSet
+ *
+ * @brief   drive the mock SRDY line, e.g. from a test or bench thread.
+ *          A falling edge queues a timestamped event.
+ *
+ * @param   value - level of the line
+ *
+ * @return  none
+ */
+void zbSocGpioMockSet( uint8_t value )
+{
+  uint64_t timestamp;
+
+  if ((__atomic_exchange_n(&gpioMockValue, value, __ATOMIC_SEQ_CST)) && (!value))
+  {
+    timestamp = gpioNow();
+    write(gpioMockFds[1], &timestamp, sizeof(timestamp));
+  }
+}
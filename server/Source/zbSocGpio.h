@@ -0,0 +1,132 @@
+/**************************************************************************************************
+ * Filename:       zbSocGpio.h
+ * Description:    SRDY GPIO of the SPI transport, sysfs, GPIO character device and mock backends.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+ 
+ 
+
+#ifndef ZBSOCGPIO_H
+#define ZBSOCGPIO_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define ZBSOC_GPIO_SYSFS   0 // /sys/class/gpio, the value file signals POLLPRI
+#define ZBSOC_GPIO_CHARDEV 1 // /dev/gpiochipN line events, timestamped
+#define ZBSOC_GPIO_MOCK    2 // driven with zbSocGpioMockSet, no hardware
+
+#define ZBSOC_GPIO_MAX_CHIP_LEN 64
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint8_t backend;
+  char chip[ZBSOC_GPIO_MAX_CHIP_LEN]; // chardev: GPIO chip device
+  uint32_t srdyLine;                  // chardev: SRDY line offset
+  int32_t enableLine;                 // chardev: SPI enable line offset, -1 for none
+} zbSocGpioConfig_t;
+
+typedef struct
+{
+  uint64_t edges;        // SRDY falling edges consumed
+  uint64_t wakeups;      // drains that consumed an edge
+  uint64_t timestamped;  // edges the latency is known of
+  uint64_t latencySumNs; // edge to drain
+  uint64_t latencyMaxNs;
+} zbSocGpioStats_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * zbSocGpioParse - parse sysfs, mock or chardev=<chip>,<srdy line>[,<enable line>].
+ */
+int32_t zbSocGpioParse( const char *str, zbSocGpioConfig_t *config );
+
+/*
+ * zbSocGpioOpen - set up SRDY as an input with falling edge events, returns the fd to poll.
+ */
+int zbSocGpioOpen( const zbSocGpioConfig_t *config );
+
+/*
+ * zbSocGpioClose - release the lines.
+ */
+void zbSocGpioClose( void );
+
+/*
+ * zbSocGpioPollEvents - poll events the fd signals an edge with.
+ */
+short zbSocGpioPollEvents( void );
+
+/*
+ * zbSocGpioGetSrdy - level of SRDY, 0 while asserted.
+ */
+int32_t zbSocGpioGetSrdy( void );
+
+/*
+ * zbSocGpioDrain - consume the pending edge events, returns how many.
+ */
+uint32_t zbSocGpioDrain( void );
+
+/*
+ * zbSocGpioGetStats - edge and latency counters.
+ */
+void zbSocGpioGetStats( zbSocGpioStats_t *stats );
+
+/*
+ * zbSocGpioMockSet - drive the mock SRDY line, a falling edge queues an event.
+ */
+void zbSocGpioMockSet( uint8_t value );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZBSOCGPIO_H */
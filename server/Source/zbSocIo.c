@@ -0,0 +1,604 @@
+/**************************************************************************************************
+ * Filename:       zbSocIo.c
+ * Description:    ZigBee SoC I/O thread and the rings between it and the main loop.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+
+#include "zbSocIo.h"
+#include "zbSocTransport.h"
+#include "zbSocCmd.h"
+#include "zbSocMtParser.h"
+#include "hal_types.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define ZBSOC_IO_CACHE_LINE 64
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint16_t len;
+  uint8_t data[ZBSOC_IO_MAX_FRAME_LEN];
+} zbSocIoSlot_t;
+
+// Single producer / single consumer ring of MT frames. The producer owns
+// tail and the consumer owns head, each only reads the other's index.
+typedef struct
+{
+  uint32_t head __attribute__ ((aligned (ZBSOC_IO_CACHE_LINE)));
+  uint32_t tail __attribute__ ((aligned (ZBSOC_IO_CACHE_LINE)));
+  uint32_t waiting __attribute__ ((aligned (ZBSOC_IO_CACHE_LINE))); // producer is waiting for a free slot
+  uint32_t mask;
+  int spaceFd; // signalled when a slot is freed while the producer waits
+  zbSocIoSlot_t *slots;
+} zbSocIoRing_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static zbSocIoRing_t zbSocIoRxRing; // I/O thread -> main loop
+static zbSocIoRing_t zbSocIoTxRing; // main loop -> I/O thread
+
+static int zbSocIoRxFd = -1; // frames queued on the Rx ring
+static int zbSocIoTxFd = -1; // frames queued on the Tx ring, or stop requested
+
+static zbSocIoRxCb_t zbSocIoRxCb;
+
+static pthread_t zbSocIoThread;
+static uint8_t zbSocIoRunning = FALSE;
+static uint32_t zbSocIoStopping = FALSE;
+
+// Bytes read from the transport and the deframer state, only used by
+// the I/O thread
+static zbSocMtParser_t zbSocIoParser;
+static uint64_t zbSocIoRxErrors;
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static int32_t zbSocIoRingInit( zbSocIoRing_t *ring, uint32_t numSlots );
+static zbSocIoSlot_t *zbSocIoRingReserve( zbSocIoRing_t *ring );
+static void zbSocIoRingCommit( zbSocIoRing_t *ring );
+static zbSocIoSlot_t *zbSocIoRingFront( zbSocIoRing_t *ring );
+static void zbSocIoRingRelease( zbSocIoRing_t *ring );
+static void zbSocIoSignal( int fd );
+static void zbSocIoDrainFd( int fd );
+static uint8_t zbSocIoDeframe( uint8_t *pushed );
+static uint8_t zbSocIoReadTransport( void );
+static void zbSocIoFlushTx( void );
+static void *zbSocIoThreadFunc( void *arg );
+
+/*********************************************************************
+ * FUNCTIONS
+ *********************************************************************/
+
+/*********************************************************************
+ * @fn      zbSocIoRingInit
+ *
+ * @brief   allocates a ring.
+ *
+ * @param   ring - ring to initialise
+ * @param   numSlots - number of frames, power of 2
+ *
+ * @return  0 on success, -1 on failure
+ */
+static int32_t zbSocIoRingInit( zbSocIoRing_t *ring, uint32_t numSlots )
+{
+  memset(ring, 0, sizeof(zbSocIoRing_t));
+  ring->mask = numSlots - 1;
+  ring->slots = calloc(numSlots, sizeof(zbSocIoSlot_t));
+  ring->spaceFd = eventfd(0, EFD_NONBLOCK);
+
+  if ((ring->slots == NULL) || (ring->spaceFd < 0))
+  {
+    return -1;
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      zbSocIoRingReserve
+ *
+ * @brief   get the next free slot, producer only.
+ *
+ * @param   ring - ring
+ *
+ * @return  slot, NULL if the ring is full
+ */
+static zbSocIoSlot_t *zbSocIoRingReserve( zbSocIoRing_t *ring )
+{
+  uint32_t tail = ring->tail;
+  uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST);
+
+  if ((tail - head) > ring->mask)
+  {
+    return NULL;
+  }
+
+  return &ring->slots[tail & ring->mask];
+}
+
+/*********************************************************************
+ * @fn      zbSocIoRingCommit
+ *
+ * @brief   publish the reserved slot to the consumer, producer only.
+ *
+ * @param   ring - ring
+ *
+ * @return  none
+ */
+static void zbSocIoRingCommit( zbSocIoRing_t *ring )
+{
+  __atomic_store_n(&ring->tail, ring->tail + 1, __ATOMIC_RELEASE);
+}
+
+/*********************************************************************
+ * @fn      zbSocIoRingFront
+ *
+ * @brief   get the oldest queued frame, consumer only.
+ *
+ * @param   ring - ring
+ *
+ * @return  slot, NULL if the ring is empty
+ */
+static zbSocIoSlot_t *zbSocIoRingFront( zbSocIoRing_t *ring )
+{
+  uint32_t head = ring->head;
+
+  if (head == __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE))
+  {
+    return NULL;
+  }
+
+  return &ring->slots[head & ring->mask];
+}
+
+/*********************************************************************
+ * @fn      zbSocIoRingRelease
+ *
+ * @brief   free the oldest queued frame and wake up the producer if it
+ *          is waiting for a slot, consumer only.
+ *
+ * @param   ring - ring
+ *
+ * @return  none
+ */
+static void zbSocIoRingRelease( zbSocIoRing_t *ring )
+{
+  __atomic_store_n(&ring->head, ring->head + 1, __ATOMIC_SEQ_CST);
+
+  if (__atomic_exchange_n(&ring->waiting, 0, __ATOMIC_SEQ_CST))
+  {
+    zbSocIoSignal(ring->spaceFd);
+  }
+}
+
+/*********************************************************************
+ * @fn      zbSocIoSignal
+ *
+ * @brief   wake up the thread waiting on an eventfd.
+ */
+static void zbSocIoSignal( int fd )
+{
+  uint64_t one = 1;
+
+  write(fd, &one, sizeof(one));
+}
+
+/*********************************************************************
+ * @fn      zbSocIoDrainFd
+ *
+ * @brief   reset an eventfd after waking up on it.
+ */
+static void zbSocIoDrainFd( int fd )
+{
+  uint64_t count;
+
+  read(fd, &count, sizeof(count));
+}
+
+/*********************************************************************
+ * @fn      zbSocIoInit
+ *
+ * @brief   creates the rings and the wakeup eventfd's, can be called
+ *          again to change the Rx callback.
+ *
+ * @param   rxCb - called on the main loop for every received frame
+ *
+ * @return  0 on success, -1 on failure
+ */
+int32_t zbSocIoInit( zbSocIoRxCb_t rxCb )
+{
+  zbSocIoRxCb = rxCb;
+
+  if (zbSocIoRxFd >= 0)
+  {
+    return 0;
+  }
+
+  zbSocMtParserInit(&zbSocIoParser);
+
+  if ((zbSocIoRingInit(&zbSocIoRxRing, ZBSOC_IO_RX_RING_LEN) < 0) ||
+      (zbSocIoRingInit(&zbSocIoTxRing, ZBSOC_IO_TX_RING_LEN) < 0))
+  {
+    printf("zbSocIoInit: failed to allocate the rings\n");
+    return -1;
+  }
+
+  zbSocIoRxFd = eventfd(0, EFD_NONBLOCK);
+  zbSocIoTxFd = eventfd(0, EFD_NONBLOCK);
+  if ((zbSocIoRxFd < 0) || (zbSocIoTxFd < 0))
+  {
+    printf("zbSocIoInit: eventfd failed - %s\n", strerror(errno));
+    return -1;
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      zbSocIoStart
+ *
+ * @brief   starts the I/O thread, from here on it owns the transport.
+ *
+ * @param   none
+ *
+ * @return  0 on success, -1 on failure
+ */
+int32_t zbSocIoStart( void )
+{
+  if (zbSocIoRunning)
+  {
+    return 0;
+  }
+
+  //a reopened port starts on a frame boundary
+  zbSocMtParserReset(&zbSocIoParser);
+  __atomic_store_n(&zbSocIoStopping, FALSE, __ATOMIC_SEQ_CST);
+
+  if (pthread_create(&zbSocIoThread, NULL, zbSocIoThreadFunc, NULL) != 0)
+  {
+    printf("zbSocIoStart: failed to create the I/O thread\n");
+    return -1;
+  }
+
+  zbSocIoRunning = TRUE;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      zbSocIoStop
+ *
+ * @brief   writes the frames still queued and stops the I/O thread, the
+ *          transport is owned by the caller again afterwards.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void zbSocIoStop( void )
+{
+  if (!zbSocIoRunning)
+  {
+    return;
+  }
+
+  __atomic_store_n(&zbSocIoStopping, TRUE, __ATOMIC_SEQ_CST);
+  zbSocIoSignal(zbSocIoTxFd);
+  pthread_join(zbSocIoThread, NULL);
+
+  zbSocIoRunning = FALSE;
+}
+
+/*********************************************************************
+ * @fn      zbSocIoWrite
+ *
+ * @brief   queues a frame for the I/O thread. Only waits if the Tx ring
+ *          is full, i.e. the transport is not keeping up.
+ *
+ * @param   buf - MT frame
+ * @param   len - length of the frame
+ *
+ * @return  none
+ */
+void zbSocIoWrite( uint8_t *buf, uint8_t len )
+{
+  zbSocIoSlot_t *slot;
+
+  if (!zbSocIoRunning)
+  {
+    zbSocTransportWrite(buf, len);
+    return;
+  }
+
+  while ((slot = zbSocIoRingReserve(&zbSocIoTxRing)) == NULL)
+  {
+    struct pollfd pollFd = { zbSocIoTxRing.spaceFd, POLLIN, 0 };
+
+    __atomic_store_n(&zbSocIoTxRing.waiting, 1, __ATOMIC_SEQ_CST);
+    if ((slot = zbSocIoRingReserve(&zbSocIoTxRing)) != NULL)
+    {
+      break;
+    }
+    poll(&pollFd, 1, -1);
+    zbSocIoDrainFd(zbSocIoTxRing.spaceFd);
+  }
+
+  memcpy(slot->data, buf, len);
+  slot->len = len;
+  zbSocIoRingCommit(&zbSocIoTxRing);
+
+  zbSocIoSignal(zbSocIoTxFd);
+}
+
+/*********************************************************************
+ * @fn      zbSocIoGetRxFd
+ *
+ * @brief   get the eventfd to wait on for received frames.
+ *
+ * @param   none
+ *
+ * @return  fd
+ */
+int zbSocIoGetRxFd( void )
+{
+  return zbSocIoRxFd;
+}
+
+/*********************************************************************
+ * @fn      zbSocIoProcessRx
+ *
+ * @brief   hands the queued frames to the Rx callback, called on the main
+ *          loop when the Rx eventfd is readable.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void zbSocIoProcessRx( void )
+{
+  zbSocIoSlot_t *slot;
+
+  zbSocIoDrainFd(zbSocIoRxFd);
+
+  while ((slot = zbSocIoRingFront(&zbSocIoRxRing)) != NULL)
+  {
+    if (zbSocIoRxCb)
+    {
+      zbSocIoRxCb(slot->data, slot->len);
+    }
+    zbSocIoRingRelease(&zbSocIoRxRing);
+  }
+}
+
+/*********************************************************************
+ * @fn      zbSocIoGetRxStats
+ *
+ * @brief   get the deframer counters. They are updated by the I/O thread
+ *          without a lock, so the copy is only a consistent snapshot
+ *          while the thread is stopped.
+ *
+ * @param   stats - set to the counters
+ *
+ * @return  none
+ */
+void zbSocIoGetRxStats( zbSocMtParserStats_t *stats )
+{
+  memcpy(stats, &zbSocIoParser.stats, sizeof(zbSocMtParserStats_t));
+}
+
+/*********************************************************************
+ * @fn      zbSocIoDeframe
+ *
+ * @brief   copies the frames the parser has completed into the Rx ring,
+ *          I/O thread only.
+ *
+ * @param   pushed - set if a frame was queued
+ *
+ * @return  FALSE if the Rx ring is full and bytes are left
+ */
+static uint8_t zbSocIoDeframe( uint8_t *pushed )
+{
+  zbSocIoSlot_t *slot;
+  uint8_t *frame;
+  uint16_t len;
+  uint64_t errors;
+
+  //reserve first, a frame taken from the parser has to go somewhere
+  while ((slot = zbSocIoRingReserve(&zbSocIoRxRing)) != NULL)
+  {
+    if (!zbSocMtParserNext(&zbSocIoParser, &frame, &len))
+    {
+      break;
+    }
+
+    memcpy(slot->data, frame, len);
+    slot->len = len;
+    zbSocIoRingCommit(&zbSocIoRxRing);
+    *pushed = TRUE;
+  }
+
+  errors = zbSocIoParser.stats.fcsErrors + zbSocIoParser.stats.lenErrors;
+  if (errors != zbSocIoRxErrors)
+  {
+    printf("zbSocIoDeframe: dropped %llu corrupt MT frame(s), %llu bytes discarded in total\n",
+      (unsigned long long)(errors - zbSocIoRxErrors), 
+      (unsigned long long)zbSocIoParser.stats.discardedBytes);
+    zbSocIoRxErrors = errors;
+  }
+
+  //the main loop is behind, wait for a slot
+  return ((slot != NULL) || (!zbSocMtParserPending(&zbSocIoParser)));
+}
+
+/*********************************************************************
+ * @fn      zbSocIoReadTransport
+ *
+ * @brief   read what the transport has into the parser.
+ *
+ * @return  TRUE if bytes were read
+ */
+static uint8_t zbSocIoReadTransport( void )
+{
+  uint32_t space;
+  uint8_t *buf = zbSocMtParserGetSpace(&zbSocIoParser, &space);
+  int32_t bytesRead = zbSocTransportRead(buf, space);
+
+  if (bytesRead <= 0)
+  {
+    return FALSE;
+  }
+
+  zbSocMtParserCommit(&zbSocIoParser, bytesRead);
+
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn      zbSocIoFlushTx
+ *
+ * @brief   write the queued frames to the transport, I/O thread only.
+ */
+static void zbSocIoFlushTx( void )
+{
+  zbSocIoSlot_t *slot;
+
+  while ((slot = zbSocIoRingFront(&zbSocIoTxRing)) != NULL)
+  {
+    zbSocTransportWrite(slot->data, slot->len);
+    zbSocIoRingRelease(&zbSocIoTxRing);
+  }
+}
+
+/*********************************************************************
+ * @fn      zbSocIoThreadFunc
+ *
+ * @brief   the I/O thread, waits on the transport and the Tx eventfd.
+ *          Stops reading the transport while the Rx ring is full so the
+ *          main loop is never overrun, and keeps writing meanwhile.
+ */
+static void *zbSocIoThreadFunc( void *arg )
+{
+  while (!__atomic_load_n(&zbSocIoStopping, __ATOMIC_SEQ_CST))
+  {
+    struct pollfd pollFds[2];
+    uint8_t pushed = FALSE, blocked;
+
+    //deframe what was read, then read until the transport is empty
+    do
+    {
+      blocked = !zbSocIoDeframe(&pushed);
+    } while ((!blocked) && (zbSocIoReadTransport()));
+
+    if (pushed)
+    {
+      zbSocIoSignal(zbSocIoRxFd);
+    }
+
+    if (blocked)
+    {
+      __atomic_store_n(&zbSocIoRxRing.waiting, 1, __ATOMIC_SEQ_CST);
+      if (zbSocIoRingReserve(&zbSocIoRxRing) != NULL)
+      {
+        continue;
+      }
+    }
+
+    //consume the edges, one that came after the transport was read is
+    //for a frame still waiting
+    if ((zbSocTransportReadiness() == ZBSOC_TRANSPORT_EDGE) && 
+        (zbSocTransportPoll()) && (!blocked))
+    {
+      continue;
+    }
+
+    pollFds[0].fd = zbSocIoTxFd;
+    pollFds[0].events = POLLIN;
+    if (blocked)
+    {
+      pollFds[1].fd = zbSocIoRxRing.spaceFd;
+      pollFds[1].events = POLLIN;
+    }
+    else
+    {
+      //-1, e.g. a closed connection, is not polled
+      pollFds[1].fd = zbSocTransportFd();
+      pollFds[1].events = zbSocTransportPollEvents();
+    }
+
+    //a read coalescing profile may hold back the last bytes of a frame
+    if (poll(pollFds, 2, blocked ? -1 : zbSocTransportReadTimeout()) < 0)
+    {
+      if (errno != EINTR)
+      {
+        printf("zbSocIoThreadFunc: poll failed - %s\n", strerror(errno));
+      }
+      continue;
+    }
+
+    if (pollFds[0].revents & POLLIN)
+    {
+      zbSocIoDrainFd(zbSocIoTxFd);
+      zbSocIoFlushTx();
+    }
+
+    if ((blocked) && (pollFds[1].revents & POLLIN))
+    {
+      zbSocIoDrainFd(zbSocIoRxRing.spaceFd);
+    }
+  }
+
+  //frames queued before the stop still go out
+  zbSocIoFlushTx();
+
+  return NULL;
+}
@@ -0,0 +1,116 @@
+/**************************************************************************************************
+ * Filename:       zbSocIo.h
+ * Description:    ZigBee SoC I/O thread and the rings between it and the main loop.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+
+#ifndef ZBSOCIO_H
+#define ZBSOCIO_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+#include "zbSocMtParser.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// SOF, len, cmd0, cmd1, up to 255 bytes of payload and the FCS
+#define ZBSOC_IO_MAX_FRAME_LEN (1 + 1 + 2 + 255 + 1)
+
+// Frames each ring can hold, must be a power of 2
+#define ZBSOC_IO_RX_RING_LEN 64
+#define ZBSOC_IO_TX_RING_LEN 64
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Called on the main loop for every MT frame received from the SoC,
+// frame starts with the SOF and ends with the FCS
+typedef void (*zbSocIoRxCb_t)( uint8_t *frame, uint16_t len );
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * zbSocIoInit - creates the rings and the wakeup eventfd's.
+ */
+int32_t zbSocIoInit( zbSocIoRxCb_t rxCb );
+
+/*
+ * zbSocIoStart - starts the I/O thread on the open transport.
+ */
+int32_t zbSocIoStart( void );
+
+/*
+ * zbSocIoStop - sends the queued frames and stops the I/O thread.
+ */
+void zbSocIoStop( void );
+
+/*
+ * zbSocIoWrite - queues a frame for the SoC, written directly if the thread is not running.
+ */
+void zbSocIoWrite( uint8_t *buf, uint8_t len );
+
+/*
+ * zbSocIoGetRxFd - eventfd that is readable while received frames are queued.
+ */
+int zbSocIoGetRxFd( void );
+
+/*
+ * zbSocIoProcessRx - hands the queued frames to the Rx callback.
+ */
+void zbSocIoProcessRx( void );
+
+/*
+ * zbSocIoGetRxStats - throughput and error counters of the Rx deframer.
+ */
+void zbSocIoGetRxStats( zbSocMtParserStats_t *stats );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZBSOCIO_H */
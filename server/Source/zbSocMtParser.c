@@ -0,0 +1,293 @@
+/**************************************************************************************************
+ * Filename:       zbSocMtParser.c
+ * Description:    Zero copy MT frame parser for the bytes read from the ZigBee SoC.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include "zbSocMtParser.h"
+#include "hal_types.h"
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef enum
+{
+  zbSocMtParserSteSOF,
+  zbSocMtParserSteLen,
+  zbSocMtParserSteCmd0,
+  zbSocMtParserSteCmd1,
+  zbSocMtParserSteData,
+  zbSocMtParserSteFcs
+} zbSocMtParserSte_t;
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static void zbSocMtParserResync( zbSocMtParser_t *parser );
+
+/*********************************************************************
+ * FUNCTIONS
+ *********************************************************************/
+
+/*********************************************************************
+ * @fn      zbSocMtParserInit
+ *
+ * @brief   empties the parser and clears the counters.
+ *
+ * @param   parser - parser
+ *
+ * @return  none
+ */
+void zbSocMtParserInit( zbSocMtParser_t *parser )
+{
+  memset(&parser->stats, 0, sizeof(zbSocMtParserStats_t));
+  zbSocMtParserReset(parser);
+}
+
+/*********************************************************************
+ * @fn      zbSocMtParserReset
+ *
+ * @brief   drops the buffered bytes so parsing starts on the next SOF,
+ *          the counters are kept.
+ *
+ * @param   parser - parser
+ *
+ * @return  none
+ */
+void zbSocMtParserReset( zbSocMtParser_t *parser )
+{
+  parser->head = parser->scan = parser->tail = 0;
+  parser->ste = zbSocMtParserSteSOF;
+  parser->fcs = 0;
+  parser->needed = 0;
+}
+
+/*********************************************************************
+ * @fn      zbSocMtParserGetSpace
+ *
+ * @brief   get the free space at the end of the buffer. Moves the frame
+ *          being parsed to the start of the buffer first if less than a
+ *          maximum size frame fits behind it, so frames never wrap.
+ *          Invalidates the frames returned by zbSocMtParserNext.
+ *
+ * @param   parser - parser
+ * @param   len - set to the number of bytes that can be read
+ *
+ * @return  where to read to
+ */
+uint8_t *zbSocMtParserGetSpace( zbSocMtParser_t *parser, uint32_t *len )
+{
+  if ((parser->head > 0) &&
+      ((ZBSOC_MT_PARSER_BUF_LEN - parser->tail) < (ZBSOC_MT_MAX_PAYLOAD + ZBSOC_MT_FRAME_OVERHEAD)))
+  {
+    uint32_t keep = parser->tail - parser->head;
+
+    memmove(parser->buf, &parser->buf[parser->head], keep);
+    parser->scan -= parser->head;
+    parser->tail = keep;
+    parser->head = 0;
+  }
+
+  *len = ZBSOC_MT_PARSER_BUF_LEN - parser->tail;
+
+  return &parser->buf[parser->tail];
+}
+
+/*********************************************************************
+ * @fn      zbSocMtParserCommit
+ *
+ * @brief   adds the bytes read into the space from zbSocMtParserGetSpace.
+ *
+ * @param   parser - parser
+ * @param   len - number of bytes read
+ *
+ * @return  none
+ */
+void zbSocMtParserCommit( zbSocMtParser_t *parser, uint32_t len )
+{
+  if (len == 0)
+  {
+    return;
+  }
+
+  parser->tail += len;
+  parser->stats.bytes += len;
+  parser->stats.fills++;
+}
+
+/*********************************************************************
+ * @fn      zbSocMtParserResync
+ *
+ * @brief   drops the SOF of a corrupt frame and hunts for the next SOF
+ *          from the byte after it, so a good frame inside the corrupt one
+ *          is not lost.
+ */
+static void zbSocMtParserResync( zbSocMtParser_t *parser )
+{
+  parser->stats.discardedBytes++;
+  parser->head++;
+  parser->scan = parser->head;
+  parser->ste = zbSocMtParserSteSOF;
+}
+
+/*********************************************************************
+ * @fn      zbSocMtParserNext
+ *
+ * @brief   parses the buffered bytes up to the end of the next frame with
+ *          a good FCS. The frame is returned in place and is valid until
+ *          the next call to zbSocMtParserGetSpace.
+ *
+ * @param   parser - parser
+ * @param   frame - set to the frame, starting with the SOF and ending
+ *                  with the FCS
+ * @param   len - set to the length of the frame
+ *
+ * @return  TRUE if a frame was returned, FALSE if more bytes are needed
+ */
+uint8_t zbSocMtParserNext( zbSocMtParser_t *parser, uint8_t **frame, uint16_t *len )
+{
+  uint8_t *buf = parser->buf;
+
+  while (parser->scan < parser->tail)
+  {
+    uint8_t ch = buf[parser->scan];
+
+    switch (parser->ste)
+    {
+      case zbSocMtParserSteSOF:
+      {
+        uint8_t *sof = memchr(&buf[parser->scan], ZBSOC_MT_SOF, parser->tail - parser->scan);
+
+        if (sof == NULL)
+        {
+          parser->stats.discardedBytes += parser->tail - parser->scan;
+          parser->head = parser->scan = parser->tail;
+          break;
+        }
+
+        parser->stats.discardedBytes += (sof - buf) - parser->scan;
+        parser->head = sof - buf;
+        parser->scan = parser->head + 1;
+        parser->ste = zbSocMtParserSteLen;
+        break;
+      }
+
+      case zbSocMtParserSteLen:
+        if (ch > ZBSOC_MT_MAX_PAYLOAD)
+        {
+          parser->stats.lenErrors++;
+          zbSocMtParserResync(parser);
+          break;
+        }
+        parser->needed = ch;
+        parser->fcs = ch;
+        parser->scan++;
+        parser->ste = zbSocMtParserSteCmd0;
+        break;
+
+      case zbSocMtParserSteCmd0:
+        parser->fcs ^= ch;
+        parser->scan++;
+        parser->ste = zbSocMtParserSteCmd1;
+        break;
+
+      case zbSocMtParserSteCmd1:
+        parser->fcs ^= ch;
+        parser->scan++;
+        parser->ste = (parser->needed) ? zbSocMtParserSteData : zbSocMtParserSteFcs;
+        break;
+
+      case zbSocMtParserSteData:
+      {
+        //take as much of the payload as has been read in one go
+        uint32_t avail = parser->tail - parser->scan;
+        uint32_t n = (parser->needed < avail) ? parser->needed : avail;
+        uint8_t *p = &buf[parser->scan], *end = p + n;
+        uint8_t fcs = parser->fcs;
+
+        while (p < end)
+        {
+          fcs ^= *p++;
+        }
+
+        parser->fcs = fcs;
+        parser->scan += n;
+        parser->needed -= n;
+        if (parser->needed == 0)
+        {
+          parser->ste = zbSocMtParserSteFcs;
+        }
+        break;
+      }
+
+      case zbSocMtParserSteFcs:
+        if (ch != parser->fcs)
+        {
+          parser->stats.fcsErrors++;
+          zbSocMtParserResync(parser);
+          break;
+        }
+        parser->scan++;
+        *frame = &buf[parser->head];
+        *len = parser->scan - parser->head;
+        parser->head = parser->scan;
+        parser->ste = zbSocMtParserSteSOF;
+        parser->stats.frames++;
+        return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/*********************************************************************
+ * @fn      zbSocMtParserPending
+ *
+ * @brief   check for bytes that have not been parsed yet.
+ *
+ * @param   parser - parser
+ *
+ * @return  TRUE if zbSocMtParserNext has bytes to look at
+ */
+uint8_t zbSocMtParserPending( zbSocMtParser_t *parser )
+{
+  return (parser->scan < parser->tail);
+}
@@ -0,0 +1,133 @@
+/**************************************************************************************************
+ * Filename:       zbSocMtParser.h
+ * Description:    Zero copy MT frame parser for the bytes read from the ZigBee SoC.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+ 
+
+#ifndef ZBSOCMTPARSER_H
+#define ZBSOCMTPARSER_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define ZBSOC_MT_SOF 0xFE
+
+// Largest payload the SoC sends (MT_RPC_DATA_MAX), a longer length byte
+// can only be corruption
+#define ZBSOC_MT_MAX_PAYLOAD 250
+
+// SOF, len, cmd0, cmd1 and the FCS around the payload
+#define ZBSOC_MT_FRAME_OVERHEAD 5
+
+// Bytes buffered by the parser, must hold a few maximum size frames
+#define ZBSOC_MT_PARSER_BUF_LEN 4096
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+  uint64_t bytes;          // bytes committed to the parser
+  uint64_t fills;          // non-empty commits, i.e. reads from the transport
+  uint64_t frames;         // frames with a good FCS
+  uint64_t fcsErrors;      // frames dropped for a bad FCS
+  uint64_t lenErrors;      // frames dropped for a length over ZBSOC_MT_MAX_PAYLOAD
+  uint64_t discardedBytes; // bytes skipped while hunting for the SOF
+} zbSocMtParserStats_t;
+
+typedef struct
+{
+  uint8_t buf[ZBSOC_MT_PARSER_BUF_LEN];
+  uint32_t head;   // start of the frame being parsed
+  uint32_t scan;   // next byte to look at
+  uint32_t tail;   // end of the buffered bytes
+  uint8_t ste;
+  uint8_t fcs;     // running XOR of len, cmd0, cmd1 and payload
+  uint8_t needed;  // payload bytes still to come
+  zbSocMtParserStats_t stats;
+} zbSocMtParser_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * zbSocMtParserInit - empties the parser and clears the counters.
+ */
+void zbSocMtParserInit( zbSocMtParser_t *parser );
+
+/*
+ * zbSocMtParserReset - drops the buffered bytes, e.g. when the port is reopened.
+ */
+void zbSocMtParserReset( zbSocMtParser_t *parser );
+
+/*
+ * zbSocMtParserGetSpace - free space to read the transport into.
+ */
+uint8_t *zbSocMtParserGetSpace( zbSocMtParser_t *parser, uint32_t *len );
+
+/*
+ * zbSocMtParserCommit - adds the bytes read into the free space.
+ */
+void zbSocMtParserCommit( zbSocMtParser_t *parser, uint32_t len );
+
+/*
+ * zbSocMtParserNext - gets the next complete frame, in place in the buffer.
+ */
+uint8_t zbSocMtParserNext( zbSocMtParser_t *parser, uint8_t **frame, uint16_t *len );
+
+/*
+ * zbSocMtParserPending - TRUE while there are bytes zbSocMtParserNext has not looked at.
+ */
+uint8_t zbSocMtParserPending( zbSocMtParser_t *parser );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZBSOCMTPARSER_H */
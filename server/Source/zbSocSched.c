@@ -0,0 +1,705 @@
+/**************************************************************************************************
+ * Filename:       zbSocSched.c
+ * Description:    Flow controlled, prioritised queue of the MT commands sent to the ZigBee SoC.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "zbSocSched.h"
+#include "zbSocIo.h"
+#include "reactor.h"
+#include "hal_types.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define ZBSOC_SCHED_SOF 0xFE
+
+#define ZBSOC_SCHED_CMD_TYPE_MASK  0xE0
+#define ZBSOC_SCHED_SUBSYSTEM_MASK 0x1F
+#define ZBSOC_SCHED_CMD_SREQ       0x20
+#define ZBSOC_SCHED_SYS_APP        0x09
+#define ZBSOC_SCHED_SYS_SBL        0x0D
+#define ZBSOC_SCHED_APP_MSG        0x00
+
+// MT_APP_MSG frame layout, see zbSocGetState
+#define ZBSOC_SCHED_APP_CLUSTER_IDX  8
+#define ZBSOC_SCHED_APP_ZCL_IDX      12
+#define ZBSOC_SCHED_APP_MIN_LEN      16
+
+// cluster id the gateway uses for its own commands, e.g. touchlink
+#define ZBSOC_SCHED_APP_MGMT_CLUSTER 0xFFFF
+
+#define ZBSOC_SCHED_ZCL_FRAME_TYPE_MASK 0x03
+#define ZBSOC_SCHED_ZCL_MANU_SPECIFIC   0x04
+#define ZBSOC_SCHED_ZCL_CMD_READ        0x00
+
+#define ZBSOC_SCHED_NONE (-1)
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef enum
+{
+  zbSocSchedSreq, // in flight until the SRSP
+  zbSocSchedAreq  // holds a window slot for ZBSOC_SCHED_AREQ_HOLD_MS
+} zbSocSchedType_t;
+
+typedef struct
+{
+  int16_t next;
+  uint8_t type;
+  uint8_t prio;
+  uint8_t retries;
+  uint8_t repeatable; // may be sent again after a timeout
+  uint16_t len;
+  uint64_t queued;   // CLOCK_MONOTONIC, us
+  uint64_t deadline; // timeout or end of hold in flight, earliest retry while queued
+  uint8_t frame[ZBSOC_IO_MAX_FRAME_LEN];
+} zbSocSchedEntry_t;
+
+typedef struct
+{
+  int16_t head;
+  int16_t tail;
+} zbSocSchedList_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static zbSocSchedEntry_t zbSocSchedEntries[ZBSOC_SCHED_QUEUE_LEN];
+static zbSocSchedList_t zbSocSchedFree;
+static zbSocSchedList_t zbSocSchedQueue[ZBSOC_SCHED_NUM_PRIOS];
+static zbSocSchedList_t zbSocSchedInFlight; // in the order sent
+
+static uint8_t zbSocSchedSreqWindow = ZBSOC_SCHED_DEFAULT_SREQ_WINDOW;
+static uint8_t zbSocSchedAreqWindow = ZBSOC_SCHED_DEFAULT_AREQ_WINDOW;
+
+static int32_t zbSocSchedTimer = -1;
+static zbSocSchedStats_t zbSocSchedStats;
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static void zbSocSchedPush( zbSocSchedList_t *list, int16_t idx );
+static void zbSocSchedPushFront( zbSocSchedList_t *list, int16_t idx );
+static int16_t zbSocSchedPop( zbSocSchedList_t *list );
+static void zbSocSchedUnlink( zbSocSchedList_t *list, int16_t prev, int16_t idx );
+static uint8_t zbSocSchedClassify( zbSocSchedEntry_t *entry );
+static void zbSocSchedAccount( int16_t idx, uint64_t now );
+static void zbSocSchedComplete( zbSocSchedList_t *list, int16_t prev, int16_t idx, uint8_t status );
+static void zbSocSchedRetry( int16_t idx, uint64_t now );
+static void zbSocSchedRun( void );
+static void zbSocSchedArmTimer( void );
+static void zbSocSchedTimerCb( void );
+
+/*********************************************************************
+ * FUNCTIONS
+ *********************************************************************/
+
+/*********************************************************************
+ * @fn      zbSocSchedPush
+ *
+ * @brief   append an entry to a list.
+ */
+static void zbSocSchedPush( zbSocSchedList_t *list, int16_t idx )
+{
+  zbSocSchedEntries[idx].next = ZBSOC_SCHED_NONE;
+
+  if (list->tail == ZBSOC_SCHED_NONE)
+  {
+    list->head = idx;
+  }
+  else
+  {
+    zbSocSchedEntries[list->tail].next = idx;
+  }
+  list->tail = idx;
+}
+
+/*********************************************************************
+ * @fn      zbSocSchedPushFront
+ *
+ * @brief   insert an entry at the head of a list.
+ */
+static void zbSocSchedPushFront( zbSocSchedList_t *list, int16_t idx )
+{
+  zbSocSchedEntries[idx].next = list->head;
+  list->head = idx;
+
+  if (list->tail == ZBSOC_SCHED_NONE)
+  {
+    list->tail = idx;
+  }
+}
+
+/*********************************************************************
+ * @fn      zbSocSchedPop
+ *
+ * @brief   remove the head of a list.
+ *
+ * @return  entry index, ZBSOC_SCHED_NONE if the list is empty
+ */
+static int16_t zbSocSchedPop( zbSocSchedList_t *list )
+{
+  int16_t idx = list->head;
+
+  if (idx != ZBSOC_SCHED_NONE)
+  {
+    zbSocSchedUnlink(list, ZBSOC_SCHED_NONE, idx);
+  }
+
+  return idx;
+}
+
+/*********************************************************************
+ * @fn      zbSocSchedUnlink
+ *
+ * @brief   remove an entry from a list.
+ *
+ * @param   list - list
+ * @param   prev - entry before idx, ZBSOC_SCHED_NONE for the head
+ * @param   idx - entry to remove
+ */
+static void zbSocSchedUnlink( zbSocSchedList_t *list, int16_t prev, int16_t idx )
+{
+  int16_t next = zbSocSchedEntries[idx].next;
+
+  if (prev == ZBSOC_SCHED_NONE)
+  {
+    list->head = next;
+  }
+  else
+  {
+    zbSocSchedEntries[prev].next = next;
+  }
+
+  if (list->tail == idx)
+  {
+    list->tail = prev;
+  }
+}
+
+/*********************************************************************
+ * @fn      zbSocSchedInit
+ *
+ * @brief   creates the timer and empties the queue, can be called again
+ *          when the port is reopened.
+ *
+ * @param   none
+ *
+ * @return  0 on success, -1 on failure
+ */
+int32_t zbSocSchedInit( void )
+{
+  int16_t idx;
+
+  zbSocSchedFree.head = zbSocSchedFree.tail = ZBSOC_SCHED_NONE;
+  zbSocSchedInFlight.head = zbSocSchedInFlight.tail = ZBSOC_SCHED_NONE;
+  for (idx = 0; idx < ZBSOC_SCHED_NUM_PRIOS; idx++)
+  {
+    zbSocSchedQueue[idx].head = zbSocSchedQueue[idx].tail = ZBSOC_SCHED_NONE;
+  }
+  for (idx = 0; idx < ZBSOC_SCHED_QUEUE_LEN; idx++)
+  {
+    zbSocSchedPush(&zbSocSchedFree, idx);
+  }
+
+  zbSocSchedStats.depth = 0;
+  zbSocSchedStats.sreqInFlight = 0;
+  zbSocSchedStats.areqInFlight = 0;
+
+  if (zbSocSchedTimer >= 0)
+  {
+    zbSocSchedArmTimer();
+    return 0;
+  }
+
+  zbSocSchedTimer = reactorAddTimer(zbSocSchedTimerCb);
+  if (zbSocSchedTimer < 0)
+  {
+    return -1;
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      zbSocSchedSetWindow
+ *
+ * @brief   sets the number of SREQs that may be in flight at the SoC
+ *          and of AREQs sent per ZBSOC_SCHED_AREQ_HOLD_MS.
+ *
+ * @param   sreqWindow - SREQs awaiting their SRSP, 0 to keep
+ * @param   areqWindow - AREQs, 0 to keep
+ *
+ * @return  none
+ */
+void zbSocSchedSetWindow( uint8_t sreqWindow, uint8_t areqWindow )
+{
+  if ((sreqWindow > 0) && (sreqWindow <= ZBSOC_SCHED_MAX_WINDOW))
+  {
+    zbSocSchedSreqWindow = sreqWindow;
+  }
+  if ((areqWindow > 0) && (areqWindow <= ZBSOC_SCHED_MAX_WINDOW))
+  {
+    zbSocSchedAreqWindow = areqWindow;
+  }
+
+  //may be set before zbSocSchedInit
+  if (zbSocSchedTimer >= 0)
+  {
+    zbSocSchedRun();
+  }
+}
+
+/*********************************************************************
+ * @fn      zbSocSchedClassify
+ *
+ * @brief   derive the flow control type and the priority of a frame.
+ *          Reads are sent last so a client polling attributes can not
+ *          hold back commands. ZCL commands that change a device, e.g.
+ *          a toggle, step or scene recall, do not do the same twice and
+ *          are not repeated after a timeout.
+ *
+ * @param   entry - queued frame
+ *
+ * @return  FALSE if the frame bypasses the queue
+ */
+static uint8_t zbSocSchedClassify( zbSocSchedEntry_t *entry )
+{
+  uint8_t *frame = entry->frame;
+  uint8_t cmdType = frame[2] & ZBSOC_SCHED_CMD_TYPE_MASK;
+  uint8_t subsystem = frame[2] & ZBSOC_SCHED_SUBSYSTEM_MASK;
+
+  //the bootloader runs its own handshake, timeouts and retries
+  if (subsystem == ZBSOC_SCHED_SYS_SBL)
+  {
+    return FALSE;
+  }
+
+  entry->type = (cmdType == ZBSOC_SCHED_CMD_SREQ) ? zbSocSchedSreq : zbSocSchedAreq;
+  entry->prio = ZBSOC_SCHED_PRIO_HIGH;
+  entry->repeatable = TRUE;
+
+  //the ZCL frames go in MT_APP_MSG SREQs
+  if ((subsystem == ZBSOC_SCHED_SYS_APP) && (frame[3] == ZBSOC_SCHED_APP_MSG) && 
+      (entry->len >= ZBSOC_SCHED_APP_MIN_LEN))
+  {
+    uint16_t clusterId = frame[ZBSOC_SCHED_APP_CLUSTER_IDX] | 
+                         (frame[ZBSOC_SCHED_APP_CLUSTER_IDX + 1] << 8);
+    uint8_t frameControl = frame[ZBSOC_SCHED_APP_ZCL_IDX];
+    uint8_t zclCmd = frame[ZBSOC_SCHED_APP_ZCL_IDX + 2];
+
+    if (frameControl & ZBSOC_SCHED_ZCL_MANU_SPECIFIC)
+    {
+      zclCmd = frame[ZBSOC_SCHED_APP_ZCL_IDX + 4];
+    }
+
+    if (clusterId != ZBSOC_SCHED_APP_MGMT_CLUSTER)
+    {
+      entry->prio = (((frameControl & ZBSOC_SCHED_ZCL_FRAME_TYPE_MASK) == 0) && 
+                     (zclCmd == ZBSOC_SCHED_ZCL_CMD_READ)) ? 
+                     ZBSOC_SCHED_PRIO_LOW : ZBSOC_SCHED_PRIO_NORMAL;
+    }
+
+    //the gateway's own commands, e.g. a touchlink reset, are not repeated either
+    entry->repeatable = (entry->prio == ZBSOC_SCHED_PRIO_LOW);
+  }
+
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn      zbSocSchedSend
+ *
+ * @brief   queues an MT frame and sends what the windows allow. Frames
+ *          that are not MT frames, e.g. the bootloader force run byte,
+ *          and SBL frames are written directly.
+ *
+ * @param   buf - frame, FCS included
+ * @param   len - length of the frame
+ *
+ * @return  none
+ */
+void zbSocSchedSend( uint8_t *buf, uint16_t len )
+{
+  zbSocSchedEntry_t *entry;
+  int16_t idx;
+
+  if ((len < 5) || (len > ZBSOC_IO_MAX_FRAME_LEN) || (buf[0] != ZBSOC_SCHED_SOF))
+  {
+    zbSocIoWrite(buf, len);
+    return;
+  }
+
+  idx = zbSocSchedFree.head;
+  if (idx == ZBSOC_SCHED_NONE)
+  {
+    zbSocSchedStats.dropped++;
+    printf("zbSocSchedSend: queue full, dropped CMD0:%02X CMD1:%02X\n", buf[2], buf[3]);
+    return;
+  }
+
+  entry = &zbSocSchedEntries[idx];
+  memcpy(entry->frame, buf, len);
+  entry->len = len;
+
+  if (!zbSocSchedClassify(entry))
+  {
+    zbSocIoWrite(buf, len);
+    return;
+  }
+
+  zbSocSchedPop(&zbSocSchedFree);
+  entry->retries = 0;
+  entry->queued = reactorNowUs();
+  entry->deadline = 0;
+  zbSocSchedPush(&zbSocSchedQueue[entry->prio], idx);
+
+  zbSocSchedStats.enqueued++;
+  if (++zbSocSchedStats.depth > zbSocSchedStats.peakDepth)
+  {
+    zbSocSchedStats.peakDepth = zbSocSchedStats.depth;
+  }
+
+  zbSocSchedRun();
+}
+
+/*********************************************************************
+ * @fn      zbSocSchedAccount
+ *
+ * @brief   account for a finished command, SREQs finish on their SRSP
+ *          and AREQs once written.
+ */
+static void zbSocSchedAccount( int16_t idx, uint64_t now )
+{
+  uint64_t latency = now - zbSocSchedEntries[idx].queued;
+
+  zbSocSchedStats.completed++;
+  zbSocSchedStats.latencySumUs += latency;
+  if (latency > zbSocSchedStats.latencyMaxUs)
+  {
+    zbSocSchedStats.latencyMaxUs = latency;
+  }
+}
+
+/*********************************************************************
+ * @fn      zbSocSchedComplete
+ *
+ * @brief   take an SREQ out of the window on its SRSP, free it or send it
+ *          again if the SoC could not take it.
+ *
+ * @param   list - in flight list
+ * @param   prev - entry before idx
+ * @param   idx - SREQ answered
+ * @param   status - status of the SRSP
+ */
+static void zbSocSchedComplete( zbSocSchedList_t *list, int16_t prev, int16_t idx, uint8_t status )
+{
+  uint64_t now = reactorNowUs();
+
+  zbSocSchedUnlink(list, prev, idx);
+  zbSocSchedStats.sreqInFlight--;
+
+  if (status != 0)
+  {
+    zbSocSchedStats.errorStatus++;
+    zbSocSchedRetry(idx, now);
+  }
+  else
+  {
+    zbSocSchedAccount(idx, now);
+    zbSocSchedPush(&zbSocSchedFree, idx);
+  }
+
+  zbSocSchedRun();
+}
+
+/*********************************************************************
+ * @fn      zbSocSchedRetry
+ *
+ * @brief   put a command that timed out or failed back at the head of its
+ *          priority, or drop it when it is out of retries. The entry must
+ *          not be on a list.
+ */
+static void zbSocSchedRetry( int16_t idx, uint64_t now )
+{
+  zbSocSchedEntry_t *entry = &zbSocSchedEntries[idx];
+
+  if (entry->retries >= ZBSOC_SCHED_MAX_RETRIES)
+  {
+    zbSocSchedStats.failed++;
+    printf("zbSocSchedRetry: CMD0:%02X CMD1:%02X failed after %d retries\n", 
+      entry->frame[2], entry->frame[3], entry->retries);
+    zbSocSchedPush(&zbSocSchedFree, idx);
+    return;
+  }
+
+  entry->retries++;
+  entry->deadline = now + (ZBSOC_SCHED_RETRY_DELAY_MS * 1000);
+  zbSocSchedStats.retries++;
+  zbSocSchedStats.depth++;
+  zbSocSchedPushFront(&zbSocSchedQueue[entry->prio], idx);
+}
+
+/*********************************************************************
+ * @fn      zbSocSchedRun
+ *
+ * @brief   sends queued commands, highest priority first, while the
+ *          windows have room, then rearms the timer.
+ */
+static void zbSocSchedRun( void )
+{
+  uint64_t now = reactorNowUs();
+  uint8_t prio;
+
+  for (prio = 0; prio < ZBSOC_SCHED_NUM_PRIOS; prio++)
+  {
+    int16_t idx;
+
+    while ((idx = zbSocSchedQueue[prio].head) != ZBSOC_SCHED_NONE)
+    {
+      zbSocSchedEntry_t *entry = &zbSocSchedEntries[idx];
+
+      //keep the order within a priority, a blocked head holds the rest
+      if ((entry->deadline > now) ||
+          ((entry->type == zbSocSchedSreq) && (zbSocSchedStats.sreqInFlight >= zbSocSchedSreqWindow)) ||
+          ((entry->type == zbSocSchedAreq) && (zbSocSchedStats.areqInFlight >= zbSocSchedAreqWindow)))
+      {
+        break;
+      }
+
+      zbSocSchedPop(&zbSocSchedQueue[prio]);
+      zbSocSchedStats.depth--;
+
+      if (entry->retries == 0)
+      {
+        zbSocSchedStats.waitSumUs += now - entry->queued;
+      }
+
+      zbSocIoWrite(entry->frame, entry->len);
+      zbSocSchedStats.sent++;
+
+      if (entry->type == zbSocSchedSreq)
+      {
+        zbSocSchedStats.sreqInFlight++;
+        entry->deadline = now + (ZBSOC_SCHED_TIMEOUT_MS * 1000);
+      }
+      else
+      {
+        zbSocSchedAccount(idx, now);
+        zbSocSchedStats.areqInFlight++;
+        entry->deadline = now + (ZBSOC_SCHED_AREQ_HOLD_MS * 1000);
+      }
+      zbSocSchedPush(&zbSocSchedInFlight, idx);
+    }
+  }
+
+  zbSocSchedArmTimer();
+}
+
+/*********************************************************************
+ * @fn      zbSocSchedArmTimer
+ *
+ * @brief   arm the timer for the earliest timeout or delayed retry, or
+ *          disarm it when nothing is waiting.
+ */
+static void zbSocSchedArmTimer( void )
+{
+  uint64_t deadline = 0;
+  uint8_t prio;
+  int16_t idx;
+
+  for (idx = zbSocSchedInFlight.head; idx != ZBSOC_SCHED_NONE; idx = zbSocSchedEntries[idx].next)
+  {
+    if ((deadline == 0) || (zbSocSchedEntries[idx].deadline < deadline))
+    {
+      deadline = zbSocSchedEntries[idx].deadline;
+    }
+  }
+
+  //only a head can be waiting to be retried
+  for (prio = 0; prio < ZBSOC_SCHED_NUM_PRIOS; prio++)
+  {
+    idx = zbSocSchedQueue[prio].head;
+    if ((idx != ZBSOC_SCHED_NONE) && (zbSocSchedEntries[idx].deadline) &&
+        ((deadline == 0) || (zbSocSchedEntries[idx].deadline < deadline)))
+    {
+      deadline = zbSocSchedEntries[idx].deadline;
+    }
+  }
+
+  //the deadlines are in us, rounded up so the timer does not fire
+  //before the entry is due
+  reactorArmTimer(zbSocSchedTimer, (deadline + 999) / 1000);
+}
+
+/*********************************************************************
+ * @fn      zbSocSchedSrsp
+ *
+ * @brief   completes the oldest SREQ in flight the SRSP answers.
+ *
+ * @param   cmd0 - CMD0 of the SRSP
+ * @param   cmd1 - CMD1 of the SRSP
+ *
+ * @return  none
+ */
+void zbSocSchedSrsp( uint8_t cmd0, uint8_t cmd1 )
+{
+  int16_t idx, prev = ZBSOC_SCHED_NONE;
+
+  for (idx = zbSocSchedInFlight.head; idx != ZBSOC_SCHED_NONE; prev = idx, idx = zbSocSchedEntries[idx].next)
+  {
+    zbSocSchedEntry_t *entry = &zbSocSchedEntries[idx];
+
+    if ((entry->type == zbSocSchedSreq) && (entry->frame[3] == cmd1) &&
+        ((entry->frame[2] & ZBSOC_SCHED_SUBSYSTEM_MASK) == (cmd0 & ZBSOC_SCHED_SUBSYSTEM_MASK)))
+    {
+      zbSocSchedComplete(&zbSocSchedInFlight, prev, idx, 0);
+      return;
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      zbSocSchedAppStatus
+ *
+ * @brief   the SoC answers MT_APP_MSGs in the order they were sent with
+ *          a status. Completes the oldest one in flight, or sends it
+ *          again if the SoC could not take it.
+ *
+ * @param   status - status of the MT_APP_MSG
+ *
+ * @return  none
+ */
+void zbSocSchedAppStatus( uint8_t status )
+{
+  int16_t idx, prev = ZBSOC_SCHED_NONE;
+
+  for (idx = zbSocSchedInFlight.head; idx != ZBSOC_SCHED_NONE; prev = idx, idx = zbSocSchedEntries[idx].next)
+  {
+    zbSocSchedEntry_t *entry = &zbSocSchedEntries[idx];
+
+    if ((entry->type == zbSocSchedSreq) && (entry->frame[3] == ZBSOC_SCHED_APP_MSG) &&
+        ((entry->frame[2] & ZBSOC_SCHED_SUBSYSTEM_MASK) == ZBSOC_SCHED_SYS_APP))
+    {
+      zbSocSchedComplete(&zbSocSchedInFlight, prev, idx, status);
+      return;
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      zbSocSchedTimerCb
+ *
+ * @brief   reactor callback of the timer, retries the repeatable SREQs
+ *          that timed out and fails the others, ends the hold of the
+ *          AREQs and sends the delayed retries that are due.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void zbSocSchedTimerCb( void )
+{
+  int16_t expired[ZBSOC_SCHED_QUEUE_LEN];
+  uint64_t now = reactorNowUs();
+  int16_t idx, prev = ZBSOC_SCHED_NONE, next, numExpired = 0;
+
+  for (idx = zbSocSchedInFlight.head; idx != ZBSOC_SCHED_NONE; idx = next)
+  {
+    zbSocSchedEntry_t *entry = &zbSocSchedEntries[idx];
+
+    next = entry->next;
+    if (entry->deadline > now)
+    {
+      prev = idx;
+      continue;
+    }
+
+    zbSocSchedUnlink(&zbSocSchedInFlight, prev, idx);
+    if (entry->type == zbSocSchedAreq)
+    {
+      //end of the hold, the AREQ frees its window slot
+      zbSocSchedStats.areqInFlight--;
+      zbSocSchedPush(&zbSocSchedFree, idx);
+      continue;
+    }
+
+    printf("zbSocSchedTimerCb: CMD0:%02X CMD1:%02X timed out\n", entry->frame[2], entry->frame[3]);
+    zbSocSchedStats.sreqInFlight--;
+    zbSocSchedStats.timeouts++;
+
+    //the SoC may have taken the command and only the SRSP got lost
+    if (!entry->repeatable)
+    {
+      zbSocSchedStats.failed++;
+      printf("zbSocSchedTimerCb: CMD0:%02X CMD1:%02X not repeated\n", entry->frame[2], entry->frame[3]);
+      zbSocSchedPush(&zbSocSchedFree, idx);
+      continue;
+    }
+
+    expired[numExpired++] = idx;
+  }
+
+  //newest first, so the retries go out in the order they were sent
+  while (numExpired > 0)
+  {
+    zbSocSchedRetry(expired[--numExpired], now);
+  }
+
+  zbSocSchedRun();
+}
+
+/*********************************************************************
+ * @fn      zbSocSchedGetStats
+ *
+ * @brief   get the queue depth, latency and retry counters.
+ *
+ * @param   stats - set to the counters
+ *
+ * @return  none
+ */
+void zbSocSchedGetStats( zbSocSchedStats_t *stats )
+{
+  memcpy(stats, &zbSocSchedStats, sizeof(zbSocSchedStats_t));
+}
@@ -0,0 +1,144 @@
+/**************************************************************************************************
+ * Filename:       zbSocSched.h
+ * Description:    Flow controlled, prioritised queue of the MT commands sent to the ZigBee SoC.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+ 
+
+#ifndef ZBSOCSCHED_H
+#define ZBSOCSCHED_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// Commands queued or in flight, further commands are dropped
+#define ZBSOC_SCHED_QUEUE_LEN 128
+
+// SREQs sent and not yet answered by their SRSP. The ZCL commands are
+// MT_APP_MSG SREQs, answered with a status once the SoC has taken them.
+#define ZBSOC_SCHED_DEFAULT_SREQ_WINDOW 1
+// AREQs get no response, at most this many are sent per
+// ZBSOC_SCHED_AREQ_HOLD_MS
+#define ZBSOC_SCHED_DEFAULT_AREQ_WINDOW 4
+#define ZBSOC_SCHED_AREQ_HOLD_MS 10
+#define ZBSOC_SCHED_MAX_WINDOW 32
+
+// An SREQ that got no SRSP by then is sent again, up to
+// ZBSOC_SCHED_MAX_RETRIES times. The SoC may have run it already, so
+// ZCL commands other than reads fail instead.
+#define ZBSOC_SCHED_TIMEOUT_MS 1000
+#define ZBSOC_SCHED_MAX_RETRIES 3
+// Gives the SoC time to free a buffer before a failed command is sent again
+#define ZBSOC_SCHED_RETRY_DELAY_MS 20
+
+// Priorities, commands are sent highest first and in order within one
+#define ZBSOC_SCHED_PRIO_HIGH   0 // SYS, NWK and gateway management commands
+#define ZBSOC_SCHED_PRIO_NORMAL 1 // ZCL commands that change a device
+#define ZBSOC_SCHED_PRIO_LOW    2 // ZCL attribute reads
+#define ZBSOC_SCHED_NUM_PRIOS   3
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+  uint16_t depth;        // commands waiting to be sent
+  uint16_t peakDepth;
+  uint8_t sreqInFlight;
+  uint8_t areqInFlight;
+  uint32_t enqueued;
+  uint32_t sent;         // writes to the SoC, including retries
+  uint32_t completed;
+  uint32_t retries;
+  uint32_t timeouts;
+  uint32_t errorStatus;  // SRSP status other than success
+  uint32_t dropped;      // queue full
+  uint32_t failed;       // out of retries, or timed out and not repeatable
+  uint64_t latencySumUs; // queued until completed
+  uint32_t latencyMaxUs;
+  uint64_t waitSumUs;    // queued until first sent
+} zbSocSchedStats_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * zbSocSchedInit - creates the timer and empties the queue.
+ */
+int32_t zbSocSchedInit( void );
+
+/*
+ * zbSocSchedSetWindow - sets the number of SREQs and AREQs in flight.
+ */
+void zbSocSchedSetWindow( uint8_t sreqWindow, uint8_t areqWindow );
+
+/*
+ * zbSocSchedSend - queues an MT frame, non MT and SBL frames are written directly.
+ */
+void zbSocSchedSend( uint8_t *buf, uint16_t len );
+
+/*
+ * zbSocSchedSrsp - completes the SREQ the SRSP answers.
+ */
+void zbSocSchedSrsp( uint8_t cmd0, uint8_t cmd1 );
+
+/*
+ * zbSocSchedAppStatus - completes, or retries on an error, the oldest MT_APP_MSG in flight.
+ */
+void zbSocSchedAppStatus( uint8_t status );
+
+/*
+ * zbSocSchedGetStats - queue depth, latency and retry counters.
+ */
+void zbSocSchedGetStats( zbSocSchedStats_t *stats );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZBSOCSCHED_H */
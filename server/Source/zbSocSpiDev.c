@@ -0,0 +1,407 @@
+/**************************************************************************************************
+ * Filename:       zbSocSpiDev.c
+ * Description:    spidev access of the SPI transport, kernel and mock backends.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+ 
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+
+#include "zbSocSpiDev.h"
+#include "zbSocGpio.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define SPIDEV_MOCK_SOF 0xFE
+
+// bytes the mock SoC can hold, a power of 2
+#define SPIDEV_MOCK_BUF_LEN 4096
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  int (*open)( const char *devicePath );
+  void (*close)( void );
+  int32_t (*transfer)( struct spi_ioc_transfer *xfers, uint32_t count );
+} zbSocSpiDevBackend_t;
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static int spiDevKernelOpen( const char *devicePath );
+static void spiDevKernelClose( void );
+static int32_t spiDevKernelTransfer( struct spi_ioc_transfer *xfers, uint32_t count );
+
+static int spiDevMockOpen( const char *devicePath );
+static void spiDevMockClose( void );
+static int32_t spiDevMockTransfer( struct spi_ioc_transfer *xfers, uint32_t count );
+static void spiDevMockPut( uint8_t ch );
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static const zbSocSpiDevBackend_t spiDevKernelBackend =
+{
+  spiDevKernelOpen, spiDevKernelClose, spiDevKernelTransfer
+};
+
+static const zbSocSpiDevBackend_t spiDevMockBackend =
+{
+  spiDevMockOpen, spiDevMockClose, spiDevMockTransfer
+};
+
+static const zbSocSpiDevBackend_t *spiDevBackend = NULL;
+static zbSocSpiDevStats_t spiDevStats;
+
+static uint8_t bits = 8;
+static uint32_t speed = 1000000; 
+static uint16_t delay = 100;
+static uint8_t mode = 0;
+
+static int spiDevKernelFd = -1;
+
+// bytes the mock SoC clocks out next, spiDevMockHead == spiDevMockTail when idle
+static uint8_t spiDevMockBuf[SPIDEV_MOCK_BUF_LEN];
+static uint32_t spiDevMockHead, spiDevMockTail;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      spiDevKernelOpen
+ *
+ * @brief   open the spidev and set mode, bits per word and max speed.
+ *
+ * @param   devicePath - /dev/spidevB.C
+ *
+ * @return  fd, -1 on failure
+ */
+static int spiDevKernelOpen( const char *devicePath )
+{
+  spiDevKernelFd = open(devicePath, O_RDWR);
+  if (spiDevKernelFd < 0)
+  {
+    perror(devicePath);
+    return -1;
+  }
+
+  /*
+   * spi mode
+   */
+  ioctl(spiDevKernelFd, SPI_IOC_WR_MODE, &mode);
+  ioctl(spiDevKernelFd, SPI_IOC_RD_MODE, &mode);
+
+  /*
+   * bits per word
+   */
+  ioctl(spiDevKernelFd, SPI_IOC_WR_BITS_PER_WORD, &bits);
+  ioctl(spiDevKernelFd, SPI_IOC_RD_BITS_PER_WORD, &bits);
+
+  /*
+   * max speed hz
+   */
+  ioctl(spiDevKernelFd, SPI_IOC_WR_MAX_SPEED_HZ, &speed);
+  ioctl(spiDevKernelFd, SPI_IOC_RD_MAX_SPEED_HZ, &speed);
+
+  return spiDevKernelFd;
+}
+
+/*********************************************************************
+ * @fn      spiDevKernelClose
+ *
+ * @brief   close the spidev.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void spiDevKernelClose( void )
+{
+  close(spiDevKernelFd);
+  spiDevKernelFd = -1;
+}
+
+/*********************************************************************
+ * @fn      spiDevKernelTransfer
+ *
+ * @brief   clock the chain in one SPI_IOC_MESSAGE, the kernel runs it
+ *          as a single spi_sync.
+ *
+ * @param   xfers - chained transfers
+ * @param   count - number of transfers
+ *
+ * @return  0 on success, -1 on failure
+ */
+static int32_t spiDevKernelTransfer( struct spi_ioc_transfer *xfers, uint32_t count )
+{
+  return (ioctl(spiDevKernelFd, SPI_IOC_MESSAGE(count), xfers) < 0) ? -1 : 0;
+}
+
+/*********************************************************************
+ * @fn      spiDevMockOpen
+ *
+ * @brief   start the mock SoC with nothing to send.
+ *
+ * @param   devicePath - ignored
+ *
+ * @return  0
+ */
+static int spiDevMockOpen( const char *devicePath )
+{
+  spiDevMockHead = spiDevMockTail = 0;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      spiDevMockClose
+ *
+ * @brief   drop what the mock SoC had queued.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void spiDevMockClose( void )
+{
+  spiDevMockHead = spiDevMockTail = 0;
+}
+
+/*********************************************************************
+ * @fn      spiDevMockTransfer
+ *
+ * @brief   clock the queued bytes into the rx buffers, zeroes once the
+ *          queue is empty. Like the SoC, SRDY is deasserted when the 
+ *          last queued byte was clocked. The tx bytes are dropped.
+ *
+ * @param   xfers - chained transfers
+ * @param   count - number of transfers
+ *
+ * @return  0
+ */
+static int32_t spiDevMockTransfer( struct spi_ioc_transfer *xfers, uint32_t count )
+{
+  uint32_t seg, idx;
+
+  for (seg = 0; seg < count; seg++)
+  {
+    uint8_t *rxBuf = (uint8_t *)(unsigned long)xfers[seg].rx_buf;
+
+    for (idx = 0; idx < xfers[seg].len; idx++)
+    {
+      uint8_t ch = 0;
+
+      if (spiDevMockHead != spiDevMockTail)
+      {
+        ch = spiDevMockBuf[spiDevMockHead];
+        spiDevMockHead = (spiDevMockHead + 1) & (SPIDEV_MOCK_BUF_LEN - 1);
+      }
+
+      if (rxBuf != NULL)
+      {
+        rxBuf[idx] = ch;
+      }
+    }
+  }
+
+  if ((spiDevMockHead == spiDevMockTail) && (zbSocGpioGetSrdy() == 0))
+  {
+    zbSocGpioMockSet(1);
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      spiDevMockPut
+ *
+ * @brief   append a byte for the mock SoC to clock out.
+ *
+ * @param   ch - byte
+ *
+ * @return  none
+ */
+static void spiDevMockPut( uint8_t ch )
+{
+  spiDevMockBuf[spiDevMockTail] = ch;
+  spiDevMockTail = (spiDevMockTail + 1) & (SPIDEV_MOCK_BUF_LEN - 1);
+}
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      zbSocSpiDevOpen
+ *
+ * @brief   open the device and set mode, word size and speed.
+ *
+ * @param   devicePath - spidev device
+ * @param   backend - ZBSOC_SPIDEV_KERNEL or ZBSOC_SPIDEV_MOCK
+ *
+ * @return  fd, -1 on failure
+ */
+int zbSocSpiDevOpen( const char *devicePath, uint8_t backend )
+{
+  int fd;
+
+  spiDevBackend = (backend == ZBSOC_SPIDEV_MOCK) ? &spiDevMockBackend : &spiDevKernelBackend;
+  memset(&spiDevStats, 0, sizeof(spiDevStats));
+
+  fd = spiDevBackend->open(devicePath);
+  if (fd < 0)
+  {
+    spiDevBackend = NULL;
+  }
+
+  return fd;
+}
+
+/*********************************************************************
+ * @fn      zbSocSpiDevClose
+ *
+ * @brief   close the device.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void zbSocSpiDevClose( void )
+{
+  if (spiDevBackend != NULL)
+  {
+    spiDevBackend->close();
+    spiDevBackend = NULL;
+  }
+}
+
+/*********************************************************************
+ * @fn      zbSocSpiDevTransfer
+ *
+ * @brief   clock a chain of transfers as one message. A NULL tx_buf 
+ *          shifts out zeroes, a NULL rx_buf drops the received bytes. 
+ *          Speed, word size and delay are filled in here. The bus is
+ *          only clocked from the I/O thread, or before it starts, so
+ *          there is no lock.
+ *
+ * @param   xfers - chained transfers
+ * @param   count - number of transfers
+ *
+ * @return  0 on success, -1 on failure
+ */
+int32_t zbSocSpiDevTransfer( struct spi_ioc_transfer *xfers, uint32_t count )
+{
+  uint32_t seg;
+
+  if (spiDevBackend == NULL)
+  {
+    return -1;
+  }
+
+  for (seg = 0; seg < count; seg++)
+  {
+    xfers[seg].speed_hz = speed;
+    xfers[seg].bits_per_word = bits;
+    xfers[seg].delay_usecs = delay;
+    spiDevStats.bytes += xfers[seg].len;
+  }
+  spiDevStats.messages++;
+  spiDevStats.segments += count;
+
+  return spiDevBackend->transfer(xfers, count);
+}
+
+/*********************************************************************
+ * @fn      zbSocSpiDevGetStats
+ *
+ * @brief   get the message, segment and byte counters.
+ *
+ * @param   stats - counters are copied here
+ *
+ * @return  none
+ */
+void zbSocSpiDevGetStats( zbSocSpiDevStats_t *stats )
+{
+  *stats = spiDevStats;
+}
+
+/*********************************************************************
+ * @fn      zbSocSpiDevMockQueue
+ *
+ * @brief   frame data as SOF, LEN, data and FCS for the mock SoC to 
+ *          clock out and assert the mock SRDY. Call it from the thread
+ *          that clocks the bus.
+ *
+ * @param   data - frame data, the MT command and payload
+ * @param   len - length of the data
+ *
+ * @return  0 on success, -1 if the frame does not fit
+ */
+int32_t zbSocSpiDevMockQueue( const uint8_t *data, uint8_t len )
+{
+  uint32_t used = (spiDevMockTail - spiDevMockHead) & (SPIDEV_MOCK_BUF_LEN - 1);
+  uint8_t fcs = len;
+  uint8_t idx;
+
+  if ((len == 0) || (used + len + 3 >= SPIDEV_MOCK_BUF_LEN))
+  {
+    return -1;
+  }
+
+  spiDevMockPut(SPIDEV_MOCK_SOF);
+  spiDevMockPut(len);
+  for (idx = 0; idx < len; idx++)
+  {
+    fcs ^= data[idx];
+    spiDevMockPut(data[idx]);
+  }
+  spiDevMockPut(fcs);
+
+  zbSocGpioMockSet(0);
+
+  return 0;
+}
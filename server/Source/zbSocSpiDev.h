@@ -0,0 +1,106 @@
+/**************************************************************************************************
+ * Filename:       zbSocSpiDev.h
+ * Description:    spidev access of the SPI transport, kernel and mock backends.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+ 
+ 
+
+#ifndef ZBSOCSPIDEV_H
+#define ZBSOCSPIDEV_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+#include "spidev.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define ZBSOC_SPIDEV_KERNEL 0 // /dev/spidevB.C
+#define ZBSOC_SPIDEV_MOCK   1 // a SoC queued with zbSocSpiDevMockQueue, drives the mock SRDY
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint64_t messages; // SPI_IOC_MESSAGE calls, one syscall each
+  uint64_t segments; // transfers chained in those messages
+  uint64_t bytes;    // bytes clocked
+} zbSocSpiDevStats_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * zbSocSpiDevOpen - open the device and set mode, word size and speed, returns the fd.
+ */
+int zbSocSpiDevOpen( const char *devicePath, uint8_t backend );
+
+/*
+ * zbSocSpiDevClose - close the device.
+ */
+void zbSocSpiDevClose( void );
+
+/*
+ * zbSocSpiDevTransfer - clock a chain of transfers as one message, returns 0 on success.
+ */
+int32_t zbSocSpiDevTransfer( struct spi_ioc_transfer *xfers, uint32_t count );
+
+/*
+ * zbSocSpiDevGetStats - message, segment and byte counters.
+ */
+void zbSocSpiDevGetStats( zbSocSpiDevStats_t *stats );
+
+/*
+ * zbSocSpiDevMockQueue - frame data for the mock SoC to clock out, asserts the mock SRDY.
+ */
+int32_t zbSocSpiDevMockQueue( const uint8_t *data, uint8_t len );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZBSOCSPIDEV_H */
@@ -0,0 +1,405 @@
+/*
+ * zbSocTransport.c
+ *
+ * This module selects the transport to the zll SoC at runtime.
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#include <sys/socket.h>
+
+#include "zbSocTransport.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// how long a write waits for the kernel Tx queue to take a frame, the
+// SoC holding CTS, or a peer not reading, longer than this is stuck
+#define TRANSPORT_WRITE_TIMEOUT_MS 1000
+
+#define TRANSPORT_MAX_PATH_LEN 255
+
+// a spidev path selects the SPI transport
+#define TRANSPORT_SPIDEV_PREFIX "/dev/spidev"
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+extern uint8_t uartDebugPrintsEnabled;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static const zbSocTransport_t *transports[] =
+{
+  &zbSocTransportUart,
+  &zbSocTransportSpi,
+  &zbSocTransportPty,
+  &zbSocTransportTcp,
+};
+
+//the UART until one is selected
+static const zbSocTransport_t *transport = &zbSocTransportUart;
+static uint8_t transportSelected = 0;
+
+//a reopen passes a NULL path
+static char transportDevicePath[TRANSPORT_MAX_PATH_LEN + 1];
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      transportStripScheme
+ *
+ * @brief   skip the <name>: a device path may start with, e.g. the
+ *          tcp: of tcp:localhost:5000.
+ *
+ * @param   devicePath - device path
+ *
+ * @return  the path the transport opens
+ */
+static const char *transportStripScheme( const char *devicePath )
+{
+  size_t len = strlen(transport->name);
+
+  if ((!strncmp(devicePath, transport->name, len)) && (devicePath[len] == ':'))
+  {
+    return devicePath + len + 1;
+  }
+
+  return devicePath;
+}
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      zbSocTransportSelect
+ *
+ * @brief   select the transport by name, or from the device path: 
+ *          <name>:... selects that transport, /dev/spidev* the SPI one,
+ *          anything else the UART.
+ *
+ * @param   name - uart, spi, pty or tcp, NULL to use the path
+ * @param   devicePath - device path, ignored if name is given
+ *
+ * @return  0 on success, -1 if there is no such transport
+ */
+int32_t zbSocTransportSelect( const char *name, const char *devicePath )
+{
+  uint32_t i;
+
+  for (i = 0; i < (sizeof(transports) / sizeof(transports[0])); i++)
+  {
+    size_t len = strlen(transports[i]->name);
+
+    if (((name != NULL) && (!strcmp(name, transports[i]->name))) ||
+        ((name == NULL) && (devicePath != NULL) && 
+         (!strncmp(devicePath, transports[i]->name, len)) && (devicePath[len] == ':')))
+    {
+      transport = transports[i];
+      transportSelected = 1;
+      return 0;
+    }
+  }
+
+  if (name != NULL)
+  {
+    return -1;
+  }
+
+  if ((devicePath != NULL) && (!strncmp(devicePath, TRANSPORT_SPIDEV_PREFIX, strlen(TRANSPORT_SPIDEV_PREFIX))))
+  {
+    transport = &zbSocTransportSpi;
+  }
+  else
+  {
+    transport = &zbSocTransportUart;
+  }
+  transportSelected = 1;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      zbSocTransportGetName
+ *
+ * @brief   get the name of the selected transport.
+ *
+ * @param   none
+ *
+ * @return  uart, spi, pty or tcp
+ */
+const char *zbSocTransportGetName( void )
+{
+  return transport->name;
+}
+
+/*********************************************************************
+ * @fn      zbSocTransportOpen
+ *
+ * @brief   opens the transport to the CC253x, selected from the path
+ *          unless zbSocTransportSelect was called.
+ *
+ * @param   devicePath - path to the device, NULL to reopen the last one
+ *
+ * @return  -1 on failure, zbSocTransportFd is the fd to poll
+ */
+int32_t zbSocTransportOpen( char *devicePath  )
+{
+  if (devicePath != NULL)
+  {
+    if (strlen(devicePath) > TRANSPORT_MAX_PATH_LEN)
+    {
+      printf("%s - device path too long\n", devicePath);
+      return(-1);
+    }
+    strcpy(transportDevicePath, devicePath);
+  }
+
+  if (!transportSelected)
+  {
+    zbSocTransportSelect(NULL, transportDevicePath);
+  }
+
+  return transport->open(transportStripScheme(transportDevicePath));
+}
+
+/*********************************************************************
+ * @fn      zbSocTransportClose
+ *
+ * @brief   closes the transport to the CC253x.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void zbSocTransportClose( void )
+{
+  transport->close();
+}
+
+/*********************************************************************
+ * @fn      zbSocTransportWrite
+ *
+ * @brief   Write an MT frame to the CC253x.
+ *
+ * @param   buf - MT frame
+ * @param   len - length of the frame
+ *
+ * @return  none
+ */
+void zbSocTransportWrite( uint8_t* buf, uint8_t len )
+{
+  if ((uartDebugPrintsEnabled) && (len > 4))
+  {
+    int x;
+
+    printf("UART OUT --> %d Bytes: SOF:%02X, Len:%02X, CMD0:%02X, CMD1:%02X, Payload:", len, buf[0], buf[1], buf[2], buf[3]);
+    for (x = 4; x < len - 1; x++)
+    {
+      printf("%02X%s", buf[x], x < len - 1 - 1 ? ":" : ",");
+    }
+    printf(" FCS:%02X\n", buf[x]);
+  }
+
+  transport->write(buf, len);
+}
+
+/*********************************************************************
+ * @fn      zbSocTransportRead
+ *
+ * @brief   Reads what the CC253x sent, never blocks.
+ *
+ * @param   buf - buffer
+ * @param   len - size of the buffer
+ *
+ * @return  bytes read, 0 if none
+ */
+int32_t zbSocTransportRead( uint8_t* buf, uint32_t len )
+{
+  return transport->read(buf, len);
+}
+
+/*********************************************************************
+ * @fn      zbSocTransportPoll
+ *
+ * @brief   consume the edges of an edge transport, a frame that came 
+ *          after the last read is not signalled again.
+ *
+ * @param   none
+ *
+ * @return  TRUE if a frame waits, always FALSE for a level transport
+ */
+uint8_t zbSocTransportPoll(void)
+{
+  return (transport->poll != NULL) ? transport->poll() : 0;
+}
+
+/*********************************************************************
+ * @fn      zbSocTransportFd
+ *
+ * @brief   get the fd the I/O thread polls.
+ *
+ * @param   none
+ *
+ * @return  fd, -1 while there is nothing to poll
+ */
+int zbSocTransportFd( void )
+{
+  return transport->fd();
+}
+
+/*********************************************************************
+ * @fn      zbSocTransportReadiness
+ *
+ * @brief   get what the fd signals.
+ *
+ * @param   none
+ *
+ * @return  ZBSOC_TRANSPORT_LEVEL or ZBSOC_TRANSPORT_EDGE
+ */
+uint8_t zbSocTransportReadiness( void )
+{
+  return transport->readiness;
+}
+
+/*********************************************************************
+ * @fn      zbSocTransportPollEvents
+ *
+ * @brief   get the poll events the fd is readable, or an edge is 
+ *          signalled with.
+ *
+ * @param   none
+ *
+ * @return  poll events
+ */
+short zbSocTransportPollEvents( void )
+{
+  return (transport->pollEvents != NULL) ? transport->pollEvents() : POLLIN;
+}
+
+/*********************************************************************
+ * @fn      zbSocTransportSetProfile
+ *
+ * @brief   set the settings of the selected transport used by the next
+ *          open.
+ *
+ * @param   profile - profile string, the format is the transport's
+ *
+ * @return  0 on success, -1 if the profile is invalid
+ */
+int32_t zbSocTransportSetProfile( const char *profile )
+{
+  return (transport->setProfile != NULL) ? transport->setProfile(profile) : -1;
+}
+
+/*********************************************************************
+ * @fn      zbSocTransportReadTimeout
+ *
+ * @brief   how long the I/O thread waits for the fd.
+ *
+ * @param   none
+ *
+ * @return  timeout in ms, -1 to wait until signalled
+ */
+int32_t zbSocTransportReadTimeout( void )
+{
+  return (transport->readTimeout != NULL) ? transport->readTimeout() : -1;
+}
+
+/*********************************************************************
+ * @fn      zbSocTransportWriteAll
+ *
+ * @brief   write a frame to a non-blocking fd. A write takes what fits
+ *          the kernel Tx queue, the rest is written once the queue 
+ *          drains, so a frame is never cut short while the SoC holds 
+ *          CTS or the peer is slow to read.
+ *
+ * @param   fd - file descriptor of the device or socket
+ * @param   buf - frame
+ * @param   len - length of the frame
+ * @param   isSocket - send without SIGPIPE, a peer that went away is 
+ *          an error to report
+ *
+ * @return  0 on success, -1 if the frame was not written whole
+ */
+int32_t zbSocTransportWriteAll( int fd, uint8_t *buf, uint32_t len, uint8_t isSocket )
+{
+  struct pollfd pollFd;
+  ssize_t written;
+
+  while (len > 0)
+  {
+    written = isSocket ? send(fd, buf, len, MSG_NOSIGNAL) : write(fd, buf, len);
+    if (written > 0)
+    {
+      buf += written;
+      len -= written;
+      continue;
+    }
+
+    if ((written < 0) && (errno == EINTR))
+    {
+      continue;
+    }
+
+    if ((written < 0) && (errno != EAGAIN))
+    {
+      printf("zbSocTransportWriteAll: write failed - %s\n", strerror(errno));
+      return -1;
+    }
+
+    pollFd.fd = fd;
+    pollFd.events = POLLOUT;
+    if ((poll(&pollFd, 1, TRANSPORT_WRITE_TIMEOUT_MS) == 0) || 
+        (pollFd.revents & (POLLERR | POLLHUP)))
+    {
+      printf("zbSocTransportWriteAll: fd not writable, %u bytes of the frame dropped\n", len);
+      return -1;
+    }
+  }
+
+  return 0;
+}
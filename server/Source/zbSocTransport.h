@@ -46,13 +46,67 @@ extern "C"
 
 #include <stdint.h>
 
+/*********************************************************************
+ * CONSTANTS
+ */
+// readiness of the fd of a transport
+#define ZBSOC_TRANSPORT_LEVEL 0 // readable while bytes wait, e.g. a UART
+#define ZBSOC_TRANSPORT_EDGE  1 // signals an SRDY edge, poll tells if a frame still waits
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  const char *name;
+  uint8_t readiness;
+  int (*open)( const char *devicePath );                // -1 on failure, the fd to poll is fd's
+  void (*close)( void );
+  void (*write)( uint8_t *buf, uint8_t len );
+  int32_t (*read)( uint8_t *buf, uint32_t len );        // bytes read, 0 if none
+  int (*fd)( void );                                    // -1 while there is nothing to poll
+  uint8_t (*poll)( void );                              // edge only, consume the edges, TRUE if a frame waits
+  short (*pollEvents)( void );                          // edge only, events the fd signals an edge with
+  int32_t (*setProfile)( const char *profile );         // optional
+  int32_t (*readTimeout)( void );                       // optional, ms the fd may stay quiet with bytes waiting
+} zbSocTransport_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+extern const zbSocTransport_t zbSocTransportUart;
+extern const zbSocTransport_t zbSocTransportSpi;
+extern const zbSocTransport_t zbSocTransportPty;
+extern const zbSocTransport_t zbSocTransportTcp;
+
 /********************************************************************/
 // ZigBee Soc API
+
+/*
+ * zbSocTransportSelect - select uart, spi, pty or tcp, or from the device path if name is NULL.
+ */
+int32_t zbSocTransportSelect( const char *name, const char *devicePath );
+
+/*
+ * zbSocTransportGetName - name of the selected transport.
+ */
+const char *zbSocTransportGetName( void );
+
 int32_t zbSocTransportOpen( char *devicePath  );
 void zbSocTransportClose( void ); 
 void zbSocTransportWrite(uint8_t* buf, uint8_t len ); 
-uint8_t zbSocTransportRead( uint8_t* buf, uint8_t len );
+int32_t zbSocTransportRead( uint8_t* buf, uint32_t len );
 uint8_t zbSocTransportPoll(void);
+int zbSocTransportFd( void );
+uint8_t zbSocTransportReadiness( void );
+short zbSocTransportPollEvents( void );
+int32_t zbSocTransportSetProfile( const char *profile );
+int32_t zbSocTransportReadTimeout( void );
+
+/*
+ * zbSocTransportWriteAll - write all of a frame to a non-blocking fd, for the fd transports.
+ */
+int32_t zbSocTransportWriteAll( int fd, uint8_t *buf, uint32_t len, uint8_t isSocket );
 
 #ifdef __cplusplus
 }
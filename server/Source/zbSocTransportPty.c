@@ -0,0 +1,228 @@
+/*
+ * zbSocTransportPty.c
+ *
+ * This module contains a pseudo-terminal transport, a simulator opens the slave like a UART.
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <termios.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <errno.h>
+
+#include "zbSocTransport.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define PTY_MAX_PATH_LEN 255
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static int ptyOpen( const char *devicePath );
+static void ptyClose( void );
+static void ptyWrite( uint8_t *buf, uint8_t len );
+static int32_t ptyRead( uint8_t *buf, uint32_t len );
+static int ptyFd( void );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+const zbSocTransport_t zbSocTransportPty =
+{
+  "pty", ZBSOC_TRANSPORT_LEVEL, ptyOpen, ptyClose, ptyWrite, ptyRead, ptyFd,
+  NULL, NULL, NULL, NULL
+};
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static int ptyMasterFd = -1;
+
+// held open so the master does not hang up while no simulator has the
+// slave open, never read
+static int ptySlaveFd = -1;
+
+static char ptyLinkPath[PTY_MAX_PATH_LEN + 1];
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      ptyOpen
+ *
+ * @brief   create a pseudo-terminal pair, the gateway has the master
+ *          and a simulator opens the slave as if it were the UART of
+ *          the SoC. The slave is raw so MT frames pass unchanged.
+ *
+ * @param   devicePath - symlink to create to the slave, "" for none
+ *
+ * @return  fd of the master, -1 on failure
+ */
+static int ptyOpen( const char *devicePath )
+{
+  struct termios tio;
+  struct stat st;
+  char *slaveName;
+
+  ptyMasterFd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if ((ptyMasterFd < 0) || (grantpt(ptyMasterFd) < 0) || (unlockpt(ptyMasterFd) < 0) ||
+      ((slaveName = ptsname(ptyMasterFd)) == NULL))
+  {
+    perror("ptyOpen");
+    ptyClose();
+    return -1;
+  }
+
+  ptySlaveFd = open(slaveName, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if ((ptySlaveFd < 0) || (tcgetattr(ptySlaveFd, &tio) < 0))
+  {
+    perror(slaveName);
+    ptyClose();
+    return -1;
+  }
+  cfmakeraw(&tio);
+  tcsetattr(ptySlaveFd, TCSANOW, &tio);
+
+  if (*devicePath != '\0')
+  {
+    //replace the link of a previous run, never anything else
+    if ((lstat(devicePath, &st) == 0) && (S_ISLNK(st.st_mode)))
+    {
+      unlink(devicePath);
+    }
+
+    if ((strlen(devicePath) > PTY_MAX_PATH_LEN) || (symlink(slaveName, devicePath) < 0))
+    {
+      perror(devicePath);
+      ptyClose();
+      return -1;
+    }
+    strcpy(ptyLinkPath, devicePath);
+    printf("zbSoC pseudo-terminal %s -> %s\n", ptyLinkPath, slaveName);
+  }
+  else
+  {
+    printf("zbSoC pseudo-terminal %s\n", slaveName);
+  }
+
+  return ptyMasterFd;
+}
+
+/*********************************************************************
+ * @fn      ptyClose
+ *
+ * @brief   close the pair and remove the symlink.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void ptyClose( void )
+{
+  if (ptyLinkPath[0] != '\0')
+  {
+    unlink(ptyLinkPath);
+    ptyLinkPath[0] = '\0';
+  }
+
+  if (ptySlaveFd >= 0)
+  {
+    close(ptySlaveFd);
+    ptySlaveFd = -1;
+  }
+
+  if (ptyMasterFd >= 0)
+  {
+    close(ptyMasterFd);
+    ptyMasterFd = -1;
+  }
+}
+
+/*********************************************************************
+ * @fn      ptyWrite
+ *
+ * @brief   write a frame for the simulator.
+ *
+ * @param   buf - MT frame
+ * @param   len - length of the frame
+ *
+ * @return  none
+ */
+static void ptyWrite( uint8_t *buf, uint8_t len )
+{
+  zbSocTransportWriteAll(ptyMasterFd, buf, len, 0);
+}
+
+/*********************************************************************
+ * @fn      ptyRead
+ *
+ * @brief   read what the simulator wrote.
+ *
+ * @param   buf - buffer
+ * @param   len - size of the buffer
+ *
+ * @return  bytes read, 0 if none
+ */
+static int32_t ptyRead( uint8_t *buf, uint32_t len )
+{
+  ssize_t bytesRead = read(ptyMasterFd, buf, len);
+
+  return (bytesRead < 0) ? 0 : bytesRead;
+}
+
+/*********************************************************************
+ * @fn      ptyFd
+ *
+ * @brief   get the fd of the master.
+ *
+ * @param   none
+ *
+ * @return  fd, -1 if closed
+ */
+static int ptyFd( void )
+{
+  return ptyMasterFd;
+}
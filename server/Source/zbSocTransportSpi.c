@@ -40,20 +40,12 @@
 /*********************************************************************
  * INCLUDES
  */
-#include <termios.h>
 #include <string.h>
 #include <stdio.h>
-#include <stdlib.h>
-#include <unistd.h>
-#include <fcntl.h>
-#include <sys/ioctl.h>
 
-#include <errno.h>
-#include <string.h>
-
-#include "zbSocCmd.h"
-#include "spidev.h"
-#include "pthread.h"
+#include "zbSocTransport.h"
+#include "zbSocGpio.h"
+#include "zbSocSpiDev.h"
 
 /*********************************************************************
  * MACROS
@@ -64,8 +56,6 @@
 #define SPI_DAT_LEN(PBUF)      ((PBUF)[SPI_LEN_IDX])
 #define SPI_PKT_LEN(PBUF)      (SPI_DAT_LEN((PBUF)) + SPI_FRM_LEN)
 
-#define SPI_LEN_T_INCR(LEN)  (LEN)++
-
 #define SPI_SOF                    0xFE  // Start-of-frame delimiter for SPI transport.
 
 // The FCS is calculated over the SPI Frame Header and the Frame Data bytes.
@@ -78,157 +68,48 @@
 #define SPI_LEN_IDX                1     // LEN byte is offset by the SOF byte.
 #define SPI_DAT_IDX                2     // Data bytes are offset by the SOF & LEN bytes.
 
-//RF2_GPIO0/SRDY GPIO74
-//RF1_SPI_ENABLE GPIO74
-//RF2_SPI_ENABLE GPIO74
-#define HAL_SRDY_VALUE "/sys/class/gpio/gpio9/value"
-#define HAL_SRDY_DIR "/sys/class/gpio/gpio9/direction"
-#define HAL_SRDY_EDGE "/sys/class/gpio/gpio9/edge"
-#define HAL_SPIENABLE_VALUE "/sys/class/gpio/gpio73/value"
-#define HAL_SPIENABLE_DIR "/sys/class/gpio/gpio73/direction"
 
 /************************************************************
  * TYPEDEFS
  */
-typedef enum
-{
-  spiRxSteSOF,
-  spiRxSteLen,
-  spiRxSteData,
-  spiRxSteFcs
-} spiRxSte_t;
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static int spiOpen( const char *devicePath );
+static void spiClose( void );
+static void spiWrite( uint8_t *buf, uint8_t len );
+static int32_t spiRead( uint8_t *buf, uint32_t len );
+static int spiFd( void );
+static uint8_t spiPoll( void );
+static short spiPollEvents( void );
+static int32_t spiSetProfile( const char *profile );
 
 /*********************************************************************
  * GLOBAL VARIABLES
  */
+const zbSocTransport_t zbSocTransportSpi =
+{
+  "spi", ZBSOC_TRANSPORT_EDGE, spiOpen, spiClose, spiWrite, spiRead, spiFd,
+  spiPoll, spiPollEvents, spiSetProfile, NULL
+};
 
 /*********************************************************************
  * LOCAL VARIABLES
  */
-int spiDevFd;
-int zbSrdyFd;
 
-static uint8_t spiRxBuf[SPI_MAX_PKT_LEN];
-static uint8_t spiRxHead, spiRxTail;  // Indices into spiRxBuf.
+//SRDY through sysfs unless the profile selects another GPIO backend
+static zbSocGpioConfig_t spiGpioConfig = { ZBSOC_GPIO_SYSFS, "", 0, -1 };
+static int spiSrdyFd = -1;
 
+// Frames are clocked straight into spiRxPkt, SOF and LEN in one transfer and the data
+// with the FCS in the next.
 static uint8_t spiRxPkt[SPI_MAX_PKT_LEN];
-static uint8_t spiRxCnt;  // Count payload data bytes parsed from spiRxBuf or read from spiRxPkt.
-static uint8_t spiRxLen;  // Total length of payload data bytes to be parsed from spiRxBuf.
-static uint8_t spiRxRdy;  // Set to spiRxLen when all bytes have been parsed and the FCS verified.
-static spiRxSte_t spiRxSte;
+static uint8_t spiRxCnt;  // Count payload data bytes read from spiRxPkt.
+static uint8_t spiRxRdy;  // Payload data bytes left in spiRxPkt once the FCS was verified.
 
 static uint8_t spiTxPkt[SPI_MAX_PKT_LEN];
 
-// Linear scratch buffer used by spiClockData(); so it could be an automatic variable (but be
-// aware of the c-call-stack depth) or dynamic from a malloc()/new().
-static uint8_t spiRxTmp[SPI_MAX_PKT_LEN];
-
-static uint8_t bits = 8;
-static uint32_t speed = 1000000; 
-static uint16_t delay = 100;
-static uint8_t mode = 0;
-
-
-static pthread_mutex_t spiMutex1 = PTHREAD_MUTEX_INITIALIZER;
-
-/**************************************************************************************************
- * @fn      HalSpiSrdysetEdge
- *
- *
- * @brief   Initialise MRDY GPIO.
- *
- * @param   port - SPI port.
- *          edge - 1 rising, 0 falling
- *
- * @return  None
- **************************************************************************************************/
-static void HalSpiSrdysetEdge(uint8_t edge)
- {
-  int zbSrdyFdEdge;
-  
-  //open the SRDY GPIO VALUE file so it can be poll'ed to using the file handle later
-	zbSrdyFdEdge = open(HAL_SRDY_EDGE, O_RDWR | O_NONBLOCK );
-	if (zbSrdyFdEdge < 0) {
-		perror("gpio/fd_open");
-	} 
-	  	
-	if(edge)
-	{
-	  lseek(zbSrdyFdEdge, SEEK_SET, 0);
-	  write(zbSrdyFdEdge, "rising", 7); 
-	}
-	else
-	{
-	  lseek(zbSrdyFdEdge, SEEK_SET, 0);
-	  write(zbSrdyFdEdge, "falling", 8); 	    
-	}
-	
-	close(zbSrdyFdEdge);
-}
-
-/*********************************************************************
- * @fn      spiSrdyInit
- *
- * @brief   opens Fd to the CC2530 - host Interupt.
- *
- * @param   devicePath - path to the UART device
- *
- * @return  status
- */
-static int spiSrdyInit(void)
-{       
-  //printf("spiSrdyInit++\n"); 
-//----------------- SPI ENABLE GPIO -------------------------
-  //open the SPI Enable GPIO DIR file
-  zbSrdyFd = open(HAL_SPIENABLE_DIR, O_RDWR); 
-  if(zbSrdyFd == 0)                                                 
-  {                                                                 
-    perror(HAL_SPIENABLE_DIR);                    
-    //printf("%s open failed\n",HAL_SPIENABLE_DIR); 
-    exit(-1);                                                       
-  }                      
-  //Set SPI Enable GPIO as output                                                                  
-  write(zbSrdyFd, "out", 3);   
-  //close SRDY DIR file
-  close(zbSrdyFd);     
-	       
-  //open the SPI Enable GPIO VALUE file so it can be written to
-	zbSrdyFd = open(HAL_SPIENABLE_VALUE, O_RDWR | O_NONBLOCK );
-	if (zbSrdyFd < 0) {
-		perror("gpio/fd_open");
-	} 	
-  //Set SPI Enable GPIO as high                                                                  
-  write(zbSrdyFd, "1", 1); 
-  //close SRDY DIR file
-  close(zbSrdyFd);	
-
-//----------------- SRDY GPIO -------------------------	
-  //open the SPI Enable GPIO VALUE  file
-  zbSrdyFd = open(HAL_SRDY_DIR, O_RDWR); 
-  if(zbSrdyFd == 0)                                                 
-  {                                                                 
-    perror(HAL_SRDY_DIR);                    
-    //printf("%s open failed\n",HAL_SRDY_DIR); 
-    exit(-1);                                                       
-  }                      
-  //Set SRDY GPIO as input                                                                  
-  write(zbSrdyFd, "in", 2);   
-  //close SRDY DIR file
-  close(zbSrdyFd);     
-
-  //set to use failing edge.
-  HalSpiSrdysetEdge(0);
-  	       
-  //open the SRDY GPIO VALUE file so it can be poll'ed to using the file handle later
-	zbSrdyFd = open(HAL_SRDY_VALUE, O_RDWR | O_NONBLOCK );
-	if (zbSrdyFd < 0) {
-		perror("gpio/fd_open");
-	} 
-	
-	//TODO: Lock the SRDY GPIO.	  
-	return zbSrdyFd; 
-}
-
 /**************************************************************************************************
  * @fn      spiSrdyCheck
  *
@@ -242,30 +123,8 @@ static int spiSrdyInit(void)
  **************************************************************************************************/
 static uint8_t spiSrdyCheck(uint8_t state)
 {
-  uint32_t rtn;
-  uint8_t srdy;
-  char ch;  
-  
-  if(zbSrdyFd != -1)
-  {
-    lseek(zbSrdyFd, SEEK_SET, 0);
-    rtn = read(zbSrdyFd,&ch, 1);
-
-    //srdy will be '1' or '0' in Ascii, so -30 will give it in int
-    srdy=ch-0x30;
-    
-    //printf("spiSrdyCheck: srdy=%x\n", srdy);
-    
-  //SRDY is active low
-  }
-  else
-  {
-    //printf("spiSrdyCheck: zbSrdyFd == -1\n");
-    srdy = state;
-  }
-  
   //Note the !, SRDY is active low.  
-  return (!(state == srdy));
+  return (!(state == zbSocGpioGetSrdy()));
 }
 
 /**************************************************************************************************
@@ -301,62 +160,39 @@ static uint8_t spiCalcFcs(uint8_t *pBuf)
 /**************************************************************************************************
  * @fn          spiClockData
  *
- * @brief       Clock Rx bytes on the SPI bus.
+ * @brief       Clock bytes on the SPI bus as a single transfer.
  *
  * input parameters
  *
- * @param       pBuf - pointer to the memory of the data bytes to send; NULL to send dummy zeroes.
- * @param       len - the length of the data bytes to send.
+ * @param       pTx - the data bytes to send; NULL to send dummy zeroes.
+ * @param       pRx - where the received bytes go; NULL to drop them.
+ * @param       len - the number of bytes to clock.
  *
  * output parameters
  *
  * None.
  *
- * @return      The FCS calculated.
+ * @return      0 on success, -1 if the transfer failed.
  */
-static void spiClockData(uint8_t *pBuf, uint8_t len)
+static int32_t spiClockData(uint8_t *pTx, uint8_t *pRx, uint32_t len)
 {
-  struct spi_ioc_transfer tr = {
-    .tx_buf = (unsigned long)pBuf,
-    .rx_buf = (unsigned long)spiRxTmp,
-    .len = len,
-    .delay_usecs = delay,
-    .speed_hz = speed,
-    .bits_per_word = bits,
-  };
-
-  if (pBuf == NULL)  // If just requesting to send dummy zero bytes.
-  {
-    (void)memset(spiRxTmp, 0, len);
-    tr.tx_buf = (unsigned long)spiRxTmp;
-  }
+  struct spi_ioc_transfer tr;
 
-  pthread_mutex_lock(&spiMutex1);
-  int rtrn = ioctl(spiDevFd, SPI_IOC_MESSAGE(1), &tr);
-  pthread_mutex_unlock(&spiMutex1);
+  memset(&tr, 0, sizeof(tr));
+  tr.tx_buf = (unsigned long)pTx;
+  tr.rx_buf = (unsigned long)pRx;
+  tr.len = len;
 
-  if (rtrn < 0)
-  {
-    //printf("spiClockData: Full duplex transfer failed\n");
-  }
-  else
-  {    
-    pBuf = spiRxTmp;
-
-    // Now that the SPI bus Mutex has been released, copy the Rx data from this temporary linear
-    // buffer into the circular buffer accessed by the background parsing algorithm.
-    while (len--)
-    {
-      //printf("spiClockData[%x]: %x\n", spiRxTail, *pBuf); 
-      spiRxBuf[spiRxTail++] = *pBuf++;                    
-    }
-  }
+  return zbSocSpiDevTransfer(&tr, 1);
 }
 
 /**************************************************************************************************
- * @fn          spiParseRx
+ * @fn          spiReadFrame
  *
- * @brief       Parse all available bytes from the spiRxBuf[] into the spiRxPkt[].
+ * @brief       Clock the next frame into the spiRxPkt[] while SRDY is asserted. The SOF and
+ *              LEN come in one transfer, the data and the FCS chained in one more, so a frame
+ *              takes two SPI_IOC_MESSAGE calls whatever its length. Only a lost sync clocks
+ *              byte by byte until the SOF.
  *              Note: Only call if (spiRxRdy == 0).
  *
  * input parameters
@@ -369,175 +205,122 @@ static void spiClockData(uint8_t *pBuf, uint8_t len)
  *
  * @return      None.
  */
-static void spiParseRx(void)
+static void spiReadFrame(void)
 { 
-  //printf("spiParseRx++\n");
-  
-  while (1)
-  {       
-    if (spiRxHead == spiRxTail)
+  struct spi_ioc_transfer tr[2];
+  uint8_t len, fcs;
+
+  while (spiSrdyCheck(1))
+  {
+    if (spiClockData(NULL, spiRxPkt, SPI_HDR_LEN + 1) != 0)
     {
-      //If we have FCS/Sync errors consider giving zbSoC longer to change SRDY
-      //usleep(50);
+      return;
+    }
 
-      if (spiSrdyCheck(1))
+    while (spiRxPkt[SPI_SOF_IDX] != SPI_SOF)
+    {
+      if (!spiSrdyCheck(1))
       {
-        spiClockData(NULL, 1);
-        continue;
+        return;
       }
 
-      break;
-    }   
-    
-    uint8_t ch = spiRxBuf[spiRxHead];
-    SPI_LEN_T_INCR(spiRxHead);
-    
-    switch (spiRxSte)
-    {     
-    case spiRxSteSOF:
-      if (ch == SPI_SOF)
+      //hunt for the SOF, the byte after it is the LEN
+      spiRxPkt[SPI_SOF_IDX] = spiRxPkt[SPI_LEN_IDX];
+      if (spiClockData(NULL, spiRxPkt + SPI_LEN_IDX, 1) != 0)
       {
-        spiRxSte = spiRxSteLen;
-
-        // At this point, the master has effected the protocol for ensuring that the SPI slave is
-        // awake, so set the spiRxLen to non-zero to prevent the slave from re-entering sleep until
-        // the entire packet is received - even if the master interrupts the sending of the packet
-        // by de-asserting/re-asserting MRDY one or more times.
-        spiRxLen = 1;
+        return;
       }
-      break;
+    }
 
-    case spiRxSteLen:
-      spiRxPkt[SPI_LEN_IDX] = ch;
-      if ((ch == 0) || (ch > SPI_MAX_DAT_LEN))
-      {
-        spiRxSte = spiRxSteSOF;
-        spiRxLen = 0;
-      }
-      else
-      {
-        spiRxLen = ch;
-        spiRxCnt = 0;
-        spiRxSte = spiRxSteData;
-        spiClockData(NULL, (ch+1));  // Clock out the SPI Frame Data bytes and FCS.
-      }
-      break;
+    len = spiRxPkt[SPI_LEN_IDX];
+    if ((len == 0) || (len > SPI_MAX_DAT_LEN))
+    {
+      continue;
+    }
 
-    case spiRxSteData:
-      spiRxPkt[SPI_DAT_IDX + spiRxCnt++] = ch;
+    //the data lands in the frame, the FCS beside it for spiCalcFcs to check against
+    memset(tr, 0, sizeof(tr));
+    tr[0].rx_buf = (unsigned long)(spiRxPkt + SPI_DAT_IDX);
+    tr[0].len = len;
+    tr[1].rx_buf = (unsigned long)&fcs;
+    tr[1].len = 1;
 
-      if (spiRxCnt == spiRxLen)
-      {
-        spiRxSte = spiRxSteFcs;
-      }
-      break;
-
-    case spiRxSteFcs:
-      spiRxSte = spiRxSteSOF;
-
-      if (ch == spiCalcFcs(spiRxPkt))
-      {        
-        spiRxRdy = spiRxLen;
-        // Zero spiRxLen now to re-enable sleep within SPI_PM_DLY time. Before sleep is entered,
-        // both the Application will be notified of spiRxRdy via uartCB(), and the spiRxBuf will be
-        // polled again for another SOF (which would block the return to sleep).
-        spiRxLen = 0;
-        // Zero spiRxCnt now to re-use it for counting the data bytes incrementally read with
-        // HalUARTReadSPI() for Applications that do not read all at once.
-        spiRxCnt = 0;
-        return;
-      }
-      else
-      {
-        printf("spiParseRx: FCS failed for len %x, Calc:%x Read:%x\n", spiRxPkt[SPI_LEN_IDX], spiCalcFcs(spiRxPkt), ch);    
-      }
+    if (zbSocSpiDevTransfer(tr, 2) != 0)
+    {
+      return;
+    }
 
+    if (fcs == spiCalcFcs(spiRxPkt))
+    {        
+      spiRxRdy = len;
+      // Zero spiRxCnt now to re-use it for counting the data bytes incrementally read with
+      // zbSocTransportRead() for callers that do not read all at once.
       spiRxCnt = 0;
-      break;
-
-    default:
-      spiRxSte = spiRxSteSOF;
-      break;
+      return;
     }
+
+    printf("spiReadFrame: FCS failed for len %x, Calc:%x Read:%x\n", len, spiCalcFcs(spiRxPkt), fcs);
   }
 }
   
 /*********************************************************************
- * API FUNCTIONS
- */
-
-
-/*********************************************************************
- * @fn      zbSocTransportOpen
+ * @fn      spiOpen
  *
- * @brief   opens the serial port to the CC253x.
+ * @brief   opens the spidev to the CC253x and its SRDY line.
  *
- * @param   devicePath - path to the UART device
+ * @param   devicePath - path to the spidev
  *
- * @return  status
+ * @return  fd SRDY edges are signalled on, -1 on failure
  */
-int32_t zbSocTransportOpen( char *devicePath  )
+static int spiOpen( const char *devicePath )
 {
-  //printf("zbSocTransportOpen++: %s\n",devicePath);
-  
-  /* open the device */  
-  spiDevFd = open(devicePath, O_RDWR );
-  if (spiDevFd <0)
+  /* open the device, the mock GPIO comes with a mock SoC on the bus */  
+  if (zbSocSpiDevOpen(devicePath, (spiGpioConfig.backend == ZBSOC_GPIO_MOCK) ? 
+        ZBSOC_SPIDEV_MOCK : ZBSOC_SPIDEV_KERNEL) < 0)
   {
-    perror(devicePath);
     printf("%s open failed\n",devicePath);
-    exit(-1);
+    return -1;
   }
 
- 	/*
- 	 * spi mode
- 	 */
- 	ioctl(spiDevFd, SPI_IOC_WR_MODE, &mode);
- 	ioctl(spiDevFd, SPI_IOC_RD_MODE, &mode);
-
-	/*
-	 * bits per word
-	 */
-	ioctl(spiDevFd, SPI_IOC_WR_BITS_PER_WORD, &bits);;
-	ioctl(spiDevFd, SPI_IOC_RD_BITS_PER_WORD, &bits);
-
-	/*
-	 * max speed hz
-	 */
-	ioctl(spiDevFd, SPI_IOC_WR_MAX_SPEED_HZ, &speed);
-	ioctl(spiDevFd, SPI_IOC_RD_MAX_SPEED_HZ, &speed);
-
-  return spiSrdyInit();
+  spiRxRdy = 0;
+  spiSrdyFd = zbSocGpioOpen(&spiGpioConfig);
+  if (spiSrdyFd < 0)
+  {
+    zbSocSpiDevClose();
+  }
+
+  return spiSrdyFd;
 }
 
 /*********************************************************************
- * @fn      zbSocTransportClose
+ * @fn      spiClose
  *
- * @brief   closes the serial port to the CC253x.
+ * @brief   closes the spidev and SRDY.
  *
- * @param   fd - file descriptor of the UART device
+ * @param   none
  *
- * @return  status
+ * @return  none
  */
-void zbSocTransportClose( void )
+static void spiClose( void )
 {
-  tcflush(spiDevFd, TCOFLUSH);
-  close(spiDevFd);
-  close(zbSrdyFd);
+  zbSocSpiDevClose();
+  zbSocGpioClose();
+  spiSrdyFd = -1;
   
   return;
 }
 
 /*********************************************************************
- * @fn      zbSocTransportWrite
+ * @fn      spiWrite
  *
- * @brief   Write to the the serial port to the CC253x.
+ * @brief   Write a frame to the CC253x.
  *
- * @param   fd - file descriptor of the UART device
+ * @param   buf - MT frame
+ * @param   len - length of the frame
  *
- * @return  status
+ * @return  none
  */
-void zbSocTransportWrite( uint8_t* buf, uint8_t len )
+static void spiWrite( uint8_t *buf, uint8_t len )
 {
   if (len > SPI_MAX_DAT_LEN)
   {
@@ -550,26 +333,28 @@ void zbSocTransportWrite( uint8_t* buf, uint8_t len )
   spiCalcFcs(spiTxPkt);
   spiTxPkt[SPI_SOF_IDX] = SPI_SOF;
 
-  spiClockData(spiTxPkt, SPI_PKT_LEN(spiTxPkt));
+  //the bytes the SoC clocks back meanwhile are not a frame
+  spiClockData(spiTxPkt, NULL, SPI_PKT_LEN(spiTxPkt));
 
   return;
 }
 
 /*********************************************************************
- * @fn      zbSocTransportRead
+ * @fn      spiRead
  *
- * @brief   Reads from the the serial port to the CC253x.
+ * @brief   Reads the data of the frame the CC253x has, clocking it in
+ *          if SRDY is asserted.
  *
- * @param   fd - file descriptor of the UART device
+ * @param   buf - buffer
+ * @param   len - size of the buffer
  *
- * @return  status
+ * @return  bytes read, 0 if none
  */
-uint8_t zbSocTransportRead( uint8_t* buf, uint8_t len )
+static int32_t spiRead( uint8_t *buf, uint32_t len )
 {
-  //printf("zbSocTransportRead++\n");
   if (spiRxRdy == 0)
   {
-    spiParseRx();
+    spiReadFrame();
   }
     
   if (len > spiRxRdy)
@@ -586,22 +371,71 @@ uint8_t zbSocTransportRead( uint8_t* buf, uint8_t len )
 }
 
 /*********************************************************************
- * @fn      zbSocTransportPoll
+ * @fn      spiFd
  *
- * @brief   poll the SPI SRDY to see if there is data to read.
+ * @brief   get the fd SRDY edges are signalled on.
  *
- * @param   fd - file descriptor of the UART device
+ * @param   none
  *
- * @return  status
+ * @return  fd, -1 if closed
  */
-uint8_t zbSocTransportPoll(void)
+static int spiFd( void )
 {
-  //printf("zbSocTransportPoll++: spiRxRdy=%x\n", spiRxRdy);
-  if (spiRxRdy == 0)
+  return spiSrdyFd;
+}
+
+/*********************************************************************
+ * @fn      spiPoll
+ *
+ * @brief   consume the SRDY edges, one that came after the frame was 
+ *          read is for a frame still waiting.
+ *
+ * @param   none
+ *
+ * @return  TRUE if SRDY is asserted
+ */
+static uint8_t spiPoll( void )
+{
+  zbSocGpioDrain();
+
+  return (spiRxRdy != 0) || spiSrdyCheck(1);
+}
+
+/*********************************************************************
+ * @fn      spiPollEvents
+ *
+ * @brief   get the poll events of an SRDY edge.
+ *
+ * @param   none
+ *
+ * @return  POLLPRI or POLLIN
+ */
+static short spiPollEvents( void )
+{
+  return zbSocGpioPollEvents();
+}
+
+/*********************************************************************
+ * @fn      spiSetProfile
+ *
+ * @brief   set the SRDY GPIO backend used by the next open, as sysfs,
+ *          mock or chardev=<chip>,<srdy line>[,<enable line>]. The
+ *          mock GPIO also replaces the spidev with a mock SoC.
+ *
+ * @param   profile - profile string
+ *
+ * @return  0 on success, -1 if the profile is invalid
+ */
+static int32_t spiSetProfile( const char *profile )
+{
+  zbSocGpioConfig_t config;
+
+  if (zbSocGpioParse(profile, &config) != 0)
   {
-    spiParseRx();
+    return -1;
   }
 
-  //printf("zbSocTransportPoll--: spiRxRdy=%x\n", spiRxRdy);
-  return spiRxRdy;
-}
\ No newline at end of file
+  spiGpioConfig = config;
+
+  return 0;
+}
@@ -0,0 +1,565 @@
+/*
+ * zbSocTransportTcp.c
+ *
+ * This module contains a TCP transport, to a serial server (e.g. ser2net) or a simulator of the SoC.
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <netdb.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include <errno.h>
+
+#include "zbSocTransport.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define TCP_MAX_HOST_LEN 255
+
+// first wait before a reconnect, doubled on every failure up to the max
+#define TCP_DEFAULT_BACKOFF_MS 100
+#define TCP_DEFAULT_MAX_BACKOFF_MS 10000
+#define TCP_DEFAULT_CONNECT_MS 3000
+// idle time before the first probe, a peer that is gone is noticed
+// TCP_KEEPALIVE_PROBES * TCP_KEEPALIVE_INTERVAL_S later
+#define TCP_DEFAULT_KEEPALIVE_S 10
+#define TCP_KEEPALIVE_INTERVAL_S 5
+#define TCP_KEEPALIVE_PROBES 3
+
+/************************************************************
+ * TYPEDEFS
+ */
+typedef enum
+{
+  tcpSteClosed,
+  tcpSteBackoff,     // waiting to reconnect
+  tcpSteConnecting,  // non-blocking connect in progress
+  tcpSteConnected
+} tcpSte_t;
+
+typedef struct
+{
+  uint32_t backoffMs;
+  uint32_t maxBackoffMs;
+  uint32_t connectMs;
+  uint32_t keepaliveS;   // 0 disables keepalive
+} tcpProfile_t;
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static int tcpOpen( const char *devicePath );
+static void tcpClose( void );
+static void tcpWrite( uint8_t *buf, uint8_t len );
+static int32_t tcpRead( uint8_t *buf, uint32_t len );
+static int tcpFd( void );
+static short tcpPollEvents( void );
+static int32_t tcpSetProfile( const char *profile );
+static int32_t tcpReadTimeout( void );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+const zbSocTransport_t zbSocTransportTcp =
+{
+  "tcp", ZBSOC_TRANSPORT_LEVEL, tcpOpen, tcpClose, tcpWrite, tcpRead, tcpFd,
+  NULL, tcpPollEvents, tcpSetProfile, tcpReadTimeout
+};
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static tcpProfile_t tcpProfile = 
+{
+  TCP_DEFAULT_BACKOFF_MS, TCP_DEFAULT_MAX_BACKOFF_MS, TCP_DEFAULT_CONNECT_MS, TCP_DEFAULT_KEEPALIVE_S
+};
+
+static tcpSte_t tcpSte = tcpSteClosed;
+static int tcpSockFd = -1;
+static char tcpPeer[TCP_MAX_HOST_LEN + 8];
+
+// the addresses of the host are tried in turn
+static struct addrinfo *tcpAddrs = NULL;
+static struct addrinfo *tcpAddr = NULL;
+
+static uint64_t tcpDeadline;  // end of the backoff or of the connect, ms
+static uint32_t tcpBackoffMs; // next backoff
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      tcpNow
+ *
+ * @brief   monotonic time in ms.
+ */
+static uint64_t tcpNow( void )
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/*********************************************************************
+ * @fn      tcpRetry
+ *
+ * @brief   drop the connection and wait the backoff before the next
+ *          address is tried.
+ *
+ * @param   reason - why, for the log
+ *
+ * @return  none
+ */
+static void tcpRetry( const char *reason )
+{
+  if (tcpSockFd >= 0)
+  {
+    close(tcpSockFd);
+    tcpSockFd = -1;
+  }
+
+  printf("tcp %s: %s, reconnecting in %u ms\n", tcpPeer, reason, tcpBackoffMs);
+
+  tcpSte = tcpSteBackoff;
+  tcpDeadline = tcpNow() + tcpBackoffMs;
+  tcpBackoffMs = (tcpBackoffMs > tcpProfile.maxBackoffMs / 2) ? tcpProfile.maxBackoffMs : (tcpBackoffMs * 2);
+
+  tcpAddr = ((tcpAddr != NULL) && (tcpAddr->ai_next != NULL)) ? tcpAddr->ai_next : tcpAddrs;
+}
+
+/*********************************************************************
+ * @fn      tcpConnected
+ *
+ * @brief   the connect completed, the backoff starts over.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void tcpConnected( void )
+{
+  tcpSte = tcpSteConnected;
+  tcpBackoffMs = tcpProfile.backoffMs;
+
+  printf("tcp %s: connected\n", tcpPeer);
+}
+
+/*********************************************************************
+ * @fn      tcpConnect
+ *
+ * @brief   start a non-blocking connect to the current address. The
+ *          socket is without Nagle, a frame goes out when it is 
+ *          written, and with keepalive, a peer that is gone without a 
+ *          FIN or RST, e.g. a ser2net box that lost power, is noticed.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void tcpConnect( void )
+{
+  int one = 1;
+
+  tcpSockFd = socket(tcpAddr->ai_family, tcpAddr->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, 
+                     tcpAddr->ai_protocol);
+  if (tcpSockFd < 0)
+  {
+    tcpRetry(strerror(errno));
+    return;
+  }
+
+  setsockopt(tcpSockFd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  if (tcpProfile.keepaliveS)
+  {
+    int idle = tcpProfile.keepaliveS;
+    int interval = TCP_KEEPALIVE_INTERVAL_S;
+    int probes = TCP_KEEPALIVE_PROBES;
+    //unacknowledged frames give up as late as an idle link does
+    unsigned int userTimeout = (idle + (interval * probes)) * 1000;
+
+    setsockopt(tcpSockFd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+    setsockopt(tcpSockFd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+    setsockopt(tcpSockFd, IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof(interval));
+    setsockopt(tcpSockFd, IPPROTO_TCP, TCP_KEEPCNT, &probes, sizeof(probes));
+    setsockopt(tcpSockFd, IPPROTO_TCP, TCP_USER_TIMEOUT, &userTimeout, sizeof(userTimeout));
+  }
+
+  if (connect(tcpSockFd, tcpAddr->ai_addr, tcpAddr->ai_addrlen) == 0)
+  {
+    tcpConnected();
+  }
+  else if (errno == EINPROGRESS)
+  {
+    tcpSte = tcpSteConnecting;
+    tcpDeadline = tcpNow() + tcpProfile.connectMs;
+  }
+  else
+  {
+    tcpRetry(strerror(errno));
+  }
+}
+
+/*********************************************************************
+ * @fn      tcpService
+ *
+ * @brief   move the connection on: reconnect once the backoff is over,
+ *          and complete or time out a connect in progress. The I/O 
+ *          thread reads after every wake up, so this runs when the 
+ *          connect completes or tcpReadTimeout passes.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void tcpService( void )
+{
+  if ((tcpSte == tcpSteBackoff) && (tcpNow() >= tcpDeadline))
+  {
+    tcpConnect();
+  }
+
+  if (tcpSte == tcpSteConnecting)
+  {
+    struct pollfd pollFd = { tcpSockFd, POLLOUT, 0 };
+    socklen_t errLen = sizeof(int);
+    int err = 0;
+
+    if (poll(&pollFd, 1, 0) > 0)
+    {
+      getsockopt(tcpSockFd, SOL_SOCKET, SO_ERROR, &err, &errLen);
+      if (err == 0)
+      {
+        tcpConnected();
+      }
+      else
+      {
+        tcpRetry(strerror(err));
+      }
+    }
+    else if (tcpNow() >= tcpDeadline)
+    {
+      tcpRetry("connect timed out");
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      tcpOpen
+ *
+ * @brief   resolve <host>:<port>, an IPv6 host in brackets, and start
+ *          connecting. A peer that is not up yet is retried like a
+ *          lost connection, so the gateway can start first.
+ *
+ * @param   devicePath - <host>:<port>
+ *
+ * @return  0 on success, -1 if the host does not resolve
+ */
+static int tcpOpen( const char *devicePath )
+{
+  struct addrinfo hints;
+  char host[TCP_MAX_HOST_LEN + 1];
+  const char *port = strrchr(devicePath, ':');
+  size_t hostLen;
+  int rtn;
+
+  if ((port == NULL) || ((hostLen = port - devicePath) > TCP_MAX_HOST_LEN))
+  {
+    printf("%s - expected <host>:<port>\n", devicePath);
+    return -1;
+  }
+  port++;
+
+  //[::1]:5000
+  if ((hostLen >= 2) && (devicePath[0] == '[') && (devicePath[hostLen - 1] == ']'))
+  {
+    memcpy(host, devicePath + 1, hostLen - 2);
+    host[hostLen - 2] = '\0';
+  }
+  else
+  {
+    memcpy(host, devicePath, hostLen);
+    host[hostLen] = '\0';
+  }
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  //only here, a lookup would stall the I/O thread on every reconnect
+  rtn = getaddrinfo(host, port, &hints, &tcpAddrs);
+  if (rtn != 0)
+  {
+    printf("%s - %s\n", devicePath, gai_strerror(rtn));
+    return -1;
+  }
+
+  snprintf(tcpPeer, sizeof(tcpPeer), "%s", devicePath);
+  tcpAddr = tcpAddrs;
+  tcpBackoffMs = tcpProfile.backoffMs;
+
+  tcpConnect();
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      tcpClose
+ *
+ * @brief   close the connection and stop reconnecting.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void tcpClose( void )
+{
+  if (tcpSockFd >= 0)
+  {
+    close(tcpSockFd);
+    tcpSockFd = -1;
+  }
+
+  if (tcpAddrs != NULL)
+  {
+    freeaddrinfo(tcpAddrs);
+    tcpAddrs = tcpAddr = NULL;
+  }
+
+  tcpSte = tcpSteClosed;
+}
+
+/*********************************************************************
+ * @fn      tcpWrite
+ *
+ * @brief   write a frame to the peer. A connect in progress is waited 
+ *          for, e.g. the first frames after the open. While reconnecting
+ *          the frame is dropped, the scheduler retries what needs an 
+ *          answer.
+ *
+ * @param   buf - MT frame
+ * @param   len - length of the frame
+ *
+ * @return  none
+ */
+static void tcpWrite( uint8_t *buf, uint8_t len )
+{
+  tcpService();
+
+  if (tcpSte == tcpSteConnecting)
+  {
+    struct pollfd pollFd = { tcpSockFd, POLLOUT, 0 };
+    uint64_t now = tcpNow();
+
+    poll(&pollFd, 1, (tcpDeadline > now) ? (int)(tcpDeadline - now) : 0);
+    tcpService();
+  }
+
+  if (tcpSte != tcpSteConnected)
+  {
+    printf("tcp %s: not connected, frame dropped\n", tcpPeer);
+    return;
+  }
+
+  if (zbSocTransportWriteAll(tcpSockFd, buf, len, 1) != 0)
+  {
+    tcpRetry("write failed");
+  }
+}
+
+/*********************************************************************
+ * @fn      tcpRead
+ *
+ * @brief   read what the peer sent. A connection the peer closed, or
+ *          keepalive found dead, is reconnected.
+ *
+ * @param   buf - buffer
+ * @param   len - size of the buffer
+ *
+ * @return  bytes read, 0 if none
+ */
+static int32_t tcpRead( uint8_t *buf, uint32_t len )
+{
+  ssize_t bytesRead;
+
+  tcpService();
+
+  if ((tcpSte != tcpSteConnected) || (len == 0))
+  {
+    return 0;
+  }
+
+  bytesRead = read(tcpSockFd, buf, len);
+  if (bytesRead > 0)
+  {
+    return bytesRead;
+  }
+
+  if (bytesRead == 0)
+  {
+    tcpRetry("closed by the peer");
+  }
+  else if ((errno != EAGAIN) && (errno != EINTR))
+  {
+    tcpRetry(strerror(errno));
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      tcpFd
+ *
+ * @brief   get the fd of the socket.
+ *
+ * @param   none
+ *
+ * @return  fd, -1 while waiting to reconnect
+ */
+static int tcpFd( void )
+{
+  return tcpSockFd;
+}
+
+/*********************************************************************
+ * @fn      tcpPollEvents
+ *
+ * @brief   get the poll events to wait for, the socket becomes writable
+ *          when a connect completes.
+ *
+ * @param   none
+ *
+ * @return  POLLOUT while connecting, POLLIN otherwise
+ */
+static short tcpPollEvents( void )
+{
+  return (tcpSte == tcpSteConnecting) ? POLLOUT : POLLIN;
+}
+
+/*********************************************************************
+ * @fn      tcpSetProfile
+ *
+ * @brief   set the reconnect settings, as [backoff=<ms>][:maxbackoff=<ms>]
+ *          [:connect=<ms>][:keepalive=<s>], keepalive=0 disables it.
+ *
+ * @param   profile - profile string
+ *
+ * @return  0 on success, -1 if the profile is invalid
+ */
+static int32_t tcpSetProfile( const char *profile )
+{
+  tcpProfile_t newProfile = tcpProfile;
+  char buf[64], *tok, *save;
+  unsigned int value;
+
+  if (strlen(profile) >= sizeof(buf))
+  {
+    return -1;
+  }
+  strcpy(buf, profile);
+
+  for (tok = strtok_r(buf, ":", &save); tok != NULL; tok = strtok_r(NULL, ":", &save))
+  {
+    if ((sscanf(tok, "backoff=%u", &value) == 1) && (value > 0))
+    {
+      newProfile.backoffMs = value;
+    }
+    else if ((sscanf(tok, "maxbackoff=%u", &value) == 1) && (value > 0))
+    {
+      newProfile.maxBackoffMs = value;
+    }
+    else if ((sscanf(tok, "connect=%u", &value) == 1) && (value > 0))
+    {
+      newProfile.connectMs = value;
+    }
+    else if ((sscanf(tok, "keepalive=%u", &value) == 1) && (value <= 3600))
+    {
+      newProfile.keepaliveS = value;
+    }
+    else
+    {
+      return -1;
+    }
+  }
+
+  if (newProfile.maxBackoffMs < newProfile.backoffMs)
+  {
+    return -1;
+  }
+
+  tcpProfile = newProfile;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      tcpReadTimeout
+ *
+ * @brief   how long the I/O thread may wait, up to the end of the 
+ *          backoff or of the connect in progress.
+ *
+ * @param   none
+ *
+ * @return  timeout in ms, -1 while connected
+ */
+static int32_t tcpReadTimeout( void )
+{
+  uint64_t now;
+
+  if ((tcpSte != tcpSteBackoff) && (tcpSte != tcpSteConnecting))
+  {
+    return -1;
+  }
+
+  now = tcpNow();
+
+  return (tcpDeadline > now) ? (int32_t)(tcpDeadline - now) : 0;
+}
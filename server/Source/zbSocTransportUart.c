@@ -47,32 +47,14 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
+#include <linux/serial.h>
 
 #include <errno.h>
 #include <string.h>
 
-#include "zbSocCmd.h"
+#include "zbSocTransport.h"
 
 
-/*********************************************************************
- * MACROS
- */
-          
-#define socWrite(fd,rpcBuff,rpcLen) \
-	do { \
-		if (uartDebugPrintsEnabled) \
-		{ \
-			int x; \
-			printf("UART OUT --> %d Bytes: SOF:%02X, Len:%02X, CMD0:%02X, CMD1:%02X, Payload:", (rpcLen), (rpcBuff)[0], (rpcBuff)[1] , (rpcBuff)[2], (rpcBuff)[3] ); \
-			for (x = 4; x < (rpcLen) - 1; x++) \
-			{ \
-			  printf("%02X%s", (rpcBuff)[x], x < (rpcLen) - 1 - 1 ? ":" : ","); \
-			} \
-			printf(" FCS:%02X\n", (rpcBuff)[x]); \
-		} \
-		write((fd),(rpcBuff),(rpcLen)); \
-	} while (0)
-	
 /*********************************************************************
  * CONSTANTS
  */
@@ -82,57 +64,90 @@
 #define SB_FORCE_BOOT               0xF8
 #define SB_FORCE_RUN               (SB_FORCE_BOOT ^ 0xFF)
 
+// Max time uartClose waits for the written frames to go out, in ms
+#define UART_CLOSE_DRAIN_MS 100
+
 /************************************************************
  * TYPEDEFS
  */
+typedef struct
+{
+  uint32_t baudRate;
+  speed_t speed;
+} uartBaud_t;
+
+typedef struct
+{
+  speed_t speed;
+  uint32_t baudRate;
+  uint8_t flowControl; // RTS/CTS
+  uint8_t lowLatency;  // ASYNC_LOW_LATENCY, the driver pushes Rx bytes at once
+  uint8_t vmin;        // termios VMIN, bytes a read waits for
+  uint8_t vtime;       // termios VTIME, 1/10 s a read waits between bytes
+} uartProfile_t;
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static int uartOpen( const char *devicePath );
+static void uartClose( void );
+static void uartWrite( uint8_t *buf, uint8_t len );
+static int32_t uartRead( uint8_t *buf, uint32_t len );
+static int uartFd( void );
+static int32_t uartSetProfile( const char *profile );
+static int32_t uartReadTimeout( void );
 
 /*********************************************************************
  * GLOBAL VARIABLES
  */
-extern uint8_t uartDebugPrintsEnabled;
+const zbSocTransport_t zbSocTransportUart =
+{
+  "uart", ZBSOC_TRANSPORT_LEVEL, uartOpen, uartClose, uartWrite, uartRead, uartFd,
+  NULL, NULL, uartSetProfile, uartReadTimeout
+};
 
 /*********************************************************************
  * LOCAL VARIABLES
  */
-int serialPortFd;
+static int uartPortFd = -1;
+
+static const uartBaud_t uartBauds[] =
+{
+  { 9600, B9600 },
+  { 19200, B19200 },
+  { 38400, B38400 },
+  { 57600, B57600 },
+  { 115200, B115200 },
+  { 230400, B230400 },
+  { 460800, B460800 },
+  { 500000, B500000 },
+  { 576000, B576000 },
+  { 921600, B921600 },
+};
+
+//the profile the CC253x image ships with
+static uartProfile_t uartProfile = { B38400, 38400, 1, 0, 0, 0 };
 
 /*********************************************************************
- * API FUNCTIONS
+ * LOCAL FUNCTIONS
  */
- 
+
 /*********************************************************************
- * @fn      zbSocTransportOpen
+ * @fn      uartOpen
  *
  * @brief   opens the serial port to the CC253x.
  *
  * @param   devicePath - path to the UART device
  *
- * @return  status
+ * @return  fd, -1 on failure
  */
-int32_t zbSocTransportOpen( char *_devicePath  )
+static int uartOpen( const char *devicePath )
 {
   struct termios tio;
-  static char lastUsedDevicePath[255];
-  char * devicePath;
-  
-  if (_devicePath != NULL)
-  {
-	if (strlen(_devicePath) > (sizeof(lastUsedDevicePath) - 1))
-	{
-		printf("%s - device path too long\n",_devicePath);
-		return(-1);
-	}
-  	devicePath = _devicePath;
-	strcpy(lastUsedDevicePath, _devicePath);
-  }
-  else
-  {
-  	devicePath = lastUsedDevicePath;
-  }
   
   /* open the device to be non-blocking (read will return immediatly) */
-  serialPortFd = open(devicePath, O_RDWR | O_NOCTTY | O_NONBLOCK);
-  if (serialPortFd <0) 
+  uartPortFd = open(devicePath, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (uartPortFd <0) 
   {
     perror(devicePath); 
     printf("%s open failed\n",devicePath);
@@ -140,15 +155,23 @@ int32_t zbSocTransportOpen( char *_devicePath  )
   }
   
   //make the access exclusive so other instances will return -1 and exit
-  ioctl(serialPortFd, TIOCEXCL);
+  ioctl(uartPortFd, TIOCEXCL);
+
+  memset(&tio, 0, sizeof(tio));
 
   /* c-iflags
-     B115200 : set board rate to 115200
-     CRTSCTS : HW flow control (disabled below)
+     speed   : the baud rate of the profile
+     CRTSCTS : HW flow control, unless the profile disables it
      CS8     : 8n1 (8bit,no parity,1 stopbit)
      CLOCAL  : local connection, no modem contol
      CREAD   : enable receiving characters*/
-  tio.c_cflag = B38400 | CRTSCTS | CS8 | CLOCAL | CREAD;
+  tio.c_cflag = CS8 | CLOCAL | CREAD;
+  if (uartProfile.flowControl)
+  {
+    tio.c_cflag |= CRTSCTS;
+  }
+  cfsetispeed(&tio, uartProfile.speed);
+  cfsetospeed(&tio, uartProfile.speed);
   /* c-iflags
      ICRNL   : maps 0xD (CR) to 0x10 (LR), we do not want this.
      IGNPAR  : ignore bits with parity erros, I guess it is 
@@ -156,57 +179,209 @@ int32_t zbSocTransportOpen( char *_devicePath  )
   tio.c_iflag = IGNPAR  & ~ICRNL; 
   tio.c_oflag = 0;
   tio.c_lflag = 0;
+  //the port is non-blocking, so these only hold back the poll wake up
+  tio.c_cc[VMIN] = uartProfile.vmin;
+  tio.c_cc[VTIME] = uartProfile.vtime;
+
+  tcflush(uartPortFd, TCIFLUSH);
+  tcsetattr(uartPortFd,TCSANOW,&tio);
+
+  if (uartProfile.lowLatency)
+  {
+    struct serial_struct serial;
+    int rtn;
+
+    rtn = ioctl(uartPortFd, TIOCGSERIAL, &serial);
+    if (rtn == 0)
+    {
+      serial.flags |= ASYNC_LOW_LATENCY;
+      rtn = ioctl(uartPortFd, TIOCSSERIAL, &serial);
+    }
 
-  tcflush(serialPortFd, TCIFLUSH);
-  tcsetattr(serialPortFd,TCSANOW,&tio);
+    //a pty or USB bridge may not have it, the port works without
+    if (rtn < 0)
+    {
+      printf("%s: low latency mode not supported - %s\n", devicePath, strerror(errno));
+    }
+  }
   
-  return serialPortFd;
+  return uartPortFd;
 }
 
 /*********************************************************************
- * @fn      zbSocTransportClose
+ * @fn      uartClose
  *
  * @brief   closes the serial port to the CC253x.
  *
- * @param   fd - file descriptor of the UART device
+ * @param   none
  *
- * @return  status
+ * @return  none
  */
-void zbSocTransportClose( void )
+static void uartClose( void )
 {
-  tcflush(serialPortFd, TCOFLUSH);
-  close(serialPortFd);
+  int pending, waitMs;
+
+  //let the frames already written go out, e.g. a reset request. A SoC
+  //that holds CTS would block tcdrain() forever, so only wait a while
+  for (waitMs = 0; waitMs < UART_CLOSE_DRAIN_MS; waitMs++)
+  {
+    if ((ioctl(uartPortFd, TIOCOUTQ, &pending) < 0) || (pending == 0))
+    {
+      break;
+    }
+    usleep(1000);
+  }
+
+  tcflush(uartPortFd, TCOFLUSH);
+  close(uartPortFd);
+  uartPortFd = -1;
 
   return;
 }
 
 /*********************************************************************
- * @fn      zbSocTransportWrite
+ * @fn      uartWrite
  *
  * @brief   Write to the the serial port to the CC253x.
  *
- * @param   fd - file descriptor of the UART device
+ * @param   buf - MT frame
+ * @param   len - length of the frame
  *
- * @return  status
+ * @return  none
  */
-void zbSocTransportWrite( uint8_t* buf, uint8_t len )
+static void uartWrite( uint8_t *buf, uint8_t len )
 {
-  socWrite(serialPortFd, buf, len);
-  tcflush(serialPortFd, TCOFLUSH); 
+  zbSocTransportWriteAll(uartPortFd, buf, len, 0);
 
   return;
 }
 
 /*********************************************************************
- * @fn      zbSocTransportRead
+ * @fn      uartRead
  *
  * @brief   Reads from the the serial port to the CC253x.
  *
- * @param   fd - file descriptor of the UART device
+ * @param   buf - buffer
+ * @param   len - size of the buffer
+ *
+ * @return  bytes read, 0 if none
+ */
+static int32_t uartRead( uint8_t *buf, uint32_t len )
+{
+  ssize_t bytesRead = read(uartPortFd, buf, len);
+
+  return (bytesRead < 0) ? 0 : bytesRead;
+}
+
+/*********************************************************************
+ * @fn      uartFd
+ *
+ * @brief   get the fd of the port.
+ *
+ * @param   none
+ *
+ * @return  fd, -1 if closed
+ */
+static int uartFd( void )
+{
+  return uartPortFd;
+}
+
+/*********************************************************************
+ * @fn      uartSetProfile
+ *
+ * @brief   set the port settings used by the next open, as 
+ *          <baud>[:noflow][:lowlat][:vmin=<bytes>][:vtime=<1/10 s>].
+ *          The baud rate goes up to 921600, the SoC image must be built
+ *          for the same rate. vmin with a vtime of 0 coalesces the Rx 
+ *          bytes into fewer reads, at the cost of the I/O thread waking
+ *          up every uartReadTimeout while the port is idle.
+ *
+ * @param   profile - profile string
+ *
+ * @return  0 on success, -1 if the profile is invalid
+ */
+static int32_t uartSetProfile( const char *profile )
+{
+  uartProfile_t newProfile = { 0, 0, 1, 0, 0, 0 };
+  char buf[64], *tok, *save;
+  unsigned int value;
+  uint32_t i;
+
+  if (strlen(profile) >= sizeof(buf))
+  {
+    return -1;
+  }
+  strcpy(buf, profile);
+
+  tok = strtok_r(buf, ":", &save);
+  if ((tok == NULL) || (sscanf(tok, "%u", &value) != 1))
+  {
+    return -1;
+  }
+
+  for (i = 0; i < (sizeof(uartBauds) / sizeof(uartBauds[0])); i++)
+  {
+    if (uartBauds[i].baudRate == value)
+    {
+      newProfile.baudRate = value;
+      newProfile.speed = uartBauds[i].speed;
+    }
+  }
+
+  if (newProfile.baudRate == 0)
+  {
+    return -1;
+  }
+
+  while ((tok = strtok_r(NULL, ":", &save)) != NULL)
+  {
+    if (!strcmp(tok, "noflow"))
+    {
+      newProfile.flowControl = 0;
+    }
+    else if (!strcmp(tok, "lowlat"))
+    {
+      newProfile.lowLatency = 1;
+    }
+    else if ((sscanf(tok, "vmin=%u", &value) == 1) && (value <= 255))
+    {
+      newProfile.vmin = value;
+    }
+    else if ((sscanf(tok, "vtime=%u", &value) == 1) && (value <= 255))
+    {
+      newProfile.vtime = value;
+    }
+    else
+    {
+      return -1;
+    }
+  }
+
+  uartProfile = newProfile;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      uartReadTimeout
+ *
+ * @brief   how long the I/O thread waits for the port to be readable.
+ *          With vmin and a vtime of 0 the port is only readable once
+ *          vmin bytes are queued, the wait ends when they would have
+ *          been received so a shorter frame is read anyway.
  *
- * @return  status
+ * @param   none
+ *
+ * @return  timeout in ms, -1 to wait until readable
  */
-uint8_t zbSocTransportRead( uint8_t* buf, uint8_t len )
+static int32_t uartReadTimeout( void )
 {
-  return read(serialPortFd, buf, len);
+  if ((uartProfile.vmin <= 1) || (uartProfile.vtime != 0))
+  {
+    return -1;
+  }
+
+  //10 bits a byte, rounded up
+  return ((uartProfile.vmin * 10 * 1000) + uartProfile.baudRate - 1) / uartProfile.baudRate;
 }
@@ -0,0 +1,584 @@
+/**************************************************************************************************
+ * Filename:       zbSocZcl.c
+ * Description:    ZCL data types, attribute record decoding and the attribute handler table.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+ 
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+#include <math.h>
+
+#include "zbSocZcl.h"
+#include "hal_types.h"
+#include "hal_defs.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// arrays, sets, bags and structures nested deeper are not decoded
+#define ZBSOC_ZCL_MAX_DEPTH 4
+
+// invalid length of a string or count of a collection
+#define ZBSOC_ZCL_INVALID_LEN8  0xFF
+#define ZBSOC_ZCL_INVALID_LEN16 0xFFFF
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint8_t inUse;
+  uint8_t dataType;
+  uint16_t clusterId;
+  uint16_t attrId;
+  zbSocZclAttrCb_t cb;
+} zbSocZclAttrHandler_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static zbSocZclAttrHandler_t zbSocZclAttrTable[ZBSOC_ZCL_ATTR_TABLE_LEN];
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static int32_t zbSocZclFixedLen( uint8_t dataType );
+static int32_t zbSocZclValueLen( uint8_t dataType, uint8_t *buf, uint16_t len, uint8_t depth );
+static double zbSocZclSemiToDouble( uint16_t semi );
+static uint32_t zbSocZclHash( uint16_t clusterId, uint16_t attrId );
+
+/*********************************************************************
+ * FUNCTIONS
+ *********************************************************************/
+
+/*********************************************************************
+ * @fn      zbSocZclFixedLen
+ *
+ * @brief   get the length of a data type of fixed length.
+ *
+ * @param   dataType - ZCL data type
+ *
+ * @return  length, -1 if the length is variable or the type unknown
+ */
+static int32_t zbSocZclFixedLen( uint8_t dataType )
+{
+  if ((dataType >= ZCL_DATATYPE_DATA8) && (dataType <= ZCL_DATATYPE_DATA64))
+  {
+    return dataType - ZCL_DATATYPE_DATA8 + 1;
+  }
+  if ((dataType >= ZCL_DATATYPE_BITMAP8) && (dataType <= ZCL_DATATYPE_BITMAP64))
+  {
+    return dataType - ZCL_DATATYPE_BITMAP8 + 1;
+  }
+  if ((dataType >= ZCL_DATATYPE_UINT8) && (dataType <= ZCL_DATATYPE_UINT64))
+  {
+    return dataType - ZCL_DATATYPE_UINT8 + 1;
+  }
+  if ((dataType >= ZCL_DATATYPE_INT8) && (dataType <= ZCL_DATATYPE_INT64))
+  {
+    return dataType - ZCL_DATATYPE_INT8 + 1;
+  }
+
+  switch (dataType)
+  {
+    case ZCL_DATATYPE_NO_DATA:
+      return 0;
+    case ZCL_DATATYPE_BOOLEAN:
+    case ZCL_DATATYPE_ENUM8:
+      return 1;
+    case ZCL_DATATYPE_ENUM16:
+    case ZCL_DATATYPE_SEMI_PREC:
+    case ZCL_DATATYPE_CLUSTER_ID:
+    case ZCL_DATATYPE_ATTR_ID:
+      return 2;
+    case ZCL_DATATYPE_SINGLE_PREC:
+    case ZCL_DATATYPE_TOD:
+    case ZCL_DATATYPE_DATE:
+    case ZCL_DATATYPE_UTC:
+    case ZCL_DATATYPE_BAC_OID:
+      return 4;
+    case ZCL_DATATYPE_DOUBLE_PREC:
+    case ZCL_DATATYPE_IEEE_ADDR:
+      return 8;
+    case ZCL_DATATYPE_128_BIT_SEC_KEY:
+      return 16;
+    default:
+      return -1;
+  }
+}
+
+/*********************************************************************
+ * @fn      zbSocZclValueLen
+ *
+ * @brief   get the length of a value in a frame, walking the elements
+ *          of arrays, sets, bags and structures.
+ *
+ * @param   dataType - ZCL data type
+ * @param   buf - value
+ * @param   len - bytes left in the frame
+ * @param   depth - nesting of the value
+ *
+ * @return  length, -1 if the value is truncated or of an unknown type
+ */
+static int32_t zbSocZclValueLen( uint8_t dataType, uint8_t *buf, uint16_t len, uint8_t depth )
+{
+  int32_t valueLen, elemLen;
+  uint16_t count;
+  uint8_t elemType;
+
+  valueLen = zbSocZclFixedLen(dataType);
+  if (valueLen >= 0)
+  {
+    return (valueLen <= len) ? valueLen : -1;
+  }
+
+  switch (dataType)
+  {
+    case ZCL_DATATYPE_OCTET_STR:
+    case ZCL_DATATYPE_CHAR_STR:
+      if (len < 1)
+      {
+        return -1;
+      }
+      valueLen = 1 + ((buf[0] == ZBSOC_ZCL_INVALID_LEN8) ? 0 : buf[0]);
+      break;
+
+    case ZCL_DATATYPE_LONG_OCTET_STR:
+    case ZCL_DATATYPE_LONG_CHAR_STR:
+      if (len < 2)
+      {
+        return -1;
+      }
+      count = BUILD_UINT16(buf[0], buf[1]);
+      valueLen = 2 + ((count == ZBSOC_ZCL_INVALID_LEN16) ? 0 : count);
+      break;
+
+    case ZCL_DATATYPE_ARRAY:
+    case ZCL_DATATYPE_SET:
+    case ZCL_DATATYPE_BAG:
+    case ZCL_DATATYPE_STRUCT:
+      if (depth >= ZBSOC_ZCL_MAX_DEPTH)
+      {
+        return -1;
+      }
+
+      //arrays, sets and bags have one element type ahead of the count,
+      //every element of a structure has its own type
+      valueLen = (dataType == ZCL_DATATYPE_STRUCT) ? 0 : 1;
+      if (len < (valueLen + 2))
+      {
+        return -1;
+      }
+      elemType = buf[0];
+      count = BUILD_UINT16(buf[valueLen], buf[valueLen + 1]);
+      valueLen += 2;
+      if (count == ZBSOC_ZCL_INVALID_LEN16)
+      {
+        count = 0;
+      }
+
+      while (count--)
+      {
+        if (dataType == ZCL_DATATYPE_STRUCT)
+        {
+          if (valueLen >= len)
+          {
+            return -1;
+          }
+          elemType = buf[valueLen++];
+        }
+
+        elemLen = zbSocZclValueLen(elemType, &buf[valueLen], len - valueLen, depth + 1);
+        if (elemLen < 0)
+        {
+          return -1;
+        }
+        valueLen += elemLen;
+      }
+      break;
+
+    default:
+      //the length of an unknown type is unknown
+      return -1;
+  }
+
+  return (valueLen <= len) ? valueLen : -1;
+}
+
+/*********************************************************************
+ * @fn      zbSocZclSemiToDouble
+ *
+ * @brief   convert a ZCL semi-precision (IEEE 754 half) value.
+ *
+ * @param   semi - value
+ *
+ * @return  value
+ */
+static double zbSocZclSemiToDouble( uint16_t semi )
+{
+  int exponent = (semi >> 10) & 0x1F;
+  double mantissa = semi & 0x3FF;
+  double value;
+
+  if (exponent == 0)
+  {
+    //subnormal
+    value = ldexp(mantissa, -24);
+  }
+  else if (exponent == 0x1F)
+  {
+    value = (mantissa == 0) ? INFINITY : NAN;
+  }
+  else
+  {
+    value = ldexp(mantissa + 1024, exponent - 25);
+  }
+
+  return (semi & 0x8000) ? -value : value;
+}
+
+/*********************************************************************
+ * @fn      zbSocZclDecodeValue
+ *
+ * @brief   decode a value of any ZCL data type. The value is not copied,
+ *          the record points to it in the frame. Values of up to 8 bytes
+ *          are also decoded to a number.
+ *
+ * @param   dataType - ZCL data type
+ * @param   buf - value
+ * @param   len - bytes left in the frame
+ * @param   attr - record the value is decoded to
+ *
+ * @return  length of the value, -1 if it is truncated or of an unknown type
+ */
+int32_t zbSocZclDecodeValue( uint8_t dataType, uint8_t *buf, uint16_t len, zbSocZclAttr_t *attr )
+{
+  int32_t valueLen, fixedLen, i;
+  uint64_t raw = 0;
+
+  valueLen = zbSocZclValueLen(dataType, buf, len, 0);
+  if (valueLen < 0)
+  {
+    return -1;
+  }
+
+  attr->dataType = dataType;
+  attr->data = buf;
+  attr->len = valueLen;
+  attr->isNumeric = FALSE;
+  attr->value.u = 0;
+
+  fixedLen = zbSocZclFixedLen(dataType);
+  if ((fixedLen <= 0) || (fixedLen > 8))
+  {
+    //no data, strings, collections and keys
+    return valueLen;
+  }
+
+  //little endian
+  for (i = fixedLen - 1; i >= 0; i--)
+  {
+    raw = (raw << 8) | buf[i];
+  }
+
+  attr->isNumeric = TRUE;
+
+  if (dataType == ZCL_DATATYPE_SEMI_PREC)
+  {
+    attr->value.f = zbSocZclSemiToDouble((uint16_t)raw);
+  }
+  else if (dataType == ZCL_DATATYPE_SINGLE_PREC)
+  {
+    uint32_t raw32 = (uint32_t)raw;
+    float f;
+
+    memcpy(&f, &raw32, sizeof(f));
+    attr->value.f = f;
+  }
+  else if (dataType == ZCL_DATATYPE_DOUBLE_PREC)
+  {
+    memcpy(&attr->value.f, &raw, sizeof(attr->value.f));
+  }
+  else if ((dataType >= ZCL_DATATYPE_INT8) && (dataType <= ZCL_DATATYPE_INT64) && (fixedLen < 8) &&
+           (raw & ((uint64_t)1 << ((fixedLen * 8) - 1))))
+  {
+    //sign extend
+    attr->value.s = (int64_t)(raw | (~(uint64_t)0 << (fixedLen * 8)));
+  }
+  else
+  {
+    attr->value.u = raw;
+  }
+
+  return valueLen;
+}
+
+/*********************************************************************
+ * @fn      zbSocZclParseReadRsp
+ *
+ * @brief   walk the attribute records of a read attributes response,
+ *          attribute id, status and for a successful read the data type
+ *          and value. A truncated record or a value of an unknown type
+ *          ends the walk, as the records after it can not be found.
+ *
+ * @param   buf - records
+ * @param   len - length of the records
+ * @param   attrs - decoded records
+ * @param   maxAttrs - size of attrs
+ *
+ * @return  number of records decoded
+ */
+uint8_t zbSocZclParseReadRsp( uint8_t *buf, uint16_t len, zbSocZclAttr_t *attrs, uint8_t maxAttrs )
+{
+  uint8_t numAttrs = 0;
+  int32_t valueLen;
+
+  while ((len >= 3) && (numAttrs < maxAttrs))
+  {
+    zbSocZclAttr_t *attr = &attrs[numAttrs];
+
+    attr->attrId = BUILD_UINT16(buf[0], buf[1]);
+    attr->status = buf[2];
+    buf += 3;
+    len -= 3;
+
+    if (attr->status != ZCL_STATUS_SUCCESS)
+    {
+      attr->dataType = ZCL_DATATYPE_NO_DATA;
+      attr->data = NULL;
+      attr->len = 0;
+      attr->isNumeric = FALSE;
+      attr->value.u = 0;
+    }
+    else
+    {
+      if (len < 1)
+      {
+        break;
+      }
+
+      valueLen = zbSocZclDecodeValue(buf[0], &buf[1], len - 1, attr);
+      if (valueLen < 0)
+      {
+        break;
+      }
+      buf += 1 + valueLen;
+      len -= 1 + valueLen;
+    }
+
+    numAttrs++;
+  }
+
+  return numAttrs;
+}
+
+/*********************************************************************
+ * @fn      zbSocZclParseReport
+ *
+ * @brief   walk the attribute records of a report attributes command,
+ *          attribute id, data type and value. The records are returned
+ *          with a success status, as those of a read response.
+ *
+ * @param   buf - records
+ * @param   len - length of the records
+ * @param   attrs - decoded records
+ * @param   maxAttrs - size of attrs
+ *
+ * @return  number of records decoded
+ */
+uint8_t zbSocZclParseReport( uint8_t *buf, uint16_t len, zbSocZclAttr_t *attrs, uint8_t maxAttrs )
+{
+  uint8_t numAttrs = 0;
+  int32_t valueLen;
+
+  while ((len >= 3) && (numAttrs < maxAttrs))
+  {
+    zbSocZclAttr_t *attr = &attrs[numAttrs];
+
+    attr->attrId = BUILD_UINT16(buf[0], buf[1]);
+    attr->status = ZCL_STATUS_SUCCESS;
+
+    valueLen = zbSocZclDecodeValue(buf[2], &buf[3], len - 3, attr);
+    if (valueLen < 0)
+    {
+      break;
+    }
+    buf += 3 + valueLen;
+    len -= 3 + valueLen;
+
+    numAttrs++;
+  }
+
+  return numAttrs;
+}
+
+/*********************************************************************
+ * @fn      zbSocZclDataTypeLen
+ *
+ * @brief   get the length of a data type of fixed length.
+ *
+ * @param   dataType - ZCL data type
+ *
+ * @return  length, -1 if the length is variable or the type unknown
+ */
+int32_t zbSocZclDataTypeLen( uint8_t dataType )
+{
+  return zbSocZclFixedLen(dataType);
+}
+
+/*********************************************************************
+ * @fn      zbSocZclIsAnalog
+ *
+ * @brief   check if a data type is analog. Reporting of an analog
+ *          attribute is configured with a reportable change, of the
+ *          same data type.
+ *
+ * @param   dataType - ZCL data type
+ *
+ * @return  TRUE if the data type is analog
+ */
+uint8_t zbSocZclIsAnalog( uint8_t dataType )
+{
+  return (((dataType >= ZCL_DATATYPE_UINT8) && (dataType <= ZCL_DATATYPE_INT64)) ||
+          ((dataType >= ZCL_DATATYPE_SEMI_PREC) && (dataType <= ZCL_DATATYPE_DOUBLE_PREC)) ||
+          ((dataType >= ZCL_DATATYPE_TOD) && (dataType <= ZCL_DATATYPE_UTC)));
+}
+
+/*********************************************************************
+ * @fn      zbSocZclHash
+ *
+ * @brief   index of an attribute in the handler table.
+ *
+ * @param   clusterId - cluster
+ * @param   attrId - attribute
+ *
+ * @return  index
+ */
+static uint32_t zbSocZclHash( uint16_t clusterId, uint16_t attrId )
+{
+  //multiplicative hash, the table length is a power of 2
+  return ((((uint32_t)clusterId << 16) | attrId) * 2654435761u >> 16) & (ZBSOC_ZCL_ATTR_TABLE_LEN - 1);
+}
+
+/*********************************************************************
+ * @fn      zbSocZclRegisterAttr
+ *
+ * @brief   register the handler of an attribute. Records of the
+ *          attribute with another data type are not passed to it, an
+ *          attribute may have a handler per data type. Registering the
+ *          same attribute and data type again replaces the handler.
+ *
+ * @param   clusterId - cluster
+ * @param   attrId - attribute
+ * @param   dataType - ZCL data type of the attribute
+ * @param   cb - handler
+ *
+ * @return  0 on success, -1 if the table is full
+ */
+int32_t zbSocZclRegisterAttr( uint16_t clusterId, uint16_t attrId, uint8_t dataType, zbSocZclAttrCb_t cb )
+{
+  uint32_t idx = zbSocZclHash(clusterId, attrId);
+  uint32_t i;
+
+  for (i = 0; i < ZBSOC_ZCL_ATTR_TABLE_LEN; i++)
+  {
+    zbSocZclAttrHandler_t *entry = &zbSocZclAttrTable[(idx + i) & (ZBSOC_ZCL_ATTR_TABLE_LEN - 1)];
+
+    if ((!entry->inUse) || ((entry->clusterId == clusterId) && (entry->attrId == attrId) && 
+        (entry->dataType == dataType)))
+    {
+      entry->inUse = TRUE;
+      entry->clusterId = clusterId;
+      entry->attrId = attrId;
+      entry->dataType = dataType;
+      entry->cb = cb;
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+/*********************************************************************
+ * @fn      zbSocZclDispatchAttrs
+ *
+ * @brief   call the handlers registered for the records with a value.
+ *
+ * @param   clusterId - cluster of the records
+ * @param   attrs - records
+ * @param   numAttrs - number of records
+ * @param   nwkAddr - device that sent the records
+ * @param   endpoint - endpoint of the device
+ * @param   transSeqNum - ZCL transaction sequence number of the frame
+ *
+ * @return  none
+ */
+void zbSocZclDispatchAttrs( uint16_t clusterId, zbSocZclAttr_t *attrs, uint8_t numAttrs, 
+                            uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum )
+{
+  uint32_t idx, i;
+  uint8_t n;
+
+  for (n = 0; n < numAttrs; n++)
+  {
+    if (attrs[n].status != ZCL_STATUS_SUCCESS)
+    {
+      continue;
+    }
+
+    idx = zbSocZclHash(clusterId, attrs[n].attrId);
+
+    //entries are never removed, an empty one ends the probe
+    for (i = 0; i < ZBSOC_ZCL_ATTR_TABLE_LEN; i++)
+    {
+      zbSocZclAttrHandler_t *entry = &zbSocZclAttrTable[(idx + i) & (ZBSOC_ZCL_ATTR_TABLE_LEN - 1)];
+
+      if (!entry->inUse)
+      {
+        break;
+      }
+
+      if ((entry->clusterId == clusterId) && (entry->attrId == attrs[n].attrId) && 
+          (entry->dataType == attrs[n].dataType))
+      {
+        entry->cb(clusterId, &attrs[n], nwkAddr, endpoint, transSeqNum);
+      }
+    }
+  }
+}
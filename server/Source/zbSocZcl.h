@@ -0,0 +1,194 @@
+/**************************************************************************************************
+ * Filename:       zbSocZcl.h
+ * Description:    ZCL data types, attribute record decoding and the attribute handler table.
+ *
+ *
+ * Copyright (C) 2013 Texas Instruments Incorporated - http://www.ti.com/ 
+ * 
+ * 
+ *  Redistribution and use in source and binary forms, with or without 
+ *  modification, are permitted provided that the following conditions 
+ *  are met:
+ *
+ *    Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the   
+ *    distribution.
+ *
+ *    Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ 
+ 
+ 
+
+#ifndef ZBSOCZCL_H
+#define ZBSOCZCL_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Data Types
+#define ZCL_DATATYPE_NO_DATA                            0x00
+#define ZCL_DATATYPE_DATA8                              0x08
+#define ZCL_DATATYPE_DATA16                             0x09
+#define ZCL_DATATYPE_DATA24                             0x0a
+#define ZCL_DATATYPE_DATA32                             0x0b
+#define ZCL_DATATYPE_DATA40                             0x0c
+#define ZCL_DATATYPE_DATA48                             0x0d
+#define ZCL_DATATYPE_DATA56                             0x0e
+#define ZCL_DATATYPE_DATA64                             0x0f
+#define ZCL_DATATYPE_BOOLEAN                            0x10
+#define ZCL_DATATYPE_BITMAP8                            0x18
+#define ZCL_DATATYPE_BITMAP16                           0x19
+#define ZCL_DATATYPE_BITMAP24                           0x1a
+#define ZCL_DATATYPE_BITMAP32                           0x1b
+#define ZCL_DATATYPE_BITMAP40                           0x1c
+#define ZCL_DATATYPE_BITMAP48                           0x1d
+#define ZCL_DATATYPE_BITMAP56                           0x1e
+#define ZCL_DATATYPE_BITMAP64                           0x1f
+#define ZCL_DATATYPE_UINT8                              0x20
+#define ZCL_DATATYPE_UINT16                             0x21
+#define ZCL_DATATYPE_UINT24                             0x22
+#define ZCL_DATATYPE_UINT32                             0x23
+#define ZCL_DATATYPE_UINT40                             0x24
+#define ZCL_DATATYPE_UINT48                             0x25
+#define ZCL_DATATYPE_UINT56                             0x26
+#define ZCL_DATATYPE_UINT64                             0x27
+#define ZCL_DATATYPE_INT8                               0x28
+#define ZCL_DATATYPE_INT16                              0x29
+#define ZCL_DATATYPE_INT24                              0x2a
+#define ZCL_DATATYPE_INT32                              0x2b
+#define ZCL_DATATYPE_INT40                              0x2c
+#define ZCL_DATATYPE_INT48                              0x2d
+#define ZCL_DATATYPE_INT56                              0x2e
+#define ZCL_DATATYPE_INT64                              0x2f
+#define ZCL_DATATYPE_ENUM8                              0x30
+#define ZCL_DATATYPE_ENUM16                             0x31
+#define ZCL_DATATYPE_SEMI_PREC                          0x38
+#define ZCL_DATATYPE_SINGLE_PREC                        0x39
+#define ZCL_DATATYPE_DOUBLE_PREC                        0x3a
+#define ZCL_DATATYPE_OCTET_STR                          0x41
+#define ZCL_DATATYPE_CHAR_STR                           0x42
+#define ZCL_DATATYPE_LONG_OCTET_STR                     0x43
+#define ZCL_DATATYPE_LONG_CHAR_STR                      0x44
+#define ZCL_DATATYPE_ARRAY                              0x48
+#define ZCL_DATATYPE_STRUCT                             0x4c
+#define ZCL_DATATYPE_SET                                0x50
+#define ZCL_DATATYPE_BAG                                0x51
+#define ZCL_DATATYPE_TOD                                0xe0
+#define ZCL_DATATYPE_DATE                               0xe1
+#define ZCL_DATATYPE_UTC                                0xe2
+#define ZCL_DATATYPE_CLUSTER_ID                         0xe8
+#define ZCL_DATATYPE_ATTR_ID                            0xe9
+#define ZCL_DATATYPE_BAC_OID                            0xea
+#define ZCL_DATATYPE_IEEE_ADDR                          0xf0
+#define ZCL_DATATYPE_128_BIT_SEC_KEY                    0xf1
+#define ZCL_DATATYPE_UNKNOWN                            0xff
+
+#define ZCL_STATUS_SUCCESS                              0x00
+
+// attribute records of one read response frame, a record is at least
+// 3 bytes (attribute id and a failed status)
+#define ZBSOC_ZCL_MAX_ATTRS 80
+
+// attribute handlers that can be registered
+#define ZBSOC_ZCL_ATTR_TABLE_LEN 64
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Attribute record of a read response or report
+typedef struct
+{
+  uint16_t attrId;
+  uint8_t status;     // ZCL_STATUS_SUCCESS if the record carries a value
+  uint8_t dataType;
+  uint8_t *data;      // value as sent over the air, in the frame
+  uint16_t len;       // length of the value
+  uint8_t isNumeric;  // TRUE if the value is decoded below
+  union
+  {
+    uint64_t u;       // unsigned, bitmap, enum, data, boolean, time and id types
+    int64_t s;        // signed types, sign extended
+    double f;         // floating point types
+  } value;
+} zbSocZclAttr_t;
+
+// Handler of an attribute, called for every record of it with a value
+typedef void (*zbSocZclAttrCb_t)(uint16_t clusterId, zbSocZclAttr_t *attr, uint16_t nwkAddr, 
+                                 uint8_t endpoint, uint8_t transSeqNum);
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * zbSocZclDecodeValue - decode a value of any data type, returns its length or -1.
+ */
+int32_t zbSocZclDecodeValue( uint8_t dataType, uint8_t *buf, uint16_t len, zbSocZclAttr_t *attr );
+
+/*
+ * zbSocZclParseReadRsp - walk the attribute records of a read attributes response, returns the number of records.
+ */
+uint8_t zbSocZclParseReadRsp( uint8_t *buf, uint16_t len, zbSocZclAttr_t *attrs, uint8_t maxAttrs );
+
+/*
+ * zbSocZclParseReport - walk the attribute records of a report attributes command, returns the number of records.
+ */
+uint8_t zbSocZclParseReport( uint8_t *buf, uint16_t len, zbSocZclAttr_t *attrs, uint8_t maxAttrs );
+
+/*
+ * zbSocZclDataTypeLen - get the length of a data type, -1 if it has no fixed length.
+ */
+int32_t zbSocZclDataTypeLen( uint8_t dataType );
+
+/*
+ * zbSocZclIsAnalog - check if a data type is analog, i.e. has a reportable change.
+ */
+uint8_t zbSocZclIsAnalog( uint8_t dataType );
+
+/*
+ * zbSocZclRegisterAttr - register the handler of an attribute of a data type.
+ */
+int32_t zbSocZclRegisterAttr( uint16_t clusterId, uint16_t attrId, uint8_t dataType, zbSocZclAttrCb_t cb );
+
+/*
+ * zbSocZclDispatchAttrs - call the handlers registered for the records.
+ */
+void zbSocZclDispatchAttrs( uint16_t clusterId, zbSocZclAttr_t *attrs, uint8_t numAttrs, 
+                            uint16_t nwkAddr, uint8_t endpoint, uint8_t transSeqNum );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZBSOCZCL_H */